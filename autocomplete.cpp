@@ -0,0 +1,476 @@
+#include "autocomplete.h"
+#include "sqllexer.h"
+#include <algorithm>
+#include <numeric>
+#include <ranges>
+
+namespace
+{
+    [[nodiscard]] constexpr auto FoldChar(char CharValue) noexcept -> char
+    {
+        return CharValue >= 'A' && CharValue <= 'Z' ? static_cast<char>(CharValue + ('a' - 'A')) : CharValue;
+    }
+
+    [[nodiscard]] constexpr auto IsIdentifierUnit(char16_t CharValue) noexcept -> bool
+    {
+        return (CharValue >= u'a' && CharValue <= u'z') || (CharValue >= u'A' && CharValue <= u'Z') || (CharValue >= u'0' && CharValue <= u'9') ||
+            CharValue == u'_' || CharValue == u'$' || CharValue >= 0x80;
+    }
+
+    // Pattern 的字符按顺序出现在 Name 中，且首字符相同
+    [[nodiscard]] auto IsFuzzyMatch(std::string_view Pattern, std::string_view Name) noexcept -> bool
+    {
+        if (Pattern.empty() || Name.empty() || Pattern.front() != Name.front())
+            return false;
+        std::size_t Position = 1;
+        for (const char CharValue : Pattern.substr(1))
+        {
+            Position = Name.find(CharValue, Position);
+            if (Position == std::string_view::npos)
+                return false;
+            ++Position;
+        }
+        return true;
+    }
+
+    [[nodiscard]] auto IsKeywordText(std::string_view Text) -> bool
+    {
+        std::string Upper(Text);
+        std::ranges::transform(Upper, Upper.begin(), [](char CharValue) { return CharValue >= 'a' && CharValue <= 'z' ? static_cast<char>(CharValue - ('a' - 'A')) : CharValue; });
+        return std::ranges::binary_search(GetSqlKeywords(), std::string_view{ Upper });
+    }
+}
+
+auto FoldCompletionText(std::string_view Text) -> std::string
+{
+    std::string Folded(Text);
+    std::ranges::transform(Folded, Folded.begin(), FoldChar);
+    return Folded;
+}
+
+auto CompletionIndex::Build(const SchemaSnapshot& Snapshot, std::span<const std::string_view> Keywords) -> CompletionIndex
+{
+    // 先按出现顺序写入临时的池，排序去重后再按顺序写入最终的池，使前缀相同的名称在池中也相邻
+    std::string RawPool;
+    std::string RawFolded;
+    std::vector<Entry> RawEntries;
+    const auto Add = [&](std::string_view Text, CompletionKind Kind)
+    {
+        if (Text.empty() || Text.size() > MaxNameBytes) [[unlikely]]
+            return false;
+        RawEntries.push_back({ static_cast<uint32_t>(RawPool.size()), static_cast<uint8_t>(Text.size()), Kind });
+        RawPool += Text;
+        std::ranges::transform(Text, std::back_inserter(RawFolded), FoldChar);
+        return true;
+    };
+    for (const std::string_view Keyword : Keywords)
+        Add(Keyword, CompletionKind::Keyword);
+    struct RawTable
+    {
+        uint32_t TableId = 0;
+        uint32_t Begin = 0;
+        uint32_t End = 0;
+    };
+    std::vector<RawTable> RawTables;
+    RawTables.reserve(Snapshot.Tables.size());
+    CompletionIndex Result;
+    for (std::size_t Table = 0; Table < Snapshot.Tables.size(); ++Table)
+    {
+        const auto TableId = static_cast<uint32_t>(RawEntries.size());
+        const bool HasTable = Add(Snapshot.Tables[Table], CompletionKind::Table);
+        const auto Begin = static_cast<uint32_t>(RawEntries.size());
+        if (Table < Snapshot.Columns.size())
+        {
+            for (const auto& Column : Snapshot.Columns[Table])
+                Add(Column, CompletionKind::Column);
+            Result.ColumnCount += Snapshot.Columns[Table].size();
+        }
+        if (HasTable)
+            RawTables.push_back({ TableId, Begin, static_cast<uint32_t>(RawEntries.size()) });
+    }
+
+    const auto GetRawText = [&](uint32_t Id) { return std::string_view{ RawPool.data() + RawEntries[Id].Offset, RawEntries[Id].Length }; };
+    const auto GetRawFolded = [&](uint32_t Id) { return std::string_view{ RawFolded.data() + RawEntries[Id].Offset, RawEntries[Id].Length }; };
+    std::vector<uint32_t> Order(RawEntries.size());
+    std::iota(Order.begin(), Order.end(), uint32_t{ 0 });
+    std::ranges::sort(Order, [&](uint32_t Left, uint32_t Right)
+    {
+        if (const auto Compared = GetRawFolded(Left).compare(GetRawFolded(Right)); Compared != 0)
+            return Compared < 0;
+        if (RawEntries[Left].Kind != RawEntries[Right].Kind)
+            return RawEntries[Left].Kind < RawEntries[Right].Kind;
+        return GetRawText(Left) < GetRawText(Right);
+    });
+
+    // 同一种类、同一原文的名称（如多张表中的同名列）只保留一个条目
+    std::vector<uint32_t> RawToFinal(RawEntries.size());
+    Result.Pool.reserve(RawPool.size());
+    Result.FoldedPool.reserve(RawFolded.size());
+    Result.Entries.reserve(RawEntries.size());
+    for (const uint32_t RawId : Order)
+    {
+        const Entry& Source = RawEntries[RawId];
+        if (!Result.Entries.empty() && Result.Entries.back().Kind == Source.Kind && Result.GetText(Result.GetSize() - 1) == GetRawText(RawId))
+        {
+            RawToFinal[RawId] = Result.GetSize() - 1;
+            continue;
+        }
+        RawToFinal[RawId] = Result.GetSize();
+        Result.Entries.push_back({ static_cast<uint32_t>(Result.Pool.size()), Source.Length, Source.Kind });
+        Result.Pool += GetRawText(RawId);
+        Result.FoldedPool += GetRawFolded(RawId);
+    }
+
+    Result.Tables.reserve(RawTables.size());
+    Result.TableColumns.reserve(Result.ColumnCount);
+    for (const auto& [TableId, Begin, End] : RawTables)
+    {
+        const auto First = static_cast<uint32_t>(Result.TableColumns.size());
+        for (uint32_t RawId = Begin; RawId < End; ++RawId)
+            Result.TableColumns.push_back(RawToFinal[RawId]);
+        // 最终下标即折叠顺序
+        const auto Segment = std::ranges::subrange(Result.TableColumns.begin() + First, Result.TableColumns.end());
+        std::ranges::sort(Segment);
+        Result.TableColumns.erase(std::ranges::unique(Segment).begin(), Result.TableColumns.end());
+        Result.Tables.push_back({ RawToFinal[TableId], First, static_cast<uint32_t>(Result.TableColumns.size()) });
+    }
+    std::ranges::sort(Result.Tables, {}, &TableRange::TableId);
+    return Result;
+}
+
+auto CompletionIndex::FindPrefix(std::string_view FoldedPrefix) const noexcept -> std::pair<uint32_t, uint32_t>
+{
+    const auto Ids = std::views::iota(uint32_t{ 0 }, GetSize());
+    const auto First = std::ranges::partition_point(Ids, [this, FoldedPrefix](uint32_t Id) { return GetFoldedText(Id) < FoldedPrefix; });
+    const auto Last = std::ranges::partition_point(First, Ids.end(), [this, FoldedPrefix](uint32_t Id) { return GetFoldedText(Id).starts_with(FoldedPrefix); });
+    return { static_cast<uint32_t>(First - Ids.begin()), static_cast<uint32_t>(Last - Ids.begin()) };
+}
+
+auto CompletionIndex::FindName(std::string_view Name, CompletionKind Kind) const -> uint32_t
+{
+    const std::string Folded = FoldCompletionText(Name);
+    const auto [First, Last] = FindPrefix(Folded);
+    uint32_t Found = GetSize();
+    // 折叠后与 Name 相同的条目排在前缀范围的最前面；大小写完全一致的优先
+    for (uint32_t Id = First; Id < Last && Entries[Id].Length == Folded.size(); ++Id)
+    {
+        if (Entries[Id].Kind != Kind)
+            continue;
+        if (GetText(Id) == Name)
+            return Id;
+        if (Found == GetSize())
+            Found = Id;
+    }
+    return Found;
+}
+
+auto CompletionIndex::GetTableColumns(uint32_t TableId) const noexcept -> std::span<const uint32_t>
+{
+    const auto Found = std::ranges::lower_bound(Tables, TableId, {}, &TableRange::TableId);
+    if (Found == Tables.end() || Found->TableId != TableId)
+        return {};
+    return std::span<const uint32_t>{ TableColumns }.subspan(Found->Begin, Found->End - Found->Begin);
+}
+
+auto FindCompletionWord(std::u16string_view Text, std::size_t Caret) noexcept -> CompletionWord
+{
+    Caret = (std::min)(Caret, Text.size());
+    std::size_t Start = Caret;
+    while (Start > 0 && IsIdentifierUnit(Text[Start - 1]))
+        --Start;
+    CompletionWord Word{ Start, Text.substr(Start, Caret - Start), {} };
+    if (Start == 0 || Text[Start - 1] != u'.')
+        return Word;
+    const std::size_t QualifierEnd = Start - 1;
+    if (QualifierEnd >= 2 && Text[QualifierEnd - 1] == u'`')
+    {
+        const std::size_t Open = Text.rfind(u'`', QualifierEnd - 2);
+        if (Open != std::u16string_view::npos)
+            Word.Qualifier = Text.substr(Open + 1, QualifierEnd - 1 - (Open + 1));
+        return Word;
+    }
+    std::size_t QualifierStart = QualifierEnd;
+    while (QualifierStart > 0 && IsIdentifierUnit(Text[QualifierStart - 1]))
+        --QualifierStart;
+    Word.Qualifier = Text.substr(QualifierStart, QualifierEnd - QualifierStart);
+    return Word;
+}
+
+auto QuoteCompletionText(std::string_view Text, CompletionKind Kind) -> std::string
+{
+    const bool IsPlain = !Text.empty() && !(Text.front() >= '0' && Text.front() <= '9') &&
+        std::ranges::all_of(Text, [](char CharValue) { return IsIdentifierUnit(static_cast<unsigned char>(CharValue)); });
+    if (Kind == CompletionKind::Keyword || (IsPlain && !IsKeywordText(Text)))
+        return std::string(Text);
+    std::string Quoted = "`";
+    for (const char CharValue : Text)
+    {
+        if (CharValue == '`')
+            Quoted += '`';
+        Quoted += CharValue;
+    }
+    Quoted += '`';
+    return Quoted;
+}
+
+AutocompleteEngine::AutocompleteEngine(AutocompleteOptions OptionsParam) : Options(std::move(OptionsParam))
+{
+    Publish({});
+}
+
+AutocompleteEngine::~AutocompleteEngine()
+{
+    StopLoading();
+    // 大型库的 information_schema 查询可能很慢，中断后线程才能及时退出
+    for (const auto& Task : Loaders)
+        Task->Connection.Cancel();
+    for (const auto& Task : Loaders)
+        Task->Thread.join();
+}
+
+auto AutocompleteEngine::LoadAsync(MySQLConfig Config, LoadCallback Callback) -> void
+{
+    StopLoading();
+    // 回收已经退出的旧加载，仍在收尾的留到以后
+    std::erase_if(Loaders, [](const std::unique_ptr<LoadTask>& Task) { return Task->IsFinished.load(std::memory_order_acquire); });
+    const uint64_t LoadGeneration = Generation.load(std::memory_order_relaxed);
+    auto Task = std::make_unique<LoadTask>();
+    LoadTask& TaskRef = *Task;
+    TaskRef.Thread = std::jthread([this, &TaskRef, LoadGeneration, Config = std::move(Config), Callback = std::move(Callback)](std::stop_token StopToken) mutable
+    {
+        LoadSchema(StopToken, TaskRef.Connection, LoadGeneration, std::move(Config), std::move(Callback));
+        TaskRef.IsFinished.store(true, std::memory_order_release);
+    });
+    Loaders.push_back(std::move(Task));
+}
+
+auto AutocompleteEngine::StopLoading() -> void
+{
+    Generation.fetch_add(1, std::memory_order_relaxed);
+    for (const auto& Task : Loaders)
+        Task->Thread.request_stop();
+}
+
+auto AutocompleteEngine::LoadSchema(std::stop_token StopToken, MySQLWrapper& Connection, uint64_t LoadGeneration, MySQLConfig Config, LoadCallback Callback) -> void
+{
+    const auto StartTime = std::chrono::steady_clock::now();
+    if (StopToken.stop_requested())
+        return;
+    std::expected<SchemaSnapshot, std::string> Snapshot;
+    if (auto Connected = Connection.ConnectExpected(Config); Connected)
+        Snapshot = LoadSchemaSnapshot(Connection, StopToken);
+    else
+        Snapshot = std::unexpected(std::move(Connected.error()));
+    Connection.Disconnect();
+    if (StopToken.stop_requested())
+        return;
+    SchemaLoadResult Result;
+    if (Snapshot)
+    {
+        if (!PublishIfCurrent(*Snapshot, LoadGeneration))
+            return;
+        Result.TableCount = Snapshot->Tables.size();
+        for (const auto& Columns : Snapshot->Columns)
+            Result.ColumnCount += Columns.size();
+    }
+    else
+    {
+        // 已作废的加载不报告错误
+        if (Generation.load(std::memory_order_relaxed) != LoadGeneration)
+            return;
+        Result.ErrorMessage = std::move(Snapshot.error());
+    }
+    Result.Elapsed = std::chrono::steady_clock::now() - StartTime;
+    if (Callback)
+        Callback(Result);
+}
+
+auto AutocompleteEngine::Publish(const SchemaSnapshot& Snapshot) -> void
+{
+    auto Built = std::make_shared<const CompletionIndex>(CompletionIndex::Build(Snapshot, GetSqlKeywords()));
+    std::lock_guard<std::mutex> Lock(IndexMutex);
+    Index.swap(Built);
+}
+
+auto AutocompleteEngine::PublishIfCurrent(const SchemaSnapshot& Snapshot, uint64_t LoadGeneration) -> bool
+{
+    auto Built = std::make_shared<const CompletionIndex>(CompletionIndex::Build(Snapshot, GetSqlKeywords()));
+    // 在锁内比较代号：Reset 先递增代号再替换索引，作废的加载不会覆盖之后的索引
+    std::lock_guard<std::mutex> Lock(IndexMutex);
+    if (Generation.load(std::memory_order_relaxed) != LoadGeneration)
+        return false;
+    Index.swap(Built);
+    return true;
+}
+
+auto AutocompleteEngine::Reset() -> void
+{
+    StopLoading();
+    Publish({});
+}
+
+auto AutocompleteEngine::GetIndex() -> std::shared_ptr<const CompletionIndex>
+{
+    std::shared_ptr<const CompletionIndex> Current;
+    {
+        std::lock_guard<std::mutex> Lock(IndexMutex);
+        Current = Index;
+    }
+    if (Current == UsageIndex) [[likely]]
+        return Current;
+    UsageById.assign(Current->GetSize(), 0);
+    for (const auto& [Folded, Count] : UsageByName)
+    {
+        const auto [First, Last] = Current->FindPrefix(Folded);
+        for (uint32_t Id = First; Id < Last && Current->GetFoldedText(Id).size() == Folded.size(); ++Id)
+            UsageById[Id] = Count;
+    }
+    UsageIndex = Current;
+    return Current;
+}
+
+auto AutocompleteEngine::Complete(std::string_view Prefix, std::string_view Qualifier) -> std::vector<CompletionCandidate>
+{
+    const auto Current = GetIndex();
+    const std::size_t Limit = Options.MaxCandidates;
+    if (Limit == 0) [[unlikely]]
+        return {};
+    const std::string Folded = FoldCompletionText(Prefix);
+    // 排序所需的字段都放在候选内，比较时不再访问索引
+    struct Match
+    {
+        uint32_t Id = 0;
+        uint32_t Usage = 0;
+        uint16_t Length = 0;
+        CompletionKind Kind = CompletionKind::Keyword;
+        bool IsFuzzy = false;
+    };
+    const auto IsBetter = [](const Match& Left, const Match& Right)
+    {
+        if (Left.IsFuzzy != Right.IsFuzzy)
+            return !Left.IsFuzzy;
+        if (Left.Usage != Right.Usage)
+            return Left.Usage > Right.Usage;
+        if (Left.Length != Right.Length)
+            return Left.Length < Right.Length;
+        if (Left.Kind != Right.Kind)
+            return Left.Kind < Right.Kind;
+        return Left.Id < Right.Id;
+    };
+    // 以 IsBetter 为序的堆，堆顶是已选出的候选中最差的一个；只保留 Limit 个
+    std::vector<Match> Selected;
+    Selected.reserve(Limit);
+    const auto Offer = [&](uint32_t Id, bool IsFuzzy)
+    {
+        const Match Candidate{ Id, UsageById[Id], static_cast<uint16_t>(Current->GetText(Id).size()), Current->GetKind(Id), IsFuzzy };
+        if (Selected.size() < Limit)
+        {
+            Selected.push_back(Candidate);
+            std::ranges::push_heap(Selected, IsBetter);
+            return;
+        }
+        if (!IsBetter(Candidate, Selected.front()))
+            return;
+        std::ranges::pop_heap(Selected, IsBetter);
+        Selected.back() = Candidate;
+        std::ranges::push_heap(Selected, IsBetter);
+    };
+
+    const uint32_t TableId = Qualifier.empty() ? Current->GetSize() : Current->FindName(Qualifier, CompletionKind::Table);
+    if (TableId < Current->GetSize())
+    {
+        for (const uint32_t Id : Current->GetTableColumns(TableId))
+        {
+            const std::string_view Name = Current->GetFoldedText(Id);
+            if (Name.starts_with(Folded))
+                Offer(Id, false);
+            else if (IsFuzzyMatch(Folded, Name))
+                Offer(Id, true);
+        }
+    }
+    else
+    {
+        // 限定名不是已知的表（如别名）时在全部列中查找
+        const bool IsColumnOnly = !Qualifier.empty();
+        const auto Accepts = [&Current, IsColumnOnly](uint32_t Id) { return !IsColumnOnly || Current->GetKind(Id) == CompletionKind::Column; };
+        const auto [First, Last] = Current->FindPrefix(Folded);
+        for (uint32_t Id = First; Id < Last; ++Id)
+        {
+            if (Accepts(Id))
+                Offer(Id, false);
+        }
+        // 前缀匹配不足时，在首字符相同的条目中补充子序列匹配
+        if (Folded.size() >= 2 && Selected.size() < Limit)
+        {
+            const auto [ScanFirst, ScanLast] = Current->FindPrefix(std::string_view{ Folded }.substr(0, 1));
+            const uint32_t ScanEnd = static_cast<uint32_t>((std::min)(std::size_t{ ScanLast }, ScanFirst + Options.MaxFuzzyScan));
+            for (uint32_t Id = ScanFirst; Id < ScanEnd; ++Id)
+            {
+                if (Id == First && First < Last)
+                {
+                    Id = Last - 1;
+                    continue;
+                }
+                if (Accepts(Id) && IsFuzzyMatch(Folded, Current->GetFoldedText(Id)))
+                    Offer(Id, true);
+            }
+        }
+    }
+
+    std::ranges::sort_heap(Selected, IsBetter);
+    std::vector<CompletionCandidate> Candidates;
+    Candidates.reserve(Selected.size());
+    for (const auto& [Id, Usage, Length, Kind, IsFuzzy] : Selected)
+        Candidates.push_back({ std::string(Current->GetText(Id)), Kind, IsFuzzy, Usage });
+    return Candidates;
+}
+
+auto AutocompleteEngine::RecordUsage(std::string_view Text) -> void
+{
+    const auto Current = GetIndex();
+    std::string Folded = FoldCompletionText(Text);
+    const auto [First, Last] = Current->FindPrefix(Folded);
+    const uint32_t Count = ++UsageByName[std::move(Folded)];
+    for (uint32_t Id = First; Id < Last && Current->GetText(Id).size() == Text.size(); ++Id)
+        UsageById[Id] = Count;
+}
+
+auto LoadSchemaSnapshot(MySQLWrapper& Connection, std::stop_token StopToken) -> std::expected<SchemaSnapshot, std::string>
+{
+    SchemaSnapshot Snapshot;
+    const MySQLResult Columns = Connection.Query("SELECT TABLE_NAME, COLUMN_NAME FROM information_schema.COLUMNS WHERE TABLE_SCHEMA = DATABASE() ORDER BY TABLE_NAME, ORDINAL_POSITION");
+    if (Columns.Success) [[likely]]
+    {
+        for (const auto& RowData : Columns.Rows)
+        {
+            if (RowData.Size() < 2) [[unlikely]]
+                continue;
+            if (Snapshot.Tables.empty() || Snapshot.Tables.back() != RowData.Fields[0])
+            {
+                Snapshot.Tables.push_back(RowData.Fields[0]);
+                Snapshot.Columns.emplace_back();
+            }
+            Snapshot.Columns.back().push_back(RowData.Fields[1]);
+        }
+        return Snapshot;
+    }
+    if (StopToken.stop_requested())
+        return std::unexpected(Columns.ErrorMessage);
+    auto Tables = Connection.GetTables();
+    if (!Tables) [[unlikely]]
+        return std::unexpected(std::move(Tables.error()));
+    Snapshot.Tables = std::move(*Tables);
+    Snapshot.Columns.resize(Snapshot.Tables.size());
+    for (std::size_t Table = 0; Table < Snapshot.Tables.size() && !StopToken.stop_requested(); ++Table)
+    {
+        const auto Structure = Connection.GetTableStructure(Snapshot.Tables[Table]);
+        if (!Structure) [[unlikely]]
+            continue;
+        for (const auto& RowData : Structure->Rows)
+        {
+            if (!RowData.Fields.empty())
+                Snapshot.Columns[Table].push_back(RowData.Fields[0]);
+        }
+    }
+    return Snapshot;
+}
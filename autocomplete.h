@@ -0,0 +1,190 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class CompletionKind : uint8_t
+{
+    Keyword,
+    Table,
+    Column
+};
+
+// 当前库的表与列，由加载线程从服务器取出
+struct SchemaSnapshot
+{
+    std::vector<std::string> Tables;
+    // 与 Tables 一一对应
+    std::vector<std::vector<std::string>> Columns;
+};
+
+struct CompletionCandidate
+{
+    std::string Text;
+    CompletionKind Kind = CompletionKind::Keyword;
+    // 子序列匹配而非前缀匹配
+    bool IsFuzzy = false;
+    uint32_t Usage = 0;
+};
+
+// 不可变的名称索引。名称按 (种类, 原文) 去重后按 ASCII 大小写折叠的顺序排列，原文与折叠后的文本各存放在一个连续的字符串池中，
+// 每个名称只占一个 8 字节的条目；前缀查找是两次二分，得到的是一段连续的条目。每张表另有按同样顺序排列的列条目下标，供 "表名." 之后补全。
+class CompletionIndex
+{
+public:
+    // MySQL 标识符最长 64 个字符，超过此长度的名称不收录
+    static constexpr std::size_t MaxNameBytes = 255;
+private:
+    struct Entry
+    {
+        uint32_t Offset = 0;
+        uint8_t Length = 0;
+        CompletionKind Kind = CompletionKind::Keyword;
+    };
+    std::string Pool;
+    std::string FoldedPool;
+    std::vector<Entry> Entries;
+    // 按表条目下标排序；列下标为 TableColumns 中 [Begin, End) 一段
+    struct TableRange
+    {
+        uint32_t TableId = 0;
+        uint32_t Begin = 0;
+        uint32_t End = 0;
+    };
+    std::vector<TableRange> Tables;
+    std::vector<uint32_t> TableColumns;
+    std::size_t ColumnCount = 0;
+public:
+    [[nodiscard]] static auto Build(const SchemaSnapshot& Snapshot, std::span<const std::string_view> Keywords) -> CompletionIndex;
+    // 折叠后以 FoldedPrefix 开头的条目为 [first, second)
+    [[nodiscard]] auto FindPrefix(std::string_view FoldedPrefix) const noexcept -> std::pair<uint32_t, uint32_t>;
+    // 不区分大小写地查找指定种类的名称，找不到时返回 GetSize()
+    [[nodiscard]] auto FindName(std::string_view Name, CompletionKind Kind) const -> uint32_t;
+    // 表的列条目下标，按折叠顺序排列；表不存在时为空
+    [[nodiscard]] auto GetTableColumns(uint32_t TableId) const noexcept -> std::span<const uint32_t>;
+    [[nodiscard]] auto GetText(uint32_t Id) const noexcept -> std::string_view
+    {
+        return { Pool.data() + Entries[Id].Offset, Entries[Id].Length };
+    }
+    [[nodiscard]] auto GetFoldedText(uint32_t Id) const noexcept -> std::string_view
+    {
+        return { FoldedPool.data() + Entries[Id].Offset, Entries[Id].Length };
+    }
+    [[nodiscard]] auto GetKind(uint32_t Id) const noexcept -> CompletionKind
+    {
+        return Entries[Id].Kind;
+    }
+    [[nodiscard]] auto GetSize() const noexcept -> uint32_t
+    {
+        return static_cast<uint32_t>(Entries.size());
+    }
+    [[nodiscard]] auto GetTableCount() const noexcept -> std::size_t
+    {
+        return Tables.size();
+    }
+    // 各表列数之和（去重前）
+    [[nodiscard]] auto GetColumnCount() const noexcept -> std::size_t
+    {
+        return ColumnCount;
+    }
+};
+
+// ASCII 字母转为小写，其余字节不变
+[[nodiscard]] auto FoldCompletionText(std::string_view Text) -> std::string;
+
+// 光标前正在输入的标识符：[Start, Caret) 为前缀，紧挨在 '.' 之前的标识符为限定的表名（反引号已去除）
+struct CompletionWord
+{
+    std::size_t Start = 0;
+    std::u16string_view Prefix;
+    std::u16string_view Qualifier;
+};
+
+[[nodiscard]] auto FindCompletionWord(std::u16string_view Text, std::size_t Caret) noexcept -> CompletionWord;
+
+// 插入输入框的文本：不是普通标识符的名称加上反引号
+[[nodiscard]] auto QuoteCompletionText(std::string_view Text, CompletionKind Kind) -> std::string;
+
+struct AutocompleteOptions
+{
+    std::size_t MaxCandidates = 50;
+    // 模糊匹配最多检查的条目数，保证大型库上的单次查找时间有界
+    std::size_t MaxFuzzyScan = 65536;
+};
+
+struct SchemaLoadResult
+{
+    std::size_t TableCount = 0;
+    std::size_t ColumnCount = 0;
+    std::chrono::nanoseconds Elapsed{ 0 };
+    std::string ErrorMessage;
+};
+
+// 输入框的自动补全。库结构在独立连接上由后台线程加载并建好索引，建好后整体替换当前索引；
+// 界面线程查找时只在锁内复制一次 shared_ptr，加载期间仍使用旧索引（初始只含关键字），不会等待。
+// 每次加载带一个代号，重新加载或 Reset 后旧加载只被通知停止，界面线程不等待它退出，它的结果按代号丢弃；
+// 中断查询与等待线程退出只在析构时进行。
+// 候选按 精确前缀、使用次数、长度、种类、字典序 排序；使用次数按折叠后的名称记录，重新加载后仍然有效。
+// Complete 与 RecordUsage 只应在界面线程调用。
+class AutocompleteEngine
+{
+public:
+    // 回调在加载线程上执行
+    using LoadCallback = std::function<void(const SchemaLoadResult&)>;
+private:
+    AutocompleteOptions Options;
+    mutable std::mutex IndexMutex;
+    std::shared_ptr<const CompletionIndex> Index;
+    // 以下只在界面线程访问：UsageById 与 UsageIndex 对应，索引替换后按 UsageByName 重建
+    std::shared_ptr<const CompletionIndex> UsageIndex;
+    std::vector<uint32_t> UsageById;
+    std::unordered_map<std::string, uint32_t> UsageByName;
+    // 每次加载使用自己的连接，旧加载收尾时不影响新加载
+    struct LoadTask
+    {
+        MySQLWrapper Connection;
+        std::atomic<bool> IsFinished{ false };
+        std::jthread Thread;
+    };
+    // 只在界面线程访问
+    std::vector<std::unique_ptr<LoadTask>> Loaders;
+    std::atomic<uint64_t> Generation{ 0 };
+    auto LoadSchema(std::stop_token StopToken, MySQLWrapper& Connection, uint64_t LoadGeneration, MySQLConfig Config, LoadCallback Callback) -> void;
+    // 只有代号仍是最新时才替换索引
+    [[nodiscard]] auto PublishIfCurrent(const SchemaSnapshot& Snapshot, uint64_t LoadGeneration) -> bool;
+    // 取当前索引，索引已被替换时重建 UsageById
+    auto GetIndex() -> std::shared_ptr<const CompletionIndex>;
+public:
+    explicit AutocompleteEngine(AutocompleteOptions OptionsParam = {});
+    ~AutocompleteEngine();
+    AutocompleteEngine(const AutocompleteEngine&) = delete;
+    auto operator=(const AutocompleteEngine&) -> AutocompleteEngine & = delete;
+    // 作废尚未完成的加载后重新开始
+    auto LoadAsync(MySQLConfig Config, LoadCallback Callback) -> void;
+    // 作废并通知停止所有加载，不等待，也不中断正在执行的查询
+    auto StopLoading() -> void;
+    // 以快照建立索引并替换当前索引，可在任意线程调用
+    auto Publish(const SchemaSnapshot& Snapshot) -> void;
+    // 取消加载并退回只含关键字的索引
+    auto Reset() -> void;
+    // Qualifier 非空且是已知的表名时只返回该表的列
+    [[nodiscard]] auto Complete(std::string_view Prefix, std::string_view Qualifier = {}) -> std::vector<CompletionCandidate>;
+    auto RecordUsage(std::string_view Text) -> void;
+};
+
+// 一次查询 information_schema 取出当前库的全部列；不可用时退回 SHOW TABLES 与逐表 DESCRIBE
+[[nodiscard]] auto LoadSchemaSnapshot(MySQLWrapper& Connection, std::stop_token StopToken = {}) -> std::expected<SchemaSnapshot, std::string>;
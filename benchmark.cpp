@@ -0,0 +1,519 @@
+#include "def.h"
+#include "autocomplete.h"
+#include "database.h"
+#include "formatter.hpp"
+#include "outputlog.h"
+#include "sqllexer.h"
+#include "sqlscript.hpp"
+#include "transcode.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AllocationCounter
+{
+    inline std::atomic<uint64_t> Count{ 0 };
+    inline std::atomic<uint64_t> Bytes{ 0 };
+
+    [[nodiscard]] inline auto Allocate(std::size_t Size) -> void*
+    {
+        Count.fetch_add(1, std::memory_order_relaxed);
+        Bytes.fetch_add(Size, std::memory_order_relaxed);
+        if (void* Pointer = std::malloc(Size == 0 ? 1 : Size)) [[likely]]
+            return Pointer;
+        throw std::bad_alloc();
+    }
+}
+
+auto operator new(std::size_t Size) -> void* { return AllocationCounter::Allocate(Size); }
+auto operator new[](std::size_t Size) -> void* { return AllocationCounter::Allocate(Size); }
+auto operator delete(void* Pointer) noexcept -> void { std::free(Pointer); }
+auto operator delete[](void* Pointer) noexcept -> void { std::free(Pointer); }
+auto operator delete(void* Pointer, std::size_t) noexcept -> void { std::free(Pointer); }
+auto operator delete[](void* Pointer, std::size_t) noexcept -> void { std::free(Pointer); }
+
+namespace Benchmark
+{
+    template<typename T>
+    inline auto DoNotOptimize(const T& Value) -> void
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(Value) : "memory");
+#else
+        static const void* volatile Sink;
+        Sink = &Value;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    struct Options
+    {
+        std::string Filter;
+        std::string OutputFormat = "table";
+        std::string OutputPath;
+        std::chrono::milliseconds MinTime{ 200 };
+        std::size_t Repetitions = 5;
+        std::size_t Scale = 1;
+    };
+
+    struct Case
+    {
+        std::string Name;
+        std::size_t BytesPerOperation = 0;
+        std::function<void()> Body;
+    };
+
+    struct Result
+    {
+        std::string Name;
+        uint64_t Iterations = 0;
+        double NanosecondsPerOperation = 0.0;
+        double MinNanosecondsPerOperation = 0.0;
+        double BytesPerSecond = 0.0;
+        double AllocationsPerOperation = 0.0;
+        double AllocatedBytesPerOperation = 0.0;
+    };
+
+    // 固定种子，保证不同版本之间的语料完全一致，结果可直接比较
+    class CorpusGenerator
+    {
+    private:
+        std::mt19937_64 Engine{ 20240521 };
+        static constexpr std::array<std::string_view, 12> ChineseWords =
+        {
+            "数据库", "连接池", "事务", "索引", "查询优化", "用户", "订单", "库存", "支付", "日志", "备份", "复制"
+        };
+        static constexpr std::array<std::string_view, 8> EnglishWords =
+        {
+            "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"
+        };
+    public:
+        [[nodiscard]] auto Next(uint64_t Bound) -> uint64_t
+        {
+            return std::uniform_int_distribution<uint64_t>(0, Bound - 1)(Engine);
+        }
+        [[nodiscard]] auto Chinese(std::size_t WordCount) -> std::string
+        {
+            std::string Text;
+            for (std::size_t Index = 0; Index < WordCount; ++Index)
+                Text += ChineseWords[Next(ChineseWords.size())];
+            return Text;
+        }
+        [[nodiscard]] auto English(std::size_t WordCount) -> std::string
+        {
+            std::string Text;
+            for (std::size_t Index = 0; Index < WordCount; ++Index)
+            {
+                if (Index > 0)
+                    Text += ' ';
+                Text += EnglishWords[Next(EnglishWords.size())];
+            }
+            return Text;
+        }
+        // 表名各不相同，列名由两个单词和一个编号组成，不同表之间有重名
+        [[nodiscard]] auto Schema(std::size_t TableCount, std::size_t ColumnsPerTable) -> SchemaSnapshot
+        {
+            SchemaSnapshot Snapshot;
+            for (std::size_t Table = 0; Table < TableCount; ++Table)
+            {
+                Snapshot.Tables.push_back(std::format("{}_{}", EnglishWords[Next(EnglishWords.size())], Table));
+                auto& Columns = Snapshot.Columns.emplace_back();
+                for (std::size_t Column = 0; Column < ColumnsPerTable; ++Column)
+                    Columns.push_back(std::format("{}_{}_{}", EnglishWords[Next(EnglishWords.size())], EnglishWords[Next(EnglishWords.size())], Next(1000)));
+            }
+            return Snapshot;
+        }
+        [[nodiscard]] auto Decimal() -> std::string
+        {
+            return std::format("{}.{:02}", Next(100000), Next(100));
+        }
+        [[nodiscard]] auto OltpStatement() -> std::string
+        {
+            switch (Next(6))
+            {
+            case 0: return std::format("SELECT id, name, balance FROM accounts WHERE id = {};", Next(1000000));
+            case 1: return std::format("UPDATE accounts SET balance = balance - {}, note = 'transfer #{}' WHERE id = {};", Decimal(), Next(10000), Next(1000000));
+            case 2: return std::format("INSERT INTO orders (user_id, sku, qty, memo) VALUES ({}, 'SKU-{}', {}, 'it\\'s {}');", Next(100000), Next(100000), Next(10) + 1, English(3));
+            case 3: return std::format("-- 会话清理\nDELETE FROM sessions WHERE expires_at < '2024-{:02}-{:02} 00:00:00';", Next(12) + 1, Next(28) + 1);
+            case 4: return std::format("/* 报表 */ SELECT o.id, u.name FROM orders o JOIN users u ON u.id = o.user_id WHERE o.status IN ({}, {}, {}) LIMIT 50;", Next(5), Next(5), Next(5));
+            default: return std::format("SELECT COUNT(*) FROM events WHERE type = \"{}\" AND created_at > NOW() - INTERVAL {} DAY;", English(1), Next(30) + 1);
+            }
+        }
+        [[nodiscard]] auto OltpScript(std::size_t StatementCount) -> std::string
+        {
+            std::string Script;
+            for (std::size_t Index = 0; Index < StatementCount; ++Index)
+            {
+                Script += OltpStatement();
+                Script += '\n';
+            }
+            return Script;
+        }
+        [[nodiscard]] auto DumpScript(std::size_t StatementCount, std::size_t RowsPerStatement) -> std::string
+        {
+            std::string Script = "# 导出自 benchmark\n/*!40101 SET NAMES utf8mb4 */;\n";
+            for (std::size_t StatementIndex = 0; StatementIndex < StatementCount; ++StatementIndex)
+            {
+                Script += "INSERT INTO `articles` VALUES ";
+                for (std::size_t RowIndex = 0; RowIndex < RowsPerStatement; ++RowIndex)
+                {
+                    if (RowIndex > 0)
+                        Script += ',';
+                    Script += std::format("({},'{}','{}\\n{}；“引号”',{})", StatementIndex * RowsPerStatement + RowIndex, Chinese(3), Chinese(20), SQLSanitizer::EscapeString(English(4) + " 'quoted' "), Decimal());
+                }
+                Script += ";\n";
+            }
+            return Script;
+        }
+        [[nodiscard]] auto WideResult(std::size_t RowCount, std::size_t ColumnCount) -> MySQLResult
+        {
+            MySQLResult ResultData;
+            ResultData.Success = true;
+            for (std::size_t Index = 0; Index < ColumnCount; ++Index)
+                ResultData.ColumnNames.push_back(std::format("column_{}", Index));
+            ResultData.Rows.reserve(RowCount);
+            for (std::size_t RowIndex = 0; RowIndex < RowCount; ++RowIndex)
+            {
+                MySQLRow RowData;
+                for (std::size_t Index = 0; Index < ColumnCount; ++Index)
+                {
+                    switch (Index % 5)
+                    {
+                    case 0: RowData.Fields.push_back(std::to_string(RowIndex)); break;
+                    case 1: RowData.Fields.push_back(Chinese(Next(4) + 1)); break;
+                    case 2: RowData.Fields.push_back(Decimal()); break;
+                    case 3: RowData.Fields.push_back(Next(10) == 0 ? "NULL" : English(Next(3) + 1)); break;
+                    default: RowData.Fields.push_back(std::format("2024-{:02}-{:02} {:02}:{:02}:{:02}", Next(12) + 1, Next(28) + 1, Next(24), Next(60), Next(60))); break;
+                    }
+                }
+                ResultData.Rows.push_back(std::move(RowData));
+            }
+            ResultData.AffectedRows = ResultData.Rows.size();
+            return ResultData;
+        }
+    };
+
+    // 与 sql::ResultSet 相同的 next/isNull/getString 接口，单元格预先生成，只测物化本身的开销
+    class SyntheticResultSet
+    {
+    private:
+        const MySQLResult& Source;
+        std::size_t Position = 0;
+    public:
+        explicit SyntheticResultSet(const MySQLResult& SourceData) : Source(SourceData) {}
+        [[nodiscard]] auto next() noexcept -> bool
+        {
+            return ++Position <= Source.Rows.size();
+        }
+        [[nodiscard]] auto isNull(int Index) const noexcept -> bool
+        {
+            return Source.Rows[Position - 1].Fields[static_cast<std::size_t>(Index - 1)] == "NULL";
+        }
+        [[nodiscard]] auto getString(int Index) const -> const std::string&
+        {
+            return Source.Rows[Position - 1].Fields[static_cast<std::size_t>(Index - 1)];
+        }
+    };
+
+    [[nodiscard]] auto ResultBytes(const MySQLResult& ResultData) -> std::size_t
+    {
+        std::size_t TotalBytes = 0;
+        for (const auto& RowData : ResultData.Rows)
+        {
+            for (const auto& FieldValue : RowData.Fields)
+                TotalBytes += FieldValue.size();
+        }
+        return TotalBytes;
+    }
+
+    [[nodiscard]] auto Run(const Case& BenchmarkCase, const Options& RunOptions) -> Result
+    {
+        using Clock = std::chrono::steady_clock;
+        BenchmarkCase.Body();
+        uint64_t Iterations = 1;
+        while (true)
+        {
+            const auto StartTime = Clock::now();
+            for (uint64_t Index = 0; Index < Iterations; ++Index)
+                BenchmarkCase.Body();
+            const auto Elapsed = Clock::now() - StartTime;
+            if (Elapsed >= RunOptions.MinTime / 10 || Iterations >= (uint64_t{ 1 } << 40))
+            {
+                const double Ratio = std::chrono::duration<double>(RunOptions.MinTime) / std::chrono::duration<double>((std::max)(Elapsed, Clock::duration{ 1 }));
+                Iterations = (std::max)(uint64_t{ 1 }, static_cast<uint64_t>(static_cast<double>(Iterations) * Ratio));
+                break;
+            }
+            Iterations *= 2;
+        }
+        std::vector<double> Samples;
+        Samples.reserve(RunOptions.Repetitions);
+        const uint64_t AllocationsBefore = AllocationCounter::Count.load(std::memory_order_relaxed);
+        const uint64_t BytesBefore = AllocationCounter::Bytes.load(std::memory_order_relaxed);
+        for (std::size_t Repetition = 0; Repetition < RunOptions.Repetitions; ++Repetition)
+        {
+            const auto StartTime = Clock::now();
+            for (uint64_t Index = 0; Index < Iterations; ++Index)
+                BenchmarkCase.Body();
+            const auto Elapsed = std::chrono::duration<double, std::nano>(Clock::now() - StartTime);
+            Samples.push_back(Elapsed.count() / static_cast<double>(Iterations));
+        }
+        const double TotalOperations = static_cast<double>(Iterations * RunOptions.Repetitions);
+        Result ResultData;
+        ResultData.Name = BenchmarkCase.Name;
+        ResultData.Iterations = Iterations;
+        ResultData.AllocationsPerOperation = static_cast<double>(AllocationCounter::Count.load(std::memory_order_relaxed) - AllocationsBefore) / TotalOperations;
+        ResultData.AllocatedBytesPerOperation = static_cast<double>(AllocationCounter::Bytes.load(std::memory_order_relaxed) - BytesBefore) / TotalOperations;
+        std::ranges::sort(Samples);
+        ResultData.NanosecondsPerOperation = Samples[Samples.size() / 2];
+        ResultData.MinNanosecondsPerOperation = Samples.front();
+        if (BenchmarkCase.BytesPerOperation > 0 && ResultData.NanosecondsPerOperation > 0.0)
+            ResultData.BytesPerSecond = static_cast<double>(BenchmarkCase.BytesPerOperation) * 1e9 / ResultData.NanosecondsPerOperation;
+        return ResultData;
+    }
+
+    auto WriteTable(std::FILE* Output, const std::vector<Result>& Results) -> void
+    {
+        std::println(Output, "{:<40} {:>14} {:>14} {:>12} {:>12} {:>14}", "benchmark", "ns/op", "min ns/op", "MB/s", "allocs/op", "alloc B/op");
+        for (const auto& ResultData : Results)
+        {
+            std::println(Output, "{:<40} {:>14.1f} {:>14.1f} {:>12.2f} {:>12.2f} {:>14.1f}", ResultData.Name, ResultData.NanosecondsPerOperation, ResultData.MinNanosecondsPerOperation,
+                ResultData.BytesPerSecond / 1e6, ResultData.AllocationsPerOperation, ResultData.AllocatedBytesPerOperation);
+        }
+    }
+
+    auto WriteCsv(std::FILE* Output, const std::vector<Result>& Results) -> void
+    {
+        std::println(Output, "name,iterations,ns_per_op,min_ns_per_op,bytes_per_second,allocs_per_op,alloc_bytes_per_op");
+        for (const auto& ResultData : Results)
+        {
+            std::println(Output, "{},{},{:.3f},{:.3f},{:.1f},{:.3f},{:.1f}", ResultData.Name, ResultData.Iterations, ResultData.NanosecondsPerOperation, ResultData.MinNanosecondsPerOperation,
+                ResultData.BytesPerSecond, ResultData.AllocationsPerOperation, ResultData.AllocatedBytesPerOperation);
+        }
+    }
+
+    auto WriteJson(std::FILE* Output, const std::vector<Result>& Results, const Options& RunOptions) -> void
+    {
+#ifdef NDEBUG
+        constexpr std::string_view BuildType = "release";
+#else
+        constexpr std::string_view BuildType = "debug";
+#endif
+        const auto Timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        std::println(Output, "{{");
+        std::println(Output, "  \"context\": {{ \"timestamp\": {}, \"build\": \"{}\", \"scale\": {}, \"min_time_ms\": {}, \"repetitions\": {} }},", Timestamp, BuildType, RunOptions.Scale, RunOptions.MinTime.count(), RunOptions.Repetitions);
+        std::println(Output, "  \"benchmarks\": [");
+        for (std::size_t Index = 0; Index < Results.size(); ++Index)
+        {
+            const auto& ResultData = Results[Index];
+            std::println(Output, "    {{ \"name\": \"{}\", \"iterations\": {}, \"ns_per_op\": {:.3f}, \"min_ns_per_op\": {:.3f}, \"bytes_per_second\": {:.1f}, \"allocs_per_op\": {:.3f}, \"alloc_bytes_per_op\": {:.1f} }}{}",
+                ResultData.Name, ResultData.Iterations, ResultData.NanosecondsPerOperation, ResultData.MinNanosecondsPerOperation, ResultData.BytesPerSecond,
+                ResultData.AllocationsPerOperation, ResultData.AllocatedBytesPerOperation, Index + 1 < Results.size() ? "," : "");
+        }
+        std::println(Output, "  ]");
+        std::println(Output, "}}");
+    }
+
+    [[nodiscard]] auto ParseOptions(int ArgumentCount, char** Arguments) -> std::expected<Options, std::string>
+    {
+        Options RunOptions;
+        const auto ParseNumber = [](std::string_view Text, std::string_view OptionName) -> std::expected<std::size_t, std::string>
+        {
+            std::size_t Value = 0;
+            const auto [Pointer, ErrorCode] = std::from_chars(Text.data(), Text.data() + Text.size(), Value);
+            if (ErrorCode != std::errc{} || Pointer != Text.data() + Text.size() || Value == 0)
+                return std::unexpected(std::format("无效的 {} 参数: {}", OptionName, Text));
+            return Value;
+        };
+        for (int Index = 1; Index < ArgumentCount; ++Index)
+        {
+            const std::string_view Argument = Arguments[Index];
+            const auto Separator = Argument.find('=');
+            const std::string_view Name = Argument.substr(0, Separator);
+            const std::string_view Value = Separator == std::string_view::npos ? std::string_view{} : Argument.substr(Separator + 1);
+            if (Name == "--filter")
+                RunOptions.Filter = Value;
+            else if (Name == "--format")
+            {
+                if (Value != "table" && Value != "json" && Value != "csv")
+                    return std::unexpected(std::format("不支持的输出格式: {}", Value));
+                RunOptions.OutputFormat = Value;
+            }
+            else if (Name == "--output")
+                RunOptions.OutputPath = Value;
+            else if (Name == "--min-time")
+            {
+                const auto Number = ParseNumber(Value, Name);
+                if (!Number)
+                    return std::unexpected(Number.error());
+                RunOptions.MinTime = std::chrono::milliseconds(*Number);
+            }
+            else if (Name == "--repetitions")
+            {
+                const auto Number = ParseNumber(Value, Name);
+                if (!Number)
+                    return std::unexpected(Number.error());
+                RunOptions.Repetitions = *Number;
+            }
+            else if (Name == "--scale")
+            {
+                const auto Number = ParseNumber(Value, Name);
+                if (!Number)
+                    return std::unexpected(Number.error());
+                RunOptions.Scale = *Number;
+            }
+            else
+                return std::unexpected(std::format("未知参数: {}\n用法: benchmark [--filter=子串] [--format=table|json|csv] [--output=文件] [--min-time=毫秒] [--repetitions=N] [--scale=N]", Argument));
+        }
+        return RunOptions;
+    }
+}
+
+auto main(int ArgumentCount, char** Arguments) -> int
+{
+    using namespace Benchmark;
+    const auto ParsedOptions = ParseOptions(ArgumentCount, Arguments);
+    if (!ParsedOptions)
+    {
+        std::println(stderr, "{}", ParsedOptions.error());
+        return 2;
+    }
+    const Options& RunOptions = *ParsedOptions;
+    EventLogger::Instance().SetMinLevel(EventLevel::Off);
+
+    CorpusGenerator Generator;
+    const std::string OltpScript = Generator.OltpScript(2000 * RunOptions.Scale);
+    const std::string DumpScript = Generator.DumpScript(20 * RunOptions.Scale, 100);
+    std::vector<std::string> OltpStatements;
+    for (std::size_t Index = 0; Index < 256; ++Index)
+        OltpStatements.push_back(Generator.OltpStatement());
+    std::size_t OltpStatementBytes = 0;
+    for (const auto& Statement : OltpStatements)
+        OltpStatementBytes += Statement.size();
+    std::vector<std::string> EscapeInputs;
+    for (std::size_t Index = 0; Index < 256; ++Index)
+        EscapeInputs.push_back(Generator.Chinese(4) + "'" + Generator.English(2) + "\"\\\n" + Generator.Chinese(2));
+    std::size_t EscapeInputBytes = 0;
+    for (const auto& Input : EscapeInputs)
+        EscapeInputBytes += Input.size();
+    const std::vector<std::string> ParameterList = { Generator.English(2), Generator.Chinese(6), "O'Reilly", Generator.Decimal(), "line1\nline2" };
+    constexpr std::string_view ParameterTemplate = "INSERT INTO customers (name, address, company, credit, notes) VALUES (?, ?, ?, ?, ?)";
+    const MySQLResult NarrowResult = Generator.WideResult(100 * RunOptions.Scale, 5);
+    const MySQLResult WideResult = Generator.WideResult(1000 * RunOptions.Scale, 40);
+    MySQLRow ValueRow;
+    ValueRow.Fields = { "123456", "98765.4321", "9007199254740993", "NULL", Generator.Chinese(5), "true" };
+    std::vector<std::string> LogMessages;
+    for (std::size_t Index = 0; Index < 1024; ++Index)
+        LogMessages.push_back(std::format("[2026-01-01 12:00:00.000]\r\n返回 {} 行 {} 列\r\n{} {}", Index, Index % 7 + 1, Generator.Chinese(8), Generator.English(6)));
+    const std::u16string DumpScriptUtf16 = Utf8ToUtf16(DumpScript);
+    IncrementalSqlLexer EditedLexer;
+    EditedLexer.SetText(DumpScriptUtf16);
+    const std::size_t EditOffset = DumpScriptUtf16.rfind(u'\n', DumpScriptUtf16.size() / 2) + 1;
+    std::size_t LogMessageBytes = 0;
+    for (const auto& Message : LogMessages)
+        LogMessageBytes += Message.size();
+    const SchemaSnapshot Schema = Generator.Schema(2000 * RunOptions.Scale, 60);
+    AutocompleteEngine Completion;
+    Completion.Publish(Schema);
+
+    std::vector<Case> Cases;
+    Cases.push_back({ "split/oltp", OltpScript.size(), [&] { DoNotOptimize(SplitSQLStatements(OltpScript)); } });
+    Cases.push_back({ "split/dump_cjk", DumpScript.size(), [&] { DoNotOptimize(SplitSQLStatements(DumpScript)); } });
+    Cases.push_back({ "sanitizer/detect_injection", OltpStatementBytes, [&]
+    {
+        for (const auto& Statement : OltpStatements)
+            DoNotOptimize(SQLSanitizer::DetectSQLInjection(Statement));
+    } });
+    Cases.push_back({ "sanitizer/escape_cjk", EscapeInputBytes, [&]
+    {
+        for (const auto& Input : EscapeInputs)
+            DoNotOptimize(SQLSanitizer::EscapeString(Input));
+    } });
+    Cases.push_back({ "sanitizer/build_parameterized", ParameterTemplate.size(), [&] { DoNotOptimize(SQLSanitizer::BuildParameterizedQuery(ParameterTemplate, ParameterList)); } });
+    Cases.push_back({ "row/get_value_int", 0, [&] { DoNotOptimize(ValueRow.GetValue<int>(0)); } });
+    Cases.push_back({ "row/get_value_double", 0, [&] { DoNotOptimize(ValueRow.GetValue<double>(1)); } });
+    Cases.push_back({ "row/get_value_long_long", 0, [&] { DoNotOptimize(ValueRow.GetValue<long long>(2)); } });
+    Cases.push_back({ "row/get_value_null", 0, [&] { DoNotOptimize(ValueRow.GetValue<int>(3)); } });
+    Cases.push_back({ "row/get_value_string", 0, [&] { DoNotOptimize(ValueRow.GetValue<std::string>(4)); } });
+    Cases.push_back({ "row/get_value_bool", 0, [&] { DoNotOptimize(ValueRow.GetValue<bool>(5)); } });
+    Cases.push_back({ "formatter/narrow", ResultBytes(NarrowResult), [&] { DoNotOptimize(TableFormatter{}.Format(NarrowResult)); } });
+    Cases.push_back({ "formatter/wide_cjk", ResultBytes(WideResult), [&] { DoNotOptimize(TableFormatter{}.Format(WideResult)); } });
+    Cases.push_back({ "materialize/wide", ResultBytes(WideResult), [&]
+    {
+        SyntheticResultSet Source(WideResult);
+        const int ColumnCount = static_cast<int>(WideResult.GetColumnCount());
+        std::vector<MySQLRow> Rows;
+        while (Source.next())
+            Rows.push_back(MaterializeRow(Source, ColumnCount));
+        DoNotOptimize(Rows);
+    } });
+    Cases.push_back({ "transcode/utf8_to_utf16_ascii", OltpScript.size(), [&] { DoNotOptimize(Utf8ToUtf16(OltpScript)); } });
+    Cases.push_back({ "transcode/utf8_to_utf16_cjk", DumpScript.size(), [&] { DoNotOptimize(Utf8ToUtf16(DumpScript)); } });
+    Cases.push_back({ "transcode/utf16_to_utf8_cjk", DumpScript.size(), [&] { DoNotOptimize(Utf16ToUtf8(DumpScriptUtf16)); } });
+    Cases.push_back({ "sqllexer/full_cjk", DumpScriptUtf16.size() * sizeof(char16_t), [&]
+    {
+        IncrementalSqlLexer Lexer;
+        DoNotOptimize(Lexer.SetText(DumpScriptUtf16));
+    } });
+    Cases.push_back({ "sqllexer/edit_middle", 0, [&]
+    {
+        // 在脚本中部的行首输入一个字符再删除，只重新分析这一行
+        DoNotOptimize(EditedLexer.ApplyEdit(EditOffset, 0, u"x"));
+        DoNotOptimize(EditedLexer.ApplyEdit(EditOffset, 1, u""));
+    } });
+    Cases.push_back({ "autocomplete/build_index", 0, [&] { DoNotOptimize(CompletionIndex::Build(Schema, GetSqlKeywords())); } });
+    Cases.push_back({ "autocomplete/lookup_prefix", 0, [&] { DoNotOptimize(Completion.Complete("d")); } });
+    Cases.push_back({ "autocomplete/lookup_fuzzy", 0, [&] { DoNotOptimize(Completion.Complete("dgolf")); } });
+    Cases.push_back({ "autocomplete/lookup_qualified", 0, [&] { DoNotOptimize(Completion.Complete("g", Schema.Tables[Schema.Tables.size() / 2])); } });
+    Cases.push_back({ "outputlog/append_trim", LogMessageBytes, [&]
+    {
+        // 上限远小于消息总量，稳态下每次追加都伴随淘汰；每 8 条刷新一次，相当于一帧内的追加
+        OutputLog Log({ .MaxEntries = 256, .MaxBytes = 32 << 10 });
+        for (std::size_t Index = 0; Index < LogMessages.size(); ++Index)
+        {
+            Log.Append(LogMessages[Index]);
+            if (Index % 8 == 7)
+                DoNotOptimize(Log.Flush());
+        }
+        DoNotOptimize(Log.Flush());
+    } });
+
+    std::vector<Result> Results;
+    for (const auto& BenchmarkCase : Cases)
+    {
+        if (!RunOptions.Filter.empty() && BenchmarkCase.Name.find(RunOptions.Filter) == std::string::npos)
+            continue;
+        Results.push_back(Run(BenchmarkCase, RunOptions));
+        if (RunOptions.OutputFormat == "table" && RunOptions.OutputPath.empty())
+            std::println(stderr, "已完成 {}", BenchmarkCase.Name);
+    }
+
+    std::FILE* Output = stdout;
+    if (!RunOptions.OutputPath.empty())
+    {
+        Output = std::fopen(RunOptions.OutputPath.c_str(), "w");
+        if (!Output)
+        {
+            std::println(stderr, "无法写入输出文件: {}", RunOptions.OutputPath);
+            return 1;
+        }
+    }
+    if (RunOptions.OutputFormat == "json")
+        WriteJson(Output, Results, RunOptions);
+    else if (RunOptions.OutputFormat == "csv")
+        WriteCsv(Output, Results);
+    else
+        WriteTable(Output, Results);
+    if (Output != stdout)
+        std::fclose(Output);
+    return 0;
+}
@@ -0,0 +1,1695 @@
+#include "binlog.h"
+#include "sqlscript.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <random>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+    constexpr SocketHandle InvalidSocket = INVALID_SOCKET;
+#else
+    using SocketHandle = int;
+    constexpr SocketHandle InvalidSocket = -1;
+#endif
+
+    // 客户端能力标志
+    constexpr uint32_t ClientLongPassword = 0x00000001;
+    constexpr uint32_t ClientLongFlag = 0x00000004;
+    constexpr uint32_t ClientConnectWithDatabase = 0x00000008;
+    constexpr uint32_t ClientProtocol41 = 0x00000200;
+    constexpr uint32_t ClientTransactions = 0x00002000;
+    constexpr uint32_t ClientSecureConnection = 0x00008000;
+    constexpr uint32_t ClientMultiResults = 0x00020000;
+    constexpr uint32_t ClientPluginAuth = 0x00080000;
+    constexpr uint32_t ClientPluginAuthLengthEncoded = 0x00200000;
+
+    constexpr uint8_t CommandQuery = 0x03;
+    constexpr uint8_t CommandBinlogDump = 0x12;
+    constexpr uint8_t CommandRegisterReplica = 0x15;
+    constexpr uint8_t CommandBinlogDumpGtid = 0x1E;
+    constexpr uint16_t DumpThroughGtid = 0x0004;
+    constexpr std::size_t MaxPacketPayload = 0xFFFFFF;
+    constexpr uint8_t Utf8mb4GeneralCollation = 45;
+
+    enum EventType : uint8_t
+    {
+        QueryEvent = 2,
+        RotateEvent = 4,
+        FormatDescriptionEvent = 15,
+        XidEvent = 16,
+        TableMapEvent = 19,
+        WriteRowsEventV1 = 23,
+        UpdateRowsEventV1 = 24,
+        DeleteRowsEventV1 = 25,
+        HeartbeatEvent = 27,
+        WriteRowsEvent = 30,
+        UpdateRowsEvent = 31,
+        DeleteRowsEvent = 32,
+        GtidEvent = 33,
+        TransactionPayloadEvent = 40
+    };
+    constexpr std::size_t EventHeaderLength = 19;
+
+    enum ColumnType : uint8_t
+    {
+        TypeDecimal = 0,
+        TypeTiny = 1,
+        TypeShort = 2,
+        TypeLong = 3,
+        TypeFloat = 4,
+        TypeDouble = 5,
+        TypeNull = 6,
+        TypeTimestamp = 7,
+        TypeLongLong = 8,
+        TypeInt24 = 9,
+        TypeDate = 10,
+        TypeTime = 11,
+        TypeDatetime = 12,
+        TypeYear = 13,
+        TypeNewDate = 14,
+        TypeVarchar = 15,
+        TypeBit = 16,
+        TypeTimestamp2 = 17,
+        TypeDatetime2 = 18,
+        TypeTime2 = 19,
+        TypeVector = 242,
+        TypeJson = 245,
+        TypeNewDecimal = 246,
+        TypeEnum = 247,
+        TypeSet = 248,
+        TypeTinyBlob = 249,
+        TypeMediumBlob = 250,
+        TypeLongBlob = 251,
+        TypeBlob = 252,
+        TypeVarString = 253,
+        TypeString = 254,
+        TypeGeometry = 255
+    };
+
+    // TABLE_MAP 可选元数据的类型
+    constexpr uint8_t MetadataSignedness = 1;
+    constexpr uint8_t MetadataColumnName = 4;
+    constexpr uint8_t MetadataSimplePrimaryKey = 8;
+    constexpr uint8_t MetadataPrimaryKeyWithPrefix = 9;
+
+    // 越界读取不抛异常：置失败标志并返回零值，由调用方在一段解析结束后统一检查
+    class ByteReader
+    {
+    private:
+        std::string_view Data;
+        std::size_t Position = 0;
+        bool IsValid = true;
+    public:
+        explicit ByteReader(std::string_view DataParam) noexcept : Data(DataParam) {}
+        [[nodiscard]] auto IsOk() const noexcept -> bool
+        {
+            return IsValid;
+        }
+        [[nodiscard]] auto Remaining() const noexcept -> std::size_t
+        {
+            return Data.size() - Position;
+        }
+        [[nodiscard]] auto Bytes(std::size_t Count) noexcept -> std::string_view
+        {
+            if (!IsValid || Count > Remaining()) [[unlikely]]
+            {
+                IsValid = false;
+                Position = Data.size();
+                return {};
+            }
+            const std::string_view Result = Data.substr(Position, Count);
+            Position += Count;
+            return Result;
+        }
+        auto Skip(std::size_t Count) noexcept -> void
+        {
+            (void)Bytes(Count);
+        }
+        [[nodiscard]] auto Little(std::size_t Count) noexcept -> uint64_t
+        {
+            const std::string_view Raw = Bytes(Count);
+            uint64_t Value = 0;
+            for (std::size_t Index = Raw.size(); Index > 0; --Index)
+                Value = (Value << 8) | static_cast<uint8_t>(Raw[Index - 1]);
+            return Value;
+        }
+        [[nodiscard]] auto Big(std::size_t Count) noexcept -> uint64_t
+        {
+            uint64_t Value = 0;
+            for (const char Byte : Bytes(Count))
+                Value = (Value << 8) | static_cast<uint8_t>(Byte);
+            return Value;
+        }
+        [[nodiscard]] auto LengthEncoded() noexcept -> uint64_t
+        {
+            const auto First = static_cast<uint8_t>(Little(1));
+            if (First < 0xFB)
+                return First;
+            if (First == 0xFC)
+                return Little(2);
+            if (First == 0xFD)
+                return Little(3);
+            if (First == 0xFE)
+                return Little(8);
+            IsValid = false;
+            return 0;
+        }
+        [[nodiscard]] auto NullTerminated() noexcept -> std::string_view
+        {
+            const std::size_t End = Data.find('\0', Position);
+            if (End == std::string_view::npos)
+                return Bytes(Remaining());
+            const std::string_view Result = Bytes(End - Position);
+            Skip(1);
+            return Result;
+        }
+        [[nodiscard]] auto Rest() noexcept -> std::string_view
+        {
+            return Bytes(Remaining());
+        }
+    };
+
+    auto AppendLittle(std::string& Output, uint64_t Value, std::size_t Count) -> void
+    {
+        for (std::size_t Index = 0; Index < Count; ++Index)
+            Output += static_cast<char>((Value >> (Index * 8)) & 0xFF);
+    }
+
+    auto AppendLengthEncoded(std::string& Output, uint64_t Value) -> void
+    {
+        if (Value < 0xFB)
+            Output += static_cast<char>(Value);
+        else if (Value <= 0xFFFF)
+        {
+            Output += '\xFC';
+            AppendLittle(Output, Value, 2);
+        }
+        else if (Value <= 0xFFFFFF)
+        {
+            Output += '\xFD';
+            AppendLittle(Output, Value, 3);
+        }
+        else
+        {
+            Output += '\xFE';
+            AppendLittle(Output, Value, 8);
+        }
+    }
+
+    [[nodiscard]] auto PadDigestMessage(std::string_view Data) -> std::string
+    {
+        std::string Message(Data);
+        const uint64_t BitLength = static_cast<uint64_t>(Data.size()) * 8;
+        Message += '\x80';
+        while (Message.size() % 64 != 56)
+            Message += '\0';
+        for (int Shift = 56; Shift >= 0; Shift -= 8)
+            Message += static_cast<char>((BitLength >> Shift) & 0xFF);
+        return Message;
+    }
+
+    [[nodiscard]] auto ReadBig32(const char* DataPtr) noexcept -> uint32_t
+    {
+        return (static_cast<uint32_t>(static_cast<uint8_t>(DataPtr[0])) << 24) | (static_cast<uint32_t>(static_cast<uint8_t>(DataPtr[1])) << 16) |
+            (static_cast<uint32_t>(static_cast<uint8_t>(DataPtr[2])) << 8) | static_cast<uint32_t>(static_cast<uint8_t>(DataPtr[3]));
+    }
+
+    template<std::size_t WordCount>
+    [[nodiscard]] auto SerializeDigest(const std::array<uint32_t, WordCount>& State) -> std::string
+    {
+        std::string Digest;
+        Digest.reserve(WordCount * 4);
+        for (const uint32_t Word : State)
+            for (int Shift = 24; Shift >= 0; Shift -= 8)
+                Digest += static_cast<char>((Word >> Shift) & 0xFF);
+        return Digest;
+    }
+
+    // 认证只需要对密码和握手随机数做少量哈希，不为此引入 OpenSSL
+    [[nodiscard]] auto Sha1(std::string_view Data) -> std::string
+    {
+        std::array<uint32_t, 5> State{ 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+        const std::string Message = PadDigestMessage(Data);
+        std::array<uint32_t, 80> Words{};
+        for (std::size_t Offset = 0; Offset < Message.size(); Offset += 64)
+        {
+            for (std::size_t Index = 0; Index < 16; ++Index)
+                Words[Index] = ReadBig32(Message.data() + Offset + Index * 4);
+            for (std::size_t Index = 16; Index < 80; ++Index)
+                Words[Index] = std::rotl(Words[Index - 3] ^ Words[Index - 8] ^ Words[Index - 14] ^ Words[Index - 16], 1);
+            auto [A, B, C, D, E] = State;
+            for (std::size_t Index = 0; Index < 80; ++Index)
+            {
+                uint32_t Mixed = 0;
+                uint32_t Constant = 0;
+                if (Index < 20)
+                {
+                    Mixed = (B & C) | (~B & D);
+                    Constant = 0x5A827999;
+                }
+                else if (Index < 40)
+                {
+                    Mixed = B ^ C ^ D;
+                    Constant = 0x6ED9EBA1;
+                }
+                else if (Index < 60)
+                {
+                    Mixed = (B & C) | (B & D) | (C & D);
+                    Constant = 0x8F1BBCDC;
+                }
+                else
+                {
+                    Mixed = B ^ C ^ D;
+                    Constant = 0xCA62C1D6;
+                }
+                const uint32_t Next = std::rotl(A, 5) + Mixed + E + Constant + Words[Index];
+                E = D;
+                D = C;
+                C = std::rotl(B, 30);
+                B = A;
+                A = Next;
+            }
+            State[0] += A;
+            State[1] += B;
+            State[2] += C;
+            State[3] += D;
+            State[4] += E;
+        }
+        return SerializeDigest(State);
+    }
+
+    [[nodiscard]] auto Sha256(std::string_view Data) -> std::string
+    {
+        static constexpr std::array<uint32_t, 64> RoundConstants
+        {
+            0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+            0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+            0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+            0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+            0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+            0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+            0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+            0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+        };
+        std::array<uint32_t, 8> State{ 0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+        const std::string Message = PadDigestMessage(Data);
+        std::array<uint32_t, 64> Words{};
+        for (std::size_t Offset = 0; Offset < Message.size(); Offset += 64)
+        {
+            for (std::size_t Index = 0; Index < 16; ++Index)
+                Words[Index] = ReadBig32(Message.data() + Offset + Index * 4);
+            for (std::size_t Index = 16; Index < 64; ++Index)
+            {
+                const uint32_t Sigma0 = std::rotr(Words[Index - 15], 7) ^ std::rotr(Words[Index - 15], 18) ^ (Words[Index - 15] >> 3);
+                const uint32_t Sigma1 = std::rotr(Words[Index - 2], 17) ^ std::rotr(Words[Index - 2], 19) ^ (Words[Index - 2] >> 10);
+                Words[Index] = Words[Index - 16] + Sigma0 + Words[Index - 7] + Sigma1;
+            }
+            auto [A, B, C, D, E, F, G, H] = State;
+            for (std::size_t Index = 0; Index < 64; ++Index)
+            {
+                const uint32_t Sum1 = std::rotr(E, 6) ^ std::rotr(E, 11) ^ std::rotr(E, 25);
+                const uint32_t Choice = (E & F) ^ (~E & G);
+                const uint32_t First = H + Sum1 + Choice + RoundConstants[Index] + Words[Index];
+                const uint32_t Sum0 = std::rotr(A, 2) ^ std::rotr(A, 13) ^ std::rotr(A, 22);
+                const uint32_t Majority = (A & B) ^ (A & C) ^ (B & C);
+                const uint32_t Second = Sum0 + Majority;
+                H = G;
+                G = F;
+                F = E;
+                E = D + First;
+                D = C;
+                C = B;
+                B = A;
+                A = First + Second;
+            }
+            State[0] += A;
+            State[1] += B;
+            State[2] += C;
+            State[3] += D;
+            State[4] += E;
+            State[5] += F;
+            State[6] += G;
+            State[7] += H;
+        }
+        return SerializeDigest(State);
+    }
+
+    [[nodiscard]] auto XorBytes(std::string Left, std::string_view Right) -> std::string
+    {
+        for (std::size_t Index = 0; Index < Left.size() && Index < Right.size(); ++Index)
+            Left[Index] = static_cast<char>(Left[Index] ^ Right[Index]);
+        return Left;
+    }
+
+    [[nodiscard]] auto ScramblePassword(std::string_view Plugin, std::string_view Password, std::string_view Nonce) -> std::expected<std::string, std::string>
+    {
+        if (Password.empty())
+            return std::string{};
+        if (Plugin == "mysql_native_password")
+        {
+            const std::string Stage1 = Sha1(Password);
+            return XorBytes(Stage1, Sha1(std::string(Nonce) + Sha1(Stage1)));
+        }
+        if (Plugin == "caching_sha2_password")
+        {
+            const std::string Stage1 = Sha256(Password);
+            return XorBytes(Stage1, Sha256(Sha256(Stage1) + std::string(Nonce)));
+        }
+        return std::unexpected(std::format("复制连接不支持认证插件 {}", Plugin));
+    }
+
+    [[nodiscard]] auto Crc32(std::string_view Data) noexcept -> uint32_t
+    {
+        static constexpr auto Table = []
+        {
+            std::array<uint32_t, 256> Entries{};
+            for (uint32_t Index = 0; Index < 256; ++Index)
+            {
+                uint32_t Value = Index;
+                for (int Bit = 0; Bit < 8; ++Bit)
+                    Value = (Value & 1) ? (Value >> 1) ^ 0xEDB88320U : Value >> 1;
+                Entries[Index] = Value;
+            }
+            return Entries;
+        }();
+        uint32_t Crc = 0xFFFFFFFFU;
+        for (const char Byte : Data)
+            Crc = Table[(Crc ^ static_cast<uint8_t>(Byte)) & 0xFF] ^ (Crc >> 8);
+        return Crc ^ 0xFFFFFFFFU;
+    }
+
+    [[nodiscard]] auto FormatServerError(std::string_view Payload) -> std::string
+    {
+        ByteReader Reader(Payload);
+        Reader.Skip(1);
+        const auto ErrorCode = Reader.Little(2);
+        if (Reader.Remaining() > 0 && Payload[3] == '#')
+            Reader.Skip(6);
+        return std::format("服务端错误 {}: {}", ErrorCode, Reader.Rest());
+    }
+
+    // "uuid:1-5:7,uuid2:1-3" 编码为 COM_BINLOG_DUMP_GTID 使用的二进制格式，区间上界为开区间
+    [[nodiscard]] auto EncodeGtidSet(std::string_view GtidSet) -> std::expected<std::string, std::string>
+    {
+        std::string Encoded;
+        uint64_t SidCount = 0;
+        AppendLittle(Encoded, 0, 8);
+        for (std::size_t Start = 0; Start <= GtidSet.size();)
+        {
+            const std::size_t End = (std::min)(GtidSet.find(',', Start), GtidSet.size());
+            std::string_view Element = GtidSet.substr(Start, End - Start);
+            Start = End + 1;
+            while (!Element.empty() && std::isspace(static_cast<unsigned char>(Element.front())))
+                Element.remove_prefix(1);
+            while (!Element.empty() && std::isspace(static_cast<unsigned char>(Element.back())))
+                Element.remove_suffix(1);
+            if (Element.empty())
+                continue;
+            const std::size_t UuidEnd = Element.find(':');
+            const std::string_view Uuid = Element.substr(0, UuidEnd);
+            std::string Sid;
+            for (std::size_t Index = 0; Index < Uuid.size(); ++Index)
+            {
+                if (Uuid[Index] == '-')
+                    continue;
+                if (Index + 1 >= Uuid.size() || !std::isxdigit(static_cast<unsigned char>(Uuid[Index])) || !std::isxdigit(static_cast<unsigned char>(Uuid[Index + 1])))
+                    return std::unexpected(std::format("无效的 GTID 集合: {}", Element));
+                Sid += static_cast<char>(std::stoi(std::string(Uuid.substr(Index, 2)), nullptr, 16));
+                ++Index;
+            }
+            if (Sid.size() != 16 || UuidEnd == std::string_view::npos)
+                return std::unexpected(std::format("无效的 GTID 集合: {}", Element));
+            std::string Intervals;
+            uint64_t IntervalCount = 0;
+            for (std::size_t IntervalStart = UuidEnd + 1; IntervalStart <= Element.size();)
+            {
+                const std::size_t IntervalEnd = (std::min)(Element.find(':', IntervalStart), Element.size());
+                const std::string_view Interval = Element.substr(IntervalStart, IntervalEnd - IntervalStart);
+                IntervalStart = IntervalEnd + 1;
+                const std::size_t Dash = Interval.find('-');
+                uint64_t First = 0;
+                uint64_t Last = 0;
+                const std::string_view FirstText = Interval.substr(0, Dash);
+                const std::string_view LastText = Dash == std::string_view::npos ? FirstText : Interval.substr(Dash + 1);
+                const auto FirstResult = std::from_chars(FirstText.data(), FirstText.data() + FirstText.size(), First);
+                const auto LastResult = std::from_chars(LastText.data(), LastText.data() + LastText.size(), Last);
+                if (FirstResult.ec != std::errc{} || FirstResult.ptr != FirstText.data() + FirstText.size() ||
+                    LastResult.ec != std::errc{} || LastResult.ptr != LastText.data() + LastText.size() || First == 0 || Last < First)
+                    return std::unexpected(std::format("无效的 GTID 区间 {}（不支持带标签的 GTID）", Interval));
+                AppendLittle(Intervals, First, 8);
+                AppendLittle(Intervals, Last + 1, 8);
+                ++IntervalCount;
+            }
+            Encoded += Sid;
+            AppendLittle(Encoded, IntervalCount, 8);
+            Encoded += Intervals;
+            ++SidCount;
+        }
+        for (std::size_t Index = 0; Index < 8; ++Index)
+            Encoded[Index] = static_cast<char>((SidCount >> (Index * 8)) & 0xFF);
+        return Encoded;
+    }
+
+    [[nodiscard]] auto FormatUuid(std::string_view Sid) -> std::string
+    {
+        std::string Text;
+        for (std::size_t Index = 0; Index < Sid.size(); ++Index)
+        {
+            if (Index == 4 || Index == 6 || Index == 8 || Index == 10)
+                Text += '-';
+            Text += std::format("{:02x}", static_cast<uint8_t>(Sid[Index]));
+        }
+        return Text;
+    }
+
+    [[nodiscard]] auto MatchesTable(std::string_view Pattern, std::string_view DatabaseName, std::string_view TableName) noexcept -> bool
+    {
+        const std::size_t Dot = Pattern.find('.');
+        if (Dot == std::string_view::npos)
+            return Pattern == DatabaseName;
+        const std::string_view PatternTable = Pattern.substr(Dot + 1);
+        return Pattern.substr(0, Dot) == DatabaseName && (PatternTable == "*" || PatternTable == TableName);
+    }
+
+    [[nodiscard]] auto MatchesAny(const std::vector<std::string>& Patterns, std::string_view DatabaseName, std::string_view TableName) noexcept -> bool
+    {
+        return Patterns.empty() || std::ranges::any_of(Patterns, [&](const std::string& Pattern) { return MatchesTable(Pattern, DatabaseName, TableName); });
+    }
+
+    [[nodiscard]] auto EqualsIgnoreCase(std::string_view Left, std::string_view Right) noexcept -> bool
+    {
+        return std::ranges::equal(Left, Right, [](char LeftChar, char RightChar)
+        {
+            return std::tolower(static_cast<unsigned char>(LeftChar)) == std::tolower(static_cast<unsigned char>(RightChar));
+        });
+    }
+
+    // 忽略大小写、按标识符边界查找；反引号和点不是标识符字符，`库`.`表` 的写法同样能找到
+    [[nodiscard]] auto MentionsName(std::string_view Statement, std::string_view Name) noexcept -> bool
+    {
+        if (Name.empty())
+            return false;
+        for (std::size_t Position = 0; Position + Name.size() <= Statement.size(); ++Position)
+        {
+            if ((Position > 0 && IsWordChar(Statement[Position - 1])) || (Position + Name.size() < Statement.size() && IsWordChar(Statement[Position + Name.size()])))
+                continue;
+            if (EqualsIgnoreCase(Statement.substr(Position, Name.size()), Name))
+                return true;
+        }
+        return false;
+    }
+
+    // 语句只有 SQL 文本：默认库是该库或语句中出现了库名，并且出现了表名（TableName 为空或 "*" 时不要求）就视为涉及。
+    // 同名的列、别名或字符串也会命中，宁可多报；整库的 DDL（DROP DATABASE 等）涉及库中的每张表
+    [[nodiscard]] auto StatementTouches(std::string_view Statement, std::string_view DefaultDatabase, std::string_view DatabaseName, std::string_view TableName) noexcept -> bool
+    {
+        if (!EqualsIgnoreCase(DefaultDatabase, DatabaseName) && !MentionsName(Statement, DatabaseName))
+            return false;
+        return TableName.empty() || TableName == "*" || MentionsName(Statement, TableName) || MentionsName(Statement, "DATABASE") || MentionsName(Statement, "SCHEMA");
+    }
+
+    [[nodiscard]] auto StatementMatchesAny(const std::vector<std::string>& Patterns, std::string_view Statement, std::string_view DefaultDatabase) noexcept -> bool
+    {
+        return std::ranges::any_of(Patterns, [&](std::string_view Pattern)
+        {
+            const std::size_t Dot = Pattern.find('.');
+            return StatementTouches(Statement, DefaultDatabase, Pattern.substr(0, Dot), Dot == std::string_view::npos ? std::string_view{} : Pattern.substr(Dot + 1));
+        });
+    }
+
+    [[nodiscard]] auto IsBitSet(std::string_view Bitmap, std::size_t Index) noexcept -> bool
+    {
+        return (static_cast<uint8_t>(Bitmap[Index / 8]) >> (Index % 8)) & 1;
+    }
+
+    [[nodiscard]] auto IsNumericColumn(uint8_t Type) noexcept -> bool
+    {
+        switch (Type)
+        {
+        case TypeTiny: case TypeShort: case TypeInt24: case TypeLong: case TypeLongLong:
+        case TypeNewDecimal: case TypeFloat: case TypeDouble:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    [[nodiscard]] auto ZeroPadded(uint64_t Value, std::size_t Width) -> std::string
+    {
+        std::string Text = std::to_string(Value);
+        if (Text.size() < Width)
+            Text.insert(0, Width - Text.size(), '0');
+        return Text;
+    }
+
+    [[nodiscard]] auto FormatFraction(uint32_t Microseconds, unsigned int Precision) -> std::string
+    {
+        Precision = (std::min)(Precision, 6U);
+        if (Precision == 0)
+            return {};
+        static constexpr std::array<uint32_t, 7> Divisors{ 1000000, 100000, 10000, 1000, 100, 10, 1 };
+        return "." + ZeroPadded(Microseconds / Divisors[Precision], Precision);
+    }
+
+    // 小数秒按精度占 0~3 字节，大端存储
+    [[nodiscard]] auto ReadFraction(ByteReader& Reader, unsigned int Precision) noexcept -> uint32_t
+    {
+        switch (Precision)
+        {
+        case 1: case 2: return static_cast<uint32_t>(Reader.Big(1)) * 10000;
+        case 3: case 4: return static_cast<uint32_t>(Reader.Big(2)) * 100;
+        case 5: case 6: return static_cast<uint32_t>(Reader.Big(3));
+        default: return 0;
+        }
+    }
+
+    [[nodiscard]] auto FormatEpochSeconds(uint64_t Seconds, uint32_t Microseconds, unsigned int Precision) -> std::string
+    {
+        if (Seconds == 0 && Microseconds == 0)
+            return "0000-00-00 00:00:00" + FormatFraction(0, Precision);
+        const std::chrono::sys_seconds TimePoint{ std::chrono::seconds{ Seconds } };
+        const auto Days = std::chrono::floor<std::chrono::days>(TimePoint);
+        const std::chrono::year_month_day Date{ Days };
+        const std::chrono::hh_mm_ss Time{ TimePoint - Days };
+        return std::format("{:04}-{:02}-{:02} {:02}:{:02}:{:02}{}", static_cast<int>(Date.year()), static_cast<unsigned int>(Date.month()), static_cast<unsigned int>(Date.day()),
+            Time.hours().count(), Time.minutes().count(), Time.seconds().count(), FormatFraction(Microseconds, Precision));
+    }
+
+    // 二进制 DECIMAL：每 9 位十进制数占 4 字节，不足 9 位的部分按位数占 1~4 字节；首字节最高位为符号，负数整体按位取反
+    [[nodiscard]] auto DecodeDecimal(ByteReader& Reader, unsigned int Precision, unsigned int Scale) -> std::expected<std::string, std::string>
+    {
+        static constexpr std::array<std::size_t, 10> DigitBytes{ 0, 1, 1, 2, 2, 3, 3, 4, 4, 4 };
+        if (Scale > Precision || Precision > 65)
+            return std::unexpected(std::format("无效的 DECIMAL({}, {}) 元数据", Precision, Scale));
+        const unsigned int IntegerDigits = Precision - Scale;
+        const std::size_t IntegerGroups = IntegerDigits / 9;
+        const std::size_t IntegerRemainder = IntegerDigits % 9;
+        const std::size_t FractionGroups = Scale / 9;
+        const std::size_t FractionRemainder = Scale % 9;
+        const std::size_t Size = IntegerGroups * 4 + DigitBytes[IntegerRemainder] + FractionGroups * 4 + DigitBytes[FractionRemainder];
+        std::string Raw(Reader.Bytes(Size));
+        if (!Reader.IsOk() || Raw.empty())
+            return std::unexpected("DECIMAL 数据不完整");
+        const bool IsNegative = (static_cast<uint8_t>(Raw[0]) & 0x80) == 0;
+        Raw[0] = static_cast<char>(Raw[0] ^ 0x80);
+        if (IsNegative)
+            for (char& Byte : Raw)
+                Byte = static_cast<char>(~Byte);
+        ByteReader Digits(Raw);
+        std::string IntegerText;
+        if (IntegerRemainder > 0)
+            IntegerText = std::to_string(Digits.Big(DigitBytes[IntegerRemainder]));
+        for (std::size_t Group = 0; Group < IntegerGroups; ++Group)
+            IntegerText += std::format("{:09}", Digits.Big(4));
+        const std::size_t FirstDigit = IntegerText.find_first_not_of('0');
+        IntegerText = FirstDigit == std::string::npos ? "0" : IntegerText.substr(FirstDigit);
+        std::string Text = IsNegative ? "-" + IntegerText : IntegerText;
+        if (Scale > 0)
+        {
+            Text += '.';
+            for (std::size_t Group = 0; Group < FractionGroups; ++Group)
+                Text += std::format("{:09}", Digits.Big(4));
+            if (FractionRemainder > 0)
+                Text += ZeroPadded(Digits.Big(DigitBytes[FractionRemainder]), FractionRemainder);
+        }
+        return Text;
+    }
+
+    [[nodiscard]] auto DecodeTime2(ByteReader& Reader, unsigned int Precision) -> std::string
+    {
+        int64_t Packed = 0;
+        if (Precision >= 5)
+            Packed = static_cast<int64_t>(Reader.Big(6)) - 0x800000000000LL;
+        else
+        {
+            int64_t IntegerPart = static_cast<int64_t>(Reader.Big(3)) - 0x800000;
+            int64_t Fraction = 0;
+            if (Precision >= 3)
+            {
+                Fraction = static_cast<int64_t>(Reader.Big(2));
+                if (IntegerPart < 0 && Fraction != 0)
+                {
+                    ++IntegerPart;
+                    Fraction -= 0x10000;
+                }
+                Fraction *= 100;
+            }
+            else if (Precision >= 1)
+            {
+                Fraction = static_cast<int64_t>(Reader.Big(1));
+                if (IntegerPart < 0 && Fraction != 0)
+                {
+                    ++IntegerPart;
+                    Fraction -= 0x100;
+                }
+                Fraction *= 10000;
+            }
+            Packed = IntegerPart * (int64_t{ 1 } << 24) + Fraction;
+        }
+        const bool IsNegative = Packed < 0;
+        const uint64_t Magnitude = static_cast<uint64_t>(IsNegative ? -Packed : Packed);
+        const uint64_t HourMinuteSecond = Magnitude >> 24;
+        const auto Microseconds = static_cast<uint32_t>(Magnitude % (uint64_t{ 1 } << 24));
+        return std::format("{}{:02}:{:02}:{:02}{}", IsNegative ? "-" : "", (HourMinuteSecond >> 12) % (1 << 10), (HourMinuteSecond >> 6) % (1 << 6), HourMinuteSecond % (1 << 6),
+            FormatFraction(Microseconds, Precision));
+    }
+
+    // 字符串按原始字节返回；长度前缀的字节数由列的最大长度决定
+    [[nodiscard]] auto DecodeValue(ByteReader& Reader, uint8_t Type, uint16_t Metadata, bool IsUnsigned) -> std::expected<BinlogValue, std::string>
+    {
+        const auto ReadInteger = [&](std::size_t Size) -> BinlogValue
+        {
+            const uint64_t Raw = Reader.Little(Size);
+            if (IsUnsigned)
+                return Raw;
+            const int Shift = static_cast<int>(64 - Size * 8);
+            return static_cast<int64_t>(Raw << Shift) >> Shift;
+        };
+        if (Type == TypeString)
+        {
+            const auto RealType = static_cast<uint8_t>(Metadata >> 8);
+            const auto LengthByte = static_cast<uint16_t>(Metadata & 0xFF);
+            if (RealType == TypeEnum || RealType == TypeSet)
+                return BinlogValue{ Reader.Little(LengthByte) };
+            uint16_t MaxLength = LengthByte;
+            if ((RealType & 0x30) != 0x30)
+                MaxLength = static_cast<uint16_t>(LengthByte | (((RealType & 0x30) ^ 0x30) << 4));
+            const uint64_t Length = Reader.Little(MaxLength < 256 ? 1 : 2);
+            return BinlogValue{ std::string(Reader.Bytes(Length)) };
+        }
+        switch (Type)
+        {
+        case TypeTiny: return ReadInteger(1);
+        case TypeShort: return ReadInteger(2);
+        case TypeInt24: return ReadInteger(3);
+        case TypeLong: return ReadInteger(4);
+        case TypeLongLong: return ReadInteger(8);
+        case TypeFloat:
+        {
+            const auto Bits = static_cast<uint32_t>(Reader.Little(4));
+            return BinlogValue{ static_cast<double>(std::bit_cast<float>(Bits)) };
+        }
+        case TypeDouble: return BinlogValue{ std::bit_cast<double>(Reader.Little(8)) };
+        case TypeNull: return BinlogValue{};
+        case TypeYear:
+        {
+            const uint64_t Year = Reader.Little(1);
+            return BinlogValue{ Year == 0 ? uint64_t{ 0 } : Year + 1900 };
+        }
+        case TypeDate:
+        case TypeNewDate:
+        {
+            const uint64_t Packed = Reader.Little(3);
+            return BinlogValue{ std::format("{:04}-{:02}-{:02}", Packed >> 9, (Packed >> 5) & 15, Packed & 31) };
+        }
+        case TypeTime:
+        {
+            const uint64_t Packed = Reader.Little(3);
+            return BinlogValue{ std::format("{:02}:{:02}:{:02}", Packed / 10000, Packed / 100 % 100, Packed % 100) };
+        }
+        case TypeDatetime:
+        {
+            const uint64_t Packed = Reader.Little(8);
+            const uint64_t DatePart = Packed / 1000000;
+            const uint64_t TimePart = Packed % 1000000;
+            return BinlogValue{ std::format("{:04}-{:02}-{:02} {:02}:{:02}:{:02}", DatePart / 10000, DatePart / 100 % 100, DatePart % 100, TimePart / 10000, TimePart / 100 % 100, TimePart % 100) };
+        }
+        case TypeTimestamp: return BinlogValue{ FormatEpochSeconds(Reader.Little(4), 0, 0) };
+        case TypeTimestamp2:
+        {
+            const uint64_t Seconds = Reader.Big(4);
+            const uint32_t Microseconds = ReadFraction(Reader, Metadata);
+            return BinlogValue{ FormatEpochSeconds(Seconds, Microseconds, Metadata) };
+        }
+        case TypeDatetime2:
+        {
+            const int64_t IntegerPart = static_cast<int64_t>(Reader.Big(5)) - 0x8000000000LL;
+            const uint32_t Microseconds = ReadFraction(Reader, Metadata);
+            const uint64_t Magnitude = static_cast<uint64_t>(IntegerPart < 0 ? -IntegerPart : IntegerPart);
+            const uint64_t YearMonthDay = Magnitude >> 17;
+            const uint64_t YearMonth = YearMonthDay >> 5;
+            const uint64_t HourMinuteSecond = Magnitude % (1 << 17);
+            return BinlogValue{ std::format("{:04}-{:02}-{:02} {:02}:{:02}:{:02}{}", YearMonth / 13, YearMonth % 13, YearMonthDay % (1 << 5),
+                HourMinuteSecond >> 12, (HourMinuteSecond >> 6) % (1 << 6), HourMinuteSecond % (1 << 6), FormatFraction(Microseconds, Metadata)) };
+        }
+        case TypeTime2: return BinlogValue{ DecodeTime2(Reader, Metadata) };
+        case TypeNewDecimal:
+        {
+            auto Text = DecodeDecimal(Reader, Metadata >> 8, Metadata & 0xFF);
+            if (!Text)
+                return std::unexpected(Text.error());
+            return BinlogValue{ std::move(*Text) };
+        }
+        case TypeVarchar:
+        case TypeVarString:
+        {
+            const uint64_t Length = Reader.Little(Metadata < 256 ? 1 : 2);
+            return BinlogValue{ std::string(Reader.Bytes(Length)) };
+        }
+        case TypeBit:
+        {
+            const std::size_t ByteCount = (Metadata >> 8) + ((Metadata & 0xFF) > 0 ? 1 : 0);
+            return BinlogValue{ Reader.Big(ByteCount) };
+        }
+        case TypeEnum:
+        case TypeSet:
+            return BinlogValue{ Reader.Little(Metadata & 0xFF) };
+        case TypeTinyBlob:
+        case TypeMediumBlob:
+        case TypeLongBlob:
+        case TypeBlob:
+        case TypeGeometry:
+        case TypeJson:
+        case TypeVector:
+        {
+            const uint64_t Length = Reader.Little(Metadata);
+            return BinlogValue{ std::string(Reader.Bytes(Length)) };
+        }
+        default:
+            return std::unexpected(std::format("不支持的列类型 {}", Type));
+        }
+    }
+
+    auto SetSocketTimeout(SocketHandle Socket, int Option, std::chrono::milliseconds Timeout) -> void
+    {
+#ifdef _WIN32
+        const DWORD Value = static_cast<DWORD>(Timeout.count());
+        setsockopt(Socket, SOL_SOCKET, Option, reinterpret_cast<const char*>(&Value), sizeof(Value));
+#else
+        timeval Value{};
+        Value.tv_sec = static_cast<time_t>(Timeout.count() / 1000);
+        Value.tv_usec = static_cast<suseconds_t>(Timeout.count() % 1000 * 1000);
+        setsockopt(Socket, SOL_SOCKET, Option, &Value, sizeof(Value));
+#endif
+    }
+
+    auto CloseSocket(SocketHandle Socket) noexcept -> void
+    {
+#ifdef _WIN32
+        closesocket(Socket);
+#else
+        close(Socket);
+#endif
+    }
+}
+
+auto FormatBinlogValue(const BinlogValue& Value) -> std::string
+{
+    if (std::holds_alternative<std::monostate>(Value))
+        return "NULL";
+    if (const auto* Signed = std::get_if<int64_t>(&Value))
+        return std::to_string(*Signed);
+    if (const auto* Unsigned = std::get_if<uint64_t>(&Value))
+        return std::to_string(*Unsigned);
+    if (const auto* Floating = std::get_if<double>(&Value))
+        return std::format("{}", *Floating);
+    const std::string& Text = std::get<std::string>(Value);
+    const bool IsBinary = std::ranges::any_of(Text, [](char Byte) { return static_cast<uint8_t>(Byte) < 0x20 && Byte != '\t' && Byte != '\n' && Byte != '\r'; });
+    if (!IsBinary)
+        return Text;
+    std::string Hex = "0x";
+    for (const char Byte : Text)
+        Hex += std::format("{:02X}", static_cast<uint8_t>(Byte));
+    return Hex;
+}
+
+auto ChangeTransaction::Touches(std::string_view DatabaseName, std::string_view TableName) const -> bool
+{
+    for (std::size_t Index = 0; Index < Statements.size(); ++Index)
+    {
+        if (StatementTouches(Statements[Index], Index < StatementDatabases.size() ? StatementDatabases[Index] : std::string_view{}, DatabaseName, TableName))
+            return true;
+    }
+    return std::ranges::any_of(Rows, [&](const RowChange& Change) { return Change.Database == DatabaseName && Change.Table == TableName; });
+}
+
+// 一条复制连接：MySQL 客户端协议的握手、认证和包收发
+struct BinlogReader::ReplicationStream
+{
+    SocketHandle Socket = InvalidSocket;
+    uint8_t Sequence = 0;
+    std::string ReceiveBuffer;
+    std::size_t BufferStart = 0;
+
+    ReplicationStream() = default;
+    ReplicationStream(const ReplicationStream&) = delete;
+    auto operator=(const ReplicationStream&) -> ReplicationStream & = delete;
+    ~ReplicationStream()
+    {
+        if (Socket != InvalidSocket)
+            CloseSocket(Socket);
+    }
+
+    // 可从其他线程调用，使阻塞中的读取立即返回
+    auto Interrupt() noexcept -> void
+    {
+        if (Socket == InvalidSocket)
+            return;
+#ifdef _WIN32
+        shutdown(Socket, SD_BOTH);
+#else
+        shutdown(Socket, SHUT_RDWR);
+#endif
+    }
+
+    [[nodiscard]] auto Connect(const MySQLConfig& Config, std::chrono::milliseconds ReadTimeout) -> std::expected<void, std::string>
+    {
+#ifdef _WIN32
+        static const bool IsWinsockReady = []
+        {
+            WSADATA StartupData{};
+            return WSAStartup(MAKEWORD(2, 2), &StartupData) == 0;
+        }();
+        if (!IsWinsockReady)
+            return std::unexpected("Winsock 初始化失败");
+#else
+        if (!Config.UnixSocket.empty())
+        {
+            sockaddr_un Address{};
+            Address.sun_family = AF_UNIX;
+            if (Config.UnixSocket.size() >= sizeof(Address.sun_path))
+                return std::unexpected(std::format("套接字路径过长: {}", Config.UnixSocket));
+            std::memcpy(Address.sun_path, Config.UnixSocket.data(), Config.UnixSocket.size());
+            Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (Socket == InvalidSocket)
+                return std::unexpected("无法创建套接字");
+            SetSocketTimeout(Socket, SO_RCVTIMEO, ReadTimeout);
+            if (connect(Socket, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0)
+                return std::unexpected(std::format("无法连接到 {}", Config.UnixSocket));
+            return {};
+        }
+#endif
+        addrinfo Hints{};
+        Hints.ai_family = AF_UNSPEC;
+        Hints.ai_socktype = SOCK_STREAM;
+        addrinfo* Addresses = nullptr;
+        if (getaddrinfo(Config.Host.c_str(), std::to_string(Config.Port).c_str(), &Hints, &Addresses) != 0 || !Addresses)
+            return std::unexpected(std::format("无法解析主机 {}", Config.Host));
+        for (const addrinfo* Address = Addresses; Address; Address = Address->ai_next)
+        {
+            Socket = socket(Address->ai_family, Address->ai_socktype, Address->ai_protocol);
+            if (Socket == InvalidSocket)
+                continue;
+            SetSocketTimeout(Socket, SO_SNDTIMEO, std::chrono::seconds(Config.ConnectTimeout));
+            SetSocketTimeout(Socket, SO_RCVTIMEO, ReadTimeout);
+            if (connect(Socket, Address->ai_addr, static_cast<int>(Address->ai_addrlen)) == 0)
+                break;
+            CloseSocket(Socket);
+            Socket = InvalidSocket;
+        }
+        freeaddrinfo(Addresses);
+        if (Socket == InvalidSocket)
+            return std::unexpected(std::format("无法连接到 {}:{}", Config.Host, Config.Port));
+        return {};
+    }
+
+    [[nodiscard]] auto Receive(std::size_t Count, std::string& Output) -> std::expected<void, std::string>
+    {
+        while (ReceiveBuffer.size() - BufferStart < Count)
+        {
+            if (BufferStart > 0)
+            {
+                ReceiveBuffer.erase(0, BufferStart);
+                BufferStart = 0;
+            }
+            std::array<char, 64 * 1024> Chunk;
+            const auto Received = recv(Socket, Chunk.data(), static_cast<int>(Chunk.size()), 0);
+            if (Received <= 0)
+                return std::unexpected(Received == 0 ? "服务端关闭了复制连接" : "复制连接读取失败或超时");
+            ReceiveBuffer.append(Chunk.data(), static_cast<std::size_t>(Received));
+        }
+        Output.append(ReceiveBuffer, BufferStart, Count);
+        BufferStart += Count;
+        return {};
+    }
+
+    // 负载达到 16MB 的包由多个物理包拼接
+    [[nodiscard]] auto ReadPacket(std::string& Payload) -> std::expected<void, std::string>
+    {
+        Payload.clear();
+        std::size_t Length = 0;
+        do
+        {
+            std::string Header;
+            if (auto Received = Receive(4, Header); !Received)
+                return Received;
+            Length = static_cast<uint8_t>(Header[0]) | (static_cast<std::size_t>(static_cast<uint8_t>(Header[1])) << 8) | (static_cast<std::size_t>(static_cast<uint8_t>(Header[2])) << 16);
+            Sequence = static_cast<uint8_t>(static_cast<uint8_t>(Header[3]) + 1);
+            if (auto Received = Receive(Length, Payload); !Received)
+                return Received;
+        } while (Length == MaxPacketPayload);
+        return {};
+    }
+
+    [[nodiscard]] auto WritePacket(std::string_view Payload) -> std::expected<void, std::string>
+    {
+        std::string Packet;
+        std::size_t Offset = 0;
+        do
+        {
+            const std::size_t Length = (std::min)(Payload.size() - Offset, MaxPacketPayload);
+            AppendLittle(Packet, Length, 3);
+            Packet += static_cast<char>(Sequence++);
+            Packet.append(Payload.substr(Offset, Length));
+            Offset += Length;
+            if (Length < MaxPacketPayload)
+                break;
+        } while (true);
+        for (std::size_t Sent = 0; Sent < Packet.size();)
+        {
+            const auto Written = send(Socket, Packet.data() + Sent, static_cast<int>(Packet.size() - Sent), 0);
+            if (Written <= 0)
+                return std::unexpected("复制连接写入失败");
+            Sent += static_cast<std::size_t>(Written);
+        }
+        return {};
+    }
+
+    // 发送一条命令并等待 OK / ERR
+    [[nodiscard]] auto Command(std::string_view Payload) -> std::expected<void, std::string>
+    {
+        Sequence = 0;
+        if (auto Written = WritePacket(Payload); !Written)
+            return Written;
+        std::string Reply;
+        if (auto Received = ReadPacket(Reply); !Received)
+            return Received;
+        if (!Reply.empty() && static_cast<uint8_t>(Reply[0]) == 0xFF)
+            return std::unexpected(FormatServerError(Reply));
+        return {};
+    }
+
+    [[nodiscard]] auto Query(std::string_view SqlStatement) -> std::expected<void, std::string>
+    {
+        std::string Payload(1, static_cast<char>(CommandQuery));
+        Payload += SqlStatement;
+        return Command(Payload);
+    }
+
+    [[nodiscard]] auto Authenticate(const MySQLConfig& Config) -> std::expected<void, std::string>
+    {
+        std::string Packet;
+        if (auto Received = ReadPacket(Packet); !Received)
+            return Received;
+        if (!Packet.empty() && static_cast<uint8_t>(Packet[0]) == 0xFF)
+            return std::unexpected(FormatServerError(Packet));
+        ByteReader Reader(Packet);
+        if (Reader.Little(1) != 10)
+            return std::unexpected("不支持的握手协议版本");
+        (void)Reader.NullTerminated();
+        Reader.Skip(4);
+        std::string Nonce(Reader.Bytes(8));
+        Reader.Skip(1);
+        uint32_t ServerCapabilities = static_cast<uint32_t>(Reader.Little(2));
+        Reader.Skip(3);
+        ServerCapabilities |= static_cast<uint32_t>(Reader.Little(2)) << 16;
+        const auto NonceLength = static_cast<std::size_t>(Reader.Little(1));
+        Reader.Skip(10);
+        if (ServerCapabilities & ClientSecureConnection)
+            Nonce += Reader.Bytes((std::max)(std::size_t{ 13 }, NonceLength > 8 ? NonceLength - 8 : 0)).substr(0, 12);
+        std::string Plugin = "mysql_native_password";
+        if (ServerCapabilities & ClientPluginAuth)
+            Plugin = Reader.NullTerminated();
+        if (!Reader.IsOk() || !(ServerCapabilities & ClientProtocol41))
+            return std::unexpected("无法解析服务端握手包");
+
+        uint32_t Capabilities = ClientLongPassword | ClientLongFlag | ClientProtocol41 | ClientTransactions | ClientSecureConnection | ClientMultiResults | ClientPluginAuth | ClientPluginAuthLengthEncoded;
+        if (!Config.Database.empty())
+            Capabilities |= ClientConnectWithDatabase;
+        Capabilities &= ServerCapabilities;
+        auto AuthData = ScramblePassword(Plugin, Config.Password, Nonce);
+        if (!AuthData)
+            return std::unexpected(AuthData.error());
+        std::string Response;
+        AppendLittle(Response, Capabilities, 4);
+        AppendLittle(Response, 1U << 30, 4);
+        Response += static_cast<char>(Utf8mb4GeneralCollation);
+        Response.append(23, '\0');
+        Response += Config.User;
+        Response += '\0';
+        if (Capabilities & ClientPluginAuthLengthEncoded)
+            AppendLengthEncoded(Response, AuthData->size());
+        else
+            Response += static_cast<char>(AuthData->size());
+        Response += *AuthData;
+        if (Capabilities & ClientConnectWithDatabase)
+        {
+            Response += Config.Database;
+            Response += '\0';
+        }
+        if (Capabilities & ClientPluginAuth)
+        {
+            Response += Plugin;
+            Response += '\0';
+        }
+        if (auto Written = WritePacket(Response); !Written)
+            return Written;
+        while (true)
+        {
+            if (auto Received = ReadPacket(Packet); !Received)
+                return Received;
+            if (Packet.empty())
+                return std::unexpected("认证过程中收到空包");
+            switch (static_cast<uint8_t>(Packet[0]))
+            {
+            case 0x00:
+                return {};
+            case 0xFF:
+                return std::unexpected(FormatServerError(Packet));
+            case 0xFE:
+            {
+                // 服务端要求切换认证插件，附带新的随机数
+                ByteReader SwitchReader(Packet);
+                SwitchReader.Skip(1);
+                Plugin = SwitchReader.NullTerminated();
+                std::string_view SwitchNonce = SwitchReader.Rest();
+                if (!SwitchNonce.empty() && SwitchNonce.back() == '\0')
+                    SwitchNonce.remove_suffix(1);
+                auto SwitchData = ScramblePassword(Plugin, Config.Password, SwitchNonce);
+                if (!SwitchData)
+                    return std::unexpected(SwitchData.error());
+                if (auto Written = WritePacket(*SwitchData); !Written)
+                    return Written;
+                break;
+            }
+            case 0x01:
+            {
+                // caching_sha2_password：3 为缓存命中，随后是 OK 包；4 要求经 TLS 或 RSA 发送明文密码
+                if (Plugin == "caching_sha2_password" && Packet.size() >= 2 && Packet[1] == 3)
+                    break;
+                return std::unexpected("服务端要求 caching_sha2_password 完整认证（需要 TLS），复制连接无法完成；请确认普通连接能以同一账号登录");
+            }
+            default:
+                return std::unexpected("认证过程中收到无法识别的包");
+            }
+        }
+    }
+};
+
+BinlogReader::BinlogReader(BinlogOptions OptionsParam) : Options(std::move(OptionsParam))
+{
+    if (Options.ServerId == 0)
+    {
+        std::random_device Device;
+        Options.ServerId = std::uniform_int_distribution<uint32_t>(0x10000000U, 0x7FFFFFFFU)(Device);
+    }
+}
+
+BinlogReader::~BinlogReader()
+{
+    Stop();
+}
+
+auto BinlogReader::Subscribe(Subscriber Callback, std::vector<std::string> Tables) -> SubscriptionId
+{
+    std::lock_guard<std::mutex> Lock(SubscriberMutex);
+    const SubscriptionId Id = NextSubscriptionId++;
+    Subscribers.push_back({ Id, std::move(Tables), Callback ? std::make_shared<const Subscriber>(std::move(Callback)) : nullptr });
+    return Id;
+}
+
+auto BinlogReader::Unsubscribe(SubscriptionId Id) -> void
+{
+    std::lock_guard<std::mutex> Lock(SubscriberMutex);
+    std::erase_if(Subscribers, [Id](const Subscription& Entry) { return Entry.Id == Id; });
+}
+
+auto BinlogReader::Start() -> std::expected<void, std::string>
+{
+    Stop();
+    // 普通连接先登录一次：caching_sha2_password 的认证缓存随之填充，复制连接才能走快速认证
+    if (auto Connected = MetadataConnection.ConnectExpected(Options.Config); !Connected)
+        return std::unexpected(Connected.error());
+    BinlogPosition From = Options.Start;
+    if (From.IsEmpty())
+    {
+        MySQLResult Status = MetadataConnection.Query("SHOW BINARY LOG STATUS");
+        if (!Status.Success)
+            Status = MetadataConnection.Query("SHOW MASTER STATUS");
+        if (!Status.Success)
+            return std::unexpected(std::format("无法读取当前 binlog 位置: {}", Status.ErrorMessage));
+        const auto FileColumn = Status.GetColumnIndex("File");
+        const auto PositionColumn = Status.GetColumnIndex("Position");
+        if (Status.Rows.empty() || !FileColumn || !PositionColumn)
+            return std::unexpected("服务端未开启 binlog");
+        const MySQLRow& StatusRow = Status.Rows[0];
+        From.FileName = StatusRow[*FileColumn];
+        From.Offset = static_cast<uint64_t>(StatusRow.GetValue<long long>(*PositionColumn).value_or(4));
+    }
+    if (auto Opened = OpenStream(From); !Opened)
+        return Opened;
+    {
+        std::lock_guard<std::mutex> Lock(StateMutex);
+        CommittedPosition = From;
+        LastError.clear();
+    }
+    ReadThread = std::jthread([this](std::stop_token StopToken) { ReadLoop(StopToken); });
+    return {};
+}
+
+auto BinlogReader::Stop() -> void
+{
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        ReadThread.request_stop();
+    }
+    WakeCondition.notify_all();
+    {
+        std::lock_guard<std::mutex> Lock(StreamMutex);
+        if (Stream)
+            Stream->Interrupt();
+    }
+    if (ReadThread.joinable())
+        ReadThread.join();
+    std::lock_guard<std::mutex> Lock(StreamMutex);
+    Stream.reset();
+}
+
+auto BinlogReader::OpenStream(const BinlogPosition& From) -> std::expected<void, std::string>
+{
+    auto NewStream = std::make_unique<ReplicationStream>();
+    // 心跳保证空闲时也有数据到达，读取超时设为两个心跳周期，超时即视为连接已断开
+    const auto ReadTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(Options.HeartbeatPeriod * 2 + std::chrono::seconds(5));
+    if (auto Connected = NewStream->Connect(Options.Config, ReadTimeout); !Connected)
+        return Connected;
+    if (auto Authenticated = NewStream->Authenticate(Options.Config); !Authenticated)
+        return Authenticated;
+    // 声明能够处理事件校验和，否则开启 binlog_checksum 的服务端会拒绝发送
+    if (auto Declared = NewStream->Query("SET @master_binlog_checksum = @@global.binlog_checksum, @source_binlog_checksum = @@global.binlog_checksum"); !Declared)
+        return Declared;
+    const auto HeartbeatNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Options.HeartbeatPeriod).count();
+    if (auto Heartbeat = NewStream->Query(std::format("SET @master_heartbeat_period = {}, @source_heartbeat_period = {}", HeartbeatNanoseconds, HeartbeatNanoseconds)); !Heartbeat)
+        return Heartbeat;
+    std::string Register(1, static_cast<char>(CommandRegisterReplica));
+    AppendLittle(Register, Options.ServerId, 4);
+    Register.append(3, '\0');
+    AppendLittle(Register, 0, 2);
+    AppendLittle(Register, 0, 4);
+    AppendLittle(Register, 0, 4);
+    if (auto Registered = NewStream->Command(Register); !Registered)
+        return Registered;
+    std::string Dump;
+    if (!From.GtidSet.empty())
+    {
+        auto Encoded = EncodeGtidSet(From.GtidSet);
+        if (!Encoded)
+            return std::unexpected(Encoded.error());
+        Dump += static_cast<char>(CommandBinlogDumpGtid);
+        AppendLittle(Dump, DumpThroughGtid, 2);
+        AppendLittle(Dump, Options.ServerId, 4);
+        AppendLittle(Dump, 0, 4);
+        AppendLittle(Dump, 4, 8);
+        AppendLittle(Dump, Encoded->size(), 4);
+        Dump += *Encoded;
+    }
+    else
+    {
+        Dump += static_cast<char>(CommandBinlogDump);
+        AppendLittle(Dump, From.Offset, 4);
+        AppendLittle(Dump, 0, 2);
+        AppendLittle(Dump, Options.ServerId, 4);
+        Dump += From.FileName;
+    }
+    NewStream->Sequence = 0;
+    if (auto Written = NewStream->WritePacket(Dump); !Written)
+        return Written;
+    CurrentFile = From.FileName;
+    HasChecksum = false;
+    TableMaps.clear();
+    Pending = {};
+    IsInTransaction = false;
+    std::lock_guard<std::mutex> Lock(StreamMutex);
+    Stream = std::move(NewStream);
+    return {};
+}
+
+auto BinlogReader::ReadLoop(std::stop_token StopToken) -> void
+{
+    std::string Packet;
+    while (!StopToken.stop_requested())
+    {
+        auto Received = Stream->ReadPacket(Packet);
+        if (Received && !Packet.empty() && Packet[0] == 0x00) [[likely]]
+        {
+            if (auto Handled = HandleEvent(std::string_view{ Packet }.substr(1)); !Handled)
+            {
+                Counters.SkippedEvents.fetch_add(1, std::memory_order_relaxed);
+                SetLastError(std::move(Handled.error()));
+            }
+            continue;
+        }
+        if (StopToken.stop_requested())
+            break;
+        if (!Received)
+            SetLastError(std::move(Received.error()));
+        else if (!Packet.empty() && static_cast<uint8_t>(Packet[0]) == 0xFF)
+            SetLastError(FormatServerError(Packet));
+        else
+            SetLastError("服务端结束了 binlog 流");
+        // 未提交的事务丢弃，从最后提交的位置重新请求，订阅者不会看到半个事务
+        while (!StopToken.stop_requested())
+        {
+            {
+                std::unique_lock<std::mutex> Lock(WakeMutex);
+                if (WakeCondition.wait_for(Lock, Options.ReconnectDelay, [&StopToken] { return StopToken.stop_requested(); }))
+                    return;
+            }
+            if (auto Opened = OpenStream(GetPosition()); Opened)
+            {
+                Counters.Reconnects.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            else
+                SetLastError(std::move(Opened.error()));
+        }
+    }
+}
+
+auto BinlogReader::HandleEvent(std::string_view Event) -> std::expected<void, std::string>
+{
+    ByteReader Header(Event);
+    const auto Timestamp = static_cast<int64_t>(Header.Little(4));
+    const auto Type = static_cast<uint8_t>(Header.Little(1));
+    Header.Skip(4);
+    const auto EventSize = Header.Little(4);
+    const auto EndOffset = Header.Little(4);
+    Header.Skip(2);
+    if (!Header.IsOk() || EventSize != Event.size()) [[unlikely]]
+        return std::unexpected(std::format("事件长度不一致（类型 {}）", Type));
+    Counters.Events.fetch_add(1, std::memory_order_relaxed);
+    Counters.Bytes.fetch_add(Event.size(), std::memory_order_relaxed);
+    if (Timestamp > 0)
+        Counters.LastEventSeconds.store(Timestamp, std::memory_order_relaxed);
+    std::string_view Body = Event.substr(EventHeaderLength);
+    if (Type == FormatDescriptionEvent)
+    {
+        // 版本 2 + 服务端版本 50 + 创建时间 4 + 头长度 1，其后是各类事件的固定头长度，最后是校验和算法 1 字节和校验和 4 字节
+        constexpr std::size_t LengthsOffset = 2 + 50 + 4 + 1;
+        if (Body.size() < LengthsOffset + 5)
+            return std::unexpected("格式描述事件不完整");
+        HasChecksum = static_cast<uint8_t>(Body[Body.size() - 5]) == 1;
+        if (HasChecksum && Crc32(Event.substr(0, Event.size() - 4)) != ByteReader(Event.substr(Event.size() - 4)).Little(4))
+            return std::unexpected("格式描述事件校验和不匹配");
+        const std::string_view Lengths = Body.substr(LengthsOffset, Body.size() - LengthsOffset - 5);
+        PostHeaderLengths.assign(Lengths.begin(), Lengths.end());
+        return {};
+    }
+    if (HasChecksum)
+    {
+        if (Body.size() < 4)
+            return std::unexpected("事件不完整");
+        if (Crc32(Event.substr(0, Event.size() - 4)) != ByteReader(Event.substr(Event.size() - 4)).Little(4)) [[unlikely]]
+            return std::unexpected(std::format("事件校验和不匹配（类型 {}，位置 {}:{}）", Type, CurrentFile, EndOffset));
+        Body.remove_suffix(4);
+    }
+    const auto PostHeaderLength = [&](uint8_t DefaultLength) -> uint8_t
+    {
+        return Type >= 1 && Type <= PostHeaderLengths.size() ? PostHeaderLengths[Type - 1] : DefaultLength;
+    };
+    switch (Type)
+    {
+    case RotateEvent:
+    {
+        ByteReader Reader(Body);
+        const uint64_t Position = Reader.Little(8);
+        CurrentFile = Reader.Rest();
+        // 开始读取时服务端先发一个时间戳为 0 的虚拟轮换事件，只用于告知文件名；按 GTID 定位时不能据此改写续传位置
+        if (Timestamp != 0 && !IsInTransaction && Pending.Rows.empty())
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex);
+            CommittedPosition = { CurrentFile, Position, {} };
+        }
+        return {};
+    }
+    case QueryEvent:
+        if (HandleQuery(Body, PostHeaderLength(13)))
+            CommitPending(EndOffset);
+        return {};
+    case XidEvent:
+        CommitPending(EndOffset);
+        return {};
+    case TableMapEvent:
+        return HandleTableMap(Body, PostHeaderLength(8));
+    case WriteRowsEventV1:
+    case UpdateRowsEventV1:
+    case DeleteRowsEventV1:
+        return HandleRows(Type, Body, PostHeaderLength(8));
+    case WriteRowsEvent:
+    case UpdateRowsEvent:
+    case DeleteRowsEvent:
+        return HandleRows(Type, Body, PostHeaderLength(10));
+    case GtidEvent:
+    {
+        ByteReader Reader(Body);
+        Reader.Skip(1);
+        const std::string_view Sid = Reader.Bytes(16);
+        const uint64_t Sequence = Reader.Little(8);
+        if (Reader.IsOk())
+            Pending.Gtid = std::format("{}:{}", FormatUuid(Sid), Sequence);
+        return {};
+    }
+    case TransactionPayloadEvent:
+        // 压缩的事务负载中包含完整事务（含提交），这里只推进位置
+        CommitPending(EndOffset);
+        return std::unexpected("压缩的事务负载（binlog_transaction_compression）无法解码，已跳过");
+    default:
+        return {};
+    }
+}
+
+auto BinlogReader::HandleQuery(std::string_view Body, uint8_t PostHeaderLength) -> bool
+{
+    ByteReader Reader(Body);
+    Reader.Skip(8);
+    const auto SchemaLength = static_cast<std::size_t>(Reader.Little(1));
+    Reader.Skip(2);
+    const auto StatusLength = static_cast<std::size_t>(Reader.Little(2));
+    Reader.Skip(PostHeaderLength > 13 ? PostHeaderLength - 13 : 0);
+    Reader.Skip(StatusLength);
+    const std::string_view SchemaName = Reader.Bytes(SchemaLength);
+    Reader.Skip(1);
+    const std::string_view Statement = Reader.Rest();
+    if (!Reader.IsOk())
+        return false;
+    if (Statement == "BEGIN")
+    {
+        IsInTransaction = true;
+        return false;
+    }
+    if (Statement == "COMMIT")
+        return true;
+    // DDL 或语句格式的 DML；结构可能已变，列名缓存失效
+    Pending.Statements.emplace_back(Statement);
+    Pending.StatementDatabases.emplace_back(SchemaName);
+    SchemaCache.clear();
+    return !IsInTransaction;
+}
+
+auto BinlogReader::HandleTableMap(std::string_view Body, uint8_t PostHeaderLength) -> std::expected<void, std::string>
+{
+    ByteReader Reader(Body);
+    const uint64_t TableId = Reader.Little(PostHeaderLength == 6 ? 4 : 6);
+    Reader.Skip(PostHeaderLength == 6 ? 2 : PostHeaderLength - 6);
+    TableInfo Info;
+    Info.Database = Reader.Bytes(Reader.Little(1));
+    Reader.Skip(1);
+    Info.Table = Reader.Bytes(Reader.Little(1));
+    Reader.Skip(1);
+    const uint64_t ColumnCount = Reader.LengthEncoded();
+    const std::string_view Types = Reader.Bytes(ColumnCount);
+    ByteReader Metadata(Reader.Bytes(Reader.LengthEncoded()));
+    Reader.Skip((ColumnCount + 7) / 8);
+    if (!Reader.IsOk())
+        return std::unexpected(std::format("表映射事件不完整（table_id {}）", TableId));
+    Info.ColumnTypes.assign(Types.begin(), Types.end());
+    Info.ColumnMetadata.resize(ColumnCount);
+    Info.IsUnsigned.resize(ColumnCount);
+    for (std::size_t Column = 0; Column < ColumnCount; ++Column)
+    {
+        switch (Info.ColumnTypes[Column])
+        {
+        case TypeFloat: case TypeDouble: case TypeBlob: case TypeTinyBlob: case TypeMediumBlob: case TypeLongBlob:
+        case TypeGeometry: case TypeJson: case TypeVector: case TypeTimestamp2: case TypeDatetime2: case TypeTime2:
+            Info.ColumnMetadata[Column] = static_cast<uint16_t>(Metadata.Little(1));
+            break;
+        case TypeVarchar: case TypeVarString: case TypeBit:
+            Info.ColumnMetadata[Column] = static_cast<uint16_t>(Metadata.Little(2));
+            break;
+        case TypeNewDecimal: case TypeString: case TypeEnum: case TypeSet:
+            Info.ColumnMetadata[Column] = static_cast<uint16_t>(Metadata.Big(2));
+            break;
+        default:
+            break;
+        }
+    }
+    if (!Metadata.IsOk())
+        return std::unexpected(std::format("{}.{} 的列元数据不完整", Info.Database, Info.Table));
+    Info.IsIncluded = MatchesAny(Options.Tables, Info.Database, Info.Table);
+    std::vector<std::string> Names;
+    std::vector<std::size_t> Keys;
+    while (Reader.Remaining() > 0)
+    {
+        const auto FieldType = static_cast<uint8_t>(Reader.Little(1));
+        ByteReader Field(Reader.Bytes(Reader.LengthEncoded()));
+        if (FieldType == MetadataSignedness)
+        {
+            const std::string_view Bitmap = Field.Rest();
+            std::size_t NumericIndex = 0;
+            for (std::size_t Column = 0; Column < ColumnCount; ++Column)
+            {
+                if (!IsNumericColumn(Info.ColumnTypes[Column]))
+                    continue;
+                if (NumericIndex / 8 < Bitmap.size())
+                    Info.IsUnsigned[Column] = (static_cast<uint8_t>(Bitmap[NumericIndex / 8]) & (0x80 >> (NumericIndex % 8))) != 0;
+                ++NumericIndex;
+            }
+        }
+        else if (FieldType == MetadataColumnName)
+        {
+            while (Field.Remaining() > 0)
+                Names.emplace_back(Field.Bytes(Field.LengthEncoded()));
+        }
+        else if (FieldType == MetadataSimplePrimaryKey || FieldType == MetadataPrimaryKeyWithPrefix)
+        {
+            while (Field.Remaining() > 0)
+            {
+                Keys.push_back(Field.LengthEncoded());
+                if (FieldType == MetadataPrimaryKeyWithPrefix)
+                    (void)Field.LengthEncoded();
+            }
+        }
+    }
+    if (Names.size() == ColumnCount)
+    {
+        Info.ColumnNames = std::make_shared<const std::vector<std::string>>(std::move(Names));
+        Info.KeyIndexes = std::make_shared<const std::vector<std::size_t>>(std::move(Keys));
+    }
+    else if (Info.IsIncluded)
+        LoadSchema(Info);
+    TableMaps.insert_or_assign(TableId, std::move(Info));
+    return {};
+}
+
+// binlog_row_metadata=MINIMAL 时事件中没有列名，从 information_schema 读取当前结构；与事件的列数不符时以 @1、@2 命名
+auto BinlogReader::LoadSchema(TableInfo& Info) -> void
+{
+    const std::string CacheKey = Info.Database + '.' + Info.Table;
+    auto Cached = SchemaCache.find(CacheKey);
+    if (Cached == SchemaCache.end())
+    {
+        std::vector<std::string> Names;
+        std::vector<std::size_t> Keys;
+        const MySQLResult Columns = MetadataConnection.Query(std::format(
+            "SELECT COLUMN_NAME, COLUMN_KEY FROM information_schema.COLUMNS WHERE TABLE_SCHEMA = '{}' AND TABLE_NAME = '{}' ORDER BY ORDINAL_POSITION",
+            SQLSanitizer::EscapeString(Info.Database), SQLSanitizer::EscapeString(Info.Table)));
+        if (Columns.Success)
+        {
+            for (const MySQLRow& ColumnRow : Columns.Rows)
+            {
+                if (ColumnRow.Size() >= 2 && ColumnRow[1] == "PRI")
+                    Keys.push_back(Names.size());
+                Names.push_back(ColumnRow.Size() > 0 ? ColumnRow[0] : std::string{});
+            }
+        }
+        Cached = SchemaCache.emplace(CacheKey, std::make_pair(std::make_shared<const std::vector<std::string>>(std::move(Names)),
+            std::make_shared<const std::vector<std::size_t>>(std::move(Keys)))).first;
+    }
+    if (Cached->second.first->size() == Info.ColumnTypes.size())
+    {
+        Info.ColumnNames = Cached->second.first;
+        Info.KeyIndexes = Cached->second.second;
+        return;
+    }
+    std::vector<std::string> Placeholders;
+    for (std::size_t Column = 0; Column < Info.ColumnTypes.size(); ++Column)
+        Placeholders.push_back(std::format("@{}", Column + 1));
+    Info.ColumnNames = std::make_shared<const std::vector<std::string>>(std::move(Placeholders));
+    Info.KeyIndexes = std::make_shared<const std::vector<std::size_t>>();
+}
+
+auto BinlogReader::HandleRows(uint8_t EventType, std::string_view Body, uint8_t PostHeaderLength) -> std::expected<void, std::string>
+{
+    ByteReader Reader(Body);
+    const uint64_t TableId = Reader.Little(PostHeaderLength == 6 ? 4 : 6);
+    Reader.Skip(2);
+    const bool IsVersion2 = EventType >= WriteRowsEvent;
+    if (IsVersion2)
+        Reader.Skip(static_cast<std::size_t>(Reader.Little(2)) - 2);
+    const auto Found = TableMaps.find(TableId);
+    if (Found == TableMaps.end())
+        return std::unexpected(std::format("行事件缺少 table_id {} 的表映射", TableId));
+    const TableInfo& Info = Found->second;
+    if (!Info.IsIncluded)
+        return {};
+    const uint64_t ColumnCount = Reader.LengthEncoded();
+    const std::size_t BitmapSize = (ColumnCount + 7) / 8;
+    const std::string_view BeforeColumns = Reader.Bytes(BitmapSize);
+    const bool IsUpdate = EventType == UpdateRowsEvent || EventType == UpdateRowsEventV1;
+    const std::string_view AfterColumns = IsUpdate ? Reader.Bytes(BitmapSize) : BeforeColumns;
+    if (!Reader.IsOk() || ColumnCount > Info.ColumnTypes.size())
+        return std::unexpected(std::format("{}.{} 的行事件与表映射不符", Info.Database, Info.Table));
+    RowChangeKind Kind = RowChangeKind::Insert;
+    if (IsUpdate)
+        Kind = RowChangeKind::Update;
+    else if (EventType == DeleteRowsEvent || EventType == DeleteRowsEventV1)
+        Kind = RowChangeKind::Delete;
+
+    const auto DecodeImage = [&](std::string_view PresentColumns) -> std::expected<std::vector<BinlogValue>, std::string>
+    {
+        std::size_t PresentCount = 0;
+        for (std::size_t Column = 0; Column < ColumnCount; ++Column)
+            PresentCount += IsBitSet(PresentColumns, Column) ? 1 : 0;
+        const std::string_view NullBitmap = Reader.Bytes((PresentCount + 7) / 8);
+        std::vector<BinlogValue> Values(ColumnCount);
+        std::size_t PresentIndex = 0;
+        for (std::size_t Column = 0; Column < ColumnCount && Reader.IsOk(); ++Column)
+        {
+            if (!IsBitSet(PresentColumns, Column))
+                continue;
+            if (IsBitSet(NullBitmap, PresentIndex++))
+                continue;
+            auto Value = DecodeValue(Reader, Info.ColumnTypes[Column], Info.ColumnMetadata[Column], Info.IsUnsigned[Column]);
+            if (!Value)
+                return std::unexpected(std::format("{}.{} 第 {} 列: {}", Info.Database, Info.Table, Column + 1, Value.error()));
+            Values[Column] = std::move(*Value);
+        }
+        if (!Reader.IsOk())
+            return std::unexpected(std::format("{}.{} 的行数据不完整", Info.Database, Info.Table));
+        return Values;
+    };
+
+    while (Reader.Remaining() > 0)
+    {
+        RowChange& Change = Pending.Rows.emplace_back();
+        Change.Kind = Kind;
+        Change.Database = Info.Database;
+        Change.Table = Info.Table;
+        Change.ColumnNames = Info.ColumnNames;
+        Change.KeyIndexes = Info.KeyIndexes;
+        std::expected<std::vector<BinlogValue>, std::string> Image;
+        if (Kind != RowChangeKind::Insert)
+        {
+            Image = DecodeImage(BeforeColumns);
+            if (Image)
+                Change.Before = std::move(*Image);
+        }
+        if (Image && Kind != RowChangeKind::Delete)
+        {
+            Image = DecodeImage(AfterColumns);
+            if (Image)
+                Change.After = std::move(*Image);
+        }
+        if (!Image) [[unlikely]]
+        {
+            // 行边界已无法确定：保留一条没有取值的变更，订阅者仍能得知该表发生了变化
+            Change.Before.clear();
+            Change.After.clear();
+            return std::unexpected(std::move(Image.error()));
+        }
+    }
+    return {};
+}
+
+auto BinlogReader::CommitPending(uint64_t EndOffset) -> void
+{
+    Pending.Position = { CurrentFile, EndOffset, {} };
+    Pending.CommitTime = std::chrono::system_clock::time_point{ std::chrono::seconds{ Counters.LastEventSeconds.load(std::memory_order_relaxed) } };
+    {
+        std::lock_guard<std::mutex> Lock(StateMutex);
+        CommittedPosition = Pending.Position;
+    }
+    if (!Pending.Rows.empty() || !Pending.Statements.empty())
+    {
+        Counters.Transactions.fetch_add(1, std::memory_order_relaxed);
+        Counters.RowChanges.fetch_add(Pending.Rows.size(), std::memory_order_relaxed);
+        Dispatch(Pending);
+    }
+    Pending = {};
+    IsInTransaction = false;
+    // 每个事务在行事件之前都会重新写出表映射
+    TableMaps.clear();
+}
+
+auto BinlogReader::Dispatch(const ChangeTransaction& Transaction) -> void
+{
+    // 只在锁内挑出要通知的回调，回调本身在锁外执行：回调里可以取消订阅，其他线程订阅时也不必等回调返回
+    std::vector<std::shared_ptr<const Subscriber>> Targets;
+    {
+        std::lock_guard<std::mutex> Lock(SubscriberMutex);
+        for (const Subscription& Entry : Subscribers)
+        {
+            bool IsInterested = Entry.Tables.empty() || std::ranges::any_of(Transaction.Rows, [&](const RowChange& Change)
+            {
+                return MatchesAny(Entry.Tables, Change.Database, Change.Table);
+            });
+            for (std::size_t Index = 0; !IsInterested && Index < Transaction.Statements.size(); ++Index)
+                IsInterested = StatementMatchesAny(Entry.Tables, Transaction.Statements[Index], Transaction.StatementDatabases[Index]);
+            if (IsInterested && Entry.Callback)
+                Targets.push_back(Entry.Callback);
+        }
+    }
+    for (const std::shared_ptr<const Subscriber>& Callback : Targets)
+    {
+        try
+        {
+            (*Callback)(Transaction);
+        }
+        catch (const std::exception& Exception)
+        {
+            SetLastError(std::format("订阅回调异常: {}", Exception.what()));
+        }
+    }
+}
+
+auto BinlogReader::SetLastError(std::string Message) -> void
+{
+    std::lock_guard<std::mutex> Lock(StateMutex);
+    LastError = std::move(Message);
+}
+
+auto BinlogReader::GetPosition() const -> BinlogPosition
+{
+    std::lock_guard<std::mutex> Lock(StateMutex);
+    return CommittedPosition;
+}
+
+auto BinlogReader::GetLastError() const -> std::string
+{
+    std::lock_guard<std::mutex> Lock(StateMutex);
+    return LastError;
+}
+
+auto BinlogReader::GetStatistics() const -> BinlogStatistics
+{
+    BinlogStatistics Statistics;
+    Statistics.Events = Counters.Events.load(std::memory_order_relaxed);
+    Statistics.Bytes = Counters.Bytes.load(std::memory_order_relaxed);
+    Statistics.Transactions = Counters.Transactions.load(std::memory_order_relaxed);
+    Statistics.RowChanges = Counters.RowChanges.load(std::memory_order_relaxed);
+    Statistics.SkippedEvents = Counters.SkippedEvents.load(std::memory_order_relaxed);
+    Statistics.Reconnects = Counters.Reconnects.load(std::memory_order_relaxed);
+    const int64_t LastEventSeconds = Counters.LastEventSeconds.load(std::memory_order_relaxed);
+    if (LastEventSeconds > 0)
+    {
+        const auto LastEvent = std::chrono::system_clock::time_point{ std::chrono::seconds{ LastEventSeconds } };
+        Statistics.Lag = (std::max)(std::chrono::milliseconds{ 0 }, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - LastEvent));
+    }
+    return Statistics;
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+struct BinlogPosition
+{
+    std::string FileName;
+    uint64_t Offset = 4;
+    // 非空时按 GTID 集合定位（跳过集合中已执行的事务），忽略 FileName 和 Offset
+    std::string GtidSet;
+    [[nodiscard]] auto IsEmpty() const noexcept -> bool
+    {
+        return FileName.empty() && GtidSet.empty();
+    }
+};
+
+struct BinlogOptions
+{
+    MySQLConfig Config;
+    // 为空时从服务端当前的写入位置开始，只接收此后的提交
+    BinlogPosition Start;
+    // 作为从库注册时使用的 server_id，不能与复制拓扑中的其他实例重复；0 表示随机取一个较大的值
+    uint32_t ServerId = 0;
+    // 只解码这些表的行事件，写为 "库.表" 或 "库.*"；为空时解码全部
+    std::vector<std::string> Tables;
+    std::chrono::seconds HeartbeatPeriod{ 15 };
+    std::chrono::milliseconds ReconnectDelay{ 1000 };
+};
+
+enum class RowChangeKind : uint8_t
+{
+    Insert,
+    Update,
+    Delete
+};
+
+// 空值为 monostate；整数按列的符号性给出；DECIMAL、日期时间按 SQL 文本给出；字符串与 BLOB 为原始字节，JSON 为服务端二进制格式
+using BinlogValue = std::variant<std::monostate, int64_t, uint64_t, double, std::string>;
+
+struct RowChange
+{
+    RowChangeKind Kind = RowChangeKind::Insert;
+    std::string Database;
+    std::string Table;
+    // 与表结构对应的列名和主键列下标，由 binlog_row_metadata=FULL 的元数据或 information_schema 得到
+    std::shared_ptr<const std::vector<std::string>> ColumnNames;
+    std::shared_ptr<const std::vector<std::size_t>> KeyIndexes;
+    // Update 和 Delete 有 Before，Insert 和 Update 有 After；binlog_row_image=MINIMAL 时未记录的列为 monostate。
+    // 行映像无法解码时两者都为空，订阅者应按整表失效处理
+    std::vector<BinlogValue> Before;
+    std::vector<BinlogValue> After;
+};
+
+// 空值为 NULL；字符串原样返回，含控制字符的内容（BLOB、JSON 等）按 0x 十六进制给出
+[[nodiscard]] auto FormatBinlogValue(const BinlogValue& Value) -> std::string;
+
+// 一个已提交的事务。DDL 等语句事件单独成为只含 Statements 的事务
+struct ChangeTransaction
+{
+    std::string Gtid;
+    // 提交之后的位置，从这里重新订阅不会重复收到该事务
+    BinlogPosition Position;
+    std::chrono::system_clock::time_point CommitTime;
+    std::vector<RowChange> Rows;
+    std::vector<std::string> Statements;
+    // 与 Statements 一一对应：执行该语句时的默认库，未选库时为空
+    std::vector<std::string> StatementDatabases;
+    // 语句事件按库名、表名在 SQL 文本中的出现粗略判断，可能多报但不会漏报
+    [[nodiscard]] auto Touches(std::string_view DatabaseName, std::string_view TableName) const -> bool;
+};
+
+struct BinlogStatistics
+{
+    uint64_t Events = 0;
+    uint64_t Bytes = 0;
+    uint64_t Transactions = 0;
+    uint64_t RowChanges = 0;
+    // 未能解码（如压缩事务负载、不支持的列类型）而跳过的事件
+    uint64_t SkippedEvents = 0;
+    uint64_t Reconnects = 0;
+    // 最近一个事件的提交时间与本地时间之差
+    std::chrono::milliseconds Lag{ 0 };
+};
+
+// 以从库身份向服务端请求 binlog（COM_BINLOG_DUMP / COM_BINLOG_DUMP_GTID），把基于行的事件解码为逐行的变更，
+// 按事务提交后交给订阅者。复制协议由本类直接实现：Connector/C++ 不提供 binlog 接口。
+// 服务端需开启 binlog_format=ROW，账号需要 REPLICATION SLAVE 与 REPLICATION CLIENT 权限。
+// 复制连接不支持 TLS：caching_sha2_password 账号依赖服务端的认证缓存，Start 会先用普通连接登录一次以填充缓存。
+class BinlogReader
+{
+public:
+    using Subscriber = std::function<void(const ChangeTransaction&)>;
+    using SubscriptionId = uint64_t;
+private:
+    struct ReplicationStream;
+    struct TableInfo
+    {
+        std::string Database;
+        std::string Table;
+        std::vector<uint8_t> ColumnTypes;
+        std::vector<uint16_t> ColumnMetadata;
+        std::vector<bool> IsUnsigned;
+        std::shared_ptr<const std::vector<std::string>> ColumnNames;
+        std::shared_ptr<const std::vector<std::size_t>> KeyIndexes;
+        bool IsIncluded = true;
+    };
+    struct Subscription
+    {
+        SubscriptionId Id = 0;
+        std::vector<std::string> Tables;
+        // 派发时在锁内复制后于锁外调用，取消订阅不会使正在执行的回调失效
+        std::shared_ptr<const Subscriber> Callback;
+    };
+    BinlogOptions Options;
+    // 查询起始位置和表结构用的普通连接
+    MySQLWrapper MetadataConnection;
+    std::unique_ptr<ReplicationStream> Stream;
+    std::mutex StreamMutex;
+    // 以下状态只由读取线程访问
+    std::string CurrentFile;
+    bool HasChecksum = false;
+    // 格式描述事件给出的各类事件的固定头长度，下标为事件类型减一
+    std::vector<uint8_t> PostHeaderLengths;
+    std::unordered_map<uint64_t, TableInfo> TableMaps;
+    // 按 "库.表" 缓存的列名与主键，DDL 后失效
+    std::unordered_map<std::string, std::pair<std::shared_ptr<const std::vector<std::string>>, std::shared_ptr<const std::vector<std::size_t>>>> SchemaCache;
+    ChangeTransaction Pending;
+    bool IsInTransaction = false;
+    mutable std::mutex StateMutex;
+    BinlogPosition CommittedPosition;
+    std::string LastError;
+    struct ReaderCounters
+    {
+        std::atomic<uint64_t> Events{ 0 };
+        std::atomic<uint64_t> Bytes{ 0 };
+        std::atomic<uint64_t> Transactions{ 0 };
+        std::atomic<uint64_t> RowChanges{ 0 };
+        std::atomic<uint64_t> SkippedEvents{ 0 };
+        std::atomic<uint64_t> Reconnects{ 0 };
+        std::atomic<int64_t> LastEventSeconds{ 0 };
+    } Counters;
+    std::mutex SubscriberMutex;
+    std::vector<Subscription> Subscribers;
+    SubscriptionId NextSubscriptionId = 1;
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    std::jthread ReadThread;
+    [[nodiscard]] auto OpenStream(const BinlogPosition& From) -> std::expected<void, std::string>;
+    auto ReadLoop(std::stop_token StopToken) -> void;
+    [[nodiscard]] auto HandleEvent(std::string_view Event) -> std::expected<void, std::string>;
+    [[nodiscard]] auto HandleTableMap(std::string_view Body, uint8_t PostHeaderLength) -> std::expected<void, std::string>;
+    [[nodiscard]] auto HandleRows(uint8_t EventType, std::string_view Body, uint8_t PostHeaderLength) -> std::expected<void, std::string>;
+    // 返回语句是否结束了当前事务
+    [[nodiscard]] auto HandleQuery(std::string_view Body, uint8_t PostHeaderLength) -> bool;
+    auto LoadSchema(TableInfo& Info) -> void;
+    auto CommitPending(uint64_t EndOffset) -> void;
+    auto Dispatch(const ChangeTransaction& Transaction) -> void;
+    auto SetLastError(std::string Message) -> void;
+public:
+    explicit BinlogReader(BinlogOptions OptionsParam);
+    ~BinlogReader();
+    BinlogReader(const BinlogReader&) = delete;
+    auto operator=(const BinlogReader&) -> BinlogReader & = delete;
+    // Tables 为空时接收全部事务，否则只接收涉及其中某张表（"库.表" 或 "库.*"）的事务。
+    // 语句事件（DDL、语句格式的 DML）按 ChangeTransaction::Touches 的规则粗略匹配，可能收到实际未涉及这些表的语句。
+    // 回调在读取线程上按提交顺序执行，耗时的处理应转交其他线程，否则会拖慢后续事件的读取。
+    // 回调执行时不持有订阅锁，可以在回调内订阅或取消订阅；Unsubscribe 返回时已开始派发的那个事务仍可能送达一次
+    [[nodiscard]] auto Subscribe(Subscriber Callback, std::vector<std::string> Tables = {}) -> SubscriptionId;
+    auto Unsubscribe(SubscriptionId Id) -> void;
+    // 建立复制连接后在后台线程读取；连接中断时从最后提交的位置重连
+    [[nodiscard]] auto Start() -> std::expected<void, std::string>;
+    auto Stop() -> void;
+    [[nodiscard]] auto GetPosition() const -> BinlogPosition;
+    [[nodiscard]] auto GetStatistics() const -> BinlogStatistics;
+    [[nodiscard]] auto GetLastError() const -> std::string;
+};
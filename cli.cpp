@@ -0,0 +1,967 @@
+#include "def.h"
+#include "database.h"
+#include "binlog.h"
+#include "formatter.hpp"
+#include "sqlscript.hpp"
+#include "exporter.h"
+#include "replay.h"
+#include "router.h"
+#include "watch.h"
+#include "workload.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace BatchClient
+{
+    enum class OutputFormat
+    {
+        Table,
+        Csv,
+        Ndjson
+    };
+
+    enum class SummaryMode
+    {
+        Statements,
+        Totals,
+        None
+    };
+
+    struct Options
+    {
+        MySQLConfig Config;
+        std::vector<std::string> InputPaths;
+        OutputFormat Format = OutputFormat::Table;
+        SummaryMode Summary = SummaryMode::Statements;
+        std::size_t Jobs = 1;
+        bool HasJobs = false;
+        bool IsUnordered = false;
+        bool IsForce = false;
+        std::chrono::milliseconds StatementTimeout{ 0 };
+        std::size_t MaxRows = 0;
+        std::size_t ResultMemoryMegabytes = 0;
+        std::string CapturePath;
+        std::string ReplayPath;
+        std::string ExportPath;
+        std::vector<std::string> ExportTables;
+        bool IsResume = false;
+        ReplaySpeed Speed = ReplaySpeed::Original;
+        double SpeedFactor = 1.0;
+        std::vector<std::string> HostSpecs;
+        std::vector<MySQLConfig> PrimaryCandidates;
+        std::vector<std::string> ReplicaSpecs;
+        std::vector<ReplicaEndpoint> Replicas;
+        std::chrono::milliseconds MaxReplicaLag{ 5000 };
+        bool IsReadYourWrites = false;
+        std::chrono::milliseconds WatchInterval{ 0 };
+        std::vector<std::string> WatchKeys;
+        std::size_t WatchCount = 0;
+        bool IsBinlog = false;
+        BinlogPosition BinlogStart;
+        uint32_t ServerId = 0;
+    };
+
+    struct ScriptInput
+    {
+        std::string Name;
+        std::vector<std::string> Statements;
+    };
+
+    // 有序模式下一个工作单元是整份脚本（同一连接内按顺序执行）；无序模式下是单条语句
+    struct WorkUnit
+    {
+        std::size_t InputIndex = 0;
+        std::size_t FirstStatement = 0;
+        std::size_t StatementCount = 0;
+    };
+
+    struct StatementTiming
+    {
+        std::size_t InputIndex = 0;
+        std::size_t StatementIndex = 0;
+        bool Success = false;
+        bool IsSkipped = true;
+        std::size_t RowCount = 0;
+        unsigned long long AffectedRows = 0;
+        QueryTiming Timing;
+        std::chrono::nanoseconds ExecutionTime{ 0 };
+    };
+
+    constexpr std::string_view UsageText =
+        "用法: cli [选项] [脚本文件... | -]\n"
+        "  --host=主机 --port=端口 --user=用户 --password=密码 --database=数据库\n"
+        "  --host=主机1[:端口],主机2[:端口]  多个候选主库，按探测评分选择并在故障时切换\n"
+        "  --socket=路径                通过 Unix 套接字连接（localhost 且默认端口时自动探测）\n"
+        "  --format=table|csv|ndjson    输出格式（默认 table）\n"
+        "  --jobs=N                     并行连接数（默认 1）\n"
+        "  --unordered                  语句之间无依赖，逐条分派到各连接\n"
+        "  --force                      出错后继续执行后续语句\n"
+        "  --timeout=毫秒               单条语句的截止时间，超时后中止语句（默认不限）\n"
+        "  --max-rows=N                 每个结果最多返回 N 行，简单 SELECT 改写为 LIMIT（默认不限）\n"
+        "  --result-memory=MB           每个结果驻留内存的上限，超出部分暂存到临时文件（默认 256）\n"
+        "  --summary=statements|totals|none  标准错误上的计时汇总（默认 statements）\n"
+        "  --capture=文件               把执行的语句及时间、会话、延迟记录到负载日志\n"
+        "  --replay=文件                回放负载日志（--jobs 为连接数，默认 8）\n"
+        "  --speed=original|max|倍数    回放速度（默认 original）\n"
+        "  --export=目录                在一致性快照下并行分块导出 --tables 指定的表（--jobs 为连接数，默认 4，格式为 csv 或 ndjson）\n"
+        "  --tables=表1,表2             要导出的表\n"
+        "  --resume                     按目录中的清单续传，跳过已完成的分块\n"
+        "  --replica=主机[:端口][/权重]  只读语句分发到从库（可重复指定），写入与事务留在主库\n"
+        "  --max-lag=毫秒               复制延迟超过该值的从库不再接收读请求（默认 5000）\n"
+        "  --read-your-writes           写入之后的读取等待从库追上本会话的 GTID，超时改读主库\n"
+        "  --watch=毫秒                 按间隔重复执行脚本中的单条查询，只输出与上一轮相比新增(+)、变化(~)、删除(-)的行\n"
+        "  --watch-key=列1,列2          以这些列标识行（默认以整行内容标识，内容变化表现为一删一增）\n"
+        "  --watch-count=N              执行 N 轮后退出（默认持续执行）\n"
+        "  --binlog[=文件[:位置]]       以从库身份订阅 binlog，逐行打印已提交的变更（默认从当前位置开始，--tables 可写 库.表 或 库.* 过滤）\n"
+        "  --binlog-gtid=GTID集合       从该集合之后的事务开始订阅\n"
+        "  --server-id=N                注册为从库时使用的 server_id（默认随机）\n"
+        "未指定脚本或脚本为 - 时从标准输入读取；未指定 --password 时读取环境变量 MYSQL_PWD。";
+
+    [[nodiscard]] auto ParseOptions(int ArgumentCount, char** Arguments) -> std::expected<Options, std::string>
+    {
+        Options RunOptions;
+        if (const char* Password = std::getenv("MYSQL_PWD"))
+            RunOptions.Config.Password = Password;
+        const auto ParseNumber = [](std::string_view Text, std::string_view OptionName) -> std::expected<unsigned int, std::string>
+        {
+            unsigned int Value = 0;
+            const auto [Pointer, ErrorCode] = std::from_chars(Text.data(), Text.data() + Text.size(), Value);
+            if (ErrorCode != std::errc{} || Pointer != Text.data() + Text.size() || Value == 0)
+                return std::unexpected(std::format("无效的 {} 参数: {}", OptionName, Text));
+            return Value;
+        };
+        for (int Index = 1; Index < ArgumentCount; ++Index)
+        {
+            const std::string_view Argument = Arguments[Index];
+            if (Argument == "-" || !Argument.starts_with("--"))
+            {
+                RunOptions.InputPaths.emplace_back(Argument);
+                continue;
+            }
+            const auto Separator = Argument.find('=');
+            const std::string_view Name = Argument.substr(0, Separator);
+            const std::string_view Value = Separator == std::string_view::npos ? std::string_view{} : Argument.substr(Separator + 1);
+            if (Name == "--host")
+            {
+                RunOptions.HostSpecs.clear();
+                for (std::size_t Start = 0; Start <= Value.size();)
+                {
+                    const std::size_t End = (std::min)(Value.find(',', Start), Value.size());
+                    if (End > Start)
+                        RunOptions.HostSpecs.emplace_back(Value.substr(Start, End - Start));
+                    Start = End + 1;
+                }
+            }
+            else if (Name == "--user")
+                RunOptions.Config.User = Value;
+            else if (Name == "--password")
+                RunOptions.Config.Password = Value;
+            else if (Name == "--database")
+                RunOptions.Config.Database = Value;
+            else if (Name == "--socket")
+                RunOptions.Config.UnixSocket = Value;
+            else if (Name == "--port" || Name == "--jobs" || Name == "--timeout" || Name == "--max-rows" || Name == "--result-memory" || Name == "--max-lag" || Name == "--watch" || Name == "--watch-count" || Name == "--server-id")
+            {
+                const auto Number = ParseNumber(Value, Name);
+                if (!Number)
+                    return std::unexpected(Number.error());
+                if (Name == "--port")
+                    RunOptions.Config.Port = *Number;
+                else if (Name == "--timeout")
+                    RunOptions.StatementTimeout = std::chrono::milliseconds(*Number);
+                else if (Name == "--max-rows")
+                    RunOptions.MaxRows = *Number;
+                else if (Name == "--result-memory")
+                    RunOptions.ResultMemoryMegabytes = *Number;
+                else if (Name == "--max-lag")
+                    RunOptions.MaxReplicaLag = std::chrono::milliseconds(*Number);
+                else if (Name == "--watch")
+                    RunOptions.WatchInterval = std::chrono::milliseconds(*Number);
+                else if (Name == "--watch-count")
+                    RunOptions.WatchCount = *Number;
+                else if (Name == "--server-id")
+                    RunOptions.ServerId = *Number;
+                else
+                {
+                    RunOptions.Jobs = *Number;
+                    RunOptions.HasJobs = true;
+                }
+            }
+            else if (Name == "--format")
+            {
+                if (Value == "table")
+                    RunOptions.Format = OutputFormat::Table;
+                else if (Value == "csv")
+                    RunOptions.Format = OutputFormat::Csv;
+                else if (Value == "ndjson")
+                    RunOptions.Format = OutputFormat::Ndjson;
+                else
+                    return std::unexpected(std::format("不支持的输出格式: {}", Value));
+            }
+            else if (Name == "--summary")
+            {
+                if (Value == "statements")
+                    RunOptions.Summary = SummaryMode::Statements;
+                else if (Value == "totals")
+                    RunOptions.Summary = SummaryMode::Totals;
+                else if (Value == "none")
+                    RunOptions.Summary = SummaryMode::None;
+                else
+                    return std::unexpected(std::format("不支持的汇总模式: {}", Value));
+            }
+            else if (Name == "--capture")
+                RunOptions.CapturePath = Value;
+            else if (Name == "--replay")
+                RunOptions.ReplayPath = Value;
+            else if (Name == "--export")
+                RunOptions.ExportPath = Value;
+            else if (Name == "--tables")
+            {
+                for (std::size_t Start = 0; Start <= Value.size();)
+                {
+                    const std::size_t End = (std::min)(Value.find(',', Start), Value.size());
+                    if (End > Start)
+                        RunOptions.ExportTables.emplace_back(Value.substr(Start, End - Start));
+                    Start = End + 1;
+                }
+            }
+            else if (Name == "--watch-key")
+            {
+                for (std::size_t Start = 0; Start <= Value.size();)
+                {
+                    const std::size_t End = (std::min)(Value.find(',', Start), Value.size());
+                    if (End > Start)
+                        RunOptions.WatchKeys.emplace_back(Value.substr(Start, End - Start));
+                    Start = End + 1;
+                }
+            }
+            else if (Name == "--binlog")
+            {
+                RunOptions.IsBinlog = true;
+                const auto PositionSeparator = Value.rfind(':');
+                RunOptions.BinlogStart.FileName = Value.substr(0, PositionSeparator);
+                if (PositionSeparator != std::string_view::npos)
+                {
+                    const auto Offset = ParseNumber(Value.substr(PositionSeparator + 1), Name);
+                    if (!Offset)
+                        return std::unexpected(Offset.error());
+                    RunOptions.BinlogStart.Offset = *Offset;
+                }
+            }
+            else if (Name == "--binlog-gtid")
+            {
+                RunOptions.IsBinlog = true;
+                RunOptions.BinlogStart.GtidSet = Value;
+            }
+            else if (Name == "--resume")
+                RunOptions.IsResume = true;
+            else if (Name == "--replica")
+                RunOptions.ReplicaSpecs.emplace_back(Value);
+            else if (Name == "--read-your-writes")
+                RunOptions.IsReadYourWrites = true;
+            else if (Name == "--speed")
+            {
+                if (Value == "original")
+                    RunOptions.Speed = ReplaySpeed::Original;
+                else if (Value == "max")
+                    RunOptions.Speed = ReplaySpeed::Maximum;
+                else
+                {
+                    double Factor = 0.0;
+                    const auto [Pointer, ErrorCode] = std::from_chars(Value.data(), Value.data() + Value.size(), Factor);
+                    if (ErrorCode != std::errc{} || Pointer != Value.data() + Value.size() || Factor <= 0.0)
+                        return std::unexpected(std::format("无效的 --speed 参数: {}", Value));
+                    RunOptions.Speed = ReplaySpeed::Scaled;
+                    RunOptions.SpeedFactor = Factor;
+                }
+            }
+            else if (Name == "--unordered")
+                RunOptions.IsUnordered = true;
+            else if (Name == "--force")
+                RunOptions.IsForce = true;
+            else if (Name == "--help")
+                return std::unexpected(std::string{ UsageText });
+            else
+                return std::unexpected(std::format("未知参数: {}\n{}", Argument, UsageText));
+        }
+        if (!RunOptions.ReplayPath.empty() && !RunOptions.InputPaths.empty())
+            return std::unexpected("--replay 不能与脚本输入同时使用");
+        if (!RunOptions.ExportPath.empty() && (!RunOptions.InputPaths.empty() || !RunOptions.ReplayPath.empty()))
+            return std::unexpected("--export 不能与脚本输入或 --replay 同时使用");
+        if (RunOptions.IsBinlog && (!RunOptions.InputPaths.empty() || !RunOptions.ReplayPath.empty() || !RunOptions.ExportPath.empty() || RunOptions.WatchInterval.count() > 0))
+            return std::unexpected("--binlog 不能与脚本输入、--replay、--export 或 --watch 同时使用");
+        if (!RunOptions.ExportPath.empty() && RunOptions.ExportTables.empty() && !RunOptions.IsResume)
+            return std::unexpected("--export 需要 --tables 或 --resume");
+        if (RunOptions.WatchInterval.count() > 0 && (!RunOptions.ReplayPath.empty() || !RunOptions.ExportPath.empty()))
+            return std::unexpected("--watch 不能与 --replay 或 --export 同时使用");
+        if (RunOptions.WatchInterval.count() > 0 && RunOptions.InputPaths.size() > 1)
+            return std::unexpected("--watch 只接受一个脚本输入");
+        // 各端点沿用 --user、--password 和 --database，因此在所有参数读完之后再展开
+        const auto ParseEndpoint = [&](std::string_view HostPort, std::string_view OptionName) -> std::expected<MySQLConfig, std::string>
+        {
+            MySQLConfig EndpointConfig = RunOptions.Config;
+            if (const auto PortSeparator = HostPort.rfind(':'); PortSeparator != std::string_view::npos)
+            {
+                const auto Port = ParseNumber(HostPort.substr(PortSeparator + 1), std::format("{} 端口", OptionName));
+                if (!Port)
+                    return std::unexpected(Port.error());
+                EndpointConfig.Port = *Port;
+                HostPort = HostPort.substr(0, PortSeparator);
+            }
+            if (HostPort.empty())
+                return std::unexpected(std::format("无效的 {} 参数", OptionName));
+            EndpointConfig.Host = HostPort;
+            return EndpointConfig;
+        };
+        if (RunOptions.HostSpecs.size() == 1)
+            RunOptions.Config.Host = RunOptions.HostSpecs.front();
+        else if (RunOptions.HostSpecs.size() > 1)
+        {
+            for (const std::string_view Spec : RunOptions.HostSpecs)
+            {
+                auto Candidate = ParseEndpoint(Spec, "--host");
+                if (!Candidate)
+                    return std::unexpected(Candidate.error());
+                Candidate->UnixSocket.clear();
+                RunOptions.PrimaryCandidates.push_back(std::move(*Candidate));
+            }
+            RunOptions.Config = RunOptions.PrimaryCandidates.front();
+        }
+        for (const std::string_view Spec : RunOptions.ReplicaSpecs)
+        {
+            std::string_view HostPort = Spec;
+            unsigned int Weight = 1;
+            if (const auto WeightSeparator = Spec.rfind('/'); WeightSeparator != std::string_view::npos)
+            {
+                const auto ParsedWeight = ParseNumber(Spec.substr(WeightSeparator + 1), "--replica 权重");
+                if (!ParsedWeight)
+                    return std::unexpected(ParsedWeight.error());
+                Weight = *ParsedWeight;
+                HostPort = Spec.substr(0, WeightSeparator);
+            }
+            auto ReplicaConfig = ParseEndpoint(HostPort, "--replica");
+            if (!ReplicaConfig)
+                return std::unexpected(ReplicaConfig.error());
+            ReplicaConfig->UnixSocket.clear();
+            RunOptions.Replicas.push_back({ std::move(*ReplicaConfig), Weight });
+        }
+        if (RunOptions.InputPaths.empty())
+            RunOptions.InputPaths.emplace_back("-");
+        return RunOptions;
+    }
+
+    [[nodiscard]] auto ReadInput(const std::string& Path) -> std::expected<std::string, std::string>
+    {
+        std::string Content;
+        if (Path == "-")
+            Content.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        else
+        {
+            std::ifstream InputFile(Path, std::ios::binary);
+            if (!InputFile)
+                return std::unexpected(std::format("无法打开脚本文件: {}", Path));
+            Content.assign(std::istreambuf_iterator<char>(InputFile), std::istreambuf_iterator<char>());
+        }
+        if (Content.starts_with("\xEF\xBB\xBF"))
+            Content.erase(0, 3);
+        return Content;
+    }
+
+    [[nodiscard]] auto StatementPreview(std::string_view Statement) -> std::string
+    {
+        constexpr std::size_t MaxPreviewLength = 60;
+        std::string Preview;
+        for (const char CharValue : Statement)
+        {
+            if (Preview.size() >= MaxPreviewLength)
+            {
+                // 不截断在 UTF-8 多字节字符中间
+                while (!Preview.empty() && (static_cast<unsigned char>(Preview.back()) & 0xC0) == 0x80)
+                    Preview.pop_back();
+                if (!Preview.empty() && static_cast<unsigned char>(Preview.back()) >= 0xC0)
+                    Preview.pop_back();
+                Preview += "...";
+                break;
+            }
+            const bool IsSpace = CharValue == '\n' || CharValue == '\r' || CharValue == '\t' || CharValue == ' ';
+            if (IsSpace && (Preview.empty() || Preview.back() == ' '))
+                continue;
+            Preview += IsSpace ? ' ' : CharValue;
+        }
+        return Preview;
+    }
+
+    class ResultWriter
+    {
+    private:
+        OutputFormat Format;
+        bool HasMultipleSources;
+        std::mutex OutputMutex;
+        bool HasWrittenCsv = false;
+    public:
+        ResultWriter(OutputFormat FormatValue, bool MultipleSources) : Format(FormatValue), HasMultipleSources(MultipleSources) {}
+        auto Write(const ScriptInput& Input, std::size_t StatementIndex, const MySQLResult& ResultData) -> void
+        {
+            std::string Output;
+            switch (Format)
+            {
+            case OutputFormat::Table:
+                Output = HasMultipleSources ? std::format("--- {} 语句 {} ---\n", Input.Name, StatementIndex + 1) : std::format("--- 语句 {} ---\n", StatementIndex + 1);
+                Output += TableFormatter{ "\n" }.Format(ResultData);
+                Output += '\n';
+                break;
+            case OutputFormat::Csv:
+                if (ResultData.Success && !ResultData.ColumnNames.empty())
+                    Output = FormatCsv(ResultData);
+                break;
+            case OutputFormat::Ndjson:
+            {
+                std::string Prefix = "{\"source\":";
+                AppendJsonString(Prefix, Input.Name);
+                Prefix += std::format(",\"statement\":{},", StatementIndex + 1);
+                if (!ResultData.Success)
+                {
+                    Output += Prefix + "\"error\":";
+                    AppendJsonString(Output, ResultData.ErrorMessage);
+                    Output += "}\n";
+                }
+                else if (ResultData.ColumnNames.empty())
+                    Output += Prefix + std::format("\"affected_rows\":{}}}\n", ResultData.AffectedRows);
+                else
+                {
+                    for (const auto& RowData : ResultData.Rows)
+                    {
+                        Output += Prefix + "\"row\":";
+                        AppendJsonRow(Output, ResultData.ColumnNames, RowData);
+                        Output += "}\n";
+                    }
+                }
+                break;
+            }
+            }
+            if (!ResultData.Success && Format == OutputFormat::Csv)
+                std::println(stderr, "{} 语句 {}: 错误: {}", Input.Name, StatementIndex + 1, ResultData.ErrorMessage);
+            if (Output.empty())
+                return;
+            std::lock_guard<std::mutex> Lock(OutputMutex);
+            if (Format == OutputFormat::Csv && std::exchange(HasWrittenCsv, true))
+                std::fputc('\n', stdout);
+            std::fwrite(Output.data(), 1, Output.size(), stdout);
+            std::fflush(stdout);
+        }
+    };
+
+    [[nodiscard]] auto FormatMilliseconds(std::chrono::nanoseconds Duration) -> std::string
+    {
+        return std::format("{:.3f}", std::chrono::duration<double, std::milli>(Duration).count());
+    }
+
+    auto PrintSummary(const Options& RunOptions, const std::vector<ScriptInput>& Inputs, const std::vector<StatementTiming>& Timings, std::chrono::nanoseconds WallTime) -> void
+    {
+        if (RunOptions.Summary == SummaryMode::None)
+            return;
+        LatencyHistogram Histogram;
+        std::size_t SucceededCount = 0;
+        std::size_t FailedCount = 0;
+        std::size_t SkippedCount = 0;
+        QueryTiming PhaseTotals;
+        if (RunOptions.Summary == SummaryMode::Statements)
+            std::println(stderr, "{:<24} {:>6} {:>6} {:>10} {:>12} {:>12} {:>12} {:>12}  {}", "来源", "序号", "状态", "行数", "总计ms", "执行ms", "拉取ms", "物化ms", "语句");
+        for (const auto& Timing : Timings)
+        {
+            if (Timing.IsSkipped)
+            {
+                ++SkippedCount;
+                continue;
+            }
+            Timing.Success ? ++SucceededCount : ++FailedCount;
+            Histogram.Record(Timing.ExecutionTime);
+            PhaseTotals.Validation += Timing.Timing.Validation;
+            PhaseTotals.Execute += Timing.Timing.Execute;
+            PhaseTotals.Fetch += Timing.Timing.Fetch;
+            PhaseTotals.Materialize += Timing.Timing.Materialize;
+            if (RunOptions.Summary == SummaryMode::Statements)
+            {
+                const ScriptInput& Input = Inputs[Timing.InputIndex];
+                std::println(stderr, "{:<24} {:>6} {:>6} {:>10} {:>12} {:>12} {:>12} {:>12}  {}", Input.Name, Timing.StatementIndex + 1, Timing.Success ? "成功" : "失败",
+                    Timing.RowCount > 0 ? Timing.RowCount : Timing.AffectedRows, FormatMilliseconds(Timing.ExecutionTime), FormatMilliseconds(Timing.Timing.Execute),
+                    FormatMilliseconds(Timing.Timing.Fetch), FormatMilliseconds(Timing.Timing.Materialize), StatementPreview(Inputs[Timing.InputIndex].Statements[Timing.StatementIndex]));
+            }
+        }
+        const LatencySnapshot Snapshot = Histogram.Snapshot();
+        const double WallSeconds = std::chrono::duration<double>(WallTime).count();
+        std::println(stderr, "语句: {} 成功, {} 失败, {} 未执行; 耗时 {:.3f} s, {:.1f} 条/秒", SucceededCount, FailedCount, SkippedCount, WallSeconds,
+            WallSeconds > 0.0 ? static_cast<double>(Snapshot.Count) / WallSeconds : 0.0);
+        if (Snapshot.Count > 0)
+        {
+            std::println(stderr, "延迟 ms: 平均 {:.3f}, p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, 最大 {:.3f}", static_cast<double>(Snapshot.Mean()) / 1e6,
+                static_cast<double>(Snapshot.P50) / 1e6, static_cast<double>(Snapshot.P95) / 1e6, static_cast<double>(Snapshot.P99) / 1e6, static_cast<double>(Snapshot.Max) / 1e6);
+            std::println(stderr, "阶段合计 ms: 校验 {}, 执行 {}, 拉取 {}, 物化 {}", FormatMilliseconds(PhaseTotals.Validation), FormatMilliseconds(PhaseTotals.Execute),
+                FormatMilliseconds(PhaseTotals.Fetch), FormatMilliseconds(PhaseTotals.Materialize));
+        }
+    }
+}
+
+namespace BatchClient
+{
+    [[nodiscard]] auto FormatLatencyLine(std::string_view Label, const LatencySnapshot& Snapshot) -> std::string
+    {
+        return std::format("{}: 平均 {:.3f}, p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, 最大 {:.3f} ms", Label, static_cast<double>(Snapshot.Mean()) / 1e6, static_cast<double>(Snapshot.P50) / 1e6,
+            static_cast<double>(Snapshot.P95) / 1e6, static_cast<double>(Snapshot.P99) / 1e6, static_cast<double>(Snapshot.Max) / 1e6);
+    }
+
+    auto AppendJsonLatency(std::string& Output, std::string_view Name, const LatencySnapshot& Snapshot) -> void
+    {
+        Output += std::format("\"{}\":{{\"count\":{},\"mean_ns\":{},\"p50_ns\":{},\"p95_ns\":{},\"p99_ns\":{},\"max_ns\":{}}}", Name, Snapshot.Count, Snapshot.Mean(),
+            Snapshot.P50, Snapshot.P95, Snapshot.P99, Snapshot.Max);
+    }
+
+    [[nodiscard]] auto RunReplay(const Options& RunOptions) -> int
+    {
+        const auto Log = WorkloadRecorder::Load(RunOptions.ReplayPath);
+        if (!Log)
+        {
+            std::println(stderr, "{}", Log.error());
+            return 2;
+        }
+        if (Log->IsTruncated)
+            std::println(stderr, "负载日志末尾不完整，已回放前 {} 条记录", Log->Events.size());
+        ReplayOptions Replay;
+        Replay.Config = RunOptions.Config;
+        Replay.Speed = RunOptions.Speed;
+        Replay.SpeedFactor = RunOptions.SpeedFactor;
+        Replay.ConnectionCount = RunOptions.HasJobs ? RunOptions.Jobs : 8;
+        Replay.StopOnError = !RunOptions.IsForce;
+        EventLogger::Instance().SetMinLevel(EventLevel::Off);
+        WorkloadReplayer Replayer(std::move(Replay));
+        const auto Report = Replayer.Run(*Log);
+        if (!Report)
+        {
+            std::println(stderr, "{}", Report.error());
+            return 2;
+        }
+        if (RunOptions.Format == OutputFormat::Ndjson)
+        {
+            std::string Output = std::format("{{\"events\":{},\"succeeded\":{},\"failed\":{},\"outcome_mismatches\":{},\"sessions\":{},\"connections\":{},\"elapsed_ns\":{},\"throughput\":{:.1f},",
+                Report->EventCount, Report->SucceededCount, Report->FailedCount, Report->OutcomeMismatchCount, Report->SessionCount, Report->ConnectionCount, Report->Elapsed.count(), Report->Throughput());
+            AppendJsonLatency(Output, "latency", Report->Latency);
+            Output += ',';
+            AppendJsonLatency(Output, "captured_latency", Report->CapturedLatency);
+            Output += ',';
+            AppendJsonLatency(Output, "schedule_lag", Report->ScheduleLag);
+            Output += "}";
+            std::println("{}", Output);
+        }
+        else
+        {
+            std::println("回放 {} 条语句（{} 个会话，{} 条连接）: {} 成功, {} 失败, {} 条结果与采集时不一致", Report->EventCount, Report->SessionCount, Report->ConnectionCount,
+                Report->SucceededCount, Report->FailedCount, Report->OutcomeMismatchCount);
+            std::println("耗时 {:.3f} s, 吞吐 {:.1f} 条/秒", std::chrono::duration<double>(Report->Elapsed).count(), Report->Throughput());
+            std::println("{}", FormatLatencyLine("回放延迟", Report->Latency));
+            std::println("{}", FormatLatencyLine("采集延迟", Report->CapturedLatency));
+            if (Report->ScheduleLag.Count > 0)
+                std::println("{}", FormatLatencyLine("调度滞后", Report->ScheduleLag));
+            for (const auto& ErrorText : Report->SampleErrors)
+                std::println(stderr, "{}", ErrorText);
+        }
+        return Report->FailedCount > 0 ? 1 : 0;
+    }
+
+    [[nodiscard]] auto RunExport(const Options& RunOptions) -> int
+    {
+        if (RunOptions.Format == OutputFormat::Table)
+        {
+            std::println(stderr, "导出只支持 csv 或 ndjson 格式");
+            return 2;
+        }
+        ExportOptions Export;
+        Export.Config = RunOptions.Config;
+        Export.Tables = RunOptions.ExportTables;
+        Export.OutputDirectory = RunOptions.ExportPath;
+        Export.Format = RunOptions.Format == OutputFormat::Csv ? ExportFormat::Csv : ExportFormat::Ndjson;
+        Export.ConnectionCount = RunOptions.HasJobs ? RunOptions.Jobs : 4;
+        Export.Resume = RunOptions.IsResume;
+        EventLogger::Instance().SetMinLevel(EventLevel::Off);
+        ParallelExporter Exporter(std::move(Export));
+        const auto Report = Exporter.Run();
+        if (!Report)
+        {
+            std::println(stderr, "{}", Report.error());
+            return 2;
+        }
+        std::println("导出 {} 张表 {} 块（跳过已完成 {} 块，失败 {} 块）: {} 行, {} 字节", Report->TableCount, Report->ChunkCount, Report->SkippedChunkCount,
+            Report->FailedChunkCount, Report->RowCount, Report->ByteCount);
+        std::println("耗时 {:.3f} s, 吞吐 {:.1f} MB/s, 快照位置 {}{}", std::chrono::duration<double>(Report->Elapsed).count(), Report->Throughput() / (1024.0 * 1024.0),
+            Report->SnapshotPosition.empty() ? "(无 GTID)" : Report->SnapshotPosition, Report->IsLockFree ? "（无锁 GTID 校验）" : "");
+        for (const auto& ErrorText : Report->Errors)
+            std::println(stderr, "{}", ErrorText);
+        return Report->FailedChunkCount > 0 ? 1 : 0;
+    }
+
+    [[nodiscard]] auto RunWatch(const Options& RunOptions) -> int
+    {
+        const auto Content = ReadInput(RunOptions.InputPaths.front());
+        if (!Content)
+        {
+            std::println(stderr, "{}", Content.error());
+            return 2;
+        }
+        const auto Statements = SplitSQLStatements(*Content);
+        if (Statements.size() != 1)
+        {
+            std::println(stderr, "--watch 需要恰好一条查询语句，输入中有 {} 条", Statements.size());
+            return 2;
+        }
+        WatchOptions Watch;
+        Watch.Config = RunOptions.Config;
+        Watch.SqlQuery = Statements.front();
+        Watch.Interval = RunOptions.WatchInterval;
+        Watch.KeyColumns = RunOptions.WatchKeys;
+        EventLogger::Instance().SetMinLevel(EventLevel::Off);
+        QueryWatcher Watcher(std::move(Watch));
+        if (const auto Connected = Watcher.Connect(); !Connected)
+        {
+            std::println(stderr, "{}", Connected.error());
+            return 2;
+        }
+        // 在当前线程上按固定节拍执行，输出即时刷新，便于接到管道另一端
+        auto NextRun = std::chrono::steady_clock::now();
+        bool HasError = false;
+        for (std::size_t Round = 0; RunOptions.WatchCount == 0 || Round < RunOptions.WatchCount; ++Round)
+        {
+            if (Round > 0)
+                std::this_thread::sleep_until(NextRun);
+            const WatchDelta Delta = Watcher.RunOnce();
+            HasError = !Delta.ErrorMessage.empty();
+            if (Delta.HasChanges())
+            {
+                std::fputs(FormatWatchDelta(Delta, "\n").c_str(), HasError ? stderr : stdout);
+                std::fflush(HasError ? stderr : stdout);
+            }
+            NextRun = (std::max)(NextRun + RunOptions.WatchInterval, std::chrono::steady_clock::now());
+        }
+        return HasError ? 1 : 0;
+    }
+
+    auto AppendJsonBinlogImage(std::string& Output, const RowChange& Change, const std::vector<BinlogValue>& Values) -> void
+    {
+        Output += '{';
+        for (std::size_t Index = 0; Index < Values.size(); ++Index)
+        {
+            if (Index > 0)
+                Output += ',';
+            AppendJsonString(Output, Change.ColumnNames && Index < Change.ColumnNames->size() ? (*Change.ColumnNames)[Index] : std::format("@{}", Index + 1));
+            Output += ':';
+            const BinlogValue& Value = Values[Index];
+            if (std::holds_alternative<std::monostate>(Value))
+                Output += "null";
+            else if (std::holds_alternative<std::string>(Value))
+                AppendJsonString(Output, FormatBinlogValue(Value));
+            else
+                Output += FormatBinlogValue(Value);
+        }
+        Output += '}';
+    }
+
+    [[nodiscard]] auto FormatBinlogTransaction(const ChangeTransaction& Transaction, OutputFormat Format) -> std::string
+    {
+        static constexpr std::array<std::string_view, 3> KindNames{ "insert", "update", "delete" };
+        std::string Output;
+        if (Format == OutputFormat::Ndjson)
+        {
+            Output += "{\"gtid\":";
+            AppendJsonString(Output, Transaction.Gtid);
+            Output += ",\"file\":";
+            AppendJsonString(Output, Transaction.Position.FileName);
+            Output += std::format(",\"position\":{},\"commit_time\":{},\"rows\":[", Transaction.Position.Offset,
+                std::chrono::duration_cast<std::chrono::seconds>(Transaction.CommitTime.time_since_epoch()).count());
+            for (std::size_t Index = 0; Index < Transaction.Rows.size(); ++Index)
+            {
+                const RowChange& Change = Transaction.Rows[Index];
+                if (Index > 0)
+                    Output += ',';
+                Output += std::format("{{\"type\":\"{}\",\"table\":", KindNames[static_cast<std::size_t>(Change.Kind)]);
+                AppendJsonString(Output, std::format("{}.{}", Change.Database, Change.Table));
+                Output += ",\"before\":";
+                AppendJsonBinlogImage(Output, Change, Change.Before);
+                Output += ",\"after\":";
+                AppendJsonBinlogImage(Output, Change, Change.After);
+                Output += '}';
+            }
+            Output += "],\"statements\":[";
+            for (std::size_t Index = 0; Index < Transaction.Statements.size(); ++Index)
+            {
+                if (Index > 0)
+                    Output += ',';
+                AppendJsonString(Output, Transaction.Statements[Index]);
+            }
+            Output += "]}\n";
+            return Output;
+        }
+        const auto ColumnName = [](const RowChange& Change, std::size_t Index)
+        {
+            return Change.ColumnNames && Index < Change.ColumnNames->size() ? (*Change.ColumnNames)[Index] : std::format("@{}", Index + 1);
+        };
+        Output += std::format("# {} {}:{}\n", Transaction.Gtid.empty() ? "(无 GTID)" : Transaction.Gtid, Transaction.Position.FileName, Transaction.Position.Offset);
+        for (const RowChange& Change : Transaction.Rows)
+        {
+            const std::vector<BinlogValue>& Image = Change.Kind == RowChangeKind::Delete ? Change.Before : Change.After;
+            Output += std::format("{} {}.{}", Change.Kind == RowChangeKind::Insert ? '+' : Change.Kind == RowChangeKind::Update ? '~' : '-', Change.Database, Change.Table);
+            for (std::size_t Index = 0; Index < Image.size(); ++Index)
+            {
+                // 更新只打印变化的列和主键列
+                const bool IsKey = Change.KeyIndexes && std::ranges::find(*Change.KeyIndexes, Index) != Change.KeyIndexes->end();
+                if (Change.Kind == RowChangeKind::Update && !IsKey && Index < Change.Before.size() && Change.Before[Index] == Image[Index])
+                    continue;
+                Output += std::format(" {}={}", ColumnName(Change, Index), FormatBinlogValue(Image[Index]));
+                if (Change.Kind == RowChangeKind::Update && !IsKey && Index < Change.Before.size())
+                    Output += std::format("（原 {}）", FormatBinlogValue(Change.Before[Index]));
+            }
+            if (Image.empty())
+                Output += " （行映像无法解码）";
+            Output += '\n';
+        }
+        for (const auto& Statement : Transaction.Statements)
+            Output += std::format("! {}\n", Statement);
+        return Output;
+    }
+
+    [[nodiscard]] auto RunBinlog(const Options& RunOptions) -> int
+    {
+        if (RunOptions.Format == OutputFormat::Csv)
+        {
+            std::println(stderr, "binlog 订阅只支持 table 或 ndjson 格式");
+            return 2;
+        }
+        BinlogOptions Binlog;
+        Binlog.Config = RunOptions.Config;
+        Binlog.Start = RunOptions.BinlogStart;
+        Binlog.ServerId = RunOptions.ServerId;
+        Binlog.Tables = RunOptions.ExportTables;
+        EventLogger::Instance().SetMinLevel(EventLevel::Off);
+        BinlogReader Reader(std::move(Binlog));
+        (void)Reader.Subscribe([Format = RunOptions.Format](const ChangeTransaction& Transaction)
+        {
+            std::fputs(FormatBinlogTransaction(Transaction, Format).c_str(), stdout);
+            std::fflush(stdout);
+        }, RunOptions.ExportTables);
+        if (const auto Started = Reader.Start(); !Started)
+        {
+            std::println(stderr, "{}", Started.error());
+            return 2;
+        }
+        const BinlogPosition Position = Reader.GetPosition();
+        std::println(stderr, "开始订阅 binlog: {}", Position.GtidSet.empty() ? std::format("{}:{}", Position.FileName, Position.Offset) : Position.GtidSet);
+        // 直到进程被中断；读取线程自行重连，这里只把新的错误打印到标准错误
+        std::string ReportedError;
+        for (;;)
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::string CurrentError = Reader.GetLastError();
+            if (!CurrentError.empty() && CurrentError != ReportedError)
+                std::println(stderr, "{}", CurrentError);
+            ReportedError = std::move(CurrentError);
+        }
+    }
+}
+
+auto main(int ArgumentCount, char** Arguments) -> int
+{
+    using namespace BatchClient;
+    const auto ParsedOptions = ParseOptions(ArgumentCount, Arguments);
+    if (!ParsedOptions)
+    {
+        std::println(stderr, "{}", ParsedOptions.error());
+        return 2;
+    }
+    const Options& RunOptions = *ParsedOptions;
+    if (!RunOptions.ReplayPath.empty())
+        return RunReplay(RunOptions);
+    if (!RunOptions.ExportPath.empty())
+        return RunExport(RunOptions);
+    if (RunOptions.WatchInterval.count() > 0)
+        return RunWatch(RunOptions);
+    if (RunOptions.IsBinlog)
+        return RunBinlog(RunOptions);
+
+    std::vector<ScriptInput> Inputs;
+    std::vector<StatementTiming> Timings;
+    std::vector<std::size_t> TimingOffsets;
+    for (const auto& Path : RunOptions.InputPaths)
+    {
+        const auto Content = ReadInput(Path);
+        if (!Content)
+        {
+            std::println(stderr, "{}", Content.error());
+            return 2;
+        }
+        ScriptInput Input{ Path == "-" ? "stdin" : Path, SplitSQLStatements(*Content) };
+        TimingOffsets.push_back(Timings.size());
+        for (std::size_t Index = 0; Index < Input.Statements.size(); ++Index)
+        {
+            StatementTiming& Timing = Timings.emplace_back();
+            Timing.InputIndex = Inputs.size();
+            Timing.StatementIndex = Index;
+        }
+        Inputs.push_back(std::move(Input));
+    }
+
+    std::vector<WorkUnit> Units;
+    for (std::size_t InputIndex = 0; InputIndex < Inputs.size(); ++InputIndex)
+    {
+        const std::size_t StatementCount = Inputs[InputIndex].Statements.size();
+        if (RunOptions.IsUnordered)
+        {
+            for (std::size_t Index = 0; Index < StatementCount; ++Index)
+                Units.push_back({ InputIndex, Index, 1 });
+        }
+        else if (StatementCount > 0)
+            Units.push_back({ InputIndex, 0, StatementCount });
+    }
+    if (Units.empty())
+    {
+        std::println(stderr, "未检测到有效的 SQL 语句。");
+        return 0;
+    }
+
+    EventLogger::Instance().SetMinLevel(EventLevel::Off);
+    std::shared_ptr<WorkloadRecorder> Recorder;
+    if (!RunOptions.CapturePath.empty())
+    {
+        Recorder = std::make_shared<WorkloadRecorder>();
+        if (const auto Started = Recorder->Start(RunOptions.CapturePath); !Started)
+        {
+            std::println(stderr, "{}", Started.error());
+            return 2;
+        }
+    }
+    ResultWriter Writer(RunOptions.Format, Inputs.size() > 1);
+    std::atomic<std::size_t> NextUnit{ 0 };
+    std::atomic<bool> IsAborted{ false };
+    std::atomic<bool> HasFailure{ false };
+    std::atomic<bool> HasConnectionFailure{ false };
+    RoutingConfig Routing;
+    Routing.Primary = RunOptions.Config;
+    if (!RunOptions.PrimaryCandidates.empty())
+        Routing.PrimaryFailover = std::make_shared<EndpointHealthMonitor>(RunOptions.PrimaryCandidates);
+    Routing.Replicas = RunOptions.Replicas;
+    Routing.MaxReplicaLag = RunOptions.MaxReplicaLag;
+    const auto Monitor = Routing.Replicas.empty() ? nullptr : std::make_shared<ReplicaMonitor>(Routing.Replicas, Routing.ProbeInterval);
+    std::mutex RoutingMutex;
+    RoutingStatistics RoutingTotals;
+    RetryStatistics RetryTotals;
+    const std::size_t WorkerCount = (std::min)(RunOptions.Jobs, Units.size());
+    const auto StartTime = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> Workers;
+        Workers.reserve(WorkerCount);
+        for (std::size_t WorkerIndex = 0; WorkerIndex < WorkerCount; ++WorkerIndex)
+        {
+            Workers.emplace_back([&]
+            {
+                // 没有从库时路由器只持有主库连接，所有语句照常发往主库
+                auto Router = std::make_unique<QueryRouter>(Routing, Monitor);
+                if (const auto Connected = Router->Connect(); !Connected)
+                {
+                    std::println(stderr, "连接失败: {}", Connected.error());
+                    HasConnectionFailure = true;
+                    IsAborted = true;
+                    return;
+                }
+                Router->ForEachConnection([&](MySQLWrapper& Connection)
+                    {
+                        Connection.SetWorkloadRecorder(Recorder);
+                        Connection.SetResultLimit(RunOptions.MaxRows, ResultLimitMode::ServerSide);
+                        if (RunOptions.ResultMemoryMegabytes > 0)
+                            Connection.SetResultMemoryBudget(RunOptions.ResultMemoryMegabytes << 20);
+                    });
+                if (RunOptions.IsReadYourWrites)
+                    Router->SetReadConsistency(ReadConsistency::ReadYourWrites);
+                while (!IsAborted.load(std::memory_order_relaxed))
+                {
+                    const std::size_t UnitIndex = NextUnit.fetch_add(1, std::memory_order_relaxed);
+                    if (UnitIndex >= Units.size())
+                        break;
+                    const WorkUnit& Unit = Units[UnitIndex];
+                    const ScriptInput& Input = Inputs[Unit.InputIndex];
+                    for (std::size_t Index = Unit.FirstStatement; Index < Unit.FirstStatement + Unit.StatementCount; ++Index)
+                    {
+                        const MySQLResult ResultData = Router->Query(Input.Statements[Index], RunOptions.StatementTimeout);
+                        StatementTiming& Timing = Timings[TimingOffsets[Unit.InputIndex] + Index];
+                        Timing.IsSkipped = false;
+                        Timing.Success = ResultData.Success;
+                        Timing.RowCount = ResultData.Rows.size();
+                        Timing.AffectedRows = ResultData.AffectedRows;
+                        Timing.Timing = ResultData.Timing;
+                        Timing.ExecutionTime = ResultData.ExecutionTime;
+                        Writer.Write(Input, Index, ResultData);
+                        if (!ResultData.Success)
+                        {
+                            HasFailure = true;
+                            if (!RunOptions.IsForce)
+                            {
+                                IsAborted = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+                const RoutingStatistics Routed = Router->GetStatistics();
+                std::lock_guard<std::mutex> Lock(RoutingMutex);
+                RoutingTotals.PrimaryStatements += Routed.PrimaryStatements;
+                RoutingTotals.ReplicaReads += Routed.ReplicaReads;
+                RoutingTotals.FallbackReads += Routed.FallbackReads;
+                RoutingTotals.GtidWaits += Routed.GtidWaits;
+                RoutingTotals.GtidWaitTimeouts += Routed.GtidWaitTimeouts;
+                const RetryStatistics Retried = Router->GetPrimary().GetRetryStatistics();
+                RetryTotals.StatementRetries += Retried.StatementRetries;
+                RetryTotals.TransactionReplays += Retried.TransactionReplays;
+                RetryTotals.Deadlocks += Retried.Deadlocks;
+                RetryTotals.ConnectionLosses += Retried.ConnectionLosses;
+                RetryTotals.ExhaustedRetries += Retried.ExhaustedRetries;
+                RetryTotals.RetryTime += Retried.RetryTime;
+            });
+        }
+    }
+    if (Recorder)
+    {
+        Recorder->Stop();
+        std::println(stderr, "已采集 {} 条语句到 {}", Recorder->GetRecordedCount(), RunOptions.CapturePath);
+    }
+    if (HasConnectionFailure)
+        return 2;
+    const auto WallTime = std::chrono::steady_clock::now() - StartTime;
+    PrintSummary(RunOptions, Inputs, Timings, std::chrono::duration_cast<std::chrono::nanoseconds>(WallTime));
+    if (RunOptions.Summary != SummaryMode::None && (RetryTotals.StatementRetries > 0 || RetryTotals.Deadlocks > 0 || RetryTotals.ConnectionLosses > 0))
+        std::println(stderr, "重试: 语句 {} 次, 事务重放 {} 次, 死锁 {} 次, 连接中断 {} 次, 放弃 {} 次, 重试耗时 {} ms", RetryTotals.StatementRetries, RetryTotals.TransactionReplays,
+            RetryTotals.Deadlocks, RetryTotals.ConnectionLosses, RetryTotals.ExhaustedRetries, FormatMilliseconds(RetryTotals.RetryTime));
+    if (Monitor && RunOptions.Summary != SummaryMode::None)
+    {
+        std::println(stderr, "路由: 主库 {} 条, 从库读取 {} 条, 回退主库 {} 条, GTID 等待 {} 次（超时 {} 次）", RoutingTotals.PrimaryStatements, RoutingTotals.ReplicaReads,
+            RoutingTotals.FallbackReads, RoutingTotals.GtidWaits, RoutingTotals.GtidWaitTimeouts);
+        for (const auto& Health : Monitor->GetHealth())
+            std::println(stderr, "  从库 {} 权重 {}: {}", Health.Name, Health.Weight, Health.IsReplicating ? std::format("延迟 {} ms", Health.Lag->count()) : Health.LastError);
+    }
+    if (Routing.PrimaryFailover && RunOptions.Summary != SummaryMode::None)
+    {
+        constexpr std::array<std::string_view, 3> CircuitNames{ "正常", "熔断", "半开" };
+        for (const auto& Status : Routing.PrimaryFailover->GetStatus())
+            std::println(stderr, "  主库候选 {}: {}{}, 探测 {:.2f} ms, 错误率 {:.2f}{}", Status.Name, CircuitNames[static_cast<std::size_t>(Status.Circuit)],
+                Status.IsWritable ? "" : "（只读）", Status.LatencyMilliseconds, Status.ErrorRate, Status.LastError.empty() ? "" : std::format(", 最近错误: {}", Status.LastError));
+    }
+    return HasFailure ? 1 : 0;
+}
@@ -1,305 +1,1941 @@
 #include "database.h"
+#include "sqlscript.hpp"
 #include <regex>
 #include <algorithm>
 #include <cctype>
+#include <limits>
 #include <ranges>
+#include <utility>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace
+{
+    constexpr int QueryInterruptedCode = 1317;
+    constexpr int ExecutionTimeExceededCode = 3024;
+    constexpr int NoSuchThreadCode = 1094;
+    constexpr int DeadlockCode = 1213;
+    // 语句超时后服务端通常已经按提示中止，客户端兜底再多等一小段时间
+    constexpr std::chrono::milliseconds HintGracePeriod{ 250 };
+
+    [[nodiscard]] auto QueryServerConnectionId(sql::Connection& ConnectionRef) -> uint64_t
+    {
+        const std::unique_ptr<sql::Statement> Statement(ConnectionRef.createStatement());
+        const std::unique_ptr<sql::ResultSet> ResultSet(Statement->executeQuery("SELECT CONNECTION_ID()"));
+        return ResultSet->next() ? ResultSet->getUInt64(1) : 0;
+    }
+
+    // 给顶层没有 LIMIT、INTO、FOR UPDATE、LOCK IN SHARE MODE 的单条 SELECT 追加 LIMIT，让服务端提前停止；
+    // LIMIT 插在最后一个有效记号之后，末尾的分号和注释保持原样。返回空串表示不能安全改写
+    [[nodiscard]] auto ApplyRowLimit(std::string_view SqlQuery, std::size_t FetchRows) -> std::string
+    {
+        std::size_t Position = SkipSpaceAndComments(SqlQuery, 0);
+        if (Position == std::string_view::npos || !StartsWithKeyword(SqlQuery.substr(Position), "SELECT"))
+            return {};
+        int Depth = 0;
+        std::size_t LastTokenEnd = Position;
+        while (Position < SqlQuery.size())
+        {
+            const std::size_t NextPosition = SkipSpaceAndComments(SqlQuery, Position);
+            if (NextPosition == std::string_view::npos)
+                return {};
+            if (NextPosition != Position)
+            {
+                Position = NextPosition;
+                continue;
+            }
+            const char CharValue = SqlQuery[Position];
+            if (CharValue == '\'' || CharValue == '"' || CharValue == '`')
+            {
+                std::size_t QuoteEnd = Position + 1;
+                while (QuoteEnd < SqlQuery.size())
+                {
+                    if (SqlQuery[QuoteEnd] == '\\' && CharValue != '`')
+                        QuoteEnd += 2;
+                    else if (SqlQuery[QuoteEnd] == CharValue)
+                    {
+                        if (QuoteEnd + 1 < SqlQuery.size() && SqlQuery[QuoteEnd + 1] == CharValue)
+                            QuoteEnd += 2;
+                        else
+                            break;
+                    }
+                    else
+                        ++QuoteEnd;
+                }
+                if (QuoteEnd >= SqlQuery.size())
+                    return {};
+                Position = LastTokenEnd = QuoteEnd + 1;
+            }
+            else if (SqlQuery.substr(Position).starts_with("/*+"))
+            {
+                const std::size_t HintEnd = SqlQuery.find("*/", Position + 3);
+                if (HintEnd == std::string_view::npos)
+                    return {};
+                Position = LastTokenEnd = HintEnd + 2;
+            }
+            else if (IsWordChar(CharValue))
+            {
+                std::size_t WordEnd = Position;
+                while (WordEnd < SqlQuery.size() && IsWordChar(SqlQuery[WordEnd]))
+                    ++WordEnd;
+                if (Depth == 0)
+                {
+                    const std::string_view Word = SqlQuery.substr(Position, WordEnd - Position);
+                    for (const std::string_view Keyword : { "LIMIT", "INTO", "FOR", "LOCK", "PROCEDURE" })
+                    {
+                        if (StartsWithKeyword(Word, Keyword))
+                            return {};
+                    }
+                }
+                Position = LastTokenEnd = WordEnd;
+            }
+            else if (CharValue == ';' && Depth == 0)
+            {
+                // 分号之后只允许空白和注释，多语句不改写
+                const std::size_t TrailingPosition = SkipSpaceAndComments(SqlQuery, Position + 1);
+                if (TrailingPosition != SqlQuery.size())
+                    return {};
+                break;
+            }
+            else
+            {
+                if (CharValue == '(')
+                    ++Depth;
+                else if (CharValue == ')')
+                    --Depth;
+                Position = LastTokenEnd = Position + 1;
+            }
+        }
+        if (Depth != 0)
+            return {};
+        std::string LimitedQuery{ SqlQuery.substr(0, LastTokenEnd) };
+        LimitedQuery += std::format(" LIMIT {}", FetchRows);
+        LimitedQuery += SqlQuery.substr(LastTokenEnd);
+        return LimitedQuery;
+    }
+
+    // 给以 SELECT 开头的语句加上 MAX_EXECUTION_TIME 提示，由服务端自行中止；
+    // 返回空串表示语句不适用（非 SELECT 或已自带该提示），只能靠客户端截止时间
+    [[nodiscard]] auto ApplyExecutionTimeHint(std::string_view SqlQuery, std::chrono::milliseconds Timeout) -> std::string
+    {
+        const std::size_t Position = SkipSpaceAndComments(SqlQuery, 0);
+        if (Position == std::string_view::npos || !StartsWithKeyword(SqlQuery.substr(Position), "SELECT"))
+            return {};
+        const bool HasOwnHint = std::ranges::search(SqlQuery, std::string_view{ "MAX_EXECUTION_TIME" }, [](char Left, char Right)
+            {
+                return std::toupper(static_cast<unsigned char>(Left)) == Right;
+            }).begin() != SqlQuery.end();
+        if (HasOwnHint)
+            return {};
+        const auto HintMilliseconds = (std::min<std::chrono::milliseconds::rep>)(Timeout.count(), (std::numeric_limits<uint32_t>::max)());
+        std::size_t InsertPosition = Position + 6;
+        std::size_t HintPosition = InsertPosition;
+        while (HintPosition < SqlQuery.size() && std::isspace(static_cast<unsigned char>(SqlQuery[HintPosition])))
+            ++HintPosition;
+        std::string HintedQuery{ SqlQuery };
+        // 语句已有优化器提示块时并入其中，同一查询块只有第一个提示块生效
+        if (SqlQuery.substr(HintPosition).starts_with("/*+"))
+        {
+            const bool HasSpace = HintPosition + 3 < SqlQuery.size() && std::isspace(static_cast<unsigned char>(SqlQuery[HintPosition + 3]));
+            HintedQuery.insert(HintPosition + 3, std::format(" MAX_EXECUTION_TIME({}){}", HintMilliseconds, HasSpace ? "" : " "));
+        }
+        else
+            HintedQuery.insert(InsertPosition, std::format(" /*+ MAX_EXECUTION_TIME({}) */", HintMilliseconds));
+        return HintedQuery;
+    }
+
+    // 与 mysql 命令行一致，只有 localhost 走套接字：127.0.0.1 按 TCP 地址授权，改走套接字可能无法登录
+    [[nodiscard]] auto ResolveUnixSocket(const MySQLConfig& Config) -> std::string
+    {
+#ifdef _WIN32
+        (void)Config;
+        return {};
+#else
+        if (!Config.UnixSocket.empty())
+            return Config.UnixSocket;
+        if (Config.Host != "localhost" || Config.Port != 3306)
+            return {};
+        for (const char* Candidate : { "/var/run/mysqld/mysqld.sock", "/run/mysqld/mysqld.sock", "/tmp/mysql.sock", "/var/lib/mysql/mysql.sock" })
+        {
+            std::error_code ErrorCode;
+            if (std::filesystem::is_socket(Candidate, ErrorCode))
+                return Candidate;
+        }
+        return {};
+#endif
+    }
+
+    // 字符集和默认库随握手协商，超时在建连前生效，连接建立后不再需要 SET NAMES / USE 往返
+    [[nodiscard]] auto OpenConnection(sql::Driver& Driver, const MySQLConfig& Config) -> std::unique_ptr<sql::Connection>
+    {
+        sql::ConnectOptionsMap Options;
+        const std::string SocketPath = ResolveUnixSocket(Config);
+        Options["hostName"] = SocketPath.empty() ? std::format("tcp://{}:{}", Config.Host, Config.Port) : std::format("unix://{}", SocketPath);
+        Options["userName"] = Config.User;
+        Options["password"] = Config.Password;
+        if (!Config.Database.empty())
+            Options["schema"] = Config.Database;
+        Options["OPT_CHARSET_NAME"] = Config.Charset;
+        Options["OPT_CONNECT_TIMEOUT"] = static_cast<int>(Config.ConnectTimeout);
+        Options["OPT_READ_TIMEOUT"] = static_cast<int>(Config.ReadTimeout);
+        Options["OPT_WRITE_TIMEOUT"] = static_cast<int>(Config.WriteTimeout);
+        Options["OPT_RECONNECT"] = Config.EnableAutoReconnect;
+        return std::unique_ptr<sql::Connection>(Driver.connect(Options));
+    }
+
+    [[nodiscard]] auto ToLowerAscii(std::string_view Text) -> std::string
+    {
+        std::string LowerText(Text);
+        std::ranges::transform(LowerText, LowerText.begin(), [](unsigned char CharValue) { return static_cast<char>(std::tolower(CharValue)); });
+        return LowerText;
+    }
+
+    [[nodiscard]] auto InitialSessionState(const MySQLConfig& Config) -> SessionState
+    {
+        return { Config.Database, ToLowerAscii(Config.Charset), false, false };
+    }
+
+    enum class SessionEffect : uint8_t
+    {
+        None,
+        Schema,
+        Charset,
+        TransactionBegin,
+        TransactionEnd,
+        Dirty
+    };
+
+    struct StatementEffect
+    {
+        SessionEffect Kind = SessionEffect::None;
+        std::optional<std::string> Value;
+    };
+
+    // 读取一个可能带引号的名字，之后只允许空白和分号；其他情况返回空
+    [[nodiscard]] auto ReadSoleName(std::string_view Text) -> std::optional<std::string>
+    {
+        std::size_t Position = 0;
+        std::string Name;
+        if (!Text.empty() && (Text[0] == '`' || Text[0] == '\'' || Text[0] == '"'))
+        {
+            const char Quote = Text[0];
+            for (Position = 1; Position < Text.size(); ++Position)
+            {
+                if (Text[Position] == Quote)
+                {
+                    if (Position + 1 < Text.size() && Text[Position + 1] == Quote)
+                    {
+                        Name += Quote;
+                        ++Position;
+                        continue;
+                    }
+                    break;
+                }
+                Name += Text[Position];
+            }
+            if (Position >= Text.size())
+                return std::nullopt;
+            ++Position;
+        }
+        else
+        {
+            while (Position < Text.size() && IsWordChar(Text[Position]))
+                Name += Text[Position++];
+        }
+        if (Name.empty())
+            return std::nullopt;
+        for (; Position < Text.size(); ++Position)
+        {
+            if (!std::isspace(static_cast<unsigned char>(Text[Position])) && Text[Position] != ';')
+                return std::nullopt;
+        }
+        return Name;
+    }
+
+    // 引号外出现的用户变量（@name，不含 @@系统变量）或 GET_LOCK 都会留下只能靠重连清除的状态
+    [[nodiscard]] auto HasSessionSideEffect(std::string_view SqlQuery) noexcept -> bool
+    {
+        char Quote = 0;
+        for (std::size_t Index = 0; Index < SqlQuery.size(); ++Index)
+        {
+            const char CharValue = SqlQuery[Index];
+            if (Quote != 0)
+            {
+                if (CharValue == '\\' && Quote != '`')
+                    ++Index;
+                else if (CharValue == Quote)
+                    Quote = 0;
+                continue;
+            }
+            if (CharValue == '\'' || CharValue == '"' || CharValue == '`')
+                Quote = CharValue;
+            else if (CharValue == '@')
+            {
+                if (Index + 1 < SqlQuery.size() && SqlQuery[Index + 1] == '@')
+                    ++Index;
+                else
+                    return true;
+            }
+            else if ((CharValue == 'G' || CharValue == 'g') && (Index == 0 || !IsWordChar(SqlQuery[Index - 1])) && StartsWithKeyword(SqlQuery.substr(Index), "GET_LOCK"))
+                return true;
+        }
+        return false;
+    }
+
+    [[nodiscard]] auto ClassifySessionEffect(std::string_view SqlQuery) -> StatementEffect
+    {
+        const std::size_t Position = SkipSpaceAndComments(SqlQuery, 0);
+        if (Position == std::string_view::npos)
+            return {};
+        const std::string_view Text = SqlQuery.substr(Position);
+        if (StartsWithKeyword(Text, "USE"))
+            return { SessionEffect::Schema, ReadSoleName(SkipKeyword(Text, "USE")) };
+        if (StartsWithKeyword(Text, "SET"))
+        {
+            const std::string_view Rest = SkipKeyword(Text, "SET");
+            if (StartsWithKeyword(Rest, "NAMES"))
+            {
+                const auto Charset = ReadSoleName(SkipKeyword(Rest, "NAMES"));
+                return { SessionEffect::Charset, Charset ? std::optional<std::string>(ToLowerAscii(*Charset)) : std::nullopt };
+            }
+            if (StartsWithKeyword(Rest, "CHARACTER") || StartsWithKeyword(Rest, "CHARSET"))
+                return { SessionEffect::Charset, std::nullopt };
+            return { SessionEffect::Dirty, std::nullopt };
+        }
+        if (StartsWithKeyword(Text, "BEGIN") || StartsWithKeyword(Text, "START"))
+            return { SessionEffect::TransactionBegin, std::nullopt };
+        if (StartsWithKeyword(Text, "COMMIT") || (StartsWithKeyword(Text, "ROLLBACK") && !StartsWithKeyword(SkipKeyword(Text, "ROLLBACK"), "TO")))
+            return { SessionEffect::TransactionEnd, std::nullopt };
+        if (StartsWithKeyword(Text, "LOCK") || StartsWithKeyword(Text, "PREPARE") || StartsWithKeyword(Text, "HANDLER") || StartsWithKeyword(Text, "XA")
+            || (StartsWithKeyword(Text, "CREATE") && StartsWithKeyword(SkipKeyword(Text, "CREATE"), "TEMPORARY")))
+            return { SessionEffect::Dirty, std::nullopt };
+        if (StartsWithKeyword(Text, "DROP"))
+        {
+            const std::string_view Rest = SkipKeyword(Text, "DROP");
+            if (StartsWithKeyword(Rest, "DATABASE") || StartsWithKeyword(Rest, "SCHEMA"))
+                return { SessionEffect::Schema, std::nullopt };
+        }
+        return HasSessionSideEffect(Text) ? StatementEffect{ SessionEffect::Dirty, std::nullopt } : StatementEffect{};
+    }
+
+    auto ApplySessionEffect(SessionState& State, const StatementEffect& Effect) -> void
+    {
+        switch (Effect.Kind)
+        {
+        case SessionEffect::Schema: State.Schema = Effect.Value; break;
+        case SessionEffect::Charset: State.Charset = Effect.Value; break;
+        case SessionEffect::TransactionBegin: State.HasTransaction = true; break;
+        case SessionEffect::TransactionEnd: State.HasTransaction = false; break;
+        case SessionEffect::Dirty: State.IsDirty = true; break;
+        case SessionEffect::None: break;
+        }
+    }
+
+    // 事务中连接被重建后返回的错误；错误码归为连接中断，ExecuteTransaction 据此整体重放
+    constexpr std::string_view AbortedTransactionMessage = "事务进行中连接已重建，已执行的语句随旧连接回滚；请执行 ROLLBACK 后重新开始事务";
+    constexpr int AbortedTransactionErrorCode = 2006;
+
+    // 连接中断后只能重放只读语句：写入可能已经在服务端提交，只是结果没有送回
+    [[nodiscard]] auto IsIdempotentStatement(std::string_view SqlQuery) noexcept -> bool
+    {
+        const std::size_t Position = SkipSpaceAndComments(SqlQuery, 0);
+        if (Position == std::string_view::npos)
+            return false;
+        const std::string_view Text = SqlQuery.substr(Position);
+        if (StartsWithKeyword(Text, "SELECT"))
+            return !HasSessionSideEffect(Text);
+        return StartsWithKeyword(Text, "SHOW") || StartsWithKeyword(Text, "DESCRIBE") || StartsWithKeyword(Text, "DESC") || StartsWithKeyword(Text, "EXPLAIN")
+            || StartsWithKeyword(Text, "HELP") || StartsWithKeyword(Text, "TABLE") || StartsWithKeyword(Text, "VALUES");
+    }
+
+    // 截取 SHOW ENGINE INNODB STATUS 中 LATEST DETECTED DEADLOCK 标题下方、下一个分隔线之前的内容
+    [[nodiscard]] auto ExtractDeadlockSection(std::string_view StatusText) -> std::string
+    {
+        constexpr std::string_view Title = "LATEST DETECTED DEADLOCK";
+        std::size_t Start = StatusText.find(Title);
+        if (Start == std::string_view::npos)
+            return {};
+        Start = StatusText.find('\n', Start);
+        if (Start == std::string_view::npos)
+            return {};
+        // 标题下方的分隔线
+        Start = StatusText.find('\n', Start + 1);
+        if (Start == std::string_view::npos)
+            return {};
+        const std::size_t End = StatusText.find("\n------------", Start);
+        std::string_view Section = StatusText.substr(Start + 1, End == std::string_view::npos ? std::string_view::npos : End - Start - 1);
+        while (!Section.empty() && std::isspace(static_cast<unsigned char>(Section.back())))
+            Section.remove_suffix(1);
+        return std::string{ Section };
+    }
+
+    // 字典每个取值另有一份哈希表键和节点
+    constexpr std::size_t DictionaryEntryOverhead = 32;
+
+    [[nodiscard]] auto EstimateStringBytes(const std::string& Text) noexcept -> std::size_t
+    {
+        // 短字符串存放在对象内部，只有超出内联容量的部分另外分配
+        static const std::size_t InlineCapacity = std::string{}.capacity();
+        return sizeof(std::string) + (Text.capacity() > InlineCapacity ? Text.capacity() + 1 : 0);
+    }
+
+    [[nodiscard]] auto EstimateRowBytes(const MySQLRow& RowData) noexcept -> std::size_t
+    {
+        std::size_t Bytes = sizeof(MySQLRow) + (RowData.Fields.capacity() - RowData.Fields.size()) * sizeof(std::string);
+        for (const auto& Field : RowData.Fields)
+            Bytes += EstimateStringBytes(Field);
+        return Bytes;
+    }
+
+    auto AppendVarint(std::string& Output, uint64_t Value) -> void
+    {
+        while (Value >= 0x80)
+        {
+            Output += static_cast<char>((Value & 0x7F) | 0x80);
+            Value >>= 7;
+        }
+        Output += static_cast<char>(Value);
+    }
+
+    [[nodiscard]] auto ReadVarint(std::string_view Input, std::size_t& Position) -> uint64_t
+    {
+        uint64_t Value = 0;
+        for (int Shift = 0; Position < Input.size() && Shift < 64; Shift += 7)
+        {
+            const auto ByteValue = static_cast<unsigned char>(Input[Position++]);
+            Value |= static_cast<uint64_t>(ByteValue & 0x7F) << Shift;
+            if ((ByteValue & 0x80) == 0)
+                return Value;
+        }
+        throw std::runtime_error("结果临时文件已损坏");
+    }
+
+    // 行块格式：每行为 字段数(varint)，随后每个字段为 长度+1(varint) 和字段内容；长度码 0 表示 NULL
+    auto EncodeRow(std::string& Output, const MySQLRow& RowData) -> void
+    {
+        AppendVarint(Output, RowData.Fields.size());
+        for (const auto& Field : RowData.Fields)
+        {
+            if (Field == "NULL")
+            {
+                AppendVarint(Output, 0);
+                continue;
+            }
+            AppendVarint(Output, Field.size() + 1);
+            Output += Field;
+        }
+    }
+
+    [[nodiscard]] auto DecodeBlock(std::string_view Payload, std::size_t RowCount) -> std::vector<MySQLRow>
+    {
+        std::vector<MySQLRow> Rows(RowCount);
+        std::size_t Position = 0;
+        for (auto& RowData : Rows)
+        {
+            const uint64_t FieldCount = ReadVarint(Payload, Position);
+            if (FieldCount > Payload.size() - Position)
+                throw std::runtime_error("结果临时文件已损坏");
+            RowData.Fields.reserve(static_cast<std::size_t>(FieldCount));
+            for (uint64_t Index = 0; Index < FieldCount; ++Index)
+            {
+                const uint64_t LengthCode = ReadVarint(Payload, Position);
+                if (LengthCode == 0)
+                {
+                    RowData.Fields.emplace_back("NULL");
+                    continue;
+                }
+                if (LengthCode - 1 > Payload.size() - Position)
+                    throw std::runtime_error("结果临时文件已损坏");
+                RowData.Fields.emplace_back(Payload.substr(Position, static_cast<std::size_t>(LengthCode - 1)));
+                Position += static_cast<std::size_t>(LengthCode - 1);
+            }
+        }
+        return Rows;
+    }
+}
+
+struct RowStore::SpillFile
+{
+    std::filesystem::path Path;
+    std::fstream Stream;
+    std::mutex Mutex;
+    uint64_t EndOffset = 0;
+    ~SpillFile()
+    {
+        Stream.close();
+        std::error_code ErrorCode;
+        std::filesystem::remove(Path, ErrorCode);
+    }
+    [[nodiscard]] static auto Create() -> std::shared_ptr<SpillFile>
+    {
+        static std::atomic<uint64_t> FileCounter{ 0 };
+        std::error_code ErrorCode;
+        const std::filesystem::path Directory = std::filesystem::temp_directory_path(ErrorCode);
+        if (ErrorCode)
+            return nullptr;
+        auto FilePtr = std::make_shared<SpillFile>();
+        FilePtr->Path = Directory / std::format("mysql-client-{:08x}-{}.rows", std::random_device{}(), FileCounter.fetch_add(1, std::memory_order_relaxed));
+        FilePtr->Stream.open(FilePtr->Path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        return FilePtr->Stream ? FilePtr : nullptr;
+    }
+    // 复制出的结果共享同一文件，各自追加的块互不重叠
+    [[nodiscard]] auto Append(std::string_view Payload) -> std::optional<uint64_t>
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Stream.clear();
+        Stream.seekp(static_cast<std::streamoff>(EndOffset));
+        Stream.write(Payload.data(), static_cast<std::streamsize>(Payload.size()));
+        if (!Stream)
+            return std::nullopt;
+        return std::exchange(EndOffset, EndOffset + Payload.size());
+    }
+    [[nodiscard]] auto Read(uint64_t Offset, std::size_t ByteSize) -> std::optional<std::string>
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        std::string Payload(ByteSize, '\0');
+        Stream.clear();
+        Stream.seekg(static_cast<std::streamoff>(Offset));
+        Stream.read(Payload.data(), static_cast<std::streamsize>(ByteSize));
+        if (!Stream)
+            return std::nullopt;
+        return Payload;
+    }
+};
+
+RowStore::RowStore(const RowStore& Other) : ResidentRows(Other.ResidentRows), Dictionaries(Other.Dictionaries), EncodedBlocks(Other.EncodedBlocks), EncodedRowCount(Other.EncodedRowCount),
+    IsEncoding(Other.IsEncoding), Blocks(Other.Blocks), PendingBlock(Other.PendingBlock), PendingRowCount(Other.PendingRowCount), SpilledRowCount(Other.SpilledRowCount),
+    ResultBudget(Other.ResultBudget), IsSpilling(Other.IsSpilling), File(Other.File)
+{
+    ChargeBytes(Other.ResidentBytes);
+}
+
+RowStore::RowStore(RowStore&& Other) noexcept
+{
+    *this = std::move(Other);
+}
+
+auto RowStore::operator=(const RowStore& Other) -> RowStore&
+{
+    if (this != &Other)
+        *this = RowStore(Other);
+    return *this;
+}
+
+auto RowStore::operator=(RowStore&& Other) noexcept -> RowStore&
+{
+    if (this == &Other)
+        return *this;
+    clear();
+    ResidentRows = std::move(Other.ResidentRows);
+    Dictionaries = std::move(Other.Dictionaries);
+    EncodedBlocks = std::move(Other.EncodedBlocks);
+    EncodedRowCount = Other.EncodedRowCount;
+    IsEncoding = Other.IsEncoding;
+    Blocks = std::move(Other.Blocks);
+    PendingBlock = std::move(Other.PendingBlock);
+    PendingRowCount = Other.PendingRowCount;
+    SpilledRowCount = Other.SpilledRowCount;
+    ResidentBytes = std::exchange(Other.ResidentBytes, 0);
+    ResultBudget = Other.ResultBudget;
+    IsSpilling = Other.IsSpilling;
+    File = std::move(Other.File);
+    Cache = std::move(Other.Cache);
+    RecentCacheSlot = Other.RecentCacheSlot;
+    Other.clear();
+    return *this;
+}
+
+RowStore::~RowStore()
+{
+    ReleaseBytes(ResidentBytes);
+}
+
+auto RowStore::ChargeBytes(std::size_t Bytes) noexcept -> void
+{
+    ResidentBytes += Bytes;
+    ProcessResidentBytes.fetch_add(Bytes, std::memory_order_relaxed);
+}
+
+auto RowStore::ReleaseBytes(std::size_t Bytes) noexcept -> void
+{
+    ResidentBytes -= Bytes;
+    ProcessResidentBytes.fetch_sub(Bytes, std::memory_order_relaxed);
+}
+
+auto RowStore::clear() noexcept -> void
+{
+    ReleaseBytes(ResidentBytes);
+    ResidentRows.clear();
+    Dictionaries.clear();
+    EncodedBlocks.clear();
+    EncodedRowCount = 0;
+    IsEncoding = false;
+    Blocks.clear();
+    PendingBlock.clear();
+    PendingRowCount = 0;
+    SpilledRowCount = 0;
+    IsSpilling = false;
+    File.reset();
+    Cache = {};
+    RecentCacheSlot = 0;
+}
+
+auto RowStore::push_back(MySQLRow RowData) -> void
+{
+    if (!IsSpilling) [[likely]]
+    {
+        const std::size_t RowBytes = EstimateRowBytes(RowData);
+        const bool IsWithinBudget = ResidentBytes + RowBytes <= ResultBudget && ProcessResidentBytes.load(std::memory_order_relaxed) + RowBytes <= ProcessBudget.load(std::memory_order_relaxed);
+        if (IsWithinBudget && !IsEncoding) [[likely]]
+        {
+            ResidentRows.push_back(std::move(RowData));
+            ChargeBytes(RowBytes);
+            if (ResidentRows.size() == DictionarySampleRows)
+                ChooseDictionaryColumns();
+            return;
+        }
+        if (IsWithinBudget && RowData.Size() == Dictionaries.size())
+        {
+            AppendEncoded(std::move(RowData));
+            return;
+        }
+        // 一旦开始落盘，后续行全部追加到行块，行序保持不变；列数与字典不一致的行无法按列编码，同样转入行块
+        IsSpilling = true;
+    }
+    const std::size_t PreviousSize = PendingBlock.size();
+    EncodeRow(PendingBlock, RowData);
+    ChargeBytes(PendingBlock.size() - PreviousSize);
+    ++PendingRowCount;
+    ++SpilledRowCount;
+    InvalidateCachedBlock(size() - PendingRowCount);
+    if (PendingBlock.size() >= BlockBytes)
+        FlushPendingBlock();
+}
+
+auto RowStore::ChooseDictionaryColumns() -> void
+{
+    const std::size_t ColumnCount = ResidentRows.front().Size();
+    if (ColumnCount == 0 || std::ranges::any_of(ResidentRows, [ColumnCount](const MySQLRow& RowData) { return RowData.Size() != ColumnCount; }))
+        return;
+    std::vector<ColumnDictionary> Candidates(ColumnCount);
+    for (std::size_t ColumnIndex = 0; ColumnIndex < ColumnCount; ++ColumnIndex)
+    {
+        std::unordered_set<std::string_view> DistinctValues;
+        for (const auto& RowData : ResidentRows)
+        {
+            DistinctValues.insert(RowData.Fields[ColumnIndex]);
+            if (DistinctValues.size() > MaxSampleDistinct)
+                break;
+        }
+        Candidates[ColumnIndex].IsActive = DistinctValues.size() <= MaxSampleDistinct;
+        IsEncoding |= Candidates[ColumnIndex].IsActive;
+    }
+    if (IsEncoding)
+        Dictionaries = std::move(Candidates);
+}
+
+auto RowStore::AppendEncoded(MySQLRow RowData) -> void
+{
+    const std::size_t ColumnCount = Dictionaries.size();
+    if (EncodedBlocks.empty() || EncodedBlocks.back().RowCount == EncodedBlockRows)
+    {
+        EncodedBlock& NewBlock = EncodedBlocks.emplace_back();
+        NewBlock.Codes.resize(ColumnCount);
+        NewBlock.Plain.resize(ColumnCount);
+        ChargeBytes(sizeof(EncodedBlock) + ColumnCount * (sizeof(std::vector<uint16_t>) + sizeof(std::vector<std::string>)));
+    }
+    EncodedBlock& Block = EncodedBlocks.back();
+    std::size_t Bytes = 0;
+    for (std::size_t ColumnIndex = 0; ColumnIndex < ColumnCount; ++ColumnIndex)
+    {
+        std::string& Field = RowData.Fields[ColumnIndex];
+        ColumnDictionary& Dictionary = Dictionaries[ColumnIndex];
+        if (Dictionary.IsActive)
+        {
+            if (const auto Found = Dictionary.Codes.find(Field); Found != Dictionary.Codes.end())
+            {
+                Block.Codes[ColumnIndex].push_back(Found->second);
+                Bytes += sizeof(uint16_t);
+                continue;
+            }
+            if (Dictionary.Values.size() < MaxDictionaryEntries)
+            {
+                const auto Code = static_cast<uint16_t>(Dictionary.Values.size());
+                Dictionary.Codes.emplace(Field, Code);
+                Dictionary.Values.push_back(Field);
+                Block.Codes[ColumnIndex].push_back(Code);
+                Bytes += sizeof(uint16_t) + 2 * EstimateStringBytes(Field) + DictionaryEntryOverhead;
+                continue;
+            }
+            // 基数超出上限：该列退回普通存储，当前块已有的编码就地还原
+            Dictionary.IsActive = false;
+            Dictionary.Codes = {};
+            std::vector<std::string>& PlainValues = Block.Plain[ColumnIndex];
+            for (const uint16_t Code : Block.Codes[ColumnIndex])
+            {
+                PlainValues.push_back(Dictionary.Values[Code]);
+                Bytes += EstimateStringBytes(PlainValues.back());
+            }
+            Block.Codes[ColumnIndex] = {};
+        }
+        Bytes += EstimateStringBytes(Field);
+        Block.Plain[ColumnIndex].push_back(std::move(Field));
+    }
+    ChargeBytes(Bytes);
+    InvalidateCachedBlock(ResidentRows.size() + EncodedRowCount - Block.RowCount);
+    ++Block.RowCount;
+    ++EncodedRowCount;
+}
+
+auto RowStore::FlushPendingBlock() -> void
+{
+    SpillBlock Block;
+    Block.FirstRow = SpilledRowCount - PendingRowCount;
+    Block.RowCount = PendingRowCount;
+    Block.ByteSize = static_cast<uint32_t>(PendingBlock.size());
+    if (!File)
+        File = SpillFile::Create();
+    if (const auto Offset = File ? File->Append(PendingBlock) : std::nullopt)
+    {
+        Block.Offset = *Offset;
+        ReleaseBytes(PendingBlock.size());
+        PendingBlock.clear();
+    }
+    else
+        Block.Payload = std::exchange(PendingBlock, {});
+    Blocks.push_back(std::move(Block));
+    PendingRowCount = 0;
+}
+
+auto RowStore::InvalidateCachedBlock(std::size_t FirstRow) noexcept -> void
+{
+    for (auto& Entry : Cache)
+    {
+        if (Entry.FirstRow == FirstRow)
+            Entry = {};
+    }
+}
+
+auto RowStore::BlockRow(std::size_t Index) const -> const MySQLRow&
+{
+    if (Index >= size())
+        throw std::out_of_range("结果行下标越界");
+    const std::size_t SpilledStart = ResidentRows.size() + EncodedRowCount;
+    std::size_t FirstRow = 0;
+    std::size_t BlockIndex = 0;
+    if (Index < SpilledStart)
+    {
+        BlockIndex = (Index - ResidentRows.size()) / EncodedBlockRows;
+        FirstRow = ResidentRows.size() + BlockIndex * EncodedBlockRows;
+    }
+    else
+    {
+        const std::size_t SpilledIndex = Index - SpilledStart;
+        const std::size_t FlushedRowCount = SpilledRowCount - PendingRowCount;
+        BlockIndex = SpilledIndex >= FlushedRowCount ? Blocks.size()
+            : static_cast<std::size_t>(std::ranges::upper_bound(Blocks, SpilledIndex, {}, &SpillBlock::FirstRow) - Blocks.begin()) - 1;
+        FirstRow = SpilledStart + (BlockIndex < Blocks.size() ? Blocks[BlockIndex].FirstRow : FlushedRowCount);
+    }
+    for (std::size_t Slot = 0; Slot < Cache.size(); ++Slot)
+    {
+        if (Cache[Slot].FirstRow == FirstRow)
+        {
+            RecentCacheSlot = Slot;
+            return Cache[Slot].Rows[Index - FirstRow];
+        }
+    }
+    // 两个槽位按最近使用替换，交替访问两个块时不会反复解码或读盘
+    const std::size_t Slot = (RecentCacheSlot + 1) % Cache.size();
+    CachedBlock& Entry = Cache[Slot];
+    if (Index < SpilledStart)
+    {
+        const EncodedBlock& Block = EncodedBlocks[BlockIndex];
+        std::vector<MySQLRow> Rows(Block.RowCount);
+        for (std::size_t RowIndex = 0; RowIndex < Block.RowCount; ++RowIndex)
+        {
+            std::vector<std::string>& Fields = Rows[RowIndex].Fields;
+            Fields.reserve(Dictionaries.size());
+            for (std::size_t ColumnIndex = 0; ColumnIndex < Dictionaries.size(); ++ColumnIndex)
+            {
+                const auto& Codes = Block.Codes[ColumnIndex];
+                Fields.push_back(Codes.empty() ? Block.Plain[ColumnIndex][RowIndex] : Dictionaries[ColumnIndex].Values[Codes[RowIndex]]);
+            }
+        }
+        Entry.Rows = std::move(Rows);
+    }
+    else if (BlockIndex == Blocks.size())
+        Entry.Rows = DecodeBlock(PendingBlock, PendingRowCount);
+    else if (const SpillBlock& Block = Blocks[BlockIndex]; !Block.Payload.empty())
+        Entry.Rows = DecodeBlock(Block.Payload, Block.RowCount);
+    else
+    {
+        const auto Payload = File->Read(Block.Offset, Block.ByteSize);
+        if (!Payload)
+            throw std::runtime_error("读取结果临时文件失败");
+        Entry.Rows = DecodeBlock(*Payload, Block.RowCount);
+    }
+    Entry.FirstRow = FirstRow;
+    RecentCacheSlot = Slot;
+    return Entry.Rows[Index - FirstRow];
+}
+
+auto RowStore::CountValues(std::size_t ColumnIndex) const -> std::vector<std::pair<std::string, std::size_t>>
+{
+    std::unordered_map<std::string, std::size_t> Counts;
+    const auto CountRow = [&Counts, ColumnIndex](const MySQLRow& RowData)
+    {
+        if (ColumnIndex < RowData.Size())
+            ++Counts[RowData.Fields[ColumnIndex]];
+    };
+    std::ranges::for_each(ResidentRows, CountRow);
+    if (ColumnIndex < Dictionaries.size())
+    {
+        const std::vector<std::string>& Values = Dictionaries[ColumnIndex].Values;
+        std::vector<std::size_t> CodeCounts(Values.size());
+        for (const auto& Block : EncodedBlocks)
+        {
+            for (const uint16_t Code : Block.Codes[ColumnIndex])
+                ++CodeCounts[Code];
+            for (const auto& Field : Block.Plain[ColumnIndex])
+                ++Counts[Field];
+        }
+        for (std::size_t Code = 0; Code < Values.size(); ++Code)
+        {
+            if (CodeCounts[Code] > 0)
+                Counts[Values[Code]] += CodeCounts[Code];
+        }
+    }
+    for (std::size_t Index = ResidentRows.size() + EncodedRowCount; Index < size(); ++Index)
+        CountRow((*this)[Index]);
+    std::vector<std::pair<std::string, std::size_t>> SortedCounts(std::make_move_iterator(Counts.begin()), std::make_move_iterator(Counts.end()));
+    std::ranges::sort(SortedCounts, [](const auto& Left, const auto& Right) { return Left.second != Right.second ? Left.second > Right.second : Left.first < Right.first; });
+    return SortedCounts;
+}
+
+auto RowStore::FindRows(std::size_t ColumnIndex, std::string_view Value) const -> std::vector<std::size_t>
+{
+    std::vector<std::size_t> Matches;
+    for (std::size_t Index = 0; Index < ResidentRows.size(); ++Index)
+    {
+        if (ColumnIndex < ResidentRows[Index].Size() && ResidentRows[Index].Fields[ColumnIndex] == Value)
+            Matches.push_back(Index);
+    }
+    if (ColumnIndex < Dictionaries.size())
+    {
+        const std::vector<std::string>& Values = Dictionaries[ColumnIndex].Values;
+        const auto Found = std::ranges::find(Values, Value);
+        const std::optional<uint16_t> TargetCode = Found == Values.end() ? std::nullopt : std::optional<uint16_t>(static_cast<uint16_t>(Found - Values.begin()));
+        std::size_t FirstRow = ResidentRows.size();
+        for (const auto& Block : EncodedBlocks)
+        {
+            const auto& Codes = Block.Codes[ColumnIndex];
+            const auto& PlainValues = Block.Plain[ColumnIndex];
+            for (std::size_t RowIndex = 0; RowIndex < Block.RowCount; ++RowIndex)
+            {
+                if (Codes.empty() ? PlainValues[RowIndex] == Value : TargetCode == Codes[RowIndex])
+                    Matches.push_back(FirstRow + RowIndex);
+            }
+            FirstRow += Block.RowCount;
+        }
+    }
+    for (std::size_t Index = ResidentRows.size() + EncodedRowCount; Index < size(); ++Index)
+    {
+        const MySQLRow& RowData = (*this)[Index];
+        if (ColumnIndex < RowData.Size() && RowData.Fields[ColumnIndex] == Value)
+            Matches.push_back(Index);
+    }
+    return Matches;
+}
+
 auto MySQLResult::GetColumnIndex(std::string_view ColumnName) const -> std::optional<std::size_t>
 {
-    const auto IteratorPosition = std::ranges::find(ColumnNames, ColumnName);
-    if (IteratorPosition != ColumnNames.end())
-        return std::distance(ColumnNames.begin(), IteratorPosition);
-    return std::nullopt;
+    const auto IteratorPosition = std::ranges::find(ColumnNames, ColumnName);
+    if (IteratorPosition != ColumnNames.end())
+        return std::distance(ColumnNames.begin(), IteratorPosition);
+    return std::nullopt;
+}
+
+auto MySQLResult::HasColumn(std::string_view ColumnName) const -> bool
+{
+    return std::ranges::any_of(ColumnNames, [ColumnName](const std::string& NameValue) { return NameValue == ColumnName; });
+}
+
+auto ClassifyError(int ErrorCode) noexcept -> ErrorCategory
+{
+    switch (ErrorCode)
+    {
+    case 0:
+        return ErrorCategory::None;
+    // 客户端：无法连接、连接已断开、查询中连接丢失、读取握手失败
+    case 2002: case 2003: case 2006: case 2013: case 2055:
+    // 服务端：正在关闭、连接被终止、网络读写出错
+    case 1053: case 1927: case 4031: case 1158: case 1159: case 1160: case 1161:
+        return ErrorCategory::ConnectionLost;
+    // 死锁与锁等待超时
+    case 1213: case 1205:
+        return ErrorCategory::Deadlock;
+    default:
+        return ErrorCategory::Permanent;
+    }
+}
+
+TransactionGuard::TransactionGuard(sql::Connection* ConnectionPtr) : Connection(ConnectionPtr)
+{
+    if (Connection)
+    {
+        try { Connection->setAutoCommit(false); }
+        catch (...) { }
+    }
+}
+
+TransactionGuard::~TransactionGuard()
+{
+    if (Connection && !IsCommitted && !IsRolledBack)
+    {
+        try
+        {
+            Connection->rollback();
+            Connection->setAutoCommit(true);
+        }
+        catch (...) { }
+    }
+}
+
+auto TransactionGuard::Commit() -> void
+{
+    if (Connection && !IsCommitted && !IsRolledBack)
+    {
+        Connection->commit();
+        Connection->setAutoCommit(true);
+        IsCommitted = true;
+    }
+}
+
+auto TransactionGuard::Rollback() -> void
+{
+    if (Connection && !IsCommitted && !IsRolledBack)
+    {
+        Connection->rollback();
+        Connection->setAutoCommit(true);
+        IsRolledBack = true;
+    }
+}
+
+auto SQLSanitizer::DetectSQLInjection(std::string_view SqlQuery) -> bool
+{
+    constexpr std::array<std::string_view, 6> DangerousPatterns = 
+    {
+        R"((\bOR\b|\bAND\b)\s+['\"]?\d+['\"]?\s*=\s*['\"]?\d+)",
+        R"(;\s*(DROP|DELETE|UPDATE|INSERT)\s+)",
+        R"(--|\#|/\*)",
+        R"(\bUNION\b.*\bSELECT\b)",
+        R"(\bEXEC\b|\bEXECUTE\b)",
+        R"(\bxp_cmdshell\b)",
+    };
+    std::string UpperCaseQuery;
+    UpperCaseQuery.reserve(SqlQuery.size());
+    std::ranges::transform(SqlQuery, std::back_inserter(UpperCaseQuery), [](unsigned char CharValue) { return std::toupper(CharValue); });
+    for (const auto& PatternString : DangerousPatterns)
+    {
+        try
+        {
+            const std::regex PatternRegex(PatternString.data(), std::regex::icase);
+            if (std::regex_search(UpperCaseQuery, PatternRegex))
+                return true;
+        }
+        catch (...)
+        {
+            continue;
+        }
+    }
+    return false;
+}
+
+auto SQLSanitizer::IsValidIdentifier(std::string_view IdentifierName) -> bool
+{
+    if (IdentifierName.empty()) [[unlikely]]
+        return false;
+    if (std::isdigit(static_cast<unsigned char>(IdentifierName[0]))) [[unlikely]]
+        return false;
+    return std::ranges::all_of(IdentifierName, [](unsigned char CharValue) { return std::isalnum(CharValue) || CharValue == '_'; });
+}
+
+auto SQLSanitizer::QuoteIdentifier(std::string_view IdentifierName) -> std::string
+{
+    std::string QuotedName;
+    QuotedName.reserve(IdentifierName.size() + 2);
+    QuotedName += '`';
+    for (const char CharValue : IdentifierName)
+    {
+        if (CharValue == '`')
+            QuotedName += '`';
+        QuotedName += CharValue;
+    }
+    QuotedName += '`';
+    return QuotedName;
+}
+
+auto SQLSanitizer::EscapeString(std::string_view InputString) -> std::string
+{
+    std::string EscapedString;
+    EscapedString.reserve(InputString.length() * 2);
+    for (const char CharValue : InputString)
+    {
+        switch (CharValue)
+        {
+        case '\'': EscapedString += "\\'"; break;
+        case '\"': EscapedString += "\\\""; break;
+        case '\\': EscapedString += "\\\\"; break;
+        case '\0': EscapedString += "\\0"; break;
+        case '\n': EscapedString += "\\n"; break;
+        case '\r': EscapedString += "\\r"; break;
+        case '\t': EscapedString += "\\t"; break;
+        default: EscapedString += CharValue; break;
+        }
+    }
+    return EscapedString;
+}
+
+auto SQLSanitizer::BuildParameterizedQuery(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> std::string
+{
+    std::string ResultQuery{ QueryTemplate };
+    std::size_t ParameterIndex = 0;
+    std::size_t SearchPosition = 0;
+    while ((SearchPosition = ResultQuery.find('?', SearchPosition)) != std::string::npos)
+    {
+        if (ParameterIndex >= ParameterList.size()) [[unlikely]]
+            break;
+        const std::string EscapedParameter = std::format("'{}'", EscapeString(ParameterList[ParameterIndex]));
+        ResultQuery.replace(SearchPosition, 1, EscapedParameter);
+        SearchPosition += EscapedParameter.length();
+        ++ParameterIndex;
+    }
+    return ResultQuery;
+}
+
+MySQLWrapper::MySQLWrapper()
+{
+    // 先构造日志单例，使其晚于本对象析构：全局的 MySQLWrapper 析构时仍要发事件、移除日志接收器
+    (void)EventLogger::Instance();
+    try
+    {
+        DriverInstance = sql::mysql::get_driver_instance();
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        LastErrorMessage = std::format("驱动初始化错误: {} (代码: {})", Exception.what(), Exception.getErrorCode());
+    }
+    Watchdog = std::make_unique<QueryWatchdog>([this](StatementTracker& Tracker, uint64_t Generation)
+        {
+            (void)Interrupt(Tracker, Generation, QueryStatus::TimedOut);
+        });
+}
+
+MySQLWrapper::~MySQLWrapper()
+{
+    Watchdog.reset();
+    {
+        std::lock_guard<std::mutex> Lock(PendingExplainMutex);
+        ExplainThread.request_stop();
+    }
+    ExplainWake.notify_all();
+    if (ExplainThread.joinable())
+        ExplainThread.join();
+    Disconnect();
+    if (LogSinkId != 0)
+    {
+        EventLogger::Instance().Flush();
+        EventLogger::Instance().RemoveSink(LogSinkId);
+    }
+}
+
+auto MySQLWrapper::Connect(const MySQLConfig& ConfigParam) -> bool
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    IsTransactionAborted = false;
+    Failover.reset();
+    ActiveEndpoint.reset();
+    return ConnectInternal(ConfigParam);
+}
+
+auto MySQLWrapper::ConnectFailover(std::shared_ptr<EndpointHealthMonitor> Monitor) -> bool
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    IsTransactionAborted = false;
+    Failover = std::move(Monitor);
+    if (!Failover || Failover->GetEndpointCount() == 0) [[unlikely]]
+    {
+        Failover.reset();
+        LastErrorMessage = "没有候选端点";
+        return false;
+    }
+    Failover->Start();
+    return ConnectBestEndpoint();
+}
+
+// 依次尝试评分最好的端点，熔断中的端点直接跳过，每次建连最多等待 AttemptTimeout
+auto MySQLWrapper::ConnectBestEndpoint() -> bool
+{
+    ActiveEndpoint.reset();
+    const std::vector<std::size_t> Ranked = Failover->RankEndpoints();
+    if (Ranked.empty())
+    {
+        DisconnectInternal();
+        LastErrorMessage = "所有候选端点都处于熔断状态或不可写";
+        LogError(LastErrorMessage);
+        return false;
+    }
+    std::string AttemptErrors;
+    for (const std::size_t Index : Ranked)
+    {
+        if (ConnectInternal(Failover->GetAttemptConfig(Index)))
+        {
+            Failover->RecordSuccess(Index);
+            ActiveEndpoint = Index;
+            return true;
+        }
+        Failover->RecordFailure(Index, LastErrorMessage);
+        AttemptErrors += std::format("\r\n  {}:{} - {}", CurrentConfig.Host, CurrentConfig.Port, LastErrorMessage);
+    }
+    LastErrorMessage = std::format("所有候选端点连接失败:{}", AttemptErrors);
+    LogError(LastErrorMessage);
+    return false;
+}
+
+auto MySQLWrapper::GetEndpointStatus() const -> std::vector<EndpointStatus>
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    return Failover ? Failover->GetStatus() : std::vector<EndpointStatus>{};
+}
+
+auto MySQLWrapper::ConnectInternal(const MySQLConfig& ConfigParam) -> bool
+{
+    try
+    {
+        DisconnectInternal();
+        CurrentConfig = ConfigParam;
+        if (!DriverInstance) [[unlikely]]
+        {
+            LastErrorMessage = "驱动未初始化";
+            LogError(LastErrorMessage);
+            return false;
+        }
+        ActiveConnection = OpenConnection(*DriverInstance, ConfigParam);
+        if (!ActiveConnection) [[unlikely]]
+        {
+            LastErrorMessage = "创建连接失败";
+            LogError(LastErrorMessage);
+            return false;
+        }
+        ServerConnectionId = QueryServerConnectionId(*ActiveConnection);
+        PrimaryState = InitialSessionState(ConfigParam);
+        {
+            std::lock_guard<std::mutex> ControlLock(ControlMutex);
+            ControlConfig = ConfigParam;
+        }
+        IsConnected = true;
+        SessionId = NextSessionId();
+        SessionPool = std::make_shared<ConnectionPool>(ConfigParam, SessionPoolSize);
+        LastSuccessfulConfig = ConfigParam;
+        LastErrorMessage.clear();
+        EmitEvent<EventLevel::Info>(EventCode::Connected, EventSource(), ConfigParam.Host, ConfigParam.Port);
+        return true;
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        LastErrorMessage = std::format("连接错误: {} (代码: {}, 状态: {})", Exception.what(), Exception.getErrorCode(), Exception.getSQLState());
+        LogError(LastErrorMessage);
+        IsConnected = false;
+        return false;
+    }
+}
+
+auto MySQLWrapper::DisconnectInternal() noexcept -> void
+{
+    try
+    {
+        if (ActiveConnection)
+        {
+            ActiveConnection->close();
+            ActiveConnection.reset();
+        }
+        {
+            std::lock_guard<std::mutex> ExplainLock(ExplainMutex);
+            if (ExplainConnection)
+            {
+                ExplainConnection->close();
+                ExplainConnection.reset();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> ControlLock(ControlMutex);
+            if (ControlConnection)
+            {
+                ControlConnection->close();
+                ControlConnection.reset();
+            }
+        }
+        SessionPool.reset();
+        ServerConnectionId = 0;
+        IsConnected = false;
+        EmitEvent<EventLevel::Info>(EventCode::Disconnected, EventSource(), {});
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        LastErrorMessage = std::format("断开连接错误: {}", Exception.what());
+        LogError(LastErrorMessage);
+    }
+    catch (...) { }
+}
+
+auto MySQLWrapper::Disconnect() noexcept -> void
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    IsTransactionAborted = false;
+    DisconnectInternal();
+}
+
+auto MySQLWrapper::ReconnectInternal() -> bool
+{
+    // 新连接处于自动提交模式，事务中的后续语句不能在上面悄悄生效
+    if (PrimaryState.HasTransaction)
+        IsTransactionAborted = true;
+    DisconnectInternal();
+    if (Failover)
+        return ConnectBestEndpoint();
+    if (LastSuccessfulConfig.Host.empty()) [[unlikely]]
+    {
+        LastErrorMessage = "没有可用的先前连接配置";
+        return false;
+    }
+    return ConnectInternal(LastSuccessfulConfig);
+}
+
+auto MySQLWrapper::Reconnect() -> bool
+{
+    EmitEvent<EventLevel::Info>(EventCode::Reconnecting, EventSource(), {});
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    return ReconnectInternal();
+}
+
+auto MySQLWrapper::Ping() -> bool
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    return PingInternal();
+}
+
+auto MySQLWrapper::PingInternal() -> bool
+{
+    if (!ActiveConnection) [[unlikely]]
+        return false;
+    try
+    {
+        const std::unique_ptr<sql::Statement> Statement(ActiveConnection->createStatement());
+        if (Statement->execute("SELECT 1"))
+        {
+            std::unique_ptr<sql::ResultSet> ResultSet(Statement->getResultSet());
+            while (ResultSet && ResultSet->next()) { /* 消费结果集 */ }
+        }
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+auto MySQLWrapper::Execute(const std::string& SqlCommand, std::chrono::milliseconds Timeout) -> MySQLResult
+{
+    return ExecuteInternal(SqlCommand, false, Timeout);
+}
+
+auto MySQLWrapper::Query(const std::string& SqlQuery, std::chrono::milliseconds Timeout) -> MySQLResult
+{
+    return ExecuteInternal(SqlQuery, true, Timeout);
+}
+
+auto MySQLWrapper::Cancel() -> bool
+{
+    return Interrupt(*PrimaryTracker, 0, QueryStatus::Cancelled);
+}
+
+// Generation 为 0 时中断当前正在执行的任意语句，否则只中断指定的那一次执行
+auto MySQLWrapper::Interrupt(StatementTracker& Tracker, uint64_t Generation, QueryStatus Reason) -> bool
+{
+    std::lock_guard<std::mutex> Lock(Tracker.Mutex);
+    if (!Tracker.IsRunning || Tracker.InterruptedAs || Tracker.ServerConnectionId == 0 || (Generation != 0 && Tracker.Generation != Generation))
+        return false;
+    Tracker.InterruptedAs = Reason;
+    if (KillQuery(Tracker.ServerConnectionId))
+    {
+        EmitEvent<EventLevel::Info>(EventCode::QueryInterrupted, EventSource(), Reason == QueryStatus::TimedOut ? "超过截止时间" : "用户取消", static_cast<int64_t>(Tracker.ServerConnectionId));
+        return true;
+    }
+    Tracker.InterruptedAs.reset();
+    return false;
+}
+
+auto MySQLWrapper::KillQuery(uint64_t TargetConnectionId) -> bool
+{
+    std::lock_guard<std::mutex> Lock(ControlMutex);
+    for (int Attempt = 0; Attempt < 2; ++Attempt)
+    {
+        try
+        {
+            if (!ControlConnection || ControlConnection->isClosed())
+            {
+                if (!DriverInstance) [[unlikely]]
+                    return false;
+                ControlConnection = OpenConnection(*DriverInstance, ControlConfig);
+                if (!ControlConnection) [[unlikely]]
+                    return false;
+            }
+            const std::unique_ptr<sql::Statement> Statement(ControlConnection->createStatement());
+            Statement->execute(std::format("KILL QUERY {}", TargetConnectionId));
+            return true;
+        }
+        catch (const sql::SQLException& Exception)
+        {
+            if (Exception.getErrorCode() == NoSuchThreadCode)
+                return false;
+            EmitError(std::format("发送 KILL QUERY 失败: {}", Exception.what()));
+            // 控制连接可能已失效，重建后再试一次
+            ControlConnection.reset();
+        }
+    }
+    return false;
+}
+
+auto MySQLWrapper::ExecuteParameterized(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> MySQLResult
+{
+    if (SQLSanitizer::DetectSQLInjection(QueryTemplate)) [[unlikely]]
+    {
+        MySQLResult ErrorResult;
+        ErrorResult.ErrorMessage = "检测到潜在的 SQL 注入";
+        ErrorResult.Success = false;
+        LogError(ErrorResult.ErrorMessage);
+        return ErrorResult;
+    }
+    const std::string FinalQuery = SQLSanitizer::BuildParameterizedQuery(QueryTemplate, ParameterList);
+    return Query(FinalQuery);
+}
+
+auto MySQLWrapper::ExecuteBatch(const std::vector<std::string>& SqlStatements) -> std::vector<MySQLResult>
+{
+    std::vector<MySQLResult> ResultList;
+    ResultList.reserve(SqlStatements.size());
+    for (const auto& SqlStatement : SqlStatements)
+        ResultList.push_back(Execute(SqlStatement));
+    return ResultList;
+}
+
+auto MySQLWrapper::BeginTransaction() -> bool
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    if (!ActiveConnection) [[unlikely]]
+        return false;
+    try
+    {
+        ActiveConnection->setAutoCommit(false);
+        PrimaryState.HasTransaction = true;
+        IsCommitOutcomeUnknown = false;
+        IsTransactionAborted = false;
+        LastErrorCode = 0;
+        EmitEvent<EventLevel::Debug>(EventCode::TransactionBegin, EventSource(), {});
+        return true;
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        LastErrorMessage = std::format("开始事务错误: {}", Exception.what());
+        LogError(LastErrorMessage);
+        return false;
+    }
+}
+
+auto MySQLWrapper::CommitTransaction() -> bool
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    if (IsTransactionAborted) [[unlikely]]
+    {
+        IsTransactionAborted = false;
+        LastErrorCode = AbortedTransactionErrorCode;
+        LastErrorMessage = std::format("提交事务错误: {}", AbortedTransactionMessage);
+        LogError(LastErrorMessage);
+        return false;
+    }
+    if (!ActiveConnection) [[unlikely]]
+        return false;
+    try
+    {
+        ActiveConnection->commit();
+        ActiveConnection->setAutoCommit(true);
+        PrimaryState.HasTransaction = false;
+        LastErrorCode = 0;
+        EmitEvent<EventLevel::Debug>(EventCode::TransactionCommit, EventSource(), {});
+        return true;
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        LastErrorCode = Exception.getErrorCode();
+        IsCommitOutcomeUnknown = ClassifyError(LastErrorCode) == ErrorCategory::ConnectionLost;
+        LastErrorMessage = std::format("提交事务错误: {}", Exception.what());
+        LogError(LastErrorMessage);
+        return false;
+    }
+}
+
+auto MySQLWrapper::RollbackTransaction() -> bool
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    IsTransactionAborted = false;
+    if (!ActiveConnection) [[unlikely]]
+        return false;
+    try
+    {
+        ActiveConnection->rollback();
+        ActiveConnection->setAutoCommit(true);
+        PrimaryState.HasTransaction = false;
+        EmitEvent<EventLevel::Debug>(EventCode::TransactionRollback, EventSource(), {});
+        return true;
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        LastErrorMessage = std::format("回滚事务错误: {}", Exception.what());
+        LogError(LastErrorMessage);
+        return false;
+    }
+}
+
+auto MySQLWrapper::GetTransactionGuard() -> std::unique_ptr<TransactionGuard>
+{
+    if (!ActiveConnection) [[unlikely]]
+        return nullptr;
+    return std::make_unique<TransactionGuard>(ActiveConnection.get());
+}
+
+auto MySQLWrapper::PrepareStatement(std::string_view SqlQuery) -> std::expected<std::unique_ptr<sql::PreparedStatement>, std::string>
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    if (!ActiveConnection) [[unlikely]]
+        return std::unexpected("未连接到数据库");
+    try
+    {
+        return std::unique_ptr<sql::PreparedStatement>(
+            ActiveConnection->prepareStatement(std::string{ SqlQuery }));
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        return std::unexpected(std::format("预处理语句错误: {}", Exception.what()));
+    }
+}
+
+auto MySQLWrapper::ExecutePrepared(sql::PreparedStatement* StatementPtr, const std::vector<std::string>& ParameterList) -> MySQLResult
+{
+    MySQLResult ResultData = ExecutePreparedOn(StatementPtr, ParameterList);
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    if (ResultData.Success)
+        LastErrorCode = 0;
+    else
+    {
+        LastErrorMessage = ResultData.ErrorMessage;
+        LastErrorCode = ResultData.ErrorCode;
+    }
+    return ResultData;
+}
+
+auto MySQLWrapper::ExecutePreparedOn(sql::PreparedStatement* StatementPtr, const std::vector<std::string>& ParameterList) -> MySQLResult
+{
+    MySQLResult ResultData;
+    ResultData.Rows.SetBudget(ResultMemoryBudget.load(std::memory_order_relaxed));
+    if (!StatementPtr) [[unlikely]]
+    {
+        ResultData.ErrorMessage = "空语句指针";
+        return ResultData;
+    }
+    auto PhaseStart = std::chrono::steady_clock::now();
+    try
+    {
+        for (std::size_t Index = 0; Index < ParameterList.size(); ++Index)
+            StatementPtr->setString(static_cast<unsigned int>(Index + 1), ParameterList[Index]);
+        const bool HasResultSet = StatementPtr->execute();
+        auto PhaseEnd = std::chrono::steady_clock::now();
+        ResultData.Timing.Execute = PhaseEnd - PhaseStart;
+        PhaseStart = PhaseEnd;
+        if (HasResultSet)
+        {
+            const std::unique_ptr<sql::ResultSet> ResultSet(StatementPtr->getResultSet());
+            sql::ResultSetMetaData* MetaData = ResultSet->getMetaData();
+            const int ColumnCount = MetaData->getColumnCount();
+            for (int Index = 1; Index <= ColumnCount; ++Index)
+                ResultData.ColumnNames.push_back(MetaData->getColumnName(Index));
+            while (ResultSet->next())
+            {
+                PhaseEnd = std::chrono::steady_clock::now();
+                ResultData.Timing.Fetch += PhaseEnd - PhaseStart;
+                PhaseStart = PhaseEnd;
+                ResultData.Rows.push_back(MaterializeRow(*ResultSet, ColumnCount));
+                PhaseEnd = std::chrono::steady_clock::now();
+                ResultData.Timing.Materialize += PhaseEnd - PhaseStart;
+                PhaseStart = PhaseEnd;
+            }
+            ResultData.Timing.Fetch += std::chrono::steady_clock::now() - PhaseStart;
+        }
+        else
+            ResultData.AffectedRows = StatementPtr->getUpdateCount();
+        ResultData.Success = true;
+        ResultData.Status = QueryStatus::Succeeded;
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        auto& PendingPhase = ResultData.Timing.Execute.count() == 0 ? ResultData.Timing.Execute : ResultData.Timing.Fetch;
+        PendingPhase += std::chrono::steady_clock::now() - PhaseStart;
+        ResultData.ErrorCode = Exception.getErrorCode();
+        ResultData.ErrorMessage = std::format("执行预处理语句错误: {}", Exception.what());
+        EmitError(ResultData.ErrorMessage);
+        if (const ErrorCategory Category = ClassifyError(ResultData.ErrorCode); Category == ErrorCategory::Deadlock)
+        {
+            Statistics.Deadlocks.fetch_add(1, std::memory_order_relaxed);
+            if (ResultData.ErrorCode == DeadlockCode && StatementPtr->getConnection())
+                CaptureDeadlock(*StatementPtr->getConnection(), "(预处理语句)");
+        }
+        else if (Category == ErrorCategory::ConnectionLost)
+            Statistics.ConnectionLosses.fetch_add(1, std::memory_order_relaxed);
+    }
+    ResultData.ExecutionTime = ResultData.Timing.Total();
+    UpdateStatistics({}, ResultData, nullptr, nullptr);
+    return ResultData;
+}
+
+auto MySQLWrapper::GetDatabases() -> std::expected<std::vector<std::string>, std::string>
+{
+    const MySQLResult ResultData = Query("SHOW DATABASES");
+    if (!ResultData.Success) [[unlikely]]
+        return std::unexpected(ResultData.ErrorMessage);
+    std::vector<std::string> DatabaseList;
+    DatabaseList.reserve(ResultData.Rows.size());
+    for (const auto& RowData : ResultData.Rows)
+    {
+        if (!RowData.Fields.empty())
+            DatabaseList.push_back(RowData.Fields[0]);
+    }
+    return DatabaseList;
+}
+
+auto MySQLWrapper::GetTables(std::string_view DatabaseName) -> std::expected<std::vector<std::string>, std::string>
+{
+    std::string SqlQuery = "SHOW TABLES";
+    if (!DatabaseName.empty())
+        SqlQuery += std::format(" FROM `{}`", DatabaseName);
+    const MySQLResult ResultData = Query(SqlQuery);
+    if (!ResultData.Success) [[unlikely]]
+        return std::unexpected(ResultData.ErrorMessage);
+    std::vector<std::string> TableList;
+    TableList.reserve(ResultData.Rows.size());
+    for (const auto& RowData : ResultData.Rows)
+    {
+        if (!RowData.Fields.empty())
+            TableList.push_back(RowData.Fields[0]);
+    }
+    return TableList;
+}
+
+auto MySQLWrapper::GetTableStructure(std::string_view TableName) -> std::expected<MySQLResult, std::string>
+{
+    if (!SQLSanitizer::IsValidIdentifier(TableName)) [[unlikely]]
+        return std::unexpected("无效的表名");
+    const MySQLResult ResultData = Query(std::format("DESCRIBE `{}`", TableName));
+    if (!ResultData.Success) [[unlikely]]
+        return std::unexpected(ResultData.ErrorMessage);
+    return ResultData;
+}
+
+auto MySQLWrapper::GetTableIndexes(std::string_view TableName) -> std::expected<MySQLResult, std::string>
+{
+    if (!SQLSanitizer::IsValidIdentifier(TableName)) [[unlikely]]
+        return std::unexpected("无效的表名");
+    const MySQLResult ResultData = Query(std::format("SHOW INDEX FROM `{}`", TableName));
+    if (!ResultData.Success) [[unlikely]]
+        return std::unexpected(ResultData.ErrorMessage);
+    return ResultData;
+}
+
+auto MySQLWrapper::GetServerVersion() -> std::expected<std::string, std::string>
+{
+    const MySQLResult ResultData = Query("SELECT VERSION()");
+    if (!ResultData.Success || ResultData.Rows.empty() || ResultData.Rows[0].Fields.empty()) [[unlikely]]
+        return std::unexpected("获取服务器版本失败");
+    return ResultData.Rows[0].Fields[0];
+}
+
+auto MySQLWrapper::GetCurrentDatabase() -> std::expected<std::string, std::string>
+{
+    const MySQLResult ResultData = Query("SELECT DATABASE()");
+    if (!ResultData.Success || ResultData.Rows.empty() || ResultData.Rows[0].Fields.empty()) [[unlikely]]
+        return std::unexpected("获取当前数据库失败");
+    return ResultData.Rows[0].Fields[0];
 }
 
-auto MySQLResult::HasColumn(std::string_view ColumnName) const -> bool
+auto MySQLWrapper::EscapeString(const std::string& InputString) const -> std::string
 {
-    return std::ranges::any_of(ColumnNames, [ColumnName](const std::string& NameValue) { return NameValue == ColumnName; });
+    return SQLSanitizer::EscapeString(InputString);
 }
 
-TransactionGuard::TransactionGuard(sql::Connection* ConnectionPtr) : Connection(ConnectionPtr)
+auto MySQLWrapper::ValidateSQL(std::string_view SqlQuery) const -> bool
 {
-    if (Connection)
-    {
-        try { Connection->setAutoCommit(false); }
-        catch (...) { }
-    }
+    return !SQLSanitizer::DetectSQLInjection(SqlQuery);
 }
 
-TransactionGuard::~TransactionGuard()
+auto MySQLWrapper::SetQueryTimeout(unsigned int TimeoutSeconds) -> void
 {
-    if (Connection && !IsCommitted && !IsRolledBack)
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    if (ActiveConnection)
     {
         try
         {
-            Connection->rollback();
-            Connection->setAutoCommit(true);
+            ActiveConnection->setClientOption("OPT_READ_TIMEOUT", &TimeoutSeconds);
         }
         catch (...) { }
     }
 }
 
-auto TransactionGuard::Commit() -> void
+auto MySQLWrapper::SetResultLimit(std::size_t MaxRows, ResultLimitMode Mode) -> void
 {
-    if (Connection && !IsCommitted && !IsRolledBack)
-    {
-        Connection->commit();
-        Connection->setAutoCommit(true);
-        IsCommitted = true;
-    }
+    MaxResultRows.store(MaxRows, std::memory_order_relaxed);
+    LimitMode.store(Mode, std::memory_order_relaxed);
 }
 
-auto TransactionGuard::Rollback() -> void
+auto MySQLWrapper::SetResultMemoryBudget(std::size_t Bytes) -> void
 {
-    if (Connection && !IsCommitted && !IsRolledBack)
+    ResultMemoryBudget.store(Bytes, std::memory_order_relaxed);
+}
+
+auto MySQLWrapper::GetLastError() const -> std::string
+{
+    return LastErrorMessage;
+}
+
+auto MySQLWrapper::IsTransactionOutcomeUnknown() const -> bool
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    return IsCommitOutcomeUnknown;
+}
+
+auto MySQLWrapper::SetLogCallback(std::function<void(std::string_view)> CallbackFunc) -> void
+{
+    EventLogger& Logger = EventLogger::Instance();
+    if (LogSinkId != 0)
     {
-        Connection->rollback();
-        Connection->setAutoCommit(true);
-        IsRolledBack = true;
+        Logger.RemoveSink(LogSinkId);
+        LogSinkId = 0;
     }
+    if (CallbackFunc)
+        LogSinkId = Logger.AddSink([Callback = std::move(CallbackFunc)](const EventEntry& Entry) { Callback(Entry.Message); }, EventSource());
 }
 
-auto SQLSanitizer::DetectSQLInjection(std::string_view SqlQuery) -> bool
+auto MySQLWrapper::Log(std::string_view Message) const -> void
 {
-    constexpr std::array<std::string_view, 6> DangerousPatterns = 
+    EmitEvent<EventLevel::Info>(EventCode::Message, EventSource(), Message);
+}
+
+auto MySQLWrapper::LogError(std::string_view ErrorMessage) -> void
+{
+    LastErrorMessage = ErrorMessage;
+    EmitError(ErrorMessage);
+}
+
+auto MySQLWrapper::EmitError(std::string_view ErrorMessage) const -> void
+{
+    EmitEvent<EventLevel::Error>(EventCode::Error, EventSource(), ErrorMessage);
+}
+
+auto MySQLWrapper::ConnectExpected(const MySQLConfig& ConfigParam) -> std::expected<void, std::string>
+{
+    const bool IsSuccess = Connect(ConfigParam);
+    if (IsSuccess)
+        return {};
+    else
+        return std::unexpected(LastErrorMessage);
+}
+
+auto MySQLWrapper::QueryExpected(const std::string& SqlQuery) -> std::expected<MySQLResult, std::string>
+{
+    MySQLResult ResultData = Query(SqlQuery);
+    if (ResultData.Success)
+        return ResultData;
+    else
+        return std::unexpected(ResultData.ErrorMessage);
+}
+
+auto MySQLWrapper::GetStatistics() const -> std::tuple<uint64_t, uint64_t, uint64_t>
+{
+    return 
     {
-        R"((\bOR\b|\bAND\b)\s+['\"]?\d+['\"]?\s*=\s*['\"]?\d+)",
-        R"(;\s*(DROP|DELETE|UPDATE|INSERT)\s+)",
-        R"(--|\#|/\*)",
-        R"(\bUNION\b.*\bSELECT\b)",
-        R"(\bEXEC\b|\bEXECUTE\b)",
-        R"(\bxp_cmdshell\b)",
+        Statistics.TotalQueries.load(),
+        Statistics.SuccessfulQueries.load(),
+        Statistics.FailedQueries.load()
     };
-    std::string UpperCaseQuery;
-    UpperCaseQuery.reserve(SqlQuery.size());
-    std::ranges::transform(SqlQuery, std::back_inserter(UpperCaseQuery), [](unsigned char CharValue) { return std::toupper(CharValue); });
-    for (const auto& PatternString : DangerousPatterns)
+}
+
+auto MySQLWrapper::GetRetryStatistics() const -> RetryStatistics
+{
+    return
     {
-        try
-        {
-            const std::regex PatternRegex(PatternString.data(), std::regex::icase);
-            if (std::regex_search(UpperCaseQuery, PatternRegex))
-                return true;
-        }
-        catch (...)
-        {
-            continue;
-        }
-    }
-    return false;
+        Statistics.StatementRetries.load(),
+        Statistics.TransactionReplays.load(),
+        Statistics.Deadlocks.load(),
+        Statistics.ConnectionLosses.load(),
+        Statistics.ExhaustedRetries.load(),
+        std::chrono::nanoseconds{ Statistics.RetryNanoseconds.load() }
+    };
 }
 
-auto SQLSanitizer::IsValidIdentifier(std::string_view IdentifierName) -> bool
+auto MySQLWrapper::GetDeadlocks() const -> std::vector<DeadlockRecord>
 {
-    if (IdentifierName.empty()) [[unlikely]]
-        return false;
-    if (std::isdigit(static_cast<unsigned char>(IdentifierName[0]))) [[unlikely]]
-        return false;
-    return std::ranges::all_of(IdentifierName, [](unsigned char CharValue) { return std::isalnum(CharValue) || CharValue == '_'; });
+    std::lock_guard<std::mutex> Lock(DeadlockMutex);
+    return { Deadlocks.begin(), Deadlocks.end() };
 }
 
-auto SQLSanitizer::EscapeString(std::string_view InputString) -> std::string
+auto MySQLWrapper::ResetStatistics() -> void
 {
-    std::string EscapedString;
-    EscapedString.reserve(InputString.length() * 2);
-    for (const char CharValue : InputString)
+    Statistics.TotalQueries = 0;
+    Statistics.SuccessfulQueries = 0;
+    Statistics.FailedQueries = 0;
+    Statistics.QueryLatency.Reset();
+    Statistics.StatementRetries = 0;
+    Statistics.TransactionReplays = 0;
+    Statistics.Deadlocks = 0;
+    Statistics.ConnectionLosses = 0;
+    Statistics.ExhaustedRetries = 0;
+    Statistics.RetryNanoseconds = 0;
+    Digests.Reset();
     {
-        switch (CharValue)
-        {
-        case '\'': EscapedString += "\\'"; break;
-        case '\"': EscapedString += "\\\""; break;
-        case '\\': EscapedString += "\\\\"; break;
-        case '\0': EscapedString += "\\0"; break;
-        case '\n': EscapedString += "\\n"; break;
-        case '\r': EscapedString += "\\r"; break;
-        case '\t': EscapedString += "\\t"; break;
-        default: EscapedString += CharValue; break;
-        }
+        std::lock_guard<std::mutex> Lock(DeadlockMutex);
+        Deadlocks.clear();
     }
-    return EscapedString;
+    std::lock_guard<std::mutex> Lock(SlowQueryMutex);
+    SlowQueries.clear();
 }
 
-auto SQLSanitizer::BuildParameterizedQuery(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> std::string
+auto MySQLWrapper::GetLatencySnapshot() const -> LatencySnapshot
 {
-    std::string ResultQuery{ QueryTemplate };
-    std::size_t ParameterIndex = 0;
-    std::size_t SearchPosition = 0;
-    while ((SearchPosition = ResultQuery.find('?', SearchPosition)) != std::string::npos)
-    {
-        if (ParameterIndex >= ParameterList.size()) [[unlikely]]
-            break;
-        const std::string EscapedParameter = std::format("'{}'", EscapeString(ParameterList[ParameterIndex]));
-        ResultQuery.replace(SearchPosition, 1, EscapedParameter);
-        SearchPosition += EscapedParameter.length();
-        ++ParameterIndex;
-    }
-    return ResultQuery;
+    return Statistics.QueryLatency.Snapshot();
 }
 
-MySQLWrapper::MySQLWrapper()
+auto MySQLWrapper::GetConnectionInfo() const -> std::string
 {
-    try
-    {
-        DriverInstance = sql::mysql::get_driver_instance();
-    }
-    catch (const sql::SQLException& Exception)
-    {
-        LastErrorMessage = std::format("驱动初始化错误: {} (代码: {})", Exception.what(), Exception.getErrorCode());
-    }
+    if (!IsConnected)
+        return "未连接";
+    return std::format("{}@{}:{}/{}", CurrentConfig.User, CurrentConfig.Host, CurrentConfig.Port, CurrentConfig.Database);
 }
 
-MySQLWrapper::~MySQLWrapper()
+auto MySQLWrapper::SetWorkloadRecorder(std::shared_ptr<WorkloadRecorder> RecorderPtr) -> void
 {
-    Disconnect();
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    Recorder = std::move(RecorderPtr);
 }
 
-auto MySQLWrapper::Connect(const MySQLConfig& ConfigParam) -> bool
+auto MySQLWrapper::SetFetchObserver(std::shared_ptr<const FetchObserver> ObserverPtr) -> void
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    return ConnectInternal(ConfigParam);
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    Observer = std::move(ObserverPtr);
 }
 
-auto MySQLWrapper::ConnectInternal(const MySQLConfig& ConfigParam) -> bool
+auto MySQLWrapper::GetSessionId() const -> uint64_t
 {
-    try
-    {
-        DisconnectInternal();
-        CurrentConfig = ConfigParam;
-        if (!DriverInstance) [[unlikely]]
-        {
-            LastErrorMessage = "驱动未初始化";
-            LogError(LastErrorMessage);
-            return false;
-        }
-        const std::string ConnectionUrl = std::format("tcp://{}:{}", ConfigParam.Host, ConfigParam.Port);
-        ActiveConnection.reset(DriverInstance->connect(ConnectionUrl, ConfigParam.User, ConfigParam.Password));
-        if (!ActiveConnection) [[unlikely]]
-        {
-            LastErrorMessage = "创建连接失败";
-            LogError(LastErrorMessage);
-            return false;
-        }
-        ActiveConnection->setClientOption("OPT_CONNECT_TIMEOUT", &ConfigParam.ConnectTimeout);
-        ActiveConnection->setClientOption("OPT_READ_TIMEOUT", &ConfigParam.ReadTimeout);
-        ActiveConnection->setClientOption("OPT_WRITE_TIMEOUT", &ConfigParam.WriteTimeout);
-        if (ConfigParam.EnableAutoReconnect)
-        {
-            bool AutoReconnectFlag = true;
-            ActiveConnection->setClientOption("OPT_RECONNECT", &AutoReconnectFlag);
-        }
-        if (!ConfigParam.Database.empty())
-            ActiveConnection->setSchema(ConfigParam.Database);
-        const std::unique_ptr<sql::Statement> Statement(ActiveConnection->createStatement());
-        Statement->execute(std::format("SET NAMES {}", ConfigParam.Charset));
-        IsConnected = true;
-        LastSuccessfulConfig = ConfigParam;
-        LastErrorMessage.clear();
-        Log(std::format("已连接到 {}:{}", ConfigParam.Host, ConfigParam.Port));
-        return true;
-    }
-    catch (const sql::SQLException& Exception)
-    {
-        LastErrorMessage = std::format("连接错误: {} (代码: {}, 状态: {})", Exception.what(), Exception.getErrorCode(), Exception.getSQLState());
-        LogError(LastErrorMessage);
-        IsConnected = false;
-        return false;
-    }
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    return SessionId;
 }
 
-auto MySQLWrapper::DisconnectInternal() noexcept -> void
+auto MySQLWrapper::NextSessionId() noexcept -> uint64_t
 {
-    try
+    static std::atomic<uint64_t> SessionCounter{ 1 };
+    return SessionCounter.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto MySQLWrapper::OpenSession() -> std::expected<std::unique_ptr<Session>, std::string>
+{
+    std::shared_ptr<ConnectionPool> PoolPtr;
+    std::shared_ptr<WorkloadRecorder> RecorderPtr;
     {
-        if (ActiveConnection)
-        {
-            ActiveConnection->close();
-            ActiveConnection.reset();
-        }
-        IsConnected = false;
-        Log("已断开数据库连接");
+        std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+        PoolPtr = SessionPool;
+        RecorderPtr = Recorder;
     }
-    catch (const sql::SQLException& Exception)
+    if (!PoolPtr) [[unlikely]]
+        return std::unexpected("未连接到数据库");
+    std::unique_ptr<sql::Connection> ConnectionPtr = PoolPtr->AcquireConnection();
+    if (!ConnectionPtr) [[unlikely]]
+        return std::unexpected("无法从连接池获取连接");
+    return std::unique_ptr<Session>(new Session(*this, std::move(PoolPtr), std::move(ConnectionPtr), std::move(RecorderPtr)));
+}
+
+auto MySQLWrapper::SetSessionPoolSize(std::size_t PoolSize) -> void
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    SessionPoolSize = (std::max)(PoolSize, std::size_t{ 1 });
+}
+
+auto MySQLWrapper::GetSessionPoolLatency() const -> std::pair<LatencySnapshot, LatencySnapshot>
+{
+    std::shared_ptr<ConnectionPool> PoolPtr;
     {
-        LastErrorMessage = std::format("断开连接错误: {}", Exception.what());
-        LogError(LastErrorMessage);
+        std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+        PoolPtr = SessionPool;
     }
-    catch (...) { }
+    if (!PoolPtr)
+        return {};
+    return { PoolPtr->GetAcquireLatency(), PoolPtr->GetHoldLatency() };
 }
 
-auto MySQLWrapper::Disconnect() noexcept -> void
+Session::Session(MySQLWrapper& OwnerRef, std::shared_ptr<ConnectionPool> PoolPtr, std::unique_ptr<sql::Connection> ConnectionPtr, std::shared_ptr<WorkloadRecorder> RecorderPtr)
+    : Owner(&OwnerRef), Pool(std::move(PoolPtr)), Connection(std::move(ConnectionPtr)), Recorder(std::move(RecorderPtr)),
+      Tracker(std::make_shared<StatementTracker>()), State(Pool->GetInitialState()), SessionId(MySQLWrapper::NextSessionId()), ServerConnectionId(Pool->GetServerConnectionId(Connection.get()))
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    DisconnectInternal();
 }
 
-auto MySQLWrapper::ReconnectInternal() -> bool
+Session::~Session()
 {
-    DisconnectInternal();
-    if (LastSuccessfulConfig.Host.empty()) [[unlikely]]
+    // ReplaceConnection 检出失败后连接为空
+    if (!Connection) [[unlikely]]
+        return;
+    if (IsInTransaction)
     {
-        LastErrorMessage = "没有可用的先前连接配置";
-        return false;
+        try
+        {
+            Connection->rollback();
+            Connection->setAutoCommit(true);
+        }
+        catch (...) { }
     }
-    return ConnectInternal(LastSuccessfulConfig);
+    Pool->ReleaseConnection(std::move(Connection), State);
 }
 
-auto MySQLWrapper::Reconnect() -> bool
+auto Session::SetError(std::string_view ErrorMessage) -> void
 {
-    Log("尝试重新连接...");
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    return ReconnectInternal();
+    LastErrorMessage = ErrorMessage;
+    Owner->EmitError(ErrorMessage);
 }
 
-auto MySQLWrapper::Ping() -> bool
+// 先归还再检出，避免池已满时等待自己占用的名额；检出失败后会话不再可用
+auto Session::ReplaceConnection() -> bool
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    return PingInternal();
+    if (Connection)
+        Pool->ReleaseConnection(std::move(Connection), State);
+    // 旧连接上的事务随连接一起结束
+    IsInTransaction = false;
+    Connection = Pool->AcquireConnection();
+    if (!Connection) [[unlikely]]
+        return false;
+    State = Pool->GetInitialState();
+    ServerConnectionId = Pool->GetServerConnectionId(Connection.get());
+    return true;
+}
+
+auto Session::Execute(const std::string& SqlCommand, std::chrono::milliseconds Timeout) -> MySQLResult
+{
+    MySQLResult ResultData;
+    if (!Connection) [[unlikely]]
+    {
+        ResultData.ErrorMessage = "会话连接已失效";
+        LastErrorMessage = ResultData.ErrorMessage;
+        return ResultData;
+    }
+    std::chrono::steady_clock::time_point FirstFailure;
+    uint32_t RetryCount = 0;
+    for (const unsigned int MaxRetries = Pool->GetMaxRetries();; ++RetryCount)
+    {
+        const MySQLWrapper::ExecutionTarget Target{ Connection.get(), ServerConnectionId, SessionId, Recorder.get(), Tracker, &State };
+        ResultData = Owner->ExecuteOn(Target, SqlCommand, Timeout, {}, std::chrono::steady_clock::now());
+        if (ResultData.Success || IsInTransaction || !Owner->ShouldRetryStatement(ResultData, SqlCommand, State, Pool->GetInitialState()))
+            break;
+        if (RetryCount >= MaxRetries)
+        {
+            Owner->Statistics.ExhaustedRetries.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        if (RetryCount == 0)
+            FirstFailure = std::chrono::steady_clock::now();
+        const auto Delay = MySQLWrapper::RetryDelay(RetryCount);
+        EmitEvent<EventLevel::Info>(EventCode::Retrying, Owner->EventSource(), SqlCommand, RetryCount + 1, std::chrono::duration_cast<std::chrono::milliseconds>(Delay).count());
+        std::this_thread::sleep_for(Delay);
+        if (ClassifyError(ResultData.ErrorCode) == ErrorCategory::ConnectionLost && !ReplaceConnection()) [[unlikely]]
+        {
+            ResultData.ErrorMessage = "连接中断后无法从连接池获取新连接";
+            break;
+        }
+        Owner->Statistics.StatementRetries.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (RetryCount > 0)
+        Owner->Statistics.RetryNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - FirstFailure).count(), std::memory_order_relaxed);
+    ResultData.RetryCount = RetryCount;
+    if (ResultData.Success)
+    {
+        LastErrorMessage.clear();
+        LastErrorCode = 0;
+    }
+    else
+    {
+        LastErrorMessage = ResultData.ErrorMessage;
+        LastErrorCode = ResultData.ErrorCode;
+    }
+    return ResultData;
 }
 
-auto MySQLWrapper::PingInternal() -> bool
+auto Session::PrepareTransactionReplay(uint32_t Attempt) -> bool
 {
-    if (!ActiveConnection) [[unlikely]]
+    if (IsCommitOutcomeUnknown) [[unlikely]]
+    {
+        SetError("提交时连接中断，事务结果未知，不再重放");
         return false;
-    try
+    }
+    const ErrorCategory Category = ClassifyError(LastErrorCode);
+    if (Category != ErrorCategory::Deadlock && Category != ErrorCategory::ConnectionLost)
+        return false;
+    if (Attempt >= Pool->GetMaxRetries())
     {
-        const std::unique_ptr<sql::Statement> Statement(ActiveConnection->createStatement());
-        if (Statement->execute("SELECT 1"))
-        {
-            std::unique_ptr<sql::ResultSet> ResultSet(Statement->getResultSet());
-            while (ResultSet && ResultSet->next()) { /* 消费结果集 */ }
-        }
-        return true;
+        Owner->Statistics.ExhaustedRetries.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
-    catch (...)
+    const auto ReplayStart = std::chrono::steady_clock::now();
+    const auto Delay = MySQLWrapper::RetryDelay(Attempt);
+    EmitEvent<EventLevel::Info>(EventCode::Retrying, Owner->EventSource(), "事务", Attempt + 1, std::chrono::duration_cast<std::chrono::milliseconds>(Delay).count());
+    std::this_thread::sleep_for(Delay);
+    if (Category == ErrorCategory::ConnectionLost && !ReplaceConnection()) [[unlikely]]
     {
+        SetError("连接中断后无法从连接池获取新连接");
         return false;
     }
+    Owner->Statistics.TransactionReplays.fetch_add(1, std::memory_order_relaxed);
+    Owner->Statistics.RetryNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ReplayStart).count(), std::memory_order_relaxed);
+    return true;
 }
 
-auto MySQLWrapper::Execute(const std::string& SqlCommand) -> MySQLResult
+auto Session::Query(const std::string& SqlQuery, std::chrono::milliseconds Timeout) -> MySQLResult
 {
-    return ExecuteInternal(SqlCommand, false);
+    return Execute(SqlQuery, Timeout);
 }
 
-auto MySQLWrapper::Query(const std::string& SqlQuery) -> MySQLResult
+auto Session::Cancel() -> bool
 {
-    return ExecuteInternal(SqlQuery, true);
+    return Owner->Interrupt(*Tracker, 0, QueryStatus::Cancelled);
 }
 
-auto MySQLWrapper::ExecuteParameterized(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> MySQLResult
+auto Session::ExecuteParameterized(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> MySQLResult
 {
     if (SQLSanitizer::DetectSQLInjection(QueryTemplate)) [[unlikely]]
     {
         MySQLResult ErrorResult;
         ErrorResult.ErrorMessage = "检测到潜在的 SQL 注入";
-        ErrorResult.Success = false;
-        LogError(ErrorResult.ErrorMessage);
+        SetError(ErrorResult.ErrorMessage);
         return ErrorResult;
     }
-    const std::string FinalQuery = SQLSanitizer::BuildParameterizedQuery(QueryTemplate, ParameterList);
-    return Query(FinalQuery);
+    return Execute(SQLSanitizer::BuildParameterizedQuery(QueryTemplate, ParameterList));
 }
 
-auto MySQLWrapper::ExecuteBatch(const std::vector<std::string>& SqlStatements) -> std::vector<MySQLResult>
+auto Session::ExecuteBatch(const std::vector<std::string>& SqlStatements) -> std::vector<MySQLResult>
 {
     std::vector<MySQLResult> ResultList;
     ResultList.reserve(SqlStatements.size());
@@ -308,81 +1944,82 @@ auto MySQLWrapper::ExecuteBatch(const std::vector<std::string>& SqlStatements) -
     return ResultList;
 }
 
-auto MySQLWrapper::BeginTransaction() -> bool
+auto Session::BeginTransaction() -> bool
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    if (!ActiveConnection) [[unlikely]]
+    if (!Connection) [[unlikely]]
+    {
+        SetError("会话连接已失效");
         return false;
+    }
     try
     {
-        ActiveConnection->setAutoCommit(false);
-        Log("事务已开始");
+        Connection->setAutoCommit(false);
+        IsInTransaction = true;
+        IsCommitOutcomeUnknown = false;
+        LastErrorCode = 0;
+        EmitEvent<EventLevel::Debug>(EventCode::TransactionBegin, Owner->EventSource(), {});
         return true;
     }
     catch (const sql::SQLException& Exception)
     {
-        LastErrorMessage = std::format("开始事务错误: {}", Exception.what());
-        LogError(LastErrorMessage);
+        SetError(std::format("开始事务错误: {}", Exception.what()));
         return false;
     }
 }
 
-auto MySQLWrapper::CommitTransaction() -> bool
+auto Session::CommitTransaction() -> bool
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    if (!ActiveConnection) [[unlikely]]
+    if (!Connection) [[unlikely]]
         return false;
     try
     {
-        ActiveConnection->commit();
-        ActiveConnection->setAutoCommit(true);
-        Log("事务已提交");
+        Connection->commit();
+        Connection->setAutoCommit(true);
+        IsInTransaction = false;
+        LastErrorCode = 0;
+        EmitEvent<EventLevel::Debug>(EventCode::TransactionCommit, Owner->EventSource(), {});
         return true;
     }
     catch (const sql::SQLException& Exception)
     {
-        LastErrorMessage = std::format("提交事务错误: {}", Exception.what());
-        LogError(LastErrorMessage);
+        LastErrorCode = Exception.getErrorCode();
+        IsCommitOutcomeUnknown = ClassifyError(LastErrorCode) == ErrorCategory::ConnectionLost;
+        SetError(std::format("提交事务错误: {}", Exception.what()));
         return false;
     }
 }
 
-auto MySQLWrapper::RollbackTransaction() -> bool
+auto Session::RollbackTransaction() -> bool
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    if (!ActiveConnection) [[unlikely]]
+    if (!Connection) [[unlikely]]
         return false;
     try
     {
-        ActiveConnection->rollback();
-        ActiveConnection->setAutoCommit(true);
-        Log("事务已回滚");
+        Connection->rollback();
+        Connection->setAutoCommit(true);
+        IsInTransaction = false;
+        EmitEvent<EventLevel::Debug>(EventCode::TransactionRollback, Owner->EventSource(), {});
         return true;
     }
     catch (const sql::SQLException& Exception)
     {
-        LastErrorMessage = std::format("回滚事务错误: {}", Exception.what());
-        LogError(LastErrorMessage);
+        SetError(std::format("回滚事务错误: {}", Exception.what()));
         return false;
     }
 }
 
-auto MySQLWrapper::GetTransactionGuard() -> std::unique_ptr<TransactionGuard>
+auto Session::GetTransactionGuard() -> std::unique_ptr<TransactionGuard>
 {
-    if (!ActiveConnection) [[unlikely]]
-        return nullptr;
-    return std::make_unique<TransactionGuard>(ActiveConnection.get());
+    return std::make_unique<TransactionGuard>(Connection.get());
 }
 
-auto MySQLWrapper::PrepareStatement(std::string_view SqlQuery) -> std::expected<std::unique_ptr<sql::PreparedStatement>, std::string>
+auto Session::PrepareStatement(std::string_view SqlQuery) -> std::expected<std::unique_ptr<sql::PreparedStatement>, std::string>
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    if (!ActiveConnection) [[unlikely]]
-        return std::unexpected("未连接到数据库");
+    if (!Connection) [[unlikely]]
+        return std::unexpected("会话连接已失效");
     try
     {
-        return std::unique_ptr<sql::PreparedStatement>(
-            ActiveConnection->prepareStatement(std::string{ SqlQuery }));
+        return std::unique_ptr<sql::PreparedStatement>(Connection->prepareStatement(std::string{ SqlQuery }));
     }
     catch (const sql::SQLException& Exception)
     {
@@ -390,239 +2027,418 @@ auto MySQLWrapper::PrepareStatement(std::string_view SqlQuery) -> std::expected<
     }
 }
 
-auto MySQLWrapper::ExecutePrepared(sql::PreparedStatement* StatementPtr, const std::vector<std::string>& ParameterList) -> MySQLResult
+auto Session::ExecutePrepared(sql::PreparedStatement* StatementPtr, const std::vector<std::string>& ParameterList) -> MySQLResult
 {
-    MySQLResult ResultData;
-    if (!StatementPtr) [[unlikely]]
-    {
-        ResultData.ErrorMessage = "空语句指针";
-        return ResultData;
-    }
-    try
+    MySQLResult ResultData = Owner->ExecutePreparedOn(StatementPtr, ParameterList);
+    if (ResultData.Success)
     {
-        for (std::size_t Index = 0; Index < ParameterList.size(); ++Index)
-            StatementPtr->setString(static_cast<unsigned int>(Index + 1), ParameterList[Index]);
-        if (StatementPtr->execute())
-        {
-            const std::unique_ptr<sql::ResultSet> ResultSet(StatementPtr->getResultSet());
-            sql::ResultSetMetaData* MetaData = ResultSet->getMetaData();
-            const int ColumnCount = MetaData->getColumnCount();
-            for (int Index = 1; Index <= ColumnCount; ++Index)
-                ResultData.ColumnNames.push_back(MetaData->getColumnName(Index));
-            while (ResultSet->next())
-            {
-                MySQLRow RowData;
-                for (int Index = 1; Index <= ColumnCount; ++Index)
-                {
-                    if (ResultSet->isNull(Index))
-                        RowData.Fields.push_back("NULL");
-                    else
-                        RowData.Fields.push_back(ResultSet->getString(Index));
-                }
-                ResultData.Rows.push_back(std::move(RowData));
-            }
-        }
-        else
-            ResultData.AffectedRows = StatementPtr->getUpdateCount();
-        ResultData.Success = true;
-        UpdateStatistics(true);
+        LastErrorMessage.clear();
+        LastErrorCode = 0;
     }
-    catch (const sql::SQLException& Exception)
+    else
     {
-        ResultData.ErrorMessage = std::format("执行预处理语句错误: {}", Exception.what());
-        UpdateStatistics(false);
-        LogError(ResultData.ErrorMessage);
+        LastErrorMessage = ResultData.ErrorMessage;
+        LastErrorCode = ResultData.ErrorCode;
     }
     return ResultData;
 }
 
-auto MySQLWrapper::GetDatabases() -> std::expected<std::vector<std::string>, std::string>
+auto MySQLWrapper::UpdateStatistics(std::string_view SqlQuery, const MySQLResult& ResultData, sql::Connection* ConnectionPtr, const SessionState* State) -> void
 {
-    const MySQLResult ResultData = Query("SHOW DATABASES");
-    if (!ResultData.Success) [[unlikely]]
-        return std::unexpected(ResultData.ErrorMessage);
-    std::vector<std::string> DatabaseList;
-    DatabaseList.reserve(ResultData.Rows.size());
-    for (const auto& RowData : ResultData.Rows)
-    {
-        if (!RowData.Fields.empty())
-            DatabaseList.push_back(RowData.Fields[0]);
-    }
-    return DatabaseList;
+    Statistics.TotalQueries.fetch_add(1, std::memory_order_relaxed);
+    if (ResultData.Success)
+        Statistics.SuccessfulQueries.fetch_add(1, std::memory_order_relaxed);
+    else
+        Statistics.FailedQueries.fetch_add(1, std::memory_order_relaxed);
+    Statistics.QueryLatency.Record(ResultData.ExecutionTime);
+    Statistics.LastQueryTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    if (SqlQuery.empty())
+        return;
+    const bool HasResultSet = !ResultData.ColumnNames.empty();
+    const uint64_t RowsSent = HasResultSet ? ResultData.Rows.size() : 0;
+    const uint64_t RowsAffected = HasResultSet ? 0 : ResultData.AffectedRows;
+    StatementDigest Digest = Digests.Record(SqlQuery, ResultData.ExecutionTime, RowsSent, RowsAffected, ResultData.Success);
+    const auto Threshold = SlowQueryThreshold.load(std::memory_order_relaxed);
+    if (Threshold > 0 && ResultData.Success && ResultData.ExecutionTime.count() >= Threshold) [[unlikely]]
+        RecordSlowQuery(SqlQuery, std::move(Digest), ResultData, ConnectionPtr, State);
 }
 
-auto MySQLWrapper::GetTables(std::string_view DatabaseName) -> std::expected<std::vector<std::string>, std::string>
+auto MySQLWrapper::RecordSlowQuery(std::string_view SqlQuery, StatementDigest Digest, const MySQLResult& ResultData, sql::Connection* ConnectionPtr, const SessionState* State) -> void
 {
-    std::string SqlQuery = "SHOW TABLES";
-    if (!DatabaseName.empty())
-        SqlQuery += std::format(" FROM `{}`", DatabaseName);
-    const MySQLResult ResultData = Query(SqlQuery);
-    if (!ResultData.Success) [[unlikely]]
-        return std::unexpected(ResultData.ErrorMessage);
-    std::vector<std::string> TableList;
-    TableList.reserve(ResultData.Rows.size());
-    for (const auto& RowData : ResultData.Rows)
+    SlowQueryRecord Record;
+    Record.Timestamp = std::chrono::system_clock::now();
+    Record.SqlText = SqlQuery;
+    Record.Digest = std::move(Digest);
+    Record.Latency = ResultData.ExecutionTime;
+    Record.RowsSent = ResultData.ColumnNames.empty() ? 0 : ResultData.Rows.size();
+    Record.RowsAffected = ResultData.ColumnNames.empty() ? ResultData.AffectedRows : 0;
+    PendingExplain Pending;
+    Record.IsExplainPending = StatementNormalizer::IsExplainable(SqlQuery);
+    if (Record.IsExplainPending)
     {
-        if (!RowData.Fields.empty())
-            TableList.push_back(RowData.Fields[0]);
+        // 执行计划要在语句所在的库中获取；会话状态不明时才向连接查询当前库
+        try
+        {
+            if (State && State->Schema)
+                Pending.SchemaName = *State->Schema;
+            else if (ConnectionPtr)
+                Pending.SchemaName = ConnectionPtr->getSchema();
+        }
+        catch (const sql::SQLException&) { }
+        Pending.SqlText = SqlQuery;
     }
-    return TableList;
-}
-
-auto MySQLWrapper::GetTableStructure(std::string_view TableName) -> std::expected<MySQLResult, std::string>
-{
-    if (!SQLSanitizer::IsValidIdentifier(TableName)) [[unlikely]]
-        return std::unexpected("无效的表名");
-    const MySQLResult ResultData = Query(std::format("DESCRIBE `{}`", TableName));
-    if (!ResultData.Success) [[unlikely]]
-        return std::unexpected(ResultData.ErrorMessage);
-    return ResultData;
-}
-
-auto MySQLWrapper::GetTableIndexes(std::string_view TableName) -> std::expected<MySQLResult, std::string>
-{
-    if (!SQLSanitizer::IsValidIdentifier(TableName)) [[unlikely]]
-        return std::unexpected("无效的表名");
-    const MySQLResult ResultData = Query(std::format("SHOW INDEX FROM `{}`", TableName));
-    if (!ResultData.Success) [[unlikely]]
-        return std::unexpected(ResultData.ErrorMessage);
-    return ResultData;
-}
-
-auto MySQLWrapper::GetServerVersion() -> std::expected<std::string, std::string>
-{
-    const MySQLResult ResultData = Query("SELECT VERSION()");
-    if (!ResultData.Success || ResultData.Rows.empty() || ResultData.Rows[0].Fields.empty()) [[unlikely]]
-        return std::unexpected("获取服务器版本失败");
-    return ResultData.Rows[0].Fields[0];
-}
-
-auto MySQLWrapper::GetCurrentDatabase() -> std::expected<std::string, std::string>
-{
-    const MySQLResult ResultData = Query("SELECT DATABASE()");
-    if (!ResultData.Success || ResultData.Rows.empty() || ResultData.Rows[0].Fields.empty()) [[unlikely]]
-        return std::unexpected("获取当前数据库失败");
-    return ResultData.Rows[0].Fields[0];
-}
-
-auto MySQLWrapper::EscapeString(const std::string& InputString) const -> std::string
-{
-    return SQLSanitizer::EscapeString(InputString);
-}
-
-auto MySQLWrapper::ValidateSQL(std::string_view SqlQuery) const -> bool
-{
-    return !SQLSanitizer::DetectSQLInjection(SqlQuery);
+    else
+        EmitSlowQuery(Record);
+    {
+        std::lock_guard<std::mutex> Lock(SlowQueryMutex);
+        Record.Id = ++NextSlowQueryId;
+        Pending.RecordId = Record.Id;
+        SlowQueries.push_back(std::move(Record));
+        while (SlowQueries.size() > MaxSlowQueryRecords)
+            SlowQueries.pop_front();
+    }
+    if (Pending.SqlText.empty())
+        return;
+    std::optional<PendingExplain> Dropped;
+    {
+        std::lock_guard<std::mutex> Lock(PendingExplainMutex);
+        if (!ExplainThread.joinable())
+            ExplainThread = std::jthread([this](std::stop_token StopToken) { ExplainLoop(StopToken); });
+        // 积压超过记录上限时最早的记录已被淘汰，放弃其执行计划
+        if (PendingExplains.size() >= MaxSlowQueryRecords)
+        {
+            Dropped = std::move(PendingExplains.front());
+            PendingExplains.pop_front();
+        }
+        PendingExplains.push_back(std::move(Pending));
+    }
+    ExplainWake.notify_one();
+    if (Dropped)
+        CompleteSlowQuery(Dropped->RecordId, std::unexpected("执行计划队列已满"));
 }
 
-auto MySQLWrapper::SetQueryTimeout(unsigned int TimeoutSeconds) -> void
+auto MySQLWrapper::ExplainLoop(std::stop_token StopToken) -> void
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    if (ActiveConnection)
+    std::unique_lock<std::mutex> Lock(PendingExplainMutex);
+    while (!StopToken.stop_requested())
     {
-        try
+        if (PendingExplains.empty())
         {
-            ActiveConnection->setClientOption("OPT_READ_TIMEOUT", &TimeoutSeconds);
+            ExplainWake.wait(Lock);
+            continue;
         }
-        catch (...) { }
+        PendingExplain Pending = std::move(PendingExplains.front());
+        PendingExplains.pop_front();
+        Lock.unlock();
+        // 先于 ExplainMutex 取得 ConnectionMutex，与 DisconnectInternal 的加锁顺序一致
+        MySQLConfig Config;
+        {
+            std::lock_guard<PrimaryConnectionMutex> ConfigLock(ConnectionMutex);
+            Config = CurrentConfig;
+        }
+        CompleteSlowQuery(Pending.RecordId, CaptureExplain(Pending.SqlText, Pending.SchemaName, Config));
+        Lock.lock();
     }
 }
 
-auto MySQLWrapper::SetResultLimit(std::size_t MaxRows) -> void
+auto MySQLWrapper::CompleteSlowQuery(uint64_t RecordId, std::expected<std::string, std::string> ExplainResult) -> void
 {
-    MaxResultRows = MaxRows;
+    std::optional<SlowQueryRecord> Completed;
+    {
+        std::lock_guard<std::mutex> Lock(SlowQueryMutex);
+        const auto Position = std::ranges::find(SlowQueries, RecordId, &SlowQueryRecord::Id);
+        // 记录已被淘汰或统计已重置
+        if (Position == SlowQueries.end())
+            return;
+        if (ExplainResult)
+            Position->ExplainJson = std::move(*ExplainResult);
+        else
+            Position->ExplainError = std::move(ExplainResult.error());
+        Position->IsExplainPending = false;
+        if constexpr (EventLevel::Warning >= CompiledMinEventLevel)
+            Completed = *Position;
+    }
+    if (Completed)
+        EmitSlowQuery(*Completed);
 }
 
-auto MySQLWrapper::GetLastError() const -> std::string
+auto MySQLWrapper::EmitSlowQuery(const SlowQueryRecord& Record) const -> void
 {
-    return LastErrorMessage;
+    if constexpr (EventLevel::Warning >= CompiledMinEventLevel)
+    {
+        if (EventLogger::Instance().IsEnabled(EventLevel::Warning))
+            EmitEvent<EventLevel::Warning>(EventCode::SlowQuery, EventSource(), std::format("慢查询 ({:.3f} ms, 摘要 {}): {}\r\n执行计划: {}", std::chrono::duration<double, std::milli>(Record.Latency).count(), Record.Digest.ToHex(), Record.SqlText, Record.ExplainJson.empty() ? Record.ExplainError : Record.ExplainJson));
+    }
 }
 
-auto MySQLWrapper::SetLogCallback(std::function<void(std::string_view)> CallbackFunc) -> void
+auto MySQLWrapper::CaptureExplain(std::string_view SqlQuery, const std::string& SchemaName, const MySQLConfig& Config) -> std::expected<std::string, std::string>
 {
-    LogCallback = std::move(CallbackFunc);
+    std::lock_guard<std::mutex> Lock(ExplainMutex);
+    try
+    {
+        if (!ExplainConnection || ExplainConnection->isClosed())
+        {
+            if (!DriverInstance) [[unlikely]]
+                return std::unexpected("驱动未初始化");
+            MySQLConfig ExplainConfig = Config;
+            if (!SchemaName.empty())
+                ExplainConfig.Database = SchemaName;
+            ExplainConnection = OpenConnection(*DriverInstance, ExplainConfig);
+            if (!ExplainConnection) [[unlikely]]
+                return std::unexpected("创建执行计划连接失败");
+            ExplainSchema = ExplainConfig.Database;
+        }
+        if (!SchemaName.empty() && SchemaName != ExplainSchema)
+        {
+            ExplainConnection->setSchema(SchemaName);
+            ExplainSchema = SchemaName;
+        }
+        const std::unique_ptr<sql::Statement> Statement(ExplainConnection->createStatement());
+        const std::unique_ptr<sql::ResultSet> ResultSet(Statement->executeQuery(std::format("EXPLAIN FORMAT=JSON {}", SqlQuery)));
+        std::string ExplainJson;
+        while (ResultSet->next())
+            ExplainJson += ResultSet->getString(1);
+        return ExplainJson;
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        return std::unexpected(std::format("获取执行计划失败: {}", Exception.what()));
+    }
 }
 
-auto MySQLWrapper::Log(std::string_view Message) const -> void
+auto MySQLWrapper::GetTopDigests(std::size_t Count, DigestSortKey SortKey) -> std::vector<DigestSummary>
 {
-    if (LogCallback)
-        LogCallback(Message);
+    return Digests.GetTop(Count, SortKey);
 }
 
-auto MySQLWrapper::LogError(std::string_view ErrorMessage) -> void
+auto MySQLWrapper::SetSlowQueryThreshold(std::chrono::milliseconds Threshold) noexcept -> void
 {
-    LastErrorMessage = ErrorMessage;
-    Log(std::format("错误: {}", ErrorMessage));
+    SlowQueryThreshold.store(std::chrono::duration_cast<std::chrono::nanoseconds>(Threshold).count(), std::memory_order_relaxed);
 }
 
-auto MySQLWrapper::ConnectExpected(const MySQLConfig& ConfigParam) -> std::expected<void, std::string>
+auto MySQLWrapper::GetSlowQueries() const -> std::vector<SlowQueryRecord>
 {
-    const bool IsSuccess = Connect(ConfigParam);
-    if (IsSuccess)
-        return {};
-    else
-        return std::unexpected(LastErrorMessage);
+    std::lock_guard<std::mutex> Lock(SlowQueryMutex);
+    return { SlowQueries.begin(), SlowQueries.end() };
 }
 
-auto MySQLWrapper::QueryExpected(const std::string& SqlQuery) -> std::expected<MySQLResult, std::string>
+// 重试期间一直持有 ConnectionMutex，同一逻辑会话上的其他语句不会插到重试之间
+auto MySQLWrapper::ExecuteInternal(const std::string& SqlQuery, bool IsQuery, std::chrono::milliseconds Timeout) -> MySQLResult
 {
-    MySQLResult ResultData = Query(SqlQuery);
+    std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+    MySQLResult ResultData;
+    std::chrono::steady_clock::time_point FirstFailure;
+    uint32_t RetryCount = 0;
+    for (;; ++RetryCount)
+    {
+        ResultData = {};
+        const auto StatementStart = std::chrono::steady_clock::now();
+        const bool IsConnectionValid = ValidateConnectionInternal();
+        ResultData.Timing.Validation = std::chrono::steady_clock::now() - StatementStart;
+        if (!IsConnectionValid) [[unlikely]]
+        {
+            ResultData.ErrorMessage = "连接验证失败";
+            ResultData.ExecutionTime = ResultData.Timing.Total();
+            UpdateStatistics(SqlQuery, ResultData, nullptr, nullptr);
+            break;
+        }
+        if (IsTransactionAborted) [[unlikely]]
+        {
+            // 只有 COMMIT / ROLLBACK 结束中止的事务：ROLLBACK 照常执行，其余语句（包括 COMMIT）都不执行并返回失败
+            const bool IsTransactionEnd = ClassifySessionEffect(SqlQuery).Kind == SessionEffect::TransactionEnd;
+            if (IsTransactionEnd)
+                IsTransactionAborted = false;
+            if (!IsTransactionEnd || !StartsWithKeyword(SkipSpaceAndComments(std::string_view{ SqlQuery }), "ROLLBACK"))
+            {
+                ResultData.ErrorMessage = AbortedTransactionMessage;
+                ResultData.ErrorCode = AbortedTransactionErrorCode;
+                ResultData.ExecutionTime = ResultData.Timing.Total();
+                UpdateStatistics(SqlQuery, ResultData, nullptr, nullptr);
+                break;
+            }
+        }
+        const ExecutionTarget Target{ ActiveConnection.get(), ServerConnectionId, SessionId, Recorder.get(), PrimaryTracker, &PrimaryState, Observer.get() };
+        ResultData = ExecuteOn(Target, SqlQuery, Timeout, std::move(ResultData), StatementStart);
+        if (ResultData.Success || !ShouldRetryStatement(ResultData, SqlQuery, PrimaryState, InitialSessionState(CurrentConfig)))
+            break;
+        if (RetryCount >= CurrentConfig.MaxRetries)
+        {
+            Statistics.ExhaustedRetries.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        if (RetryCount == 0)
+            FirstFailure = std::chrono::steady_clock::now();
+        const auto Delay = RetryDelay(RetryCount);
+        EmitEvent<EventLevel::Info>(EventCode::Retrying, EventSource(), SqlQuery, RetryCount + 1, std::chrono::duration_cast<std::chrono::milliseconds>(Delay).count());
+        std::this_thread::sleep_for(Delay);
+        Statistics.StatementRetries.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (RetryCount > 0)
+        Statistics.RetryNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - FirstFailure).count(), std::memory_order_relaxed);
+    ResultData.RetryCount = RetryCount;
     if (ResultData.Success)
-        return ResultData;
+    {
+        LastErrorMessage.clear();
+        LastErrorCode = 0;
+    }
     else
-        return std::unexpected(ResultData.ErrorMessage);
+    {
+        LastErrorMessage = ResultData.ErrorMessage;
+        LastErrorCode = ResultData.ErrorCode;
+    }
+    return ResultData;
 }
 
-auto MySQLWrapper::GetStatistics() const -> std::tuple<uint64_t, uint64_t, uint64_t>
+auto MySQLWrapper::RetryDelay(uint32_t Attempt) -> std::chrono::nanoseconds
 {
-    return 
-    {
-        Statistics.TotalQueries.load(),
-        Statistics.SuccessfulQueries.load(),
-        Statistics.FailedQueries.load()
-    };
+    thread_local std::mt19937_64 Generator{ std::random_device{}() };
+    const std::chrono::nanoseconds Ceiling = (std::min)(std::chrono::nanoseconds{ RetryBaseDelay } * (int64_t{ 1 } << (std::min)(Attempt, 16u)), std::chrono::nanoseconds{ RetryMaxDelay });
+    std::uniform_int_distribution<std::chrono::nanoseconds::rep> Distribution(0, Ceiling.count());
+    return std::chrono::nanoseconds{ Distribution(Generator) };
 }
 
-auto MySQLWrapper::ResetStatistics() -> void
+// 只在自动提交模式下重放单条语句：显式事务中的失败由 ExecuteTransaction 整体重放
+auto MySQLWrapper::ShouldRetryStatement(const MySQLResult& ResultData, std::string_view SqlQuery, const SessionState& State, const SessionState& InitialState) const -> bool
 {
-    Statistics.TotalQueries = 0;
-    Statistics.SuccessfulQueries = 0;
-    Statistics.FailedQueries = 0;
+    if (ResultData.Success || ResultData.Status != QueryStatus::Failed || State.HasTransaction || State.IsDirty)
+        return false;
+    switch (ClassifyError(ResultData.ErrorCode))
+    {
+    case ErrorCategory::Deadlock:
+        // 服务端已经回滚了这条语句，原样重放即可
+        return true;
+    case ErrorCategory::ConnectionLost:
+        // 新连接处于初始状态，库和字符集与之不同时重放会落在错误的上下文中
+        return State.Schema == InitialState.Schema && State.Charset == InitialState.Charset && IsIdempotentStatement(SqlQuery);
+    default:
+        return false;
+    }
 }
 
-auto MySQLWrapper::GetConnectionInfo() const -> std::string
+auto MySQLWrapper::PrepareTransactionReplay(uint32_t Attempt) -> bool
 {
-    if (!IsConnected)
-        return "未连接";
-    return std::format("{}@{}:{}/{}", CurrentConfig.User, CurrentConfig.Host, CurrentConfig.Port, CurrentConfig.Database);
+    ErrorCategory Category = ErrorCategory::None;
+    unsigned int MaxRetries = 0;
+    {
+        std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+        if (IsCommitOutcomeUnknown) [[unlikely]]
+        {
+            LastErrorMessage = "提交时连接中断，事务结果未知，不再重放";
+            LogError(LastErrorMessage);
+            return false;
+        }
+        Category = ClassifyError(LastErrorCode);
+        MaxRetries = CurrentConfig.MaxRetries;
+    }
+    if (Category != ErrorCategory::Deadlock && Category != ErrorCategory::ConnectionLost)
+        return false;
+    if (Attempt >= MaxRetries)
+    {
+        Statistics.ExhaustedRetries.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const auto ReplayStart = std::chrono::steady_clock::now();
+    const auto Delay = RetryDelay(Attempt);
+    EmitEvent<EventLevel::Info>(EventCode::Retrying, EventSource(), "事务", Attempt + 1, std::chrono::duration_cast<std::chrono::milliseconds>(Delay).count());
+    std::this_thread::sleep_for(Delay);
+    if (Category == ErrorCategory::ConnectionLost)
+    {
+        // BeginTransaction 不做连接检查，重放前先确保连接可用
+        std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+        if (!ValidateConnectionInternal())
+            return false;
+    }
+    Statistics.TransactionReplays.fetch_add(1, std::memory_order_relaxed);
+    Statistics.RetryNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ReplayStart).count(), std::memory_order_relaxed);
+    return true;
 }
 
-auto MySQLWrapper::UpdateStatistics(bool IsSuccess) noexcept -> void
+auto MySQLWrapper::CaptureDeadlock(sql::Connection& ConnectionRef, std::string_view SqlQuery) -> void
 {
-    Statistics.TotalQueries++;
-    if (IsSuccess)
-        Statistics.SuccessfulQueries++;
-    else
-        Statistics.FailedQueries++;
-    Statistics.LastQueryTime = std::chrono::steady_clock::now();
+    DeadlockRecord Record{ std::chrono::system_clock::now(), std::string{ SqlQuery }, {} };
+    try
+    {
+        const std::unique_ptr<sql::Statement> Statement(ConnectionRef.createStatement());
+        const std::unique_ptr<sql::ResultSet> ResultSet(Statement->executeQuery("SHOW ENGINE INNODB STATUS"));
+        if (ResultSet->next())
+        {
+            const std::string StatusText = ResultSet->getString(3);
+            Record.Diagnostics = ExtractDeadlockSection(StatusText);
+        }
+        if (Record.Diagnostics.empty())
+            Record.Diagnostics = "InnoDB 状态中没有死锁记录";
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        Record.Diagnostics = std::format("读取 InnoDB 状态失败（需要 PROCESS 权限）: {}", Exception.what());
+    }
+    EmitEvent<EventLevel::Warning>(EventCode::Deadlock, EventSource(), Record.SqlText);
+    std::lock_guard<std::mutex> Lock(DeadlockMutex);
+    if (Deadlocks.size() >= MaxDeadlockRecords)
+        Deadlocks.pop_front();
+    Deadlocks.push_back(std::move(Record));
 }
 
-auto MySQLWrapper::ExecuteInternal(const std::string& SqlQuery, bool IsQuery) -> MySQLResult
+auto MySQLWrapper::ExecuteOn(const ExecutionTarget& Target, const std::string& SqlQuery, std::chrono::milliseconds Timeout, MySQLResult ResultData, std::chrono::steady_clock::time_point StatementStart) -> MySQLResult
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    MySQLResult ResultData;
-    const auto StartTime = std::chrono::steady_clock::now();
-    if (!ValidateConnectionInternal()) [[unlikely]]
+    sql::Connection& ConnectionRef = *Target.Connection;
+    StatementTracker& Tracker = *Target.Tracker;
+    const bool HasDeadline = Timeout.count() > 0;
+    const std::size_t RowLimit = MaxResultRows.load(std::memory_order_relaxed);
+    const bool IsServerSideLimit = RowLimit > 0 && LimitMode.load(std::memory_order_relaxed) == ResultLimitMode::ServerSide;
+    const std::size_t MemoryBudget = ResultMemoryBudget.load(std::memory_order_relaxed);
+    ResultData.Rows.SetBudget(MemoryBudget);
+    const FetchObserver* Observer = Target.Observer && Target.Observer->Callback ? Target.Observer : nullptr;
+    const std::size_t ObserverInterval = Observer ? (std::max)(Observer->RowInterval, std::size_t{ 1 }) : 0;
+    const StatementEffect Effect = Target.State ? ClassifySessionEffect(SqlQuery) : StatementEffect{};
+    if (Target.State && Effect.Value && ((Effect.Kind == SessionEffect::Schema && Target.State->Schema == Effect.Value) || (Effect.Kind == SessionEffect::Charset && Target.State->Charset == Effect.Value)))
     {
-        ResultData.ErrorMessage = "连接验证失败";
-        UpdateStatistics(false);
+        // 会话已经处于目标库或字符集，不再发送
+        ResultData.Success = true;
+        ResultData.Status = QueryStatus::Succeeded;
+        ResultData.ExecutionTime = ResultData.Timing.Total();
+        UpdateStatistics(SqlQuery, ResultData, &ConnectionRef, Target.State);
+        if (Target.Recorder && Target.Recorder->IsActive())
+            Target.Recorder->Record(Target.SessionId, StatementStart, ResultData.ExecutionTime, ResultData.Success, ResultData.AffectedRows, SqlQuery);
         return ResultData;
     }
+    // 多取一行用于判断结果是否被截断
+    std::string RewrittenQuery = IsServerSideLimit ? ApplyRowLimit(SqlQuery, RowLimit + 1) : std::string{};
+    const bool IsLimitRewritten = !RewrittenQuery.empty();
+    bool IsHinted = false;
+    if (HasDeadline)
+    {
+        if (std::string HintedQuery = ApplyExecutionTimeHint(IsLimitRewritten ? RewrittenQuery : SqlQuery, Timeout); !HintedQuery.empty())
+        {
+            RewrittenQuery = std::move(HintedQuery);
+            IsHinted = true;
+        }
+    }
+    uint64_t Generation = 0;
+    {
+        std::lock_guard<std::mutex> Lock(Tracker.Mutex);
+        Generation = ++Tracker.Generation;
+        Tracker.ServerConnectionId = Target.ServerConnectionId;
+        Tracker.IsRunning = true;
+        Tracker.InterruptedAs.reset();
+    }
+    // SELECT 由服务端提示负责超时，客户端只在提示失效时兜底；其他语句完全依赖客户端截止时间
+    if (HasDeadline && Target.ServerConnectionId != 0)
+        Watchdog->Arm(Target.Tracker, Generation, StatementStart + Timeout + (IsHinted ? HintGracePeriod : std::chrono::milliseconds::zero()));
+    auto PhaseStart = std::chrono::steady_clock::now();
+    auto PhaseEnd = PhaseStart;
+    int ErrorCode = 0;
     try
     {
-        const std::unique_ptr<sql::Statement> Statement(ActiveConnection->createStatement());
-        const bool HasResultSet = Statement->execute(SqlQuery);
-        
+        const std::unique_ptr<sql::Statement> Statement(ConnectionRef.createStatement());
+        // 流式读取时驱动不再缓存完整结果：无法改写的限行语句读出超出上限的行后直接丢弃，
+        // 有内存预算时超出预算的行由 RowStore 写入临时文件
+        if ((IsServerSideLimit && !IsLimitRewritten) || MemoryBudget != 0 || Observer)
+            Statement->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+        const bool HasResultSet = Statement->execute(RewrittenQuery.empty() ? SqlQuery : RewrittenQuery);
+        PhaseEnd = std::chrono::steady_clock::now();
+        ResultData.Timing.Execute = PhaseEnd - PhaseStart;
+        PhaseStart = PhaseEnd;
         if (HasResultSet)
         {
             const std::unique_ptr<sql::ResultSet> ResultSet(Statement->getResultSet());
@@ -631,39 +2447,85 @@ auto MySQLWrapper::ExecuteInternal(const std::string& SqlQuery, bool IsQuery) ->
             for (int Index = 1; Index <= ColumnCount; ++Index)
                 ResultData.ColumnNames.push_back(MetaData->getColumnName(Index));
             std::size_t RowCount = 0;
-            while (ResultSet->next())
+            const bool IsFetching = !Observer || Observer->Callback(ResultData.ColumnNames, ResultData.Rows);
+            if (!IsFetching)
+                ResultData.IsTruncated = true;
+            while (IsFetching && ResultSet->next())
             {
-                if (MaxResultRows > 0 && RowCount >= MaxResultRows)
-                    break;
-                MySQLRow RowData;
-                for (int Index = 1; Index <= ColumnCount; ++Index)
+                PhaseEnd = std::chrono::steady_clock::now();
+                ResultData.Timing.Fetch += PhaseEnd - PhaseStart;
+                PhaseStart = PhaseEnd;
+                if (RowLimit > 0 && RowCount >= RowLimit)
                 {
-                    if (ResultSet->isNull(Index))
-                        RowData.Fields.push_back("NULL");
-                    else
-                        RowData.Fields.push_back(ResultSet->getString(Index));
+                    ResultData.IsTruncated = true;
+                    break;
                 }
-                ResultData.Rows.push_back(std::move(RowData));
+                ResultData.Rows.push_back(MaterializeRow(*ResultSet, ColumnCount));
                 ++RowCount;
+                PhaseEnd = std::chrono::steady_clock::now();
+                ResultData.Timing.Materialize += PhaseEnd - PhaseStart;
+                PhaseStart = PhaseEnd;
+                if (Observer && RowCount % ObserverInterval == 0 && !Observer->Callback(ResultData.ColumnNames, ResultData.Rows))
+                {
+                    ResultData.IsTruncated = true;
+                    break;
+                }
             }
+            ResultData.Timing.Fetch += std::chrono::steady_clock::now() - PhaseStart;
             ResultData.AffectedRows = ResultData.Rows.size();
         }
         else
             ResultData.AffectedRows = Statement->getUpdateCount();
         ResultData.Success = true;
-        UpdateStatistics(true);
-        LastErrorMessage.clear();
+        ResultData.Status = QueryStatus::Succeeded;
     }
     catch (const sql::SQLException& Exception)
     {
+        auto& PendingPhase = ResultData.Timing.Execute.count() == 0 ? ResultData.Timing.Execute : ResultData.Timing.Fetch;
+        PendingPhase += std::chrono::steady_clock::now() - PhaseStart;
+        ErrorCode = Exception.getErrorCode();
+        ResultData.ErrorCode = ErrorCode;
         ResultData.ErrorMessage = std::format("执行错误: {} (代码: {}, 状态: {})", 
-            Exception.what(), Exception.getErrorCode(), Exception.getSQLState());
-        UpdateStatistics(false);
-        LogError(ResultData.ErrorMessage);
+            Exception.what(), ErrorCode, Exception.getSQLState());
+    }
+    if (HasDeadline)
+        Watchdog->Disarm(&Tracker, Generation);
+    std::optional<QueryStatus> InterruptedAs;
+    {
+        std::lock_guard<std::mutex> Lock(Tracker.Mutex);
+        Tracker.IsRunning = false;
+        InterruptedAs = std::exchange(Tracker.InterruptedAs, std::nullopt);
+    }
+    // KILL QUERY 只终止语句，连接本身仍然可用，不触发重连
+    if (!ResultData.Success)
+    {
+        if (InterruptedAs)
+            ResultData.Status = *InterruptedAs;
+        else if (ErrorCode == ExecutionTimeExceededCode)
+            ResultData.Status = QueryStatus::TimedOut;
+        else if (ErrorCode == QueryInterruptedCode)
+            ResultData.Status = QueryStatus::Cancelled;
+        if (ResultData.Status == QueryStatus::Cancelled)
+            ResultData.ErrorMessage = "语句已被取消";
+        else if (ResultData.Status == QueryStatus::TimedOut)
+            ResultData.ErrorMessage = HasDeadline ? std::format("语句超过截止时间 {} ms，已中止", Timeout.count()) : std::string{ "语句超过服务端执行时间上限，已中止" };
+        else
+            EmitError(ResultData.ErrorMessage);
+        if (const ErrorCategory Category = ClassifyError(ErrorCode); Category == ErrorCategory::Deadlock)
+        {
+            Statistics.Deadlocks.fetch_add(1, std::memory_order_relaxed);
+            if (ErrorCode == DeadlockCode)
+                CaptureDeadlock(ConnectionRef, SqlQuery);
+        }
+        else if (Category == ErrorCategory::ConnectionLost)
+            Statistics.ConnectionLosses.fetch_add(1, std::memory_order_relaxed);
     }
-    
-    const auto EndTime = std::chrono::steady_clock::now();
-    ResultData.ExecutionTime = std::chrono::duration_cast<std::chrono::milliseconds>(EndTime - StartTime);
+    ResultData.ExecutionTime = ResultData.Timing.Total();
+    if (ResultData.Success && Target.State)
+        ApplySessionEffect(*Target.State, Effect);
+    UpdateStatistics(SqlQuery, ResultData, &ConnectionRef, Target.State);
+    if (Target.Recorder && Target.Recorder->IsActive())
+        Target.Recorder->Record(Target.SessionId, StatementStart, ResultData.ExecutionTime, ResultData.Success, ResultData.AffectedRows, SqlQuery);
     return ResultData;
 }
 
@@ -672,33 +2534,46 @@ auto MySQLWrapper::ValidateConnectionInternal() -> bool
     if (!ActiveConnection || ActiveConnection->isClosed()) [[unlikely]]
     {
         LogError("连接丢失，尝试重新连接...");
+        if (Failover && ActiveEndpoint)
+            Failover->RecordFailure(*ActiveEndpoint, "连接丢失");
+        return ReconnectInternal();
+    }
+    // 后台探测已判定当前端点不健康时不再用一次探测确认，直接切换到评分最好的端点。
+    // 只在熔断退避期间切换，半开的端点留给探测确认；事务中或会话状态无法重建时连接仍可用就不切换
+    if (Failover && ActiveEndpoint && !PrimaryState.HasTransaction && !PrimaryState.IsDirty && Failover->GetCircuit(*ActiveEndpoint) == CircuitState::Open) [[unlikely]]
+    {
+        LogError("当前端点已熔断，切换端点...");
         return ReconnectInternal();
     }
     try
     {
-        std::unique_ptr<sql::Statement> Statement(ActiveConnection->createStatement());
-        if (Statement->execute("SELECT 1"))
+        // 顺带核对服务端连接号：驱动自动重连后会话回到握手时的状态，已记录的库和字符集不再可信
+        if (const uint64_t CurrentConnectionId = QueryServerConnectionId(*ActiveConnection); CurrentConnectionId != ServerConnectionId)
         {
-            std::unique_ptr<sql::ResultSet> ResultSet(Statement->getResultSet());
-            while (ResultSet && ResultSet->next()) { /* 消费结果集 */ }
+            if (PrimaryState.HasTransaction)
+                IsTransactionAborted = true;
+            ServerConnectionId = CurrentConnectionId;
+            PrimaryState = {};
         }
         return true;
     }
-    catch (const sql::SQLException&)
+    catch (const sql::SQLException& Exception)
     {
+        if (Failover && ActiveEndpoint)
+            Failover->RecordFailure(*ActiveEndpoint, Exception.what());
         return ReconnectInternal();
     }
 }
 
-ConnectionPool::ConnectionPool(const MySQLConfig& ConfigParam, std::size_t MaxSize) : Configuration(ConfigParam), MaxPoolSize(MaxSize)
+ConnectionPool::ConnectionPool(const MySQLConfig& ConfigParam, std::size_t MaxSize) : Configuration(ConfigParam), MaxPoolSize((std::max)(MaxSize, std::size_t{ 1 }))
 {
-    Pool.reserve(MaxPoolSize);
+    IdleConnections.reserve(MaxPoolSize);
 }
 
 ConnectionPool::~ConnectionPool()
 {
     std::lock_guard<std::mutex> Lock(PoolMutex);
-    for (auto& PooledConn : Pool)
+    for (auto& PooledConn : IdleConnections)
     {
         try
         {
@@ -707,150 +2582,497 @@ ConnectionPool::~ConnectionPool()
         }
         catch (...) { }
     }
-    Pool.clear();
+    IdleConnections.clear();
+}
+
+auto ConnectionPool::CreateConnection() -> PooledConnection
+{
+    try
+    {
+        std::unique_ptr<sql::Connection> NewConnection = OpenConnection(*sql::mysql::get_driver_instance(), Configuration);
+        if (!NewConnection)
+            return {};
+        const uint64_t NewConnectionId = QueryServerConnectionId(*NewConnection);
+        return { std::move(NewConnection), std::chrono::steady_clock::now(), NewConnectionId };
+    }
+    catch (const sql::SQLException&)
+    {
+        return {};
+    }
 }
 
 auto ConnectionPool::AcquireConnection() -> std::unique_ptr<sql::Connection>
 {
-    std::lock_guard<std::mutex> Lock(PoolMutex);
-    for (auto& PooledConn : Pool)
+    const auto AcquireStart = std::chrono::steady_clock::now();
+    const auto Deadline = AcquireStart + std::chrono::seconds(Configuration.ConnectTimeout);
+    for (;;)
     {
-        if (!PooledConn.IsInUse && PooledConn.Connection)
+        PooledConnection Candidate;
         {
-            try
-            {
-                if (!PooledConn.Connection->isClosed())
+            std::unique_lock<std::mutex> Lock(PoolMutex);
+            const bool HasSlot = SlotAvailable.wait_until(Lock, Deadline, [this]
                 {
-                    std::unique_ptr<sql::Statement> TestStmt(PooledConn.Connection->createStatement());
-                    TestStmt->execute("SELECT 1");
-                    PooledConn.IsInUse = true;
-                    PooledConn.LastUsedTime = std::chrono::steady_clock::now();
-                    return std::move(PooledConn.Connection);
-                }
+                    return !IdleConnections.empty() || CheckedOutCount < MaxPoolSize;
+                });
+            if (!HasSlot)
+                return nullptr;
+            if (!IdleConnections.empty())
+            {
+                // 优先复用最近归还的连接，它最可能仍然有效
+                Candidate = std::move(IdleConnections.back());
+                IdleConnections.pop_back();
             }
-            catch (...)
+            ++CheckedOutCount;
+        }
+        // 校验和建连都在锁外进行，不阻塞其他线程检出或归还
+        if (Candidate.Connection && AcquireStart - Candidate.LastUsedTime >= ValidationInterval)
+        {
+            bool IsUsable = false;
+            try
             {
-                PooledConn.Connection.reset();
+                IsUsable = Candidate.Connection->isValid();
             }
+            catch (...) { }
+            if (!IsUsable)
+                Candidate.Connection.reset();
+        }
+        if (!Candidate.Connection)
+            Candidate = CreateConnection();
+        std::lock_guard<std::mutex> Lock(PoolMutex);
+        if (!Candidate.Connection)
+        {
+            --CheckedOutCount;
+            SlotAvailable.notify_one();
+            if (std::chrono::steady_clock::now() >= Deadline)
+                return nullptr;
+            continue;
         }
+        const auto CheckoutTime = std::chrono::steady_clock::now();
+        AcquireLatency.Record(CheckoutTime - AcquireStart);
+        CheckedOutConnections[Candidate.Connection.get()] = { CheckoutTime, Candidate.ServerConnectionId };
+        return std::move(Candidate.Connection);
     }
-    if (Pool.size() < MaxPoolSize)
+}
+
+auto ConnectionPool::GetInitialState() const -> SessionState
+{
+    return InitialSessionState(Configuration);
+}
+
+// Connector/C++ 的 JDBC 接口没有暴露 COM_RESET_CONNECTION，这里只撤销能用普通语句恢复的状态
+auto ConnectionPool::ResetSession(sql::Connection& ConnectionRef, const SessionState& State) -> bool
+{
+    if (State.IsDirty)
+        return false;
+    const SessionState Initial = InitialSessionState(Configuration);
+    try
     {
-        try
+        if (State.HasTransaction || State.Charset != Initial.Charset)
         {
-            sql::Driver* Driver = sql::mysql::get_driver_instance();
-            const std::string ConnectionUrl = std::format("tcp://{}:{}", Configuration.Host, Configuration.Port);
-            std::unique_ptr<sql::Connection> NewConnection(Driver->connect(ConnectionUrl, Configuration.User, Configuration.Password));
-            if (NewConnection)
-            {
-                NewConnection->setClientOption("OPT_CONNECT_TIMEOUT", &Configuration.ConnectTimeout);
-                NewConnection->setClientOption("OPT_READ_TIMEOUT", &Configuration.ReadTimeout);
-                NewConnection->setClientOption("OPT_WRITE_TIMEOUT", &Configuration.WriteTimeout);
-                if (Configuration.EnableAutoReconnect)
-                {
-                    bool AutoReconnect = true;
-                    NewConnection->setClientOption("OPT_RECONNECT", &AutoReconnect);
-                }
-                if (!Configuration.Database.empty())
-                {
-                    NewConnection->setSchema(Configuration.Database);
-                }
-                std::unique_ptr<sql::Statement> Statement(NewConnection->createStatement());
+            const std::unique_ptr<sql::Statement> Statement(ConnectionRef.createStatement());
+            if (State.HasTransaction)
+                Statement->execute("ROLLBACK");
+            if (State.Charset != Initial.Charset)
                 Statement->execute(std::format("SET NAMES {}", Configuration.Charset));
-                PooledConnection NewPooledConn;
-                NewPooledConn.Connection = nullptr;
-                NewPooledConn.IsInUse = true;
-                NewPooledConn.LastUsedTime = std::chrono::steady_clock::now();
-                Pool.push_back(std::move(NewPooledConn));
-                return NewConnection;
-            }
         }
-        catch (const sql::SQLException&)
+        if (State.Schema != Initial.Schema)
         {
-            return nullptr;
+            // 无法回到未选择数据库的状态
+            if (Configuration.Database.empty())
+                return false;
+            ConnectionRef.setSchema(Configuration.Database);
         }
+        return true;
+    }
+    catch (const sql::SQLException&)
+    {
+        return false;
     }
-    return nullptr;
 }
 
-auto ConnectionPool::ReleaseConnection(std::unique_ptr<sql::Connection> ConnectionPtr) -> void
+auto ConnectionPool::ReleaseConnection(std::unique_ptr<sql::Connection> ConnectionPtr, const SessionState& State) -> void
 {
     if (!ConnectionPtr)
         return;
-    std::lock_guard<std::mutex> Lock(PoolMutex);
-    bool isValid = false;
+    const sql::Connection* CheckoutKey = ConnectionPtr.get();
+    bool IsUsable = false;
     try
     {
-        isValid = !ConnectionPtr->isClosed();
-        if (isValid)
+        IsUsable = !ConnectionPtr->isClosed() && ResetSession(*ConnectionPtr, State);
+    }
+    catch (...) { }
+    if (!IsUsable)
+    {
+        // 关闭后空出的名额由下一次检出重新建立连接
+        try
         {
-            std::unique_ptr<sql::Statement> TestStmt(ConnectionPtr->createStatement());
-            TestStmt->execute("SELECT 1");
+            ConnectionPtr->close();
         }
+        catch (...) { }
+        ConnectionPtr.reset();
     }
-    catch (...)
     {
-        isValid = false;
+        std::lock_guard<std::mutex> Lock(PoolMutex);
+        uint64_t ReleasedConnectionId = 0;
+        if (const auto CheckoutEntry = CheckedOutConnections.find(CheckoutKey); CheckoutEntry != CheckedOutConnections.end())
+        {
+            HoldLatency.Record(std::chrono::steady_clock::now() - CheckoutEntry->second.CheckoutTime);
+            ReleasedConnectionId = CheckoutEntry->second.ServerConnectionId;
+            CheckedOutConnections.erase(CheckoutEntry);
+        }
+        if (CheckedOutCount > 0)
+            --CheckedOutCount;
+        if (ConnectionPtr)
+            IdleConnections.push_back({ std::move(ConnectionPtr), std::chrono::steady_clock::now(), ReleasedConnectionId });
+    }
+    SlotAvailable.notify_one();
+}
+
+auto ConnectionPool::CleanIdleConnections() -> void
+{
+    std::vector<std::unique_ptr<sql::Connection>> ExpiredConnections;
+    {
+        std::lock_guard<std::mutex> Lock(PoolMutex);
+        const auto CurrentTime = std::chrono::steady_clock::now();
+        const auto FirstActive = std::partition(IdleConnections.begin(), IdleConnections.end(), [&](const PooledConnection& PooledConn)
+            {
+                return CurrentTime - PooledConn.LastUsedTime >= IdleTimeout;
+            });
+        for (auto Position = IdleConnections.begin(); Position != FirstActive; ++Position)
+            ExpiredConnections.push_back(std::move(Position->Connection));
+        IdleConnections.erase(IdleConnections.begin(), FirstActive);
     }
-    if (!isValid)
+    for (auto& ConnectionPtr : ExpiredConnections)
     {
         try
         {
-            if (ConnectionPtr && !ConnectionPtr->isClosed())
+            if (!ConnectionPtr->isClosed())
                 ConnectionPtr->close();
         }
         catch (...) { }
-        return;
     }
-    for (auto& PooledConn : Pool)
+}
+
+auto ConnectionPool::GetServerConnectionId(const sql::Connection* ConnectionPtr) -> uint64_t
+{
+    std::lock_guard<std::mutex> Lock(PoolMutex);
+    const auto CheckoutEntry = CheckedOutConnections.find(ConnectionPtr);
+    return CheckoutEntry != CheckedOutConnections.end() ? CheckoutEntry->second.ServerConnectionId : 0;
+}
+
+auto ConnectionPool::GetAcquireLatency() const -> LatencySnapshot
+{
+    return AcquireLatency.Snapshot();
+}
+
+auto ConnectionPool::GetHoldLatency() const -> LatencySnapshot
+{
+    return HoldLatency.Snapshot();
+}
+
+namespace
+{
+    // 退避期已过的熔断端点视为半开
+    [[nodiscard]] auto EffectiveCircuit(const EndpointStatus& Status, std::chrono::steady_clock::time_point Now) noexcept -> CircuitState
+    {
+        if (Status.Circuit == CircuitState::Open && Now >= Status.RetryAt)
+            return CircuitState::HalfOpen;
+        return Status.Circuit;
+    }
+}
+
+EndpointHealthMonitor::EndpointHealthMonitor(std::vector<MySQLConfig> Candidates, FailoverOptions OptionsParam) : Options(OptionsParam)
+{
+    Endpoints.reserve(Candidates.size());
+    for (auto& Candidate : Candidates)
+    {
+        EndpointEntry& Entry = Endpoints.emplace_back();
+        Entry.Status.Name = std::format("{}:{}", Candidate.Host, Candidate.Port);
+        Entry.Config = std::move(Candidate);
+    }
+}
+
+EndpointHealthMonitor::~EndpointHealthMonitor()
+{
+    {
+        std::lock_guard<std::mutex> Lock(ProbeMutex);
+        ProbeThread.request_stop();
+    }
+    WakeCondition.notify_all();
+    if (ProbeThread.joinable())
+        ProbeThread.join();
+    for (auto& Entry : Endpoints)
     {
-        if (!PooledConn.Connection)
+        try
         {
-            PooledConn.Connection = std::move(ConnectionPtr);
-            PooledConn.IsInUse = false;
-            PooledConn.LastUsedTime = std::chrono::steady_clock::now();
-            return;
+            if (Entry.ProbeConnection)
+                Entry.ProbeConnection->close();
+        }
+        catch (...) { }
+    }
+}
+
+auto EndpointHealthMonitor::Start() -> void
+{
+    std::call_once(StartOnce, [this]
+        {
+            {
+                std::vector<std::jthread> InitialProbes;
+                InitialProbes.reserve(Endpoints.size());
+                for (std::size_t Index = 0; Index < Endpoints.size(); ++Index)
+                    InitialProbes.emplace_back([this, Index] { ProbeEndpoint(Index); });
+            }
+            ProbeThread = std::jthread([this](std::stop_token StopToken) { ProbeLoop(StopToken); });
+        });
+}
+
+auto EndpointHealthMonitor::RankEndpoints() const -> std::vector<std::size_t>
+{
+    const auto Now = std::chrono::steady_clock::now();
+    std::vector<std::pair<double, std::size_t>> Candidates;
+    {
+        std::lock_guard<std::mutex> Lock(StatusMutex);
+        for (std::size_t Index = 0; Index < Endpoints.size(); ++Index)
+        {
+            const EndpointStatus& Status = Endpoints[Index].Status;
+            if (EffectiveCircuit(Status, Now) == CircuitState::Open || (Options.RequireWritable && !Status.IsWritable))
+                continue;
+            EndpointStatus Effective = Status;
+            Effective.Circuit = EffectiveCircuit(Status, Now);
+            Candidates.emplace_back(Effective.Score(), Index);
         }
     }
-    if (Pool.size() < MaxPoolSize)
+    std::ranges::stable_sort(Candidates, {}, &std::pair<double, std::size_t>::first);
+    std::vector<std::size_t> Ranked;
+    Ranked.reserve(Candidates.size());
+    for (const auto& Candidate : Candidates)
+        Ranked.push_back(Candidate.second);
+    return Ranked;
+}
+
+auto EndpointHealthMonitor::GetAttemptConfig(std::size_t Index) const -> MySQLConfig
+{
+    MySQLConfig AttemptConfig = Endpoints[Index].Config;
+    AttemptConfig.ConnectTimeout = (std::min)(AttemptConfig.ConnectTimeout, Options.AttemptTimeout);
+    return AttemptConfig;
+}
+
+auto EndpointHealthMonitor::RecordSuccess(std::size_t Index, std::optional<std::chrono::nanoseconds> Latency) -> void
+{
+    std::lock_guard<std::mutex> Lock(StatusMutex);
+    EndpointStatus& Status = Endpoints[Index].Status;
+    if (Latency)
+    {
+        const double Sample = std::chrono::duration<double, std::milli>(*Latency).count();
+        Status.LatencyMilliseconds = Status.HasProbed ? Status.LatencyMilliseconds * 0.7 + Sample * 0.3 : Sample;
+        Status.HasProbed = true;
+    }
+    UpdateCircuit(Status, true, std::chrono::steady_clock::now());
+}
+
+auto EndpointHealthMonitor::RecordFailure(std::size_t Index, std::string_view Reason) -> void
+{
+    std::lock_guard<std::mutex> Lock(StatusMutex);
+    EndpointStatus& Status = Endpoints[Index].Status;
+    Status.LastError = Reason;
+    UpdateCircuit(Status, false, std::chrono::steady_clock::now());
+}
+
+auto EndpointHealthMonitor::GetStatus() const -> std::vector<EndpointStatus>
+{
+    const auto Now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> Lock(StatusMutex);
+    std::vector<EndpointStatus> StatusList;
+    StatusList.reserve(Endpoints.size());
+    for (const auto& Entry : Endpoints)
+    {
+        EndpointStatus& Status = StatusList.emplace_back(Entry.Status);
+        Status.Circuit = EffectiveCircuit(Entry.Status, Now);
+    }
+    return StatusList;
+}
+
+auto EndpointHealthMonitor::GetCircuit(std::size_t Index) const -> CircuitState
+{
+    const auto Now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> Lock(StatusMutex);
+    return EffectiveCircuit(Endpoints[Index].Status, Now);
+}
+
+// 调用方持有 StatusMutex。半开状态下一次失败即重新熔断，退避时间翻倍
+auto EndpointHealthMonitor::UpdateCircuit(EndpointStatus& Status, bool IsSuccess, std::chrono::steady_clock::time_point Now) -> void
+{
+    constexpr double ErrorDecay = 0.2;
+    if (IsSuccess)
     {
-        PooledConnection NewPooledConn;
-        NewPooledConn.Connection = std::move(ConnectionPtr);
-        NewPooledConn.IsInUse = false;
-        NewPooledConn.LastUsedTime = std::chrono::steady_clock::now();
-        Pool.push_back(std::move(NewPooledConn));
+        Status.ErrorRate *= 1.0 - ErrorDecay;
+        Status.ConsecutiveFailures = 0;
+        if (Status.Circuit != CircuitState::Closed)
+        {
+            Status.Circuit = CircuitState::Closed;
+            Status.OpenCount = 0;
+            EmitEvent<EventLevel::Info>(EventCode::CircuitChanged, reinterpret_cast<uintptr_t>(this), std::format("{} 已恢复", Status.Name));
+        }
+        return;
+    }
+    Status.ErrorRate = Status.ErrorRate * (1.0 - ErrorDecay) + ErrorDecay;
+    ++Status.ConsecutiveFailures;
+    if (EffectiveCircuit(Status, Now) == CircuitState::Open)
         return;
+    if (EffectiveCircuit(Status, Now) == CircuitState::HalfOpen || Status.ConsecutiveFailures >= Options.FailureThreshold)
+    {
+        const auto Backoff = (std::min)(Options.BaseBackoff * (int64_t{ 1 } << (std::min)(Status.OpenCount, 16u)), Options.MaxBackoff);
+        ++Status.OpenCount;
+        Status.Circuit = CircuitState::Open;
+        Status.RetryAt = Now + Backoff;
+        EmitEvent<EventLevel::Warning>(EventCode::CircuitChanged, reinterpret_cast<uintptr_t>(this),
+            std::format("{} 熔断，{} ms 后重试（{}）", Status.Name, Backoff.count(), Status.LastError));
+    }
+}
+
+// 熔断退避期内不探测；探测连接常驻，出错后丢弃并在下一轮重建
+auto EndpointHealthMonitor::ProbeEndpoint(std::size_t Index) -> void
+{
+    EndpointEntry& Entry = Endpoints[Index];
+    {
+        std::lock_guard<std::mutex> Lock(StatusMutex);
+        if (EffectiveCircuit(Entry.Status, std::chrono::steady_clock::now()) == CircuitState::Open)
+            return;
     }
     try
     {
-        if (ConnectionPtr && !ConnectionPtr->isClosed())
-            ConnectionPtr->close();
+        if (!Entry.ProbeConnection || Entry.ProbeConnection->isClosed())
+        {
+            MySQLConfig ProbeConfig = GetAttemptConfig(Index);
+            ProbeConfig.ReadTimeout = Options.AttemptTimeout;
+            ProbeConfig.WriteTimeout = Options.AttemptTimeout;
+            ProbeConfig.EnableAutoReconnect = false;
+            Entry.ProbeConnection = OpenConnection(*sql::mysql::get_driver_instance(), ProbeConfig);
+        }
+        const auto ProbeStart = std::chrono::steady_clock::now();
+        const std::unique_ptr<sql::Statement> Statement(Entry.ProbeConnection->createStatement());
+        const std::unique_ptr<sql::ResultSet> ResultSet(Statement->executeQuery("SELECT @@global.read_only"));
+        const bool IsWritable = ResultSet && ResultSet->next() && std::string{ ResultSet->getString(1) } == "0";
+        const auto Latency = std::chrono::steady_clock::now() - ProbeStart;
+        {
+            std::lock_guard<std::mutex> Lock(StatusMutex);
+            Entry.Status.IsWritable = IsWritable;
+        }
+        RecordSuccess(Index, Latency);
+    }
+    catch (const sql::SQLException& Exception)
+    {
+        try
+        {
+            if (Entry.ProbeConnection)
+                Entry.ProbeConnection->close();
+        }
+        catch (...) { }
+        Entry.ProbeConnection.reset();
+        RecordFailure(Index, Exception.what());
     }
-    catch (...) { }
 }
 
-auto ConnectionPool::CleanIdleConnections() -> void
+auto EndpointHealthMonitor::ProbeLoop(std::stop_token StopToken) -> void
 {
-    std::lock_guard<std::mutex> Lock(PoolMutex);
-    const auto CurrentTime = std::chrono::steady_clock::now();
-    for (auto& PooledConn : Pool)
+    std::unique_lock<std::mutex> Lock(ProbeMutex);
+    while (!StopToken.stop_requested())
+    {
+        WakeCondition.wait_for(Lock, Options.ProbeInterval);
+        if (StopToken.stop_requested())
+            break;
+        Lock.unlock();
+        for (std::size_t Index = 0; Index < Endpoints.size() && !StopToken.stop_requested(); ++Index)
+            ProbeEndpoint(Index);
+        Lock.lock();
+    }
+}
+
+QueryWatchdog::QueryWatchdog(ExpiryHandler Handler) : OnExpired(std::move(Handler))
+{
+}
+
+QueryWatchdog::~QueryWatchdog()
+{
+    {
+        std::lock_guard<std::mutex> Lock(WatchdogMutex);
+        WatchThread.request_stop();
+    }
+    WakeCondition.notify_all();
+    if (WatchThread.joinable())
+        WatchThread.join();
+}
+
+auto QueryWatchdog::Arm(const std::shared_ptr<StatementTracker>& Tracker, uint64_t Generation, std::chrono::steady_clock::time_point Deadline) -> void
+{
+    {
+        std::lock_guard<std::mutex> Lock(WatchdogMutex);
+        if (!WatchThread.joinable())
+            WatchThread = std::jthread([this](std::stop_token StopToken) { WatchLoop(StopToken); });
+        Pending.push_back({ Deadline, Tracker, Tracker.get(), Generation });
+    }
+    WakeCondition.notify_one();
+}
+
+auto QueryWatchdog::Disarm(const StatementTracker* Tracker, uint64_t Generation) -> void
+{
+    std::lock_guard<std::mutex> Lock(WatchdogMutex);
+    std::erase_if(Pending, [Tracker, Generation](const PendingDeadline& Entry)
+        {
+            return Entry.TrackerKey == Tracker && Entry.Generation == Generation;
+        });
+}
+
+// 同时带截止时间的语句数不超过连接数，线性查找最早到期项即可
+auto QueryWatchdog::WatchLoop(std::stop_token StopToken) -> void
+{
+    std::unique_lock<std::mutex> Lock(WatchdogMutex);
+    while (!StopToken.stop_requested())
     {
-        if (!PooledConn.IsInUse && PooledConn.Connection)
+        if (Pending.empty())
         {
-            const auto IdleDuration = std::chrono::duration_cast<std::chrono::minutes>(CurrentTime - PooledConn.LastUsedTime);
-            if (IdleDuration >= IdleTimeout)
-            {
-                try
-                {
-                    if (!PooledConn.Connection->isClosed())
-                    {
-                        PooledConn.Connection->close();
-                    }
-                }
-                catch (...) { }
-                PooledConn.Connection.reset();
-            }
+            WakeCondition.wait(Lock);
+            continue;
+        }
+        const auto Earliest = std::ranges::min_element(Pending, {}, &PendingDeadline::Deadline);
+        if (std::chrono::steady_clock::now() < Earliest->Deadline)
+        {
+            WakeCondition.wait_until(Lock, Earliest->Deadline);
+            continue;
         }
+        PendingDeadline Expired = std::move(*Earliest);
+        Pending.erase(Earliest);
+        Lock.unlock();
+        if (const auto Tracker = Expired.Tracker.lock())
+            OnExpired(*Tracker, Expired.Generation);
+        Lock.lock();
+    }
+}
+
+auto PrimaryConnectionMutex::lock() -> void
+{
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Released.wait(Lock, [this] { return ExclusiveOwner == std::thread::id{} || ExclusiveOwner == std::this_thread::get_id(); });
+    // 返回后继续持有 Mutex，由 unlock 释放
+    Lock.release();
+}
+
+auto PrimaryConnectionMutex::unlock() -> void
+{
+    Mutex.unlock();
+}
+
+auto PrimaryConnectionMutex::BeginExclusive() -> void
+{
+    std::lock_guard<PrimaryConnectionMutex> Lock(*this);
+    ExclusiveOwner = std::this_thread::get_id();
+}
+
+auto PrimaryConnectionMutex::EndExclusive() -> void
+{
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        ExclusiveOwner = {};
     }
-    Pool.erase( std::remove_if(Pool.begin(), Pool.end(), [](const PooledConnection& Conn) { return !Conn.Connection; }), Pool.end());
+    Released.notify_all();
 }
@@ -1,5 +1,9 @@
 ﻿#pragma once
 #include "def.h"
+#include "metrics.h"
+#include "digest.h"
+#include "eventlog.h"
+#include "workload.h"
 #include <mysql/jdbc.h>
 #include <vector>
 #include <memory>
@@ -8,8 +12,15 @@
 #include <chrono>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
 #include <string_view>
 #include <atomic>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <array>
+#include <iterator>
+#include <limits>
 
 
 struct MySQLConfig
@@ -19,6 +30,8 @@ struct MySQLConfig
     std::string Password;
     std::string Database;
     unsigned int Port = 3306;
+    // 为空时，主机为 localhost 且使用默认端口则自动查找常见的套接字路径
+    std::string UnixSocket;
     unsigned int ConnectTimeout = 10;
     unsigned int ReadTimeout = 30;
     unsigned int WriteTimeout = 30;
@@ -50,19 +63,219 @@ struct MySQLRow
     }
 };
 
+// 结果行容器，只读接口与 std::vector 一致。前 DictionarySampleRows 行按原样保存，并据此找出低基数列：
+// 之后的行按列存入编码块，低基数列只保存字典编码。已驻留的字节超过单结果预算或进程预算后，后续行编码为紧凑的行块写入临时文件。
+// 编码块和落盘块在访问时还原为行并缓存最近的两块：指向这些行的引用在访问另外两个块之前有效，因此迭代器只是输入迭代器。
+// 读取会更新块缓存，多线程共享同一结果时需外部同步。
+class RowStore
+{
+public:
+    static constexpr std::size_t DefaultResultBudget = std::size_t{ 256 } << 20;
+    static constexpr std::size_t DefaultProcessBudget = std::size_t{ 1 } << 30;
+    static constexpr std::size_t BlockBytes = std::size_t{ 1 } << 20;
+    static constexpr std::size_t DictionarySampleRows = 1024;
+    static constexpr std::size_t MaxSampleDistinct = 64;
+    static constexpr std::size_t MaxDictionaryEntries = 4096;
+    static constexpr std::size_t EncodedBlockRows = 4096;
+    class const_iterator
+    {
+    private:
+        const RowStore* Store = nullptr;
+        std::size_t Index = 0;
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = MySQLRow;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const MySQLRow*;
+        using reference = const MySQLRow&;
+        const_iterator() = default;
+        const_iterator(const RowStore* StorePtr, std::size_t Position) noexcept : Store(StorePtr), Index(Position) {}
+        [[nodiscard]] auto operator*() const -> reference
+        {
+            return (*Store)[Index];
+        }
+        [[nodiscard]] auto operator->() const -> pointer
+        {
+            return &(*Store)[Index];
+        }
+        auto operator++() noexcept -> const_iterator&
+        {
+            ++Index;
+            return *this;
+        }
+        auto operator++(int) noexcept -> const_iterator
+        {
+            const_iterator Previous = *this;
+            ++Index;
+            return Previous;
+        }
+        [[nodiscard]] auto operator==(const const_iterator& Other) const noexcept -> bool = default;
+    };
+    using iterator = const_iterator;
+    using value_type = MySQLRow;
+    using size_type = std::size_t;
+private:
+    struct SpillFile;
+    // 写临时文件失败时块内容留在 Payload 中，结果仍然完整，只是不再受内存预算约束
+    struct SpillBlock
+    {
+        uint64_t Offset = 0;
+        uint32_t ByteSize = 0;
+        std::size_t FirstRow = 0;
+        std::size_t RowCount = 0;
+        std::string Payload;
+    };
+    // 字典超过 MaxDictionaryEntries 后该列退回普通存储，已有编码块仍引用 Values
+    struct ColumnDictionary
+    {
+        std::vector<std::string> Values;
+        std::unordered_map<std::string, uint16_t> Codes;
+        bool IsActive = false;
+    };
+    // 每列只使用 Codes 或 Plain 之一
+    struct EncodedBlock
+    {
+        std::size_t RowCount = 0;
+        std::vector<std::vector<uint16_t>> Codes;
+        std::vector<std::vector<std::string>> Plain;
+    };
+    struct CachedBlock
+    {
+        std::size_t FirstRow = (std::numeric_limits<std::size_t>::max)();
+        std::vector<MySQLRow> Rows;
+    };
+    static inline std::atomic<std::size_t> ProcessResidentBytes{ 0 };
+    static inline std::atomic<std::size_t> ProcessBudget{ DefaultProcessBudget };
+    std::vector<MySQLRow> ResidentRows;
+    std::vector<ColumnDictionary> Dictionaries;
+    std::vector<EncodedBlock> EncodedBlocks;
+    std::size_t EncodedRowCount = 0;
+    bool IsEncoding = false;
+    std::vector<SpillBlock> Blocks;
+    std::string PendingBlock;
+    std::size_t PendingRowCount = 0;
+    std::size_t SpilledRowCount = 0;
+    std::size_t ResidentBytes = 0;
+    std::size_t ResultBudget = DefaultResultBudget;
+    bool IsSpilling = false;
+    std::shared_ptr<SpillFile> File;
+    mutable std::array<CachedBlock, 2> Cache;
+    mutable std::size_t RecentCacheSlot = 0;
+    auto ChargeBytes(std::size_t Bytes) noexcept -> void;
+    auto ReleaseBytes(std::size_t Bytes) noexcept -> void;
+    auto ChooseDictionaryColumns() -> void;
+    auto AppendEncoded(MySQLRow RowData) -> void;
+    auto FlushPendingBlock() -> void;
+    auto InvalidateCachedBlock(std::size_t FirstRow) noexcept -> void;
+    [[nodiscard]] auto BlockRow(std::size_t Index) const -> const MySQLRow&;
+public:
+    RowStore() = default;
+    RowStore(const RowStore& Other);
+    RowStore(RowStore&& Other) noexcept;
+    auto operator=(const RowStore& Other) -> RowStore&;
+    auto operator=(RowStore&& Other) noexcept -> RowStore&;
+    ~RowStore();
+    // 0 表示不限制
+    static auto SetProcessBudget(std::size_t Bytes) noexcept -> void
+    {
+        ProcessBudget.store(Bytes == 0 ? (std::numeric_limits<std::size_t>::max)() : Bytes, std::memory_order_relaxed);
+    }
+    [[nodiscard]] static auto GetProcessResidentBytes() noexcept -> std::size_t
+    {
+        return ProcessResidentBytes.load(std::memory_order_relaxed);
+    }
+    auto SetBudget(std::size_t Bytes) noexcept -> void
+    {
+        ResultBudget = Bytes == 0 ? (std::numeric_limits<std::size_t>::max)() : Bytes;
+    }
+    auto push_back(MySQLRow RowData) -> void;
+    auto reserve(std::size_t Capacity) -> void
+    {
+        ResidentRows.reserve(Capacity);
+    }
+    auto clear() noexcept -> void;
+    [[nodiscard]] auto operator[](std::size_t Index) const -> const MySQLRow&
+    {
+        if (Index < ResidentRows.size()) [[likely]]
+            return ResidentRows[Index];
+        return BlockRow(Index);
+    }
+    [[nodiscard]] auto back() const -> const MySQLRow&
+    {
+        return (*this)[size() - 1];
+    }
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return ResidentRows.size() + EncodedRowCount + SpilledRowCount;
+    }
+    [[nodiscard]] auto empty() const noexcept -> bool
+    {
+        return size() == 0;
+    }
+    [[nodiscard]] auto begin() const noexcept -> const_iterator
+    {
+        return { this, 0 };
+    }
+    [[nodiscard]] auto end() const noexcept -> const_iterator
+    {
+        return { this, size() };
+    }
+    // 按列统计各取值的行数（按行数降序）；字典编码的列直接按编码计数
+    [[nodiscard]] auto CountValues(std::size_t ColumnIndex) const -> std::vector<std::pair<std::string, std::size_t>>;
+    // 返回指定列等于 Value 的行号；字典编码的列只比较编码
+    [[nodiscard]] auto FindRows(std::size_t ColumnIndex, std::string_view Value) const -> std::vector<std::size_t>;
+    // 新追加的行是否仍按字典编码；基数超出上限退回普通存储后为 false，之前的编码块仍然引用字典
+    [[nodiscard]] auto IsDictionaryEncoded(std::size_t ColumnIndex) const noexcept -> bool
+    {
+        return ColumnIndex < Dictionaries.size() && Dictionaries[ColumnIndex].IsActive;
+    }
+    [[nodiscard]] auto IsSpilled() const noexcept -> bool
+    {
+        return SpilledRowCount > 0;
+    }
+    [[nodiscard]] auto GetSpilledRowCount() const noexcept -> std::size_t
+    {
+        return SpilledRowCount;
+    }
+    [[nodiscard]] auto GetResidentBytes() const noexcept -> std::size_t
+    {
+        return ResidentBytes;
+    }
+};
+
+enum class ResultLimitMode : uint8_t
+{
+    ClientSide,
+    ServerSide
+};
+
+enum class QueryStatus : uint8_t
+{
+    Succeeded,
+    Failed,
+    Cancelled,
+    TimedOut
+};
+
 struct MySQLResult
 {
     std::vector<std::string> ColumnNames;
-    std::vector<MySQLRow> Rows;
+    RowStore Rows;
     unsigned long long AffectedRows = 0;
     bool Success = false;
+    bool IsTruncated = false;
+    QueryStatus Status = QueryStatus::Failed;
     std::string ErrorMessage;
-    std::chrono::milliseconds ExecutionTime{ 0 };
-    [[nodiscard]] constexpr auto IsEmpty() const noexcept -> bool
+    // 服务端或驱动返回的错误码，成功时为 0
+    int ErrorCode = 0;
+    uint32_t RetryCount = 0;
+    std::chrono::nanoseconds ExecutionTime{ 0 };
+    QueryTiming Timing;
+    [[nodiscard]] auto IsEmpty() const noexcept -> bool
     {
         return Rows.empty();
     }
-    [[nodiscard]] constexpr auto GetRowCount() const noexcept -> std::size_t
+    [[nodiscard]] auto GetRowCount() const noexcept -> std::size_t
     {
         return Rows.size();
     }
@@ -74,6 +287,43 @@ struct MySQLResult
     [[nodiscard]] auto HasColumn(std::string_view ColumnName) const -> bool;
 };
 
+// 读取结果集期间的进度回调，在执行语句的线程上调用：列名确定后调用一次（Rows 为空），之后每读到 RowInterval 行调用一次。
+// Rows 是正在构建的结果，只在回调内有效；回调返回 false 时停止读取，结果按截断处理
+struct FetchObserver
+{
+    std::function<bool(const std::vector<std::string>& ColumnNames, const RowStore& Rows)> Callback;
+    std::size_t RowInterval = 256;
+};
+
+enum class ErrorCategory : uint8_t
+{
+    None,
+    ConnectionLost,
+    Deadlock,
+    Permanent
+};
+
+// 连接中断与死锁（含锁等待超时）属于可重试的瞬时错误，其余错误重试也不会成功
+[[nodiscard]] auto ClassifyError(int ErrorCode) noexcept -> ErrorCategory;
+
+struct RetryStatistics
+{
+    uint64_t StatementRetries = 0;
+    uint64_t TransactionReplays = 0;
+    uint64_t Deadlocks = 0;
+    uint64_t ConnectionLosses = 0;
+    uint64_t ExhaustedRetries = 0;
+    std::chrono::nanoseconds RetryTime{ 0 };
+};
+
+struct DeadlockRecord
+{
+    std::chrono::system_clock::time_point Timestamp;
+    std::string SqlText;
+    // SHOW ENGINE INNODB STATUS 中的 LATEST DETECTED DEADLOCK 段落；没有 PROCESS 权限时为读取失败的原因
+    std::string Diagnostics;
+};
+
 class TransactionGuard
 {
 private:
@@ -98,10 +348,63 @@ class SQLSanitizer
 public:
     [[nodiscard]] static auto DetectSQLInjection(std::string_view SqlQuery) -> bool;
     [[nodiscard]] static auto IsValidIdentifier(std::string_view IdentifierName) -> bool;
+    [[nodiscard]] static auto QuoteIdentifier(std::string_view IdentifierName) -> std::string;
     [[nodiscard]] static auto EscapeString(std::string_view InputString) -> std::string;
     [[nodiscard]] static auto BuildParameterizedQuery(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> std::string;
 };
 
+// 一条连接上正在执行的语句。中断方在持有 Mutex 时发送 KILL QUERY，语句结束时也要先取得这把锁，
+// 因此 KILL 不会落到同一连接的下一条语句上。
+struct StatementTracker
+{
+    std::mutex Mutex;
+    uint64_t ServerConnectionId = 0;
+    uint64_t Generation = 0;
+    bool IsRunning = false;
+    std::optional<QueryStatus> InterruptedAs;
+};
+
+// 客户端截止时间：一个后台线程等待最早到期的语句，到期后回调中断它。
+// 语句结束时撤销条目；跟踪器以 weak_ptr 保存，已销毁的会话不会被回调。
+class QueryWatchdog
+{
+public:
+    using ExpiryHandler = std::function<void(StatementTracker&, uint64_t Generation)>;
+private:
+    struct PendingDeadline
+    {
+        std::chrono::steady_clock::time_point Deadline;
+        std::weak_ptr<StatementTracker> Tracker;
+        const StatementTracker* TrackerKey = nullptr;
+        uint64_t Generation = 0;
+    };
+    std::mutex WatchdogMutex;
+    std::condition_variable WakeCondition;
+    std::vector<PendingDeadline> Pending;
+    ExpiryHandler OnExpired;
+    std::jthread WatchThread;
+    auto WatchLoop(std::stop_token StopToken) -> void;
+public:
+    explicit QueryWatchdog(ExpiryHandler Handler);
+    ~QueryWatchdog();
+    QueryWatchdog(const QueryWatchdog&) = delete;
+    auto operator=(const QueryWatchdog&) -> QueryWatchdog & = delete;
+    auto Arm(const std::shared_ptr<StatementTracker>& Tracker, uint64_t Generation, std::chrono::steady_clock::time_point Deadline) -> void;
+    auto Disarm(const StatementTracker* Tracker, uint64_t Generation) -> void;
+};
+
+// 连接上已知的会话状态。Schema / Charset 为空表示无法确定（例如 SET NAMES ... COLLATE），此时不跳过任何 USE / SET NAMES。
+// IsDirty 表示执行过只有重新连接才能撤销的操作（用户变量、临时表、表锁、会话变量等）。
+struct SessionState
+{
+    std::optional<std::string> Schema;
+    std::optional<std::string> Charset;
+    bool HasTransaction = false;
+    bool IsDirty = false;
+};
+
+// 池锁只保护空闲列表和计数，建立连接与有效性检查都在锁外进行；
+// 连接数达到上限时等待归还，最长等待 ConnectTimeout。
 class ConnectionPool
 {
 private:
@@ -109,23 +412,204 @@ private:
     {
         std::unique_ptr<sql::Connection> Connection;
         std::chrono::steady_clock::time_point LastUsedTime;
-        bool IsInUse = false;
+        uint64_t ServerConnectionId = 0;
+    };
+    struct CheckoutInfo
+    {
+        std::chrono::steady_clock::time_point CheckoutTime;
+        uint64_t ServerConnectionId = 0;
     };
-    std::vector<PooledConnection> Pool;
+    std::vector<PooledConnection> IdleConnections;
+    std::size_t CheckedOutCount = 0;
     std::mutex PoolMutex;
+    std::condition_variable SlotAvailable;
     MySQLConfig Configuration;
     std::size_t MaxPoolSize = 10;
     std::chrono::minutes IdleTimeout{ 5 };
+    static constexpr std::chrono::seconds ValidationInterval{ 5 };
+    std::unordered_map<const sql::Connection*, CheckoutInfo> CheckedOutConnections;
+    LatencyHistogram AcquireLatency;
+    LatencyHistogram HoldLatency;
+    auto CreateConnection() -> PooledConnection;
+    [[nodiscard]] auto ResetSession(sql::Connection& ConnectionRef, const SessionState& State) -> bool;
 public:
     explicit ConnectionPool(const MySQLConfig& ConfigParam, std::size_t MaxSize = 10);
     ~ConnectionPool();
     [[nodiscard]] auto AcquireConnection() -> std::unique_ptr<sql::Connection>;
-    auto ReleaseConnection(std::unique_ptr<sql::Connection> ConnectionPtr) -> void;
+    // 归还前按会话状态原地清理（回滚事务、恢复默认库和字符集），无法清理的连接直接关闭
+    auto ReleaseConnection(std::unique_ptr<sql::Connection> ConnectionPtr, const SessionState& State) -> void;
+    [[nodiscard]] auto GetInitialState() const -> SessionState;
+    [[nodiscard]] auto GetMaxRetries() const noexcept -> unsigned int
+    {
+        return Configuration.MaxRetries;
+    }
     auto CleanIdleConnections() -> void;
+    [[nodiscard]] auto GetServerConnectionId(const sql::Connection* ConnectionPtr) -> uint64_t;
+    [[nodiscard]] auto GetAcquireLatency() const -> LatencySnapshot;
+    [[nodiscard]] auto GetHoldLatency() const -> LatencySnapshot;
+};
+
+enum class CircuitState : uint8_t
+{
+    Closed,
+    Open,
+    HalfOpen
+};
+
+struct FailoverOptions
+{
+    std::chrono::milliseconds ProbeInterval{ 2000 };
+    // 探测和故障转移时每次建连的超时（秒），不使用端点配置中较长的 ConnectTimeout
+    unsigned int AttemptTimeout = 2;
+    // 连续失败达到该次数后熔断
+    uint32_t FailureThreshold = 2;
+    std::chrono::milliseconds BaseBackoff{ 1000 };
+    std::chrono::milliseconds MaxBackoff{ 60000 };
+    // 只选择 read_only = 0 的端点，避免切换到只读从库
+    bool RequireWritable = true;
+};
+
+struct EndpointStatus
+{
+    std::string Name;
+    CircuitState Circuit = CircuitState::Closed;
+    bool HasProbed = false;
+    bool IsWritable = true;
+    double LatencyMilliseconds = 0.0;
+    double ErrorRate = 0.0;
+    uint32_t ConsecutiveFailures = 0;
+    uint32_t OpenCount = 0;
+    std::chrono::steady_clock::time_point RetryAt;
+    std::string LastError;
+    // 越小越好：探测延迟（指数平均）按近期错误率放大，半开状态额外加罚
+    [[nodiscard]] auto Score() const noexcept -> double
+    {
+        return LatencyMilliseconds * (1.0 + 4.0 * ErrorRate) + (Circuit == CircuitState::HalfOpen ? 1000.0 : 0.0);
+    }
+};
+
+// 候选端点的健康评分与熔断。后台线程在每个端点的独立连接上定期探测延迟和 read_only，
+// 建连失败与探测失败都计入连续失败；熔断后按指数退避等待，到期转为半开，下一次探测或建连成功即恢复。
+// 可由多个 MySQLWrapper 共用。
+class EndpointHealthMonitor
+{
+private:
+    struct EndpointEntry
+    {
+        MySQLConfig Config;
+        EndpointStatus Status;
+        std::unique_ptr<sql::Connection> ProbeConnection;
+    };
+    std::vector<EndpointEntry> Endpoints;
+    FailoverOptions Options;
+    mutable std::mutex StatusMutex;
+    std::mutex ProbeMutex;
+    std::condition_variable WakeCondition;
+    std::once_flag StartOnce;
+    std::jthread ProbeThread;
+    auto ProbeLoop(std::stop_token StopToken) -> void;
+    auto ProbeEndpoint(std::size_t Index) -> void;
+    auto UpdateCircuit(EndpointStatus& Status, bool IsSuccess, std::chrono::steady_clock::time_point Now) -> void;
+public:
+    EndpointHealthMonitor(std::vector<MySQLConfig> Candidates, FailoverOptions OptionsParam = {});
+    ~EndpointHealthMonitor();
+    EndpointHealthMonitor(const EndpointHealthMonitor&) = delete;
+    auto operator=(const EndpointHealthMonitor&) -> EndpointHealthMonitor & = delete;
+    // 并行同步探测一轮后启动后台线程，重复调用无效
+    auto Start() -> void;
+    // 可尝试的端点按评分排序；熔断中的端点不在其中，同分时保持候选列表的顺序
+    [[nodiscard]] auto RankEndpoints() const -> std::vector<std::size_t>;
+    // 建连用的配置：ConnectTimeout 不超过 AttemptTimeout
+    [[nodiscard]] auto GetAttemptConfig(std::size_t Index) const -> MySQLConfig;
+    // 建连成功没有可比的延迟样本，只更新错误率和熔断状态
+    auto RecordSuccess(std::size_t Index, std::optional<std::chrono::nanoseconds> Latency = std::nullopt) -> void;
+    auto RecordFailure(std::size_t Index, std::string_view Reason) -> void;
+    [[nodiscard]] auto GetStatus() const -> std::vector<EndpointStatus>;
+    // 退避到期的熔断端点视为半开
+    [[nodiscard]] auto GetCircuit(std::size_t Index) const -> CircuitState;
+    [[nodiscard]] auto GetEndpointCount() const noexcept -> std::size_t
+    {
+        return Endpoints.size();
+    }
+};
+
+// 主连接的互斥量，满足 BasicLockable。BeginExclusive 之后主连接归当前线程独占：其他线程的 lock() 一直等到 EndExclusive，
+// 独占线程自己仍可以逐条加锁，因此事务回调内可以调用 MySQLWrapper 的其他接口。独占不能嵌套。
+class PrimaryConnectionMutex
+{
+private:
+    std::mutex Mutex;
+    std::condition_variable Released;
+    std::thread::id ExclusiveOwner;
+public:
+    auto lock() -> void;
+    auto unlock() -> void;
+    auto BeginExclusive() -> void;
+    auto EndExclusive() -> void;
+};
+
+class MySQLWrapper;
+
+// 从连接池检出的独立会话，只属于一个线程使用，执行时不持有任何全局锁。
+// 析构时回滚未完成的事务并把连接归还连接池；会话不能比创建它的 MySQLWrapper 存活更久。
+// 除 Cancel 可以从其他线程调用外，其余接口只能由持有会话的线程调用。
+class Session
+{
+    friend class MySQLWrapper;
+private:
+    MySQLWrapper* Owner;
+    std::shared_ptr<ConnectionPool> Pool;
+    std::unique_ptr<sql::Connection> Connection;
+    std::shared_ptr<WorkloadRecorder> Recorder;
+    std::shared_ptr<StatementTracker> Tracker;
+    SessionState State;
+    uint64_t SessionId;
+    uint64_t ServerConnectionId;
+    std::string LastErrorMessage;
+    int LastErrorCode = 0;
+    bool IsInTransaction = false;
+    // COMMIT 时连接中断：事务可能已在服务端生效，不能重放
+    bool IsCommitOutcomeUnknown = false;
+    Session(MySQLWrapper& OwnerRef, std::shared_ptr<ConnectionPool> PoolPtr, std::unique_ptr<sql::Connection> ConnectionPtr, std::shared_ptr<WorkloadRecorder> RecorderPtr);
+    auto SetError(std::string_view ErrorMessage) -> void;
+    // 连接中断后换一条池连接；会话状态无法在新连接上还原时放弃
+    [[nodiscard]] auto ReplaceConnection() -> bool;
+    [[nodiscard]] auto PrepareTransactionReplay(uint32_t Attempt) -> bool;
+public:
+    ~Session();
+    Session(const Session&) = delete;
+    auto operator=(const Session&) -> Session & = delete;
+    [[nodiscard]] auto Execute(const std::string& SqlCommand, std::chrono::milliseconds Timeout = {}) -> MySQLResult;
+    [[nodiscard]] auto Query(const std::string& SqlQuery, std::chrono::milliseconds Timeout = {}) -> MySQLResult;
+    [[nodiscard]] auto ExecuteParameterized(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> MySQLResult;
+    [[nodiscard]] auto ExecuteBatch(const std::vector<std::string>& SqlStatements) -> std::vector<MySQLResult>;
+    [[nodiscard]] auto BeginTransaction() -> bool;
+    [[nodiscard]] auto CommitTransaction() -> bool;
+    [[nodiscard]] auto RollbackTransaction() -> bool;
+    [[nodiscard]] auto GetTransactionGuard() -> std::unique_ptr<TransactionGuard>;
+    template<typename Func>
+    [[nodiscard]] auto ExecuteTransaction(Func&& TransactionFunc) -> bool;
+    [[nodiscard]] auto PrepareStatement(std::string_view SqlQuery) -> std::expected<std::unique_ptr<sql::PreparedStatement>, std::string>;
+    [[nodiscard]] auto ExecutePrepared(sql::PreparedStatement* StatementPtr, const std::vector<std::string>& ParameterList) -> MySQLResult;
+    auto Cancel() -> bool;
+    [[nodiscard]] auto GetLastError() const -> const std::string&
+    {
+        return LastErrorMessage;
+    }
+    // 最近一次提交是否因连接中断而结果未知，BeginTransaction 时清除
+    [[nodiscard]] constexpr auto IsTransactionOutcomeUnknown() const noexcept -> bool
+    {
+        return IsCommitOutcomeUnknown;
+    }
+    [[nodiscard]] constexpr auto GetSessionId() const noexcept -> uint64_t
+    {
+        return SessionId;
+    }
 };
 
 class MySQLWrapper
 {
+    friend class Session;
 private:
     sql::Driver* DriverInstance = nullptr;
     std::unique_ptr<sql::Connection> ActiveConnection;
@@ -133,22 +617,96 @@ private:
     MySQLConfig CurrentConfig;
     MySQLConfig LastSuccessfulConfig;
     std::string LastErrorMessage;
-    std::size_t MaxResultRows = 0;
-    mutable std::mutex ConnectionMutex;
+    std::atomic<std::size_t> MaxResultRows{ 0 };
+    std::atomic<ResultLimitMode> LimitMode{ ResultLimitMode::ClientSide };
+    std::atomic<std::size_t> ResultMemoryBudget{ RowStore::DefaultResultBudget };
+    mutable PrimaryConnectionMutex ConnectionMutex;
+    std::shared_ptr<ConnectionPool> SessionPool;
+    std::size_t SessionPoolSize = 8;
     struct QueryStatistics
     {
         std::atomic<uint64_t> TotalQueries{ 0 };
         std::atomic<uint64_t> SuccessfulQueries{ 0 };
         std::atomic<uint64_t> FailedQueries{ 0 };
-        std::chrono::steady_clock::time_point LastQueryTime;
+        std::atomic<std::chrono::steady_clock::rep> LastQueryTime{ 0 };
+        LatencyHistogram QueryLatency;
+        std::atomic<uint64_t> StatementRetries{ 0 };
+        std::atomic<uint64_t> TransactionReplays{ 0 };
+        std::atomic<uint64_t> Deadlocks{ 0 };
+        std::atomic<uint64_t> ConnectionLosses{ 0 };
+        std::atomic<uint64_t> ExhaustedRetries{ 0 };
+        std::atomic<std::chrono::nanoseconds::rep> RetryNanoseconds{ 0 };
     } Statistics;
-    std::function<void(std::string_view)> LogCallback;
+    std::deque<DeadlockRecord> Deadlocks;
+    mutable std::mutex DeadlockMutex;
+    static constexpr std::size_t MaxDeadlockRecords = 20;
+    static constexpr std::chrono::milliseconds RetryBaseDelay{ 20 };
+    static constexpr std::chrono::milliseconds RetryMaxDelay{ 1000 };
+    int LastErrorCode = 0;
+    // 与 Session::IsCommitOutcomeUnknown 相同，受 ConnectionMutex 保护
+    bool IsCommitOutcomeUnknown = false;
+    // 事务进行中重建了主连接：旧连接上的语句已随连接关闭回滚，COMMIT 或 ROLLBACK 之前的语句都直接失败，COMMIT 也返回失败。受 ConnectionMutex 保护
+    bool IsTransactionAborted = false;
+    DigestTable Digests;
+    std::atomic<std::chrono::nanoseconds::rep> SlowQueryThreshold{ 0 };
+    std::unique_ptr<sql::Connection> ExplainConnection;
+    std::string ExplainSchema;
+    std::mutex ExplainMutex;
+    std::deque<SlowQueryRecord> SlowQueries;
+    uint64_t NextSlowQueryId = 0;
+    mutable std::mutex SlowQueryMutex;
+    static constexpr std::size_t MaxSlowQueryRecords = 100;
+    // 等待获取执行计划的慢查询，由 ExplainThread 在执行计划连接上依次处理，不占用执行语句的线程
+    struct PendingExplain
+    {
+        uint64_t RecordId = 0;
+        std::string SqlText;
+        std::string SchemaName;
+    };
+    std::deque<PendingExplain> PendingExplains;
+    std::mutex PendingExplainMutex;
+    std::condition_variable ExplainWake;
+    std::jthread ExplainThread;
+    EventLogger::SinkId LogSinkId = 0;
+    uint64_t SessionId = 0;
+    uint64_t ServerConnectionId = 0;
+    SessionState PrimaryState;
+    std::shared_ptr<EndpointHealthMonitor> Failover;
+    std::optional<std::size_t> ActiveEndpoint;
+    std::shared_ptr<WorkloadRecorder> Recorder;
+    std::shared_ptr<const FetchObserver> Observer;
+    std::shared_ptr<StatementTracker> PrimaryTracker = std::make_shared<StatementTracker>();
+    std::unique_ptr<sql::Connection> ControlConnection;
+    MySQLConfig ControlConfig;
+    std::mutex ControlMutex;
+    std::unique_ptr<QueryWatchdog> Watchdog;
+    struct ExecutionTarget
+    {
+        sql::Connection* Connection = nullptr;
+        uint64_t ServerConnectionId = 0;
+        uint64_t SessionId = 0;
+        WorkloadRecorder* Recorder = nullptr;
+        std::shared_ptr<StatementTracker> Tracker;
+        SessionState* State = nullptr;
+        const FetchObserver* Observer = nullptr;
+    };
     auto DisconnectInternal() noexcept -> void;
     auto ReconnectInternal() -> bool;
     auto ConnectInternal(const MySQLConfig& ConfigParam) -> bool;
+    auto ConnectBestEndpoint() -> bool;
     auto PingInternal() -> bool;
     auto ValidateConnectionInternal() -> bool;
-    auto ExecuteInternal(const std::string& SqlQuery, bool IsQuery) -> MySQLResult;
+    auto ExecuteInternal(const std::string& SqlQuery, bool IsQuery, std::chrono::milliseconds Timeout) -> MySQLResult;
+    auto ExecuteOn(const ExecutionTarget& Target, const std::string& SqlQuery, std::chrono::milliseconds Timeout, MySQLResult ResultData, std::chrono::steady_clock::time_point StatementStart) -> MySQLResult;
+    auto Interrupt(StatementTracker& Tracker, uint64_t Generation, QueryStatus Reason) -> bool;
+    auto KillQuery(uint64_t TargetConnectionId) -> bool;
+    auto ExecutePreparedOn(sql::PreparedStatement* StatementPtr, const std::vector<std::string>& ParameterList) -> MySQLResult;
+    [[nodiscard]] static auto NextSessionId() noexcept -> uint64_t;
+    // 全抖动指数退避：在 [0, min(RetryMaxDelay, RetryBaseDelay * 2^Attempt)] 内均匀取值
+    [[nodiscard]] static auto RetryDelay(uint32_t Attempt) -> std::chrono::nanoseconds;
+    [[nodiscard]] auto ShouldRetryStatement(const MySQLResult& ResultData, std::string_view SqlQuery, const SessionState& State, const SessionState& InitialState) const -> bool;
+    [[nodiscard]] auto PrepareTransactionReplay(uint32_t Attempt) -> bool;
+    auto CaptureDeadlock(sql::Connection& ConnectionRef, std::string_view SqlQuery) -> void;
 public:
     MySQLWrapper();
     ~MySQLWrapper();
@@ -157,6 +715,9 @@ public:
     MySQLWrapper(MySQLWrapper&&) noexcept = default;
     auto operator=(MySQLWrapper&&) noexcept -> MySQLWrapper & = default;
     [[nodiscard]] auto Connect(const MySQLConfig& ConfigParam) -> bool;
+    // 在候选端点中连接评分最好的一个；之后的重连同样按当前评分选择，跳过熔断中的端点
+    [[nodiscard]] auto ConnectFailover(std::shared_ptr<EndpointHealthMonitor> Monitor) -> bool;
+    [[nodiscard]] auto GetEndpointStatus() const -> std::vector<EndpointStatus>;
     auto Disconnect() noexcept -> void;
     [[nodiscard]] auto Reconnect() -> bool;
     [[nodiscard]] auto Ping() -> bool;
@@ -164,10 +725,11 @@ public:
     {
         return IsConnected;
     }
-    [[nodiscard]] auto Execute(const std::string& SqlCommand) -> MySQLResult;
-    [[nodiscard]] auto Query(const std::string& SqlQuery) -> MySQLResult;
+    [[nodiscard]] auto Execute(const std::string& SqlCommand, std::chrono::milliseconds Timeout = {}) -> MySQLResult;
+    [[nodiscard]] auto Query(const std::string& SqlQuery, std::chrono::milliseconds Timeout = {}) -> MySQLResult;
     [[nodiscard]] auto ExecuteParameterized(std::string_view QueryTemplate, const std::vector<std::string>& ParameterList) -> MySQLResult;
     [[nodiscard]] auto ExecuteBatch(const std::vector<std::string>& SqlStatements) -> std::vector<MySQLResult>;
+    auto Cancel() -> bool;
     [[nodiscard]] auto BeginTransaction() -> bool;
     [[nodiscard]] auto CommitTransaction() -> bool;
     [[nodiscard]] auto RollbackTransaction() -> bool;
@@ -185,18 +747,47 @@ public:
     [[nodiscard]] auto EscapeString(const std::string& InputString) const -> std::string;
     [[nodiscard]] auto ValidateSQL(std::string_view SqlQuery) const -> bool;
     auto SetQueryTimeout(unsigned int TimeoutSeconds) -> void;
-    auto SetResultLimit(std::size_t MaxRows) -> void;
+    // ClientSide 只在客户端停止物化；ServerSide 把简单 SELECT 改写为 LIMIT，其余语句流式读取，不缓存整个结果
+    auto SetResultLimit(std::size_t MaxRows, ResultLimitMode Mode = ResultLimitMode::ClientSide) -> void;
+    // 单个结果驻留内存的上限，超出部分写入临时文件；0 表示不限制。进程总预算见 RowStore::SetProcessBudget
+    auto SetResultMemoryBudget(std::size_t Bytes) -> void;
     [[nodiscard]] auto GetLastError() const -> std::string;
+    // 主连接上最近一次提交是否因连接中断而结果未知
+    [[nodiscard]] auto IsTransactionOutcomeUnknown() const -> bool;
+    // 回调注册为 EventLogger 的 Sink：稍后在日志线程上异步调用，只收到不低于运行时级别的本连接事件（FormatEventMessage 的结果），捕获的状态须线程安全
     auto SetLogCallback(std::function<void(std::string_view)> CallbackFunc) -> void;
     auto Log(std::string_view Message) const -> void;
     [[nodiscard]] auto ConnectExpected(const MySQLConfig& ConfigParam) -> std::expected<void, std::string>;
     [[nodiscard]] auto QueryExpected(const std::string& SqlQuery) -> std::expected<MySQLResult, std::string>;
     [[nodiscard]] auto GetStatistics() const -> std::tuple<uint64_t, uint64_t, uint64_t>;
+    [[nodiscard]] auto GetRetryStatistics() const -> RetryStatistics;
+    [[nodiscard]] auto GetDeadlocks() const -> std::vector<DeadlockRecord>;
     auto ResetStatistics() -> void;
+    [[nodiscard]] auto GetLatencySnapshot() const -> LatencySnapshot;
+    [[nodiscard]] auto GetTopDigests(std::size_t Count, DigestSortKey SortKey = DigestSortKey::TotalLatency) -> std::vector<DigestSummary>;
+    auto SetSlowQueryThreshold(std::chrono::milliseconds Threshold) noexcept -> void;
+    [[nodiscard]] auto GetSlowQueries() const -> std::vector<SlowQueryRecord>;
     [[nodiscard]] auto GetConnectionInfo() const -> std::string;
+    auto SetWorkloadRecorder(std::shared_ptr<WorkloadRecorder> RecorderPtr) -> void;
+    // 之后在本连接上执行的语句读取结果时调用观察者；传入空指针取消。有观察者时结果总是流式读取
+    auto SetFetchObserver(std::shared_ptr<const FetchObserver> ObserverPtr) -> void;
+    [[nodiscard]] auto GetSessionId() const -> uint64_t;
+    [[nodiscard]] auto OpenSession() -> std::expected<std::unique_ptr<Session>, std::string>;
+    auto SetSessionPoolSize(std::size_t PoolSize) -> void;
+    [[nodiscard]] auto GetSessionPoolLatency() const -> std::pair<LatencySnapshot, LatencySnapshot>;
 private:
-    auto UpdateStatistics(bool IsSuccess) noexcept -> void;
+    auto UpdateStatistics(std::string_view SqlQuery, const MySQLResult& ResultData, sql::Connection* ConnectionPtr, const SessionState* State) -> void;
+    auto CaptureExplain(std::string_view SqlQuery, const std::string& SchemaName, const MySQLConfig& Config) -> std::expected<std::string, std::string>;
+    auto RecordSlowQuery(std::string_view SqlQuery, StatementDigest Digest, const MySQLResult& ResultData, sql::Connection* ConnectionPtr, const SessionState* State) -> void;
+    auto ExplainLoop(std::stop_token StopToken) -> void;
+    auto CompleteSlowQuery(uint64_t RecordId, std::expected<std::string, std::string> ExplainResult) -> void;
+    auto EmitSlowQuery(const SlowQueryRecord& Record) const -> void;
     auto LogError(std::string_view ErrorMessage) -> void;
+    auto EmitError(std::string_view ErrorMessage) const -> void;
+    [[nodiscard]] auto EventSource() const noexcept -> uint64_t
+    {
+        return reinterpret_cast<uintptr_t>(this);
+    }
 };
 
 template<typename T>
@@ -232,25 +823,97 @@ auto MySQLRow::GetValue(std::size_t Index) const -> std::optional<T>
     }
 }
 
+// ResultSource 只需提供 isNull(int) / getString(int)，sql::ResultSet 与基准测试中的合成结果集共用此路径
+template<typename ResultSource>
+[[nodiscard]] auto MaterializeRow(ResultSource& Source, int ColumnCount) -> MySQLRow
+{
+    MySQLRow RowData;
+    RowData.Fields.reserve(static_cast<std::size_t>(ColumnCount));
+    for (int Index = 1; Index <= ColumnCount; ++Index)
+    {
+        if (Source.isNull(Index))
+            RowData.Fields.emplace_back("NULL");
+        else
+            RowData.Fields.push_back(Source.getString(Index));
+    }
+    return RowData;
+}
+
+// 事务中的语句或提交遇到死锁、锁等待超时或连接中断时，回滚后按 MaxRetries 整体重放回调，
+// 因此回调必须可以重复执行：不要在回调内修改外部状态，或在每次进入时重新初始化。
+// 例外是 COMMIT 本身遇到连接中断：事务可能已经生效，此时不重放，返回 false 且 IsTransactionOutcomeUnknown() 为 true
+template<typename Func>
+auto Session::ExecuteTransaction(Func&& TransactionFunc) -> bool
+{
+    for (uint32_t Attempt = 0;; ++Attempt)
+    {
+        if (!BeginTransaction()) [[unlikely]]
+            return false;
+        try
+        {
+            bool IsSuccess;
+            if constexpr (std::is_invocable_v<Func, Session&>)
+                IsSuccess = TransactionFunc(*this);
+            else
+                IsSuccess = TransactionFunc();
+            if (IsSuccess && CommitTransaction())
+                return true;
+        }
+        catch (...)
+        {
+        }
+        if (IsInTransaction)
+            (void)RollbackTransaction();
+        if (!PrepareTransactionReplay(Attempt))
+            return false;
+    }
+}
+
+// 接受 Session& 参数的回调在独立会话上执行整个事务；无参回调沿用主连接。
+// 主连接上的整个事务（含重放）期间由当前线程独占主连接，其他线程的语句等到事务结束后才执行，不会混入事务被一起提交或回滚；
+// 回调内可以调用本对象的其他接口，但不能再次调用 ExecuteTransaction。重放规则与 Session::ExecuteTransaction 相同
 template<typename Func>
 auto MySQLWrapper::ExecuteTransaction(Func&& TransactionFunc) -> bool
 {
-    std::lock_guard<std::mutex> Lock(ConnectionMutex);
-    if (!BeginTransaction()) [[unlikely]]
-        return false;
-    try
+    if constexpr (std::is_invocable_v<Func, Session&>)
     {
-        if (std::forward<Func>(TransactionFunc)())
-            return CommitTransaction();
-        else
+        auto SessionResult = OpenSession();
+        if (!SessionResult) [[unlikely]]
         {
-            RollbackTransaction();
+            std::lock_guard<PrimaryConnectionMutex> Lock(ConnectionMutex);
+            LogError(SessionResult.error());
             return false;
         }
+        return (*SessionResult)->ExecuteTransaction(std::forward<Func>(TransactionFunc));
     }
-    catch (...)
+    else
     {
-        RollbackTransaction();
-        return false;
+        ConnectionMutex.BeginExclusive();
+        struct ExclusiveScope
+        {
+            PrimaryConnectionMutex& Mutex;
+            ~ExclusiveScope()
+            {
+                Mutex.EndExclusive();
+            }
+        } Exclusive{ ConnectionMutex };
+        for (uint32_t Attempt = 0;; ++Attempt)
+        {
+            if (!BeginTransaction()) [[unlikely]]
+                return false;
+            bool IsCommitted = false;
+            try
+            {
+                IsCommitted = TransactionFunc() && CommitTransaction();
+            }
+            catch (...)
+            {
+            }
+            if (IsCommitted)
+                return true;
+            (void)RollbackTransaction();
+            if (!PrepareTransactionReplay(Attempt))
+                return false;
+        }
     }
 }
\ No newline at end of file
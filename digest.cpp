@@ -0,0 +1,378 @@
+#include "digest.h"
+#include "hash.h"
+#include <algorithm>
+#include <cctype>
+#include <format>
+
+namespace
+{
+    enum class TokenKind
+    {
+        Word,
+        Identifier,
+        Placeholder,
+        List,
+        Punct
+    };
+
+    struct Token
+    {
+        TokenKind Kind;
+        std::string Text;
+    };
+
+    [[nodiscard]] auto IsWordChar(char CharValue) noexcept -> bool
+    {
+        const auto ByteValue = static_cast<unsigned char>(CharValue);
+        return std::isalnum(ByteValue) || ByteValue == '_' || ByteValue == '$' || ByteValue >= 0x80;
+    }
+
+    [[nodiscard]] auto IsOperatorChar(char CharValue) noexcept -> bool
+    {
+        return std::string_view{ "<>=!|&:+-*/%^~" }.find(CharValue) != std::string_view::npos;
+    }
+
+    [[nodiscard]] auto SkipQuoted(std::string_view SqlText, std::size_t Index) noexcept -> std::size_t
+    {
+        const char QuoteChar = SqlText[Index++];
+        while (Index < SqlText.size())
+        {
+            if (SqlText[Index] == '\\' && QuoteChar != '`')
+            {
+                Index += 2;
+                continue;
+            }
+            if (SqlText[Index] == QuoteChar)
+            {
+                if (Index + 1 < SqlText.size() && SqlText[Index + 1] == QuoteChar)
+                {
+                    Index += 2;
+                    continue;
+                }
+                return Index + 1;
+            }
+            ++Index;
+        }
+        return SqlText.size();
+    }
+
+    [[nodiscard]] auto SkipComment(std::string_view SqlText, std::size_t Index) noexcept -> std::size_t
+    {
+        const char CurrentChar = SqlText[Index];
+        const char NextChar = Index + 1 < SqlText.size() ? SqlText[Index + 1] : '\0';
+        if (CurrentChar == '#' || (CurrentChar == '-' && NextChar == '-'))
+        {
+            const std::size_t LineEnd = SqlText.find('\n', Index);
+            return LineEnd == std::string_view::npos ? SqlText.size() : LineEnd + 1;
+        }
+        if (CurrentChar == '/' && NextChar == '*')
+        {
+            const std::size_t CommentEnd = SqlText.find("*/", Index + 2);
+            return CommentEnd == std::string_view::npos ? SqlText.size() : CommentEnd + 2;
+        }
+        return Index;
+    }
+
+    auto CollapseValueList(std::vector<Token>& Tokens) -> void
+    {
+        std::size_t Depth = 0;
+        auto OpenPosition = Tokens.rbegin();
+        for (; OpenPosition != Tokens.rend(); ++OpenPosition)
+        {
+            if (OpenPosition->Kind != TokenKind::Punct)
+                continue;
+            if (OpenPosition->Text == ")")
+                ++Depth;
+            else if (OpenPosition->Text == "(")
+            {
+                if (Depth == 0)
+                    break;
+                --Depth;
+            }
+        }
+        if (OpenPosition == Tokens.rend())
+            return;
+        const auto FirstInner = OpenPosition.base();
+        if (FirstInner == Tokens.end())
+            return;
+        const bool IsValueList = std::all_of(FirstInner, Tokens.end(), [](const Token& TokenData)
+            {
+                return TokenData.Kind == TokenKind::Placeholder || TokenData.Kind == TokenKind::List || (TokenData.Kind == TokenKind::Punct && TokenData.Text == ",");
+            });
+        if (!IsValueList)
+            return;
+        Tokens.erase(FirstInner, Tokens.end());
+        Tokens.push_back({ TokenKind::List, "..." });
+    }
+
+    auto CollapseRepeatedRows(std::vector<Token>& Tokens) -> void
+    {
+        const auto IsRowGroup = [&Tokens](std::size_t EndIndex)
+            {
+                return EndIndex >= 3 && Tokens[EndIndex - 1].Text == ")" && Tokens[EndIndex - 2].Kind == TokenKind::List && Tokens[EndIndex - 3].Text == "(";
+            };
+        const std::size_t TokenCount = Tokens.size();
+        if (TokenCount >= 7 && IsRowGroup(TokenCount) && Tokens[TokenCount - 4].Text == "," && IsRowGroup(TokenCount - 4))
+            Tokens.resize(TokenCount - 4);
+    }
+
+    [[nodiscard]] auto NeedsSpace(const Token& Previous, const Token& Current) noexcept -> bool
+    {
+        if (Current.Kind == TokenKind::Punct && (Current.Text == "," || Current.Text == ")" || Current.Text == "."))
+            return false;
+        if (Current.Kind == TokenKind::List && Previous.Text == "(")
+            return false;
+        if (Previous.Kind == TokenKind::Punct && (Previous.Text == "(" || Previous.Text == "."))
+            return false;
+        if (Current.Kind == TokenKind::Punct && Current.Text == "(" && (Previous.Kind == TokenKind::Word || Previous.Kind == TokenKind::Identifier))
+            return false;
+        return true;
+    }
+}
+
+auto StatementDigest::ToHex() const -> std::string
+{
+    return std::format("{:016x}", Hash);
+}
+
+auto StatementNormalizer::Normalize(std::string_view SqlText) -> std::string
+{
+    std::vector<Token> Tokens;
+    std::size_t ApproximateLength = 0;
+    std::size_t Index = 0;
+    while (Index < SqlText.size() && ApproximateLength < MaxNormalizedLength)
+    {
+        const char CurrentChar = SqlText[Index];
+        const char NextChar = Index + 1 < SqlText.size() ? SqlText[Index + 1] : '\0';
+        if (std::isspace(static_cast<unsigned char>(CurrentChar)))
+        {
+            ++Index;
+            continue;
+        }
+        if (const std::size_t CommentEnd = SkipComment(SqlText, Index); CommentEnd != Index)
+        {
+            Index = CommentEnd;
+            continue;
+        }
+        if (CurrentChar == '\'' || CurrentChar == '"')
+        {
+            Index = SkipQuoted(SqlText, Index);
+            Tokens.push_back({ TokenKind::Placeholder, "?" });
+        }
+        else if (CurrentChar == '`')
+        {
+            const std::size_t QuoteEnd = SkipQuoted(SqlText, Index);
+            Tokens.push_back({ TokenKind::Identifier, std::string{ SqlText.substr(Index, QuoteEnd - Index) } });
+            Index = QuoteEnd;
+        }
+        else if (std::isdigit(static_cast<unsigned char>(CurrentChar)) || (CurrentChar == '.' && std::isdigit(static_cast<unsigned char>(NextChar))))
+        {
+            while (Index < SqlText.size() && (IsWordChar(SqlText[Index]) || SqlText[Index] == '.'))
+            {
+                const char LiteralChar = SqlText[Index++];
+                if ((LiteralChar == 'e' || LiteralChar == 'E') && Index + 1 < SqlText.size() && (SqlText[Index] == '+' || SqlText[Index] == '-') && std::isdigit(static_cast<unsigned char>(SqlText[Index + 1])))
+                    ++Index;
+            }
+            if (!Tokens.empty() && Tokens.back().Kind == TokenKind::Punct && Tokens.back().Text == "-" && (Tokens.size() < 2 || Tokens[Tokens.size() - 2].Kind == TokenKind::Punct))
+                Tokens.pop_back();
+            Tokens.push_back({ TokenKind::Placeholder, "?" });
+        }
+        else if (IsWordChar(CurrentChar) || CurrentChar == '@')
+        {
+            const std::size_t WordStart = Index;
+            while (Index < SqlText.size() && SqlText[Index] == '@')
+                ++Index;
+            while (Index < SqlText.size() && IsWordChar(SqlText[Index]))
+                ++Index;
+            const std::string_view Word = SqlText.substr(WordStart, Index - WordStart);
+            const bool IsPrefixedLiteral = Index < SqlText.size() && SqlText[Index] == '\'' && (Word.size() == 1 ? std::string_view{ "xXbBnN" }.find(Word[0]) != std::string_view::npos : Word[0] == '_');
+            if (IsPrefixedLiteral)
+            {
+                Index = SkipQuoted(SqlText, Index);
+                Tokens.push_back({ TokenKind::Placeholder, "?" });
+            }
+            else
+            {
+                std::string UpperWord;
+                UpperWord.reserve(Word.size());
+                std::ranges::transform(Word, std::back_inserter(UpperWord), [](unsigned char CharValue) { return static_cast<char>(std::toupper(CharValue)); });
+                Tokens.push_back({ TokenKind::Word, std::move(UpperWord) });
+            }
+        }
+        else if (CurrentChar == '?')
+        {
+            ++Index;
+            Tokens.push_back({ TokenKind::Placeholder, "?" });
+        }
+        else if (IsOperatorChar(CurrentChar))
+        {
+            const std::size_t OperatorStart = Index;
+            while (Index < SqlText.size() && IsOperatorChar(SqlText[Index]) && SkipComment(SqlText, Index) == Index)
+                ++Index;
+            Tokens.push_back({ TokenKind::Punct, std::string{ SqlText.substr(OperatorStart, Index - OperatorStart) } });
+        }
+        else
+        {
+            ++Index;
+            if (CurrentChar == ')')
+                CollapseValueList(Tokens);
+            Tokens.push_back({ TokenKind::Punct, std::string(1, CurrentChar) });
+            if (CurrentChar == ')')
+                CollapseRepeatedRows(Tokens);
+        }
+        ApproximateLength += Tokens.empty() ? 0 : Tokens.back().Text.size() + 1;
+    }
+    while (!Tokens.empty() && Tokens.back().Kind == TokenKind::Punct && Tokens.back().Text == ";")
+        Tokens.pop_back();
+    std::string NormalizedText;
+    NormalizedText.reserve(ApproximateLength);
+    for (std::size_t TokenIndex = 0; TokenIndex < Tokens.size(); ++TokenIndex)
+    {
+        if (TokenIndex > 0 && NeedsSpace(Tokens[TokenIndex - 1], Tokens[TokenIndex]))
+            NormalizedText += ' ';
+        NormalizedText += Tokens[TokenIndex].Text;
+    }
+    if (Index < SqlText.size())
+        NormalizedText += " ...";
+    return NormalizedText;
+}
+
+auto StatementNormalizer::ComputeDigest(std::string_view SqlText) -> StatementDigest
+{
+    StatementDigest Digest;
+    Digest.NormalizedText = Normalize(SqlText);
+    Digest.Hash = FastHash::Hash64(Digest.NormalizedText);
+    return Digest;
+}
+
+auto StatementNormalizer::IsExplainable(std::string_view SqlText) -> bool
+{
+    std::size_t Index = 0;
+    while (Index < SqlText.size())
+    {
+        if (std::isspace(static_cast<unsigned char>(SqlText[Index])) || SqlText[Index] == '(')
+        {
+            ++Index;
+            continue;
+        }
+        if (const std::size_t CommentEnd = SkipComment(SqlText, Index); CommentEnd != Index)
+        {
+            Index = CommentEnd;
+            continue;
+        }
+        break;
+    }
+    std::size_t WordEnd = Index;
+    while (WordEnd < SqlText.size() && IsWordChar(SqlText[WordEnd]))
+        ++WordEnd;
+    std::string Keyword;
+    std::ranges::transform(SqlText.substr(Index, WordEnd - Index), std::back_inserter(Keyword), [](unsigned char CharValue) { return static_cast<char>(std::toupper(CharValue)); });
+    constexpr std::array<std::string_view, 7> ExplainableKeywords = { "SELECT", "INSERT", "UPDATE", "DELETE", "REPLACE", "TABLE", "WITH" };
+    return std::ranges::find(ExplainableKeywords, Keyword) != ExplainableKeywords.end();
+}
+
+DigestTable::DigestTable(std::size_t MaxEntries) : MaxEntriesPerShard((std::max)(std::size_t{ 1 }, (MaxEntries + ShardCount - 1) / ShardCount))
+{
+    Overflow.NormalizedText = "(摘要表已满)";
+}
+
+auto DigestTable::Accumulate(DigestSummary& Entry, std::chrono::nanoseconds Latency, uint64_t RowsSent, uint64_t RowsAffected, bool IsSuccess, std::chrono::system_clock::time_point Now) noexcept -> void
+{
+    if (Entry.ExecutionCount == 0 && Entry.ErrorCount == 0)
+        Entry.FirstSeen = Now;
+    Entry.LastSeen = Now;
+    ++Entry.ExecutionCount;
+    if (!IsSuccess)
+        ++Entry.ErrorCount;
+    Entry.TotalLatency += Latency;
+    Entry.MaxLatency = (std::max)(Entry.MaxLatency, Latency);
+    Entry.RowsSent += RowsSent;
+    Entry.RowsAffected += RowsAffected;
+}
+
+auto DigestTable::Record(std::string_view SqlText, std::chrono::nanoseconds Latency, uint64_t RowsSent, uint64_t RowsAffected, bool IsSuccess) -> StatementDigest
+{
+    StatementDigest Digest = StatementNormalizer::ComputeDigest(SqlText);
+    Record(Digest, SqlText, Latency, RowsSent, RowsAffected, IsSuccess);
+    return Digest;
+}
+
+auto DigestTable::Record(const StatementDigest& Digest, std::string_view SqlText, std::chrono::nanoseconds Latency, uint64_t RowsSent, uint64_t RowsAffected, bool IsSuccess) -> void
+{
+    const auto Now = std::chrono::system_clock::now();
+    Shard& TargetShard = Shards[Digest.Hash % ShardCount];
+    {
+        std::lock_guard<std::mutex> Lock(TargetShard.ShardMutex);
+        auto EntryPosition = TargetShard.Entries.find(Digest.Hash);
+        if (EntryPosition == TargetShard.Entries.end() && TargetShard.Entries.size() < MaxEntriesPerShard)
+        {
+            DigestSummary NewEntry;
+            NewEntry.Hash = Digest.Hash;
+            NewEntry.NormalizedText = Digest.NormalizedText;
+            NewEntry.SampleQuery = std::string{ SqlText.substr(0, MaxSampleLength) };
+            EntryPosition = TargetShard.Entries.emplace(Digest.Hash, std::move(NewEntry)).first;
+        }
+        if (EntryPosition != TargetShard.Entries.end())
+        {
+            Accumulate(EntryPosition->second, Latency, RowsSent, RowsAffected, IsSuccess, Now);
+            return;
+        }
+    }
+    std::lock_guard<std::mutex> Lock(OverflowMutex);
+    Accumulate(Overflow, Latency, RowsSent, RowsAffected, IsSuccess, Now);
+}
+
+auto DigestTable::GetTop(std::size_t Count, DigestSortKey SortKey) -> std::vector<DigestSummary>
+{
+    std::vector<DigestSummary> Summaries;
+    for (auto& SourceShard : Shards)
+    {
+        std::lock_guard<std::mutex> Lock(SourceShard.ShardMutex);
+        for (const auto& [Hash, Entry] : SourceShard.Entries)
+            Summaries.push_back(Entry);
+    }
+    const auto SortValue = [SortKey](const DigestSummary& Entry) -> uint64_t
+        {
+            switch (SortKey)
+            {
+            case DigestSortKey::ExecutionCount: return Entry.ExecutionCount;
+            case DigestSortKey::MaxLatency: return static_cast<uint64_t>(Entry.MaxLatency.count());
+            case DigestSortKey::RowsSent: return Entry.RowsSent;
+            default: return static_cast<uint64_t>(Entry.TotalLatency.count());
+            }
+        };
+    const std::size_t ResultCount = (std::min)(Count, Summaries.size());
+    std::partial_sort(Summaries.begin(), Summaries.begin() + ResultCount, Summaries.end(), [&SortValue](const DigestSummary& Left, const DigestSummary& Right) { return SortValue(Left) > SortValue(Right); });
+    Summaries.resize(ResultCount);
+    return Summaries;
+}
+
+auto DigestTable::GetOverflow() -> DigestSummary
+{
+    std::lock_guard<std::mutex> Lock(OverflowMutex);
+    return Overflow;
+}
+
+auto DigestTable::Size() -> std::size_t
+{
+    std::size_t TotalSize = 0;
+    for (auto& SourceShard : Shards)
+    {
+        std::lock_guard<std::mutex> Lock(SourceShard.ShardMutex);
+        TotalSize += SourceShard.Entries.size();
+    }
+    return TotalSize;
+}
+
+auto DigestTable::Reset() -> void
+{
+    for (auto& TargetShard : Shards)
+    {
+        std::lock_guard<std::mutex> Lock(TargetShard.ShardMutex);
+        TargetShard.Entries.clear();
+    }
+    std::lock_guard<std::mutex> Lock(OverflowMutex);
+    const std::string OverflowText = std::move(Overflow.NormalizedText);
+    Overflow = DigestSummary{};
+    Overflow.NormalizedText = OverflowText;
+}
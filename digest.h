@@ -0,0 +1,95 @@
+#pragma once
+#include "def.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct StatementDigest
+{
+    uint64_t Hash = 0;
+    std::string NormalizedText;
+    [[nodiscard]] auto ToHex() const -> std::string;
+};
+
+class StatementNormalizer
+{
+public:
+    static constexpr std::size_t MaxNormalizedLength = 1024;
+    [[nodiscard]] static auto Normalize(std::string_view SqlText) -> std::string;
+    [[nodiscard]] static auto ComputeDigest(std::string_view SqlText) -> StatementDigest;
+    [[nodiscard]] static auto IsExplainable(std::string_view SqlText) -> bool;
+};
+
+struct DigestSummary
+{
+    uint64_t Hash = 0;
+    std::string NormalizedText;
+    std::string SampleQuery;
+    uint64_t ExecutionCount = 0;
+    uint64_t ErrorCount = 0;
+    std::chrono::nanoseconds TotalLatency{ 0 };
+    std::chrono::nanoseconds MaxLatency{ 0 };
+    uint64_t RowsSent = 0;
+    uint64_t RowsAffected = 0;
+    std::chrono::system_clock::time_point FirstSeen;
+    std::chrono::system_clock::time_point LastSeen;
+    [[nodiscard]] auto AverageLatency() const noexcept -> std::chrono::nanoseconds
+    {
+        return ExecutionCount > 0 ? TotalLatency / static_cast<std::chrono::nanoseconds::rep>(ExecutionCount) : std::chrono::nanoseconds{ 0 };
+    }
+};
+
+enum class DigestSortKey
+{
+    TotalLatency,
+    ExecutionCount,
+    MaxLatency,
+    RowsSent
+};
+
+// 按摘要哈希分片加锁；条目数达到上限后，新出现的语句形态统一计入溢出条目，不做淘汰。
+class DigestTable
+{
+private:
+    static constexpr std::size_t ShardCount = 16;
+    static constexpr std::size_t MaxSampleLength = 512;
+    struct alignas(64) Shard
+    {
+        std::mutex ShardMutex;
+        std::unordered_map<uint64_t, DigestSummary> Entries;
+    };
+    std::array<Shard, ShardCount> Shards;
+    std::size_t MaxEntriesPerShard;
+    std::mutex OverflowMutex;
+    DigestSummary Overflow;
+    static auto Accumulate(DigestSummary& Entry, std::chrono::nanoseconds Latency, uint64_t RowsSent, uint64_t RowsAffected, bool IsSuccess, std::chrono::system_clock::time_point Now) noexcept -> void;
+public:
+    explicit DigestTable(std::size_t MaxEntries = 1000);
+    auto Record(std::string_view SqlText, std::chrono::nanoseconds Latency, uint64_t RowsSent, uint64_t RowsAffected, bool IsSuccess) -> StatementDigest;
+    auto Record(const StatementDigest& Digest, std::string_view SqlText, std::chrono::nanoseconds Latency, uint64_t RowsSent, uint64_t RowsAffected, bool IsSuccess) -> void;
+    [[nodiscard]] auto GetTop(std::size_t Count, DigestSortKey SortKey = DigestSortKey::TotalLatency) -> std::vector<DigestSummary>;
+    [[nodiscard]] auto GetOverflow() -> DigestSummary;
+    [[nodiscard]] auto Size() -> std::size_t;
+    auto Reset() -> void;
+};
+
+struct SlowQueryRecord
+{
+    std::chrono::system_clock::time_point Timestamp;
+    std::string SqlText;
+    StatementDigest Digest;
+    std::chrono::nanoseconds Latency{ 0 };
+    uint64_t RowsSent = 0;
+    uint64_t RowsAffected = 0;
+    // 执行计划由后台线程获取，取到之前为 true
+    bool IsExplainPending = false;
+    std::string ExplainJson;
+    std::string ExplainError;
+    uint64_t Id = 0;
+};
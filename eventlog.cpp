@@ -0,0 +1,275 @@
+#include "eventlog.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+namespace
+{
+    [[nodiscard]] auto CurrentThreadId() noexcept -> uint32_t
+    {
+        static std::atomic<uint32_t> NextThreadId{ 1 };
+        thread_local const uint32_t ThreadId = NextThreadId.fetch_add(1, std::memory_order_relaxed);
+        return ThreadId;
+    }
+
+    struct RingHolder
+    {
+        std::shared_ptr<EventRing> Ring;
+        ~RingHolder()
+        {
+            if (Ring)
+                Ring->IsAbandoned.store(true, std::memory_order_release);
+        }
+    };
+}
+
+auto TimestampCache::Format(std::chrono::system_clock::time_point TimePoint, std::string& Output) -> void
+{
+    const std::time_t TimeT = std::chrono::system_clock::to_time_t(TimePoint);
+    const auto Milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(TimePoint.time_since_epoch()).count() % 1000;
+    if (TimeT != CachedSecond)
+    {
+        std::tm LocalTime{};
+#ifdef _WIN32
+        localtime_s(&LocalTime, &TimeT);
+#else
+        localtime_r(&TimeT, &LocalTime);
+#endif
+        CachedLength = std::strftime(CachedPrefix.data(), CachedPrefix.size(), "[%Y-%m-%d %H:%M:%S", &LocalTime);
+        CachedSecond = TimeT;
+    }
+    Output.append(CachedPrefix.data(), CachedLength);
+    const auto MillisecondValue = static_cast<int>(Milliseconds < 0 ? Milliseconds + 1000 : Milliseconds);
+    const char Suffix[] = { '.', static_cast<char>('0' + MillisecondValue / 100), static_cast<char>('0' + MillisecondValue / 10 % 10), static_cast<char>('0' + MillisecondValue % 10), ']' };
+    Output.append(Suffix, sizeof(Suffix));
+}
+
+auto EventRing::TryPush(std::span<const EventRecord> Batch) noexcept -> bool
+{
+    const std::size_t CurrentTail = Tail.load(std::memory_order_relaxed);
+    const std::size_t CurrentHead = Head.load(std::memory_order_acquire);
+    if (Capacity - (CurrentTail - CurrentHead) < Batch.size()) [[unlikely]]
+        return false;
+    for (std::size_t Index = 0; Index < Batch.size(); ++Index)
+        Records[(CurrentTail + Index) & (Capacity - 1)] = Batch[Index];
+    Tail.store(CurrentTail + Batch.size(), std::memory_order_release);
+    return true;
+}
+
+auto EventRing::TryPop(EventRecord& Output) noexcept -> bool
+{
+    const std::size_t CurrentHead = Head.load(std::memory_order_relaxed);
+    if (CurrentHead == Tail.load(std::memory_order_acquire))
+        return false;
+    Output = Records[CurrentHead & (Capacity - 1)];
+    Head.store(CurrentHead + 1, std::memory_order_release);
+    return true;
+}
+
+EventLogger::EventLogger()
+{
+    DrainThread = std::jthread([this](std::stop_token StopToken) { DrainLoop(StopToken); });
+}
+
+EventLogger::~EventLogger()
+{
+    DrainThread.request_stop();
+    WakeCondition.notify_all();
+    if (DrainThread.joinable())
+        DrainThread.join();
+}
+
+auto EventLogger::Instance() -> EventLogger&
+{
+    static EventLogger LoggerInstance;
+    return LoggerInstance;
+}
+
+auto EventLogger::LocalRing() -> EventRing*
+{
+    thread_local RingHolder Holder;
+    if (!Holder.Ring) [[unlikely]]
+    {
+        auto NewRing = std::make_shared<EventRing>();
+        std::lock_guard<std::mutex> Lock(RingsMutex);
+        Rings.push_back(NewRing);
+        Holder.Ring = std::move(NewRing);
+    }
+    return Holder.Ring.get();
+}
+
+auto EventLogger::Emit(EventLevel Level, EventCode Code, uint64_t Source, std::string_view Text, int64_t Argument0, int64_t Argument1) noexcept -> void
+{
+    try
+    {
+        static constexpr std::size_t MaxChunks = EventRing::Capacity / 4;
+        static constexpr std::size_t MaxTextBytes = MaxChunks * EventRecord::InlineTextSize;
+        // "…(已截断 N 字节)" 的最大长度
+        static constexpr std::size_t MaxTruncationMarkerBytes = 48;
+        thread_local std::vector<EventRecord> Batch;
+        thread_local std::string TruncatedText;
+        if (Text.size() > MaxTextBytes) [[unlikely]]
+        {
+            // 超长文本保留开头（不拆开 UTF-8 字符）并在末尾标明截掉的字节数，截掉部分按所需的记录数计入丢弃计数
+            std::size_t KeptBytes = MaxTextBytes - MaxTruncationMarkerBytes;
+            while (KeptBytes > 0 && (static_cast<unsigned char>(Text[KeptBytes]) & 0xC0) == 0x80)
+                --KeptBytes;
+            TruncatedText.assign(Text.substr(0, KeptBytes));
+            TruncatedText += std::format("…(已截断 {} 字节)", Text.size() - KeptBytes);
+            DroppedRecords.fetch_add((Text.size() - MaxTextBytes + EventRecord::InlineTextSize - 1) / EventRecord::InlineTextSize, std::memory_order_relaxed);
+            Text = TruncatedText;
+        }
+        const std::size_t ChunkCount = std::clamp<std::size_t>((Text.size() + EventRecord::InlineTextSize - 1) / EventRecord::InlineTextSize, 1, MaxChunks);
+        Batch.resize(ChunkCount);
+        const int64_t Timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        for (std::size_t ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+        {
+            EventRecord& Record = Batch[ChunkIndex];
+            Record.Timestamp = Timestamp;
+            Record.Source = Source;
+            Record.Arguments = { Argument0, Argument1 };
+            Record.ThreadId = CurrentThreadId();
+            Record.Code = Code;
+            Record.Level = Level;
+            Record.Flags = ChunkIndex + 1 < ChunkCount ? EventRecord::HasMoreFlag : 0;
+            const std::string_view Chunk = Text.substr((std::min)(Text.size(), ChunkIndex * EventRecord::InlineTextSize), EventRecord::InlineTextSize);
+            Record.TextLength = static_cast<uint16_t>(Chunk.size());
+            std::memcpy(Record.Text.data(), Chunk.data(), Chunk.size());
+        }
+        if (!LocalRing()->TryPush(Batch)) [[unlikely]]
+            DroppedRecords.fetch_add(ChunkCount, std::memory_order_relaxed);
+        else if (Level >= EventLevel::Error)
+            WakeCondition.notify_one();
+    }
+    catch (...)
+    {
+        DroppedRecords.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+auto EventLogger::AddSink(SinkFunction Callback, uint64_t SourceFilter) -> SinkId
+{
+    std::lock_guard<std::mutex> Lock(SinksMutex);
+    const SinkId Id = NextSinkId++;
+    Sinks.push_back({ Id, SourceFilter, std::move(Callback) });
+    return Id;
+}
+
+auto EventLogger::RemoveSink(SinkId Id) -> void
+{
+    std::lock_guard<std::mutex> Lock(SinksMutex);
+    std::erase_if(Sinks, [Id](const SinkEntry& Entry) { return Entry.Id == Id; });
+}
+
+auto EventLogger::SetMinLevel(EventLevel Level) noexcept -> void
+{
+    RuntimeMinLevel.store((std::max)(Level, CompiledMinEventLevel), std::memory_order_relaxed);
+}
+
+auto EventLogger::Flush() -> void
+{
+    std::lock_guard<std::mutex> Lock(DrainMutex);
+    while (DrainOnce()) { }
+}
+
+auto EventLogger::DrainLoop(std::stop_token StopToken) -> void
+{
+    while (!StopToken.stop_requested())
+    {
+        bool HasDrained = false;
+        {
+            std::lock_guard<std::mutex> Lock(DrainMutex);
+            HasDrained = DrainOnce();
+        }
+        if (!HasDrained)
+        {
+            std::unique_lock<std::mutex> Lock(WakeMutex);
+            WakeCondition.wait_for(Lock, std::chrono::milliseconds(5));
+        }
+    }
+    Flush();
+}
+
+auto EventLogger::DrainOnce() -> bool
+{
+    std::vector<std::shared_ptr<EventRing>> Snapshot;
+    {
+        std::lock_guard<std::mutex> Lock(RingsMutex);
+        Snapshot = Rings;
+    }
+    bool HasDrained = false;
+    EventRecord Record;
+    for (const auto& Ring : Snapshot)
+    {
+        // 多块消息整批入队，其余块已在环中：读到消息末尾之前不因单轮上限停下，拼接的文本也不会跨环
+        std::string PendingText;
+        bool HasMore = false;
+        for (std::size_t Popped = 0; (Popped < EventRing::Capacity || HasMore) && Ring->TryPop(Record); ++Popped)
+        {
+            HasDrained = true;
+            PendingText.append(Record.Text.data(), Record.TextLength);
+            HasMore = (Record.Flags & EventRecord::HasMoreFlag) != 0;
+            if (HasMore)
+                continue;
+            Deliver(Record, PendingText);
+            PendingText.clear();
+        }
+    }
+    std::lock_guard<std::mutex> Lock(RingsMutex);
+    std::erase_if(Rings, [](const std::shared_ptr<EventRing>& Ring) { return Ring->IsAbandoned.load(std::memory_order_acquire) && Ring->IsEmpty(); });
+    return HasDrained;
+}
+
+auto EventLogger::Deliver(const EventRecord& Record, std::string_view Text) -> void
+{
+    std::lock_guard<std::mutex> Lock(SinksMutex);
+    if (Sinks.empty())
+        return;
+    const std::string Message = FormatEventMessage(Record, Text);
+    DrainLineBuffer.clear();
+    DrainTimestampCache.Format(std::chrono::system_clock::time_point{ std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{ Record.Timestamp }) }, DrainLineBuffer);
+    DrainLineBuffer += std::format(" [{}] {}", LevelName(Record.Level), Message);
+    const EventEntry Entry{ Record, Message, DrainLineBuffer };
+    for (const auto& Sink : Sinks)
+    {
+        if (Sink.SourceFilter != 0 && Sink.SourceFilter != Record.Source)
+            continue;
+        try
+        {
+            Sink.Callback(Entry);
+        }
+        catch (...) { }
+    }
+}
+
+auto EventLogger::LevelName(EventLevel Level) noexcept -> std::string_view
+{
+    switch (Level)
+    {
+    case EventLevel::Trace: return "TRACE";
+    case EventLevel::Debug: return "DEBUG";
+    case EventLevel::Info: return "INFO";
+    case EventLevel::Warning: return "WARN";
+    case EventLevel::Error: return "ERROR";
+    default: return "OFF";
+    }
+}
+
+auto EventLogger::FormatEventMessage(const EventRecord& Record, std::string_view Text) -> std::string
+{
+    switch (Record.Code)
+    {
+    case EventCode::Error: return std::format("错误: {}", Text);
+    case EventCode::Connected: return std::format("已连接到 {}:{}", Text, Record.Arguments[0]);
+    case EventCode::Disconnected: return "已断开数据库连接";
+    case EventCode::Reconnecting: return "尝试重新连接...";
+    case EventCode::TransactionBegin: return "事务已开始";
+    case EventCode::TransactionCommit: return "事务已提交";
+    case EventCode::TransactionRollback: return "事务已回滚";
+    case EventCode::QueryInterrupted: return std::format("已中断连接 {} 上的语句（{}）", Record.Arguments[0], Text);
+    case EventCode::CircuitChanged: return std::format("端点熔断状态变化: {}", Text);
+    case EventCode::Deadlock: return std::format("检测到死锁: {}", Text);
+    case EventCode::Retrying: return std::format("第 {} 次重试，{} ms 后执行: {}", Record.Arguments[0], Record.Arguments[1], Text);
+    default: return std::string{ Text };
+    }
+}
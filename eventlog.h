@@ -0,0 +1,166 @@
+#pragma once
+#include "def.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class EventLevel : uint8_t
+{
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+#ifndef FLUENT_EVENTLOG_MIN_LEVEL
+#define FLUENT_EVENTLOG_MIN_LEVEL 1
+#endif
+
+inline constexpr EventLevel CompiledMinEventLevel = static_cast<EventLevel>(FLUENT_EVENTLOG_MIN_LEVEL);
+
+enum class EventCode : uint16_t
+{
+    Message,
+    Error,
+    Connected,
+    Disconnected,
+    Reconnecting,
+    TransactionBegin,
+    TransactionCommit,
+    TransactionRollback,
+    SlowQuery,
+    QueryInterrupted,
+    CircuitChanged,
+    Deadlock,
+    Retrying
+};
+
+struct EventRecord
+{
+    static constexpr std::size_t InlineTextSize = 208;
+    static constexpr uint8_t HasMoreFlag = 0x01;
+    int64_t Timestamp = 0;
+    uint64_t Source = 0;
+    std::array<int64_t, 2> Arguments{};
+    uint32_t ThreadId = 0;
+    EventCode Code = EventCode::Message;
+    EventLevel Level = EventLevel::Info;
+    uint8_t Flags = 0;
+    uint16_t TextLength = 0;
+    std::array<char, InlineTextSize> Text{};
+};
+
+static_assert(sizeof(EventRecord) == 256, "EventRecord 应保持定长 256 字节");
+
+class TimestampCache
+{
+private:
+    std::time_t CachedSecond = -1;
+    std::array<char, 32> CachedPrefix{};
+    std::size_t CachedLength = 0;
+public:
+    auto Format(std::chrono::system_clock::time_point TimePoint, std::string& Output) -> void;
+};
+
+struct EventEntry
+{
+    const EventRecord& Record;
+    std::string_view Message;
+    std::string_view FormattedLine;
+};
+
+// 每个线程一个单生产者/单消费者环形缓冲区；写满时直接丢弃并计数，写入方永不阻塞。
+class EventRing
+{
+public:
+    static constexpr std::size_t Capacity = 512;
+private:
+    std::array<EventRecord, Capacity> Records;
+    alignas(64) std::atomic<std::size_t> Head{ 0 };
+    alignas(64) std::atomic<std::size_t> Tail{ 0 };
+public:
+    std::atomic<bool> IsAbandoned{ false };
+    [[nodiscard]] auto TryPush(std::span<const EventRecord> Batch) noexcept -> bool;
+    [[nodiscard]] auto TryPop(EventRecord& Output) noexcept -> bool;
+    [[nodiscard]] auto IsEmpty() const noexcept -> bool
+    {
+        return Head.load(std::memory_order_acquire) == Tail.load(std::memory_order_acquire);
+    }
+};
+
+class EventLogger
+{
+public:
+    using SinkFunction = std::function<void(const EventEntry&)>;
+    using SinkId = uint64_t;
+private:
+    struct SinkEntry
+    {
+        SinkId Id;
+        uint64_t SourceFilter;
+        SinkFunction Callback;
+    };
+    std::mutex RingsMutex;
+    std::vector<std::shared_ptr<EventRing>> Rings;
+    std::mutex SinksMutex;
+    std::vector<SinkEntry> Sinks;
+    SinkId NextSinkId = 1;
+    std::atomic<EventLevel> RuntimeMinLevel{ CompiledMinEventLevel };
+    std::atomic<uint64_t> DroppedRecords{ 0 };
+    std::mutex DrainMutex;
+    TimestampCache DrainTimestampCache;
+    std::string DrainLineBuffer;
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    std::jthread DrainThread;
+    EventLogger();
+    [[nodiscard]] auto LocalRing() -> EventRing*;
+    auto DrainLoop(std::stop_token StopToken) -> void;
+    auto DrainOnce() -> bool;
+    auto Deliver(const EventRecord& Record, std::string_view Text) -> void;
+public:
+    ~EventLogger();
+    EventLogger(const EventLogger&) = delete;
+    auto operator=(const EventLogger&) -> EventLogger & = delete;
+    [[nodiscard]] static auto Instance() -> EventLogger&;
+    auto Emit(EventLevel Level, EventCode Code, uint64_t Source, std::string_view Text, int64_t Argument0 = 0, int64_t Argument1 = 0) noexcept -> void;
+    auto AddSink(SinkFunction Callback, uint64_t SourceFilter = 0) -> SinkId;
+    auto RemoveSink(SinkId Id) -> void;
+    auto SetMinLevel(EventLevel Level) noexcept -> void;
+    [[nodiscard]] auto IsEnabled(EventLevel Level) const noexcept -> bool
+    {
+        return Level >= RuntimeMinLevel.load(std::memory_order_relaxed);
+    }
+    // 缓冲区满时丢弃的记录数，也包括超长文本被截掉的部分按 InlineTextSize 折算的记录数
+    [[nodiscard]] auto GetDroppedCount() const noexcept -> uint64_t
+    {
+        return DroppedRecords.load(std::memory_order_relaxed);
+    }
+    auto Flush() -> void;
+    [[nodiscard]] static auto LevelName(EventLevel Level) noexcept -> std::string_view;
+    [[nodiscard]] static auto FormatEventMessage(const EventRecord& Record, std::string_view Text) -> std::string;
+};
+
+template<EventLevel Level>
+inline auto EmitEvent(EventCode Code, uint64_t Source, std::string_view Text, int64_t Argument0 = 0, int64_t Argument1 = 0) noexcept -> void
+{
+    if constexpr (Level >= CompiledMinEventLevel)
+    {
+        EventLogger& Logger = EventLogger::Instance();
+        if (Logger.IsEnabled(Level))
+            Logger.Emit(Level, Code, Source, Text, Argument0, Argument1);
+    }
+}
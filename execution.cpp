@@ -0,0 +1,159 @@
+#include "execution.h"
+#include <algorithm>
+#include <format>
+
+ExecutionController::ExecutionController(MySQLWrapper& ConnectionRef, NotifyCallback NotifyFunc, ExecutionOptions OptionsParam) : Connection(ConnectionRef), Options(OptionsParam), Notify(std::move(NotifyFunc))
+{
+}
+
+ExecutionController::~ExecutionController()
+{
+    Cancel();
+    Wait();
+}
+
+auto ExecutionController::Submit(std::vector<std::string> Statements) -> std::expected<uint64_t, std::string>
+{
+    if (Statements.empty()) [[unlikely]]
+        return std::unexpected("没有可执行的语句");
+    if (IsRunning.load(std::memory_order_acquire))
+        return std::unexpected("上一批语句仍在执行");
+    // 上一批已经结束，工作线程只剩退出
+    Wait();
+    IsCancelRequested.store(false, std::memory_order_relaxed);
+    IsRunning.store(true, std::memory_order_release);
+    const uint64_t BatchId = NextBatchId++;
+    Worker = std::jthread([this, BatchId, Statements = std::move(Statements)]() mutable { RunBatch(BatchId, std::move(Statements)); });
+    return BatchId;
+}
+
+auto ExecutionController::Cancel() -> bool
+{
+    if (!IsRunning.load(std::memory_order_acquire))
+        return false;
+    IsCancelRequested.store(true, std::memory_order_relaxed);
+    // 语句之间没有正在执行的查询时 KILL 不会发送，由标志跳过其余语句
+    (void)Connection.Cancel();
+    return true;
+}
+
+auto ExecutionController::Wait() -> void
+{
+    if (Worker.joinable())
+        Worker.join();
+}
+
+auto ExecutionController::Drain() -> std::vector<ExecutionEvent>
+{
+    std::lock_guard<std::mutex> Lock(QueueMutex);
+    std::vector<ExecutionEvent> Drained(std::make_move_iterator(Events.begin()), std::make_move_iterator(Events.end()));
+    Events.clear();
+    return Drained;
+}
+
+auto ExecutionController::Push(ExecutionEvent Event) -> void
+{
+    bool WasEmpty = false;
+    {
+        std::lock_guard<std::mutex> Lock(QueueMutex);
+        // 界面来不及取走时只保留最新的行数，队列长度不随读取的行数增长
+        if (Event.Kind == ExecutionEventKind::Progress && !Events.empty())
+        {
+            ExecutionEvent& Last = Events.back();
+            if (Last.Kind == ExecutionEventKind::Progress && Last.BatchId == Event.BatchId && Last.StatementIndex == Event.StatementIndex)
+            {
+                Last.RowCount = Event.RowCount;
+                return;
+            }
+        }
+        WasEmpty = Events.empty();
+        Events.push_back(std::move(Event));
+    }
+    if (WasEmpty && Notify)
+        Notify();
+}
+
+auto ExecutionController::RunBatch(uint64_t BatchId, std::vector<std::string> Statements) -> void
+{
+    const auto BatchStart = std::chrono::steady_clock::now();
+    const std::size_t StatementCount = Statements.size();
+    std::size_t StatementIndex = 0;
+    bool IsFirstPageSent = false;
+    auto StatementStart = BatchStart;
+    auto LastProgress = BatchStart;
+    const auto MakeEvent = [&](ExecutionEventKind Kind)
+    {
+        ExecutionEvent Event;
+        Event.Kind = Kind;
+        Event.BatchId = BatchId;
+        Event.StatementIndex = StatementIndex;
+        Event.StatementCount = StatementCount;
+        return Event;
+    };
+    auto Observer = std::make_shared<FetchObserver>();
+    Observer->RowInterval = (std::max)(Options.CheckRows, std::size_t{ 1 });
+    Observer->Callback = [&](const std::vector<std::string>& ColumnNames, const RowStore& Rows) -> bool
+    {
+        if (IsCancelRequested.load(std::memory_order_relaxed))
+            return false;
+        if (Rows.empty())
+        {
+            ExecutionEvent Event = MakeEvent(ExecutionEventKind::ResultStarted);
+            Event.ColumnNames = ColumnNames;
+            Push(std::move(Event));
+            return true;
+        }
+        const auto Now = std::chrono::steady_clock::now();
+        if (!IsFirstPageSent && (Rows.size() >= Options.FirstPageRows || Now - StatementStart >= Options.ProgressInterval))
+        {
+            ExecutionEvent Event = MakeEvent(ExecutionEventKind::FirstPage);
+            Event.ColumnNames = ColumnNames;
+            const std::size_t PageRows = (std::min)(Rows.size(), Options.FirstPageRows);
+            Event.FirstRows.reserve(PageRows);
+            for (std::size_t Row = 0; Row < PageRows; ++Row)
+                Event.FirstRows.push_back(Rows[Row]);
+            Event.RowCount = Rows.size();
+            Push(std::move(Event));
+            IsFirstPageSent = true;
+            LastProgress = Now;
+            return true;
+        }
+        if (Now - LastProgress >= Options.ProgressInterval)
+        {
+            ExecutionEvent Event = MakeEvent(ExecutionEventKind::Progress);
+            Event.RowCount = Rows.size();
+            Push(std::move(Event));
+            LastProgress = Now;
+        }
+        return true;
+    };
+    Connection.SetFetchObserver(Observer);
+    try
+    {
+        for (; StatementIndex < StatementCount && !IsCancelRequested.load(std::memory_order_relaxed); ++StatementIndex)
+        {
+            IsFirstPageSent = false;
+            StatementStart = LastProgress = std::chrono::steady_clock::now();
+            MySQLResult ResultData = Connection.Query(Statements[StatementIndex]);
+            ExecutionEvent Event = MakeEvent(ExecutionEventKind::StatementFinished);
+            Event.RowCount = ResultData.Rows.size();
+            Event.Result = std::make_shared<const MySQLResult>(std::move(ResultData));
+            Push(std::move(Event));
+        }
+    }
+    catch (const std::exception& Exception)
+    {
+        MySQLResult ResultData;
+        ResultData.ErrorMessage = std::format("执行异常: {}", Exception.what());
+        ExecutionEvent Event = MakeEvent(ExecutionEventKind::StatementFinished);
+        Event.Result = std::make_shared<const MySQLResult>(std::move(ResultData));
+        Push(std::move(Event));
+    }
+    Connection.SetFetchObserver(nullptr);
+    ExecutionEvent Event = MakeEvent(ExecutionEventKind::BatchFinished);
+    Event.IsCancelled = IsCancelRequested.load(std::memory_order_relaxed);
+    Event.Elapsed = std::chrono::steady_clock::now() - BatchStart;
+    // 先清除忙碌标志：界面收到 BatchFinished 时可以立即提交下一批
+    IsRunning.store(false, std::memory_order_release);
+    Push(std::move(Event));
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ExecutionEventKind : uint8_t
+{
+    // 结果集的列已确定
+    ResultStarted,
+    // 结果集的前若干行，语句仍在读取
+    FirstPage,
+    // 已读取的行数；队列中未取走的同一语句的进度会合并为一条
+    Progress,
+    StatementFinished,
+    BatchFinished
+};
+
+struct ExecutionEvent
+{
+    ExecutionEventKind Kind = ExecutionEventKind::Progress;
+    uint64_t BatchId = 0;
+    std::size_t StatementIndex = 0;
+    std::size_t StatementCount = 0;
+    // ResultStarted 与 FirstPage 携带列名，FirstPage 携带前 FirstPageRows 行的副本
+    std::vector<std::string> ColumnNames;
+    std::vector<MySQLRow> FirstRows;
+    std::size_t RowCount = 0;
+    // StatementFinished 携带完整结果
+    std::shared_ptr<const MySQLResult> Result;
+    // BatchFinished：是否因取消而提前结束，以及整批耗时
+    bool IsCancelled = false;
+    std::chrono::nanoseconds Elapsed{ 0 };
+};
+
+struct ExecutionOptions
+{
+    // 读到这么多行（或距语句开始超过 ProgressInterval 且已有行）时先交出第一页
+    std::size_t FirstPageRows = 200;
+    // 行数进度的最短间隔
+    std::chrono::milliseconds ProgressInterval{ 100 };
+    // 读取循环每隔多少行检查一次进度与取消
+    std::size_t CheckRows = 64;
+};
+
+// 在工作线程上依次执行一批语句，把结果按读取进度分段放入线程安全的事件队列：列名、第一页、行数进度、完整结果。
+// 读取由连接的 FetchObserver 驱动，第一页在语句读完之前就能交给界面。
+// 队列由空变为非空时调用 Notify（在工作线程上），使用方随后用 Drain 取走全部事件；同一时间只执行一批。
+class ExecutionController
+{
+public:
+    using NotifyCallback = std::function<void()>;
+private:
+    MySQLWrapper& Connection;
+    ExecutionOptions Options;
+    NotifyCallback Notify;
+    std::mutex QueueMutex;
+    std::deque<ExecutionEvent> Events;
+    std::atomic<bool> IsCancelRequested{ false };
+    std::atomic<bool> IsRunning{ false };
+    uint64_t NextBatchId = 1;
+    std::jthread Worker;
+    auto RunBatch(uint64_t BatchId, std::vector<std::string> Statements) -> void;
+    auto Push(ExecutionEvent Event) -> void;
+public:
+    ExecutionController(MySQLWrapper& ConnectionRef, NotifyCallback NotifyFunc, ExecutionOptions OptionsParam = {});
+    ~ExecutionController();
+    ExecutionController(const ExecutionController&) = delete;
+    auto operator=(const ExecutionController&) -> ExecutionController & = delete;
+    // 返回批次号；上一批仍在执行时返回错误
+    [[nodiscard]] auto Submit(std::vector<std::string> Statements) -> std::expected<uint64_t, std::string>;
+    // 中止正在执行的语句（KILL QUERY）并跳过其余语句；没有正在执行的批次时返回 false
+    auto Cancel() -> bool;
+    [[nodiscard]] auto IsBusy() const noexcept -> bool
+    {
+        return IsRunning.load(std::memory_order_acquire);
+    }
+    [[nodiscard]] auto Drain() -> std::vector<ExecutionEvent>;
+    // 等待当前批次结束
+    auto Wait() -> void;
+};
@@ -0,0 +1,469 @@
+#include "exporter.h"
+#include "formatter.hpp"
+#include "pagination.h"
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <thread>
+
+namespace
+{
+    [[nodiscard]] auto EscapeManifestField(std::string_view Field) -> std::string
+    {
+        std::string Escaped;
+        Escaped.reserve(Field.size());
+        for (const char CharValue : Field)
+        {
+            switch (CharValue)
+            {
+            case '\\': Escaped += "\\\\"; break;
+            case '\t': Escaped += "\\t"; break;
+            case '\n': Escaped += "\\n"; break;
+            case '\r': Escaped += "\\r"; break;
+            default: Escaped += CharValue; break;
+            }
+        }
+        return Escaped;
+    }
+
+    [[nodiscard]] auto SplitManifestLine(std::string_view Line) -> std::vector<std::string>
+    {
+        std::vector<std::string> Fields(1);
+        for (std::size_t Index = 0; Index < Line.size(); ++Index)
+        {
+            const char CharValue = Line[Index];
+            if (CharValue == '\t')
+                Fields.emplace_back();
+            else if (CharValue == '\\' && Index + 1 < Line.size())
+            {
+                const char Escaped = Line[++Index];
+                Fields.back() += Escaped == 't' ? '\t' : Escaped == 'n' ? '\n' : Escaped == 'r' ? '\r' : Escaped;
+            }
+            else
+                Fields.back() += CharValue;
+        }
+        return Fields;
+    }
+
+    template<typename T>
+    [[nodiscard]] auto ParseNumber(std::string_view Text) noexcept -> std::optional<T>
+    {
+        T Value{};
+        const auto [Pointer, ErrorCode] = std::from_chars(Text.data(), Text.data() + Text.size(), Value);
+        if (ErrorCode != std::errc{} || Pointer != Text.data() + Text.size())
+            return std::nullopt;
+        return Value;
+    }
+
+    [[nodiscard]] auto QuoteLiteral(std::string_view Value) -> std::string
+    {
+        return std::format("'{}'", SQLSanitizer::EscapeString(Value));
+    }
+}
+
+ParallelExporter::ParallelExporter(ExportOptions OptionsParam) : Options(std::move(OptionsParam))
+{
+    Options.ConnectionCount = (std::max)(Options.ConnectionCount, std::size_t{ 1 });
+    Options.TargetChunkRows = (std::max)(Options.TargetChunkRows, std::size_t{ 1 });
+    Options.PageRows = (std::max)(Options.PageRows, std::size_t{ 1 });
+}
+
+auto ParallelExporter::PlanTable(MySQLWrapper& Connection, const std::string& TableName) -> std::expected<std::vector<ExportChunk>, std::string>
+{
+    const auto Indexes = Connection.GetTableIndexes(TableName);
+    if (!Indexes)
+        return std::unexpected(std::format("读取表 {} 的索引失败: {}", TableName, Indexes.error()));
+    const auto KeyNameIndex = Indexes->GetColumnIndex("Key_name");
+    const auto ColumnNameIndex = Indexes->GetColumnIndex("Column_name");
+    const auto NonUniqueIndex = Indexes->GetColumnIndex("Non_unique");
+    const auto NullableIndex = Indexes->GetColumnIndex("Null");
+    if (!KeyNameIndex || !ColumnNameIndex || !NonUniqueIndex || !NullableIndex)
+        return std::unexpected(std::format("无法解析表 {} 的索引信息", TableName));
+    // 优先使用主键，其次是所有列都非空的唯一索引；SHOW INDEX 已按索引和列序排列
+    struct UniqueKey
+    {
+        std::string Name;
+        std::vector<std::string> Columns;
+        bool IsNullable = false;
+    };
+    std::vector<UniqueKey> UniqueKeys;
+    for (const auto& IndexRow : Indexes->Rows)
+    {
+        if (IndexRow[*NonUniqueIndex] != "0")
+            continue;
+        if (UniqueKeys.empty() || UniqueKeys.back().Name != IndexRow[*KeyNameIndex])
+            UniqueKeys.push_back({ IndexRow[*KeyNameIndex], {}, false });
+        UniqueKeys.back().Columns.push_back(IndexRow[*ColumnNameIndex]);
+        UniqueKeys.back().IsNullable |= IndexRow[*NullableIndex] == "YES";
+    }
+    std::vector<std::string> KeyColumns;
+    if (const auto Primary = std::ranges::find(UniqueKeys, std::string{ "PRIMARY" }, &UniqueKey::Name); Primary != UniqueKeys.end())
+        KeyColumns = Primary->Columns;
+    else if (const auto NonNull = std::ranges::find(UniqueKeys, false, &UniqueKey::IsNullable); NonNull != UniqueKeys.end())
+        KeyColumns = NonNull->Columns;
+
+    std::vector<ExportChunk> Chunks;
+    const MySQLResult Partitions = Connection.Query(std::format(
+        "SELECT PARTITION_NAME FROM information_schema.PARTITIONS WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = {} "
+        "AND PARTITION_NAME IS NOT NULL GROUP BY PARTITION_NAME ORDER BY MIN(PARTITION_ORDINAL_POSITION)", QuoteLiteral(TableName)));
+    if (!Partitions.Success)
+        return std::unexpected(std::format("读取表 {} 的分区失败: {}", TableName, Partitions.ErrorMessage));
+    if (!Partitions.Rows.empty())
+    {
+        for (const auto& PartitionRow : Partitions.Rows)
+            Chunks.push_back({ TableName, Chunks.size(), PartitionRow[0], {}, KeyColumns });
+        return Chunks;
+    }
+
+    const MySQLResult Estimate = Connection.Query(std::format(
+        "SELECT TABLE_ROWS FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = {}", QuoteLiteral(TableName)));
+    const uint64_t EstimatedRows = Estimate.Success && !Estimate.Rows.empty() ? ParseNumber<uint64_t>(Estimate.Rows[0][0]).value_or(0) : 0;
+    const std::size_t ChunkCount = static_cast<std::size_t>((std::min<uint64_t>)((EstimatedRows + Options.TargetChunkRows - 1) / Options.TargetChunkRows, MaxChunksPerTable));
+    if (KeyColumns.empty() || ChunkCount <= 1)
+    {
+        Chunks.push_back({ TableName, 0, {}, {}, KeyColumns });
+        return Chunks;
+    }
+
+    // 只按首个键列切分：范围条件对复合键同样正确，且能直接利用聚簇索引
+    const std::string LeadColumn = SQLSanitizer::QuoteIdentifier(KeyColumns.front());
+    const std::string QuotedTable = SQLSanitizer::QuoteIdentifier(TableName);
+    std::vector<std::string> Boundaries;
+    const MySQLResult Range = Connection.Query(std::format("SELECT MIN({0}), MAX({0}) FROM {1}", LeadColumn, QuotedTable));
+    if (!Range.Success || Range.Rows.empty() || Range.Rows[0].IsNull(0))
+        return std::unexpected(std::format("读取表 {} 的键范围失败: {}", TableName, Range.ErrorMessage));
+    const auto MinValue = ParseNumber<int64_t>(Range.Rows[0][0]);
+    const auto MaxValue = ParseNumber<int64_t>(Range.Rows[0][1]);
+    if (MinValue && MaxValue)
+    {
+        const uint64_t Span = static_cast<uint64_t>(*MaxValue) - static_cast<uint64_t>(*MinValue);
+        for (std::size_t Index = 1; Index < ChunkCount; ++Index)
+        {
+            const auto Offset = static_cast<uint64_t>(static_cast<long double>(Span) * Index / ChunkCount);
+            Boundaries.push_back(std::to_string(static_cast<int64_t>(static_cast<uint64_t>(*MinValue) + Offset)));
+        }
+    }
+    else
+    {
+        // 非整数键：随机抽样后取分位点作为边界，每块约 SamplesPerChunk 个样本
+        const double Fraction = (std::min)(1.0, static_cast<double>(ChunkCount * SamplesPerChunk) / static_cast<double>((std::max<uint64_t>)(EstimatedRows, 1)));
+        const MySQLResult Sample = Connection.Query(std::format("SELECT {0} FROM {1} WHERE RAND() < {2} ORDER BY {0}", LeadColumn, QuotedTable, Fraction));
+        if (!Sample.Success)
+            return std::unexpected(std::format("抽样表 {} 的键失败: {}", TableName, Sample.ErrorMessage));
+        for (std::size_t Index = 1; Index < ChunkCount && !Sample.Rows.empty(); ++Index)
+            Boundaries.push_back(QuoteLiteral(Sample.Rows[Sample.Rows.size() * Index / ChunkCount][0]));
+    }
+    const auto [DuplicateBegin, DuplicateEnd] = std::ranges::unique(Boundaries);
+    Boundaries.erase(DuplicateBegin, DuplicateEnd);
+    for (std::size_t Index = 0; Index <= Boundaries.size(); ++Index)
+    {
+        std::string Condition;
+        if (Index > 0)
+            Condition = std::format("{} >= {}", LeadColumn, Boundaries[Index - 1]);
+        if (Index < Boundaries.size())
+            Condition += std::format("{}{} < {}", Condition.empty() ? "" : " AND ", LeadColumn, Boundaries[Index]);
+        Chunks.push_back({ TableName, Index, {}, std::move(Condition), KeyColumns });
+    }
+    return Chunks;
+}
+
+auto ParallelExporter::StartSnapshots(MySQLWrapper& Connection, std::vector<std::unique_ptr<Session>>& Sessions, ExportReport& Report) -> std::expected<void, std::string>
+{
+    const auto StartAll = [&Sessions]() -> std::expected<void, std::string>
+    {
+        for (auto& SessionPtr : Sessions)
+        {
+            for (const char* SqlText : { "SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ", "START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY" })
+            {
+                const MySQLResult ResultData = SessionPtr->Execute(SqlText);
+                if (!ResultData.Success)
+                    return std::unexpected(std::format("开启一致性快照失败: {}", ResultData.ErrorMessage));
+            }
+        }
+        return {};
+    };
+    const auto ReadPosition = [&Connection]() -> std::string
+    {
+        const MySQLResult ResultData = Connection.Query("SELECT @@GLOBAL.gtid_executed");
+        return ResultData.Success && !ResultData.Rows.empty() && !ResultData.Rows[0].IsNull(0) ? ResultData.Rows[0][0] : std::string{};
+    };
+    if (Connection.Execute("FLUSH TABLES WITH READ LOCK").Success)
+    {
+        // 持锁期间没有任何提交，各会话的快照必然对应同一时刻
+        auto Started = StartAll();
+        Report.SnapshotPosition = ReadPosition();
+        (void)Connection.Execute("UNLOCK TABLES");
+        return Started;
+    }
+    // 没有 RELOAD 权限时不加锁：开启快照前后 gtid_executed 不变，说明期间没有事务提交
+    Report.IsLockFree = true;
+    for (std::size_t Attempt = 0; Attempt < MaxSnapshotAttempts; ++Attempt)
+    {
+        const std::string PositionBefore = ReadPosition();
+        if (PositionBefore.empty())
+            return std::unexpected("无法获取全局读锁，且服务器未启用 GTID，无法保证各连接的快照一致");
+        if (auto Started = StartAll(); !Started)
+            return Started;
+        const std::string PositionAfter = ReadPosition();
+        if (PositionBefore == PositionAfter)
+        {
+            Report.SnapshotPosition = PositionAfter;
+            return {};
+        }
+        for (auto& SessionPtr : Sessions)
+            (void)SessionPtr->Execute("ROLLBACK");
+    }
+    return std::unexpected(std::format("连续 {} 次未能在无提交的窗口内开启快照", MaxSnapshotAttempts));
+}
+
+auto ParallelExporter::ChunkFilePath(const ExportChunk& Chunk) const -> std::filesystem::path
+{
+    return Options.OutputDirectory / std::format("{}.{:05}.{}", Chunk.TableName, Chunk.ChunkIndex, Options.Format == ExportFormat::Csv ? "csv" : "ndjson");
+}
+
+auto ParallelExporter::ExportChunkData(Session& SessionRef, const ExportChunk& Chunk) -> std::expected<std::pair<uint64_t, uint64_t>, std::string>
+{
+    const std::filesystem::path FilePath = ChunkFilePath(Chunk);
+    std::ofstream OutputFile(FilePath, std::ios::binary | std::ios::trunc);
+    if (!OutputFile)
+        return std::unexpected(std::format("无法创建分块文件 {}", FilePath.string()));
+    const std::string QuotedTable = SQLSanitizer::QuoteIdentifier(Chunk.TableName);
+    const std::string PartitionClause = Chunk.PartitionName.empty() ? std::string{} : std::format(" PARTITION ({})", SQLSanitizer::QuoteIdentifier(Chunk.PartitionName));
+    uint64_t RowCount = 0;
+    uint64_t ByteCount = 0;
+    bool IsFirstPage = true;
+    std::string Buffer;
+    const auto WritePage = [&](const MySQLResult& Page) -> bool
+    {
+        Buffer.clear();
+        if (Options.Format == ExportFormat::Csv)
+            Buffer = FormatCsv(Page, IsFirstPage);
+        else
+        {
+            for (const auto& RowData : Page.Rows)
+            {
+                AppendJsonRow(Buffer, Page.ColumnNames, RowData);
+                Buffer += '\n';
+            }
+        }
+        IsFirstPage = false;
+        OutputFile.write(Buffer.data(), static_cast<std::streamsize>(Buffer.size()));
+        RowCount += Page.Rows.size();
+        ByteCount += Buffer.size();
+        return static_cast<bool>(OutputFile);
+    };
+    if (!Chunk.KeyColumns.empty())
+    {
+        KeysetPageOptions PageOptions;
+        if (Chunk.PartitionName.empty())
+            PageOptions.TableName = Chunk.TableName;
+        else
+            PageOptions.SourceQuery = std::format("SELECT * FROM {}{}", QuotedTable, PartitionClause);
+        PageOptions.KeyColumns = Chunk.KeyColumns;
+        PageOptions.Filter = Chunk.Condition;
+        PageOptions.PageSize = Options.PageRows;
+        auto Pager = KeysetPager::Create(SessionRef, std::move(PageOptions));
+        if (!Pager)
+            return std::unexpected(Pager.error());
+        while (Pager->HasMore())
+        {
+            if (IsCancelled.load(std::memory_order_relaxed))
+                return std::unexpected("导出已取消");
+            const auto Page = Pager->NextPage();
+            if (!Page)
+                return std::unexpected(Page.error());
+            if (!WritePage(*Page))
+                return std::unexpected(std::format("写入分块文件 {} 失败", FilePath.string()));
+        }
+    }
+    else
+    {
+        // 没有可用唯一键的表只能按偏移分页；同一快照内全表扫描的顺序是稳定的
+        for (uint64_t Offset = 0;; Offset += Options.PageRows)
+        {
+            if (IsCancelled.load(std::memory_order_relaxed))
+                return std::unexpected("导出已取消");
+            const MySQLResult Page = SessionRef.Query(std::format("SELECT * FROM {}{}{}{} LIMIT {}, {}", QuotedTable, PartitionClause,
+                Chunk.Condition.empty() ? "" : " WHERE ", Chunk.Condition, Offset, Options.PageRows));
+            if (!Page.Success)
+                return std::unexpected(Page.ErrorMessage);
+            if (!WritePage(Page))
+                return std::unexpected(std::format("写入分块文件 {} 失败", FilePath.string()));
+            if (Page.Rows.size() < Options.PageRows)
+                break;
+        }
+    }
+    OutputFile.close();
+    if (!OutputFile)
+        return std::unexpected(std::format("写入分块文件 {} 失败", FilePath.string()));
+    return std::pair{ RowCount, ByteCount };
+}
+
+auto ParallelExporter::AppendManifest(const std::vector<std::string>& Fields) -> void
+{
+    std::string Line;
+    for (const auto& Field : Fields)
+    {
+        if (!Line.empty())
+            Line += '\t';
+        Line += EscapeManifestField(Field);
+    }
+    Line += '\n';
+    std::lock_guard<std::mutex> Lock(ManifestMutex);
+    ManifestFile.write(Line.data(), static_cast<std::streamsize>(Line.size()));
+    ManifestFile.flush();
+}
+
+auto ParallelExporter::LoadManifest(const std::filesystem::path& ManifestPath) -> std::expected<ExportManifest, std::string>
+{
+    std::ifstream InputFile(ManifestPath, std::ios::binary);
+    if (!InputFile)
+        return std::unexpected(std::format("无法打开导出清单: {}", ManifestPath.string()));
+    std::string Line;
+    if (!std::getline(InputFile, Line) || Line != ManifestMagic)
+        return std::unexpected(std::format("不是有效的导出清单: {}", ManifestPath.string()));
+    ExportManifest Manifest;
+    // 崩溃时最后一行可能不完整，无法解析的行直接跳过
+    while (std::getline(InputFile, Line))
+    {
+        const std::vector<std::string> Fields = SplitManifestLine(Line);
+        if (Fields[0] == "snapshot" && Fields.size() == 2)
+            Manifest.SnapshotPositions.push_back(Fields[1]);
+        else if (Fields[0] == "chunk" && Fields.size() >= 5)
+        {
+            const auto ChunkIndex = ParseNumber<std::size_t>(Fields[2]);
+            if (!ChunkIndex)
+                continue;
+            Manifest.Plan.push_back({ Fields[1], *ChunkIndex, Fields[3], Fields[4], { Fields.begin() + 5, Fields.end() } });
+        }
+        else if (Fields[0] == "done" && Fields.size() == 5)
+        {
+            if (const auto ChunkIndex = ParseNumber<std::size_t>(Fields[2]))
+                Manifest.CompletedChunks.emplace(Fields[1], *ChunkIndex);
+        }
+    }
+    return Manifest;
+}
+
+auto ParallelExporter::Run() -> std::expected<ExportReport, std::string>
+{
+    ExportReport Report;
+    IsCancelled.store(false, std::memory_order_relaxed);
+    if (Options.Tables.empty() && !Options.Resume)
+        return std::unexpected("未指定要导出的表");
+    std::error_code ErrorCode;
+    std::filesystem::create_directories(Options.OutputDirectory, ErrorCode);
+    if (ErrorCode)
+        return std::unexpected(std::format("无法创建导出目录 {}: {}", Options.OutputDirectory.string(), ErrorCode.message()));
+    const std::filesystem::path ManifestPath = Options.OutputDirectory / "manifest.tsv";
+    const bool IsResuming = Options.Resume && std::filesystem::exists(ManifestPath);
+    ExportManifest Manifest;
+    if (IsResuming)
+    {
+        auto Loaded = LoadManifest(ManifestPath);
+        if (!Loaded)
+            return std::unexpected(Loaded.error());
+        Manifest = std::move(*Loaded);
+    }
+    else if (Options.Tables.empty())
+        return std::unexpected(std::format("没有可续传的导出清单: {}", ManifestPath.string()));
+
+    MySQLWrapper Connection;
+    if (!Connection.Connect(Options.Config))
+        return std::unexpected(std::format("连接失败: {}", Connection.GetLastError()));
+    if (!IsResuming)
+    {
+        for (const auto& TableName : Options.Tables)
+        {
+            auto TableChunks = PlanTable(Connection, TableName);
+            if (!TableChunks)
+                return std::unexpected(TableChunks.error());
+            std::ranges::move(*TableChunks, std::back_inserter(Manifest.Plan));
+        }
+    }
+    ManifestFile.open(ManifestPath, std::ios::binary | (IsResuming ? std::ios::app : std::ios::trunc));
+    if (!ManifestFile)
+        return std::unexpected(std::format("无法写入导出清单: {}", ManifestPath.string()));
+    if (!IsResuming)
+    {
+        AppendManifest({ std::string{ ManifestMagic } });
+        for (const auto& Chunk : Manifest.Plan)
+        {
+            std::vector<std::string> Fields{ "chunk", Chunk.TableName, std::to_string(Chunk.ChunkIndex), Chunk.PartitionName, Chunk.Condition };
+            Fields.insert(Fields.end(), Chunk.KeyColumns.begin(), Chunk.KeyColumns.end());
+            AppendManifest(Fields);
+        }
+    }
+
+    std::vector<const ExportChunk*> PendingChunks;
+    std::set<std::string_view> TableNames;
+    for (const auto& Chunk : Manifest.Plan)
+    {
+        TableNames.insert(Chunk.TableName);
+        if (Manifest.CompletedChunks.contains({ Chunk.TableName, Chunk.ChunkIndex }))
+            ++Report.SkippedChunkCount;
+        else
+            PendingChunks.push_back(&Chunk);
+    }
+    Report.TableCount = TableNames.size();
+    Report.ChunkCount = Manifest.Plan.size();
+    if (PendingChunks.empty())
+        return Report;
+
+    const std::size_t WorkerCount = (std::min)(Options.ConnectionCount, PendingChunks.size());
+    Connection.SetSessionPoolSize(WorkerCount);
+    std::vector<std::unique_ptr<Session>> Sessions;
+    for (std::size_t Index = 0; Index < WorkerCount; ++Index)
+    {
+        auto SessionResult = Connection.OpenSession();
+        if (!SessionResult)
+            return std::unexpected(std::format("打开导出会话失败: {}", SessionResult.error()));
+        Sessions.push_back(std::move(*SessionResult));
+    }
+    if (auto Started = StartSnapshots(Connection, Sessions, Report); !Started)
+        return std::unexpected(Started.error());
+    AppendManifest({ "snapshot", Report.SnapshotPosition });
+
+    std::atomic<std::size_t> NextChunk{ 0 };
+    std::atomic<uint64_t> RowCount{ 0 };
+    std::atomic<uint64_t> ByteCount{ 0 };
+    std::atomic<std::size_t> FailedCount{ 0 };
+    std::mutex ErrorMutex;
+    const auto StartTime = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> Workers;
+        Workers.reserve(Sessions.size());
+        for (auto& SessionPtr : Sessions)
+        {
+            Workers.emplace_back([&, SessionRaw = SessionPtr.get()]
+            {
+                while (!IsCancelled.load(std::memory_order_relaxed))
+                {
+                    const std::size_t ChunkPosition = NextChunk.fetch_add(1, std::memory_order_relaxed);
+                    if (ChunkPosition >= PendingChunks.size())
+                        break;
+                    const ExportChunk& Chunk = *PendingChunks[ChunkPosition];
+                    const auto Exported = ExportChunkData(*SessionRaw, Chunk);
+                    if (!Exported)
+                    {
+                        FailedCount.fetch_add(1, std::memory_order_relaxed);
+                        std::lock_guard<std::mutex> Lock(ErrorMutex);
+                        if (Report.Errors.size() < MaxReportedErrors)
+                            Report.Errors.push_back(std::format("{} 第 {} 块: {}", Chunk.TableName, Chunk.ChunkIndex, Exported.error()));
+                        continue;
+                    }
+                    RowCount.fetch_add(Exported->first, std::memory_order_relaxed);
+                    ByteCount.fetch_add(Exported->second, std::memory_order_relaxed);
+                    AppendManifest({ "done", Chunk.TableName, std::to_string(Chunk.ChunkIndex), std::to_string(Exported->first), std::to_string(Exported->second) });
+                }
+                (void)SessionRaw->Execute("COMMIT");
+            });
+        }
+    }
+    Report.Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime);
+    Report.RowCount = RowCount.load();
+    Report.ByteCount = ByteCount.load();
+    Report.FailedChunkCount = FailedCount.load();
+    ManifestFile.close();
+    return Report;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+enum class ExportFormat
+{
+    Csv,
+    Ndjson
+};
+
+struct ExportOptions
+{
+    MySQLConfig Config;
+    std::vector<std::string> Tables;
+    std::filesystem::path OutputDirectory;
+    ExportFormat Format = ExportFormat::Csv;
+    std::size_t ConnectionCount = 4;
+    std::size_t TargetChunkRows = 1'000'000;
+    std::size_t PageRows = 10'000;
+    bool Resume = false;
+};
+
+// 导出的最小单位：一个分区，或按首个键列切出的一段范围；Condition 为空表示整表（或整个分区）
+struct ExportChunk
+{
+    std::string TableName;
+    std::size_t ChunkIndex = 0;
+    std::string PartitionName;
+    std::string Condition;
+    std::vector<std::string> KeyColumns;
+};
+
+struct ExportReport
+{
+    std::size_t TableCount = 0;
+    std::size_t ChunkCount = 0;
+    std::size_t SkippedChunkCount = 0;
+    std::size_t FailedChunkCount = 0;
+    uint64_t RowCount = 0;
+    uint64_t ByteCount = 0;
+    std::chrono::nanoseconds Elapsed{ 0 };
+    std::string SnapshotPosition;
+    bool IsLockFree = false;
+    std::vector<std::string> Errors;
+    [[nodiscard]] auto Throughput() const noexcept -> double
+    {
+        const double Seconds = std::chrono::duration<double>(Elapsed).count();
+        return Seconds > 0.0 ? static_cast<double>(ByteCount) / Seconds : 0.0;
+    }
+};
+
+// 清单为追加写入的文本文件，每行以制表符分隔：
+//   MYEXPORT1
+//   snapshot <gtid_executed>                       每次运行一行
+//   chunk <表> <序号> <分区> <条件> <键列...>      首次运行时写入的切分计划，续传时原样复用
+//   done <表> <序号> <行数> <字节数>              已完整写出的分块
+// 续传只跳过 done 的分块，其余分块重新导出，并且使用新的快照。
+struct ExportManifest
+{
+    std::vector<std::string> SnapshotPositions;
+    std::vector<ExportChunk> Plan;
+    std::set<std::pair<std::string, std::size_t>> CompletedChunks;
+};
+
+// N 条会话在同一时刻开启一致性快照（全局读锁，或在没有 RELOAD 权限时用 GTID 校验），
+// 各表按分区或主键范围切块，由 N 个线程并发以键集分页流式写入各自的分块文件。
+class ParallelExporter
+{
+private:
+    static constexpr std::string_view ManifestMagic = "MYEXPORT1";
+    static constexpr std::size_t MaxChunksPerTable = 4096;
+    static constexpr std::size_t SamplesPerChunk = 32;
+    static constexpr std::size_t MaxSnapshotAttempts = 5;
+    static constexpr std::size_t MaxReportedErrors = 10;
+    ExportOptions Options;
+    std::atomic<bool> IsCancelled{ false };
+    std::mutex ManifestMutex;
+    std::ofstream ManifestFile;
+    [[nodiscard]] auto PlanTable(MySQLWrapper& Connection, const std::string& TableName) -> std::expected<std::vector<ExportChunk>, std::string>;
+    [[nodiscard]] auto StartSnapshots(MySQLWrapper& Connection, std::vector<std::unique_ptr<Session>>& Sessions, ExportReport& Report) -> std::expected<void, std::string>;
+    [[nodiscard]] auto ExportChunkData(Session& SessionRef, const ExportChunk& Chunk) -> std::expected<std::pair<uint64_t, uint64_t>, std::string>;
+    [[nodiscard]] auto ChunkFilePath(const ExportChunk& Chunk) const -> std::filesystem::path;
+    auto AppendManifest(const std::vector<std::string>& Fields) -> void;
+public:
+    explicit ParallelExporter(ExportOptions OptionsParam);
+    [[nodiscard]] auto Run() -> std::expected<ExportReport, std::string>;
+    [[nodiscard]] static auto LoadManifest(const std::filesystem::path& ManifestPath) -> std::expected<ExportManifest, std::string>;
+    auto Cancel() noexcept -> void
+    {
+        IsCancelled.store(true, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,163 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <algorithm>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class TableFormatter
+{
+private:
+    std::ostringstream OutputStream;
+    std::vector<std::size_t> ColumnWidths;
+    std::string_view LineBreak;
+    auto CalculateColumnWidths(const MySQLResult& ResultData) -> void
+    {
+        ColumnWidths.clear();
+        ColumnWidths.reserve(ResultData.ColumnNames.size());
+        for (const auto& ColumnName : ResultData.ColumnNames)
+            ColumnWidths.push_back(ColumnName.length());
+        for (const auto& RowData : ResultData.Rows)
+        {
+            for (auto [Index, Width] : std::views::enumerate(ColumnWidths))
+            {
+                if (static_cast<std::size_t>(Index) < RowData.Fields.size())
+                    Width = (std::max)(Width, RowData.Fields[Index].length());
+            }
+        }
+    }
+    auto AppendSeparator() -> void
+    {
+        OutputStream << "+";
+        for (std::size_t Index = 0; Index < ColumnWidths.size(); ++Index)
+        {
+            OutputStream << std::string(ColumnWidths[Index] + 2, '-');
+            if (Index < ColumnWidths.size() - 1)
+                OutputStream << "+";
+        }
+        OutputStream << "+" << LineBreak;
+    }
+    auto AppendRow(const std::vector<std::string>& FieldsData) -> void
+    {
+        OutputStream << "|";
+        for (std::size_t Index = 0; Index < FieldsData.size() && Index < ColumnWidths.size(); ++Index)
+            OutputStream << std::format(" {:<{}} |", FieldsData[Index], ColumnWidths[Index]);
+        OutputStream << LineBreak;
+    }
+public:
+    explicit TableFormatter(std::string_view LineBreakText = "\r\n") : LineBreak(LineBreakText) {}
+    [[nodiscard]] auto Format(const MySQLResult& ResultData) -> std::string
+    {
+        if (!ResultData.Success)
+            return std::format("错误: {}{}", ResultData.ErrorMessage, LineBreak);
+        if (ResultData.ColumnNames.empty())
+            return std::format("查询成功, 影响 {} 行{}", ResultData.AffectedRows, LineBreak);
+        CalculateColumnWidths(ResultData);
+        AppendSeparator();
+        AppendRow(ResultData.ColumnNames);
+        AppendSeparator();
+        for (const auto& RowData : ResultData.Rows)
+            AppendRow(RowData.Fields);
+        AppendSeparator();
+        OutputStream << std::format("共 {} 行{}", ResultData.Rows.size(), LineBreak);
+        return OutputStream.str();
+    }
+};
+
+[[nodiscard]] inline auto FormatQueryResult(const MySQLResult& ResultData) -> std::string
+{
+    return TableFormatter{}.Format(ResultData);
+}
+
+inline auto AppendCsvField(std::string& Output, std::string_view FieldValue) -> void
+{
+    if (FieldValue.find_first_of(",\"\r\n") == std::string_view::npos && !FieldValue.empty())
+    {
+        Output += FieldValue;
+        return;
+    }
+    Output += '"';
+    for (const char CharValue : FieldValue)
+    {
+        if (CharValue == '"')
+            Output += '"';
+        Output += CharValue;
+    }
+    Output += '"';
+}
+
+// NULL 输出为空字段，空字符串输出为 ""，两者可以区分
+[[nodiscard]] inline auto FormatCsv(const MySQLResult& ResultData, bool IncludeHeader = true) -> std::string
+{
+    std::string Output;
+    if (IncludeHeader)
+    {
+        for (std::size_t Index = 0; Index < ResultData.ColumnNames.size(); ++Index)
+        {
+            if (Index > 0)
+                Output += ',';
+            AppendCsvField(Output, ResultData.ColumnNames[Index]);
+        }
+        Output += '\n';
+    }
+    for (const auto& RowData : ResultData.Rows)
+    {
+        for (std::size_t Index = 0; Index < RowData.Size(); ++Index)
+        {
+            if (Index > 0)
+                Output += ',';
+            if (!RowData.IsNull(Index))
+                AppendCsvField(Output, RowData.Fields[Index]);
+        }
+        Output += '\n';
+    }
+    return Output;
+}
+
+inline auto AppendJsonString(std::string& Output, std::string_view Text) -> void
+{
+    constexpr std::string_view HexDigits = "0123456789abcdef";
+    Output += '"';
+    for (const char CharValue : Text)
+    {
+        switch (CharValue)
+        {
+        case '"': Output += "\\\""; break;
+        case '\\': Output += "\\\\"; break;
+        case '\n': Output += "\\n"; break;
+        case '\r': Output += "\\r"; break;
+        case '\t': Output += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(CharValue) < 0x20)
+            {
+                Output += "\\u00";
+                Output += HexDigits[static_cast<unsigned char>(CharValue) >> 4];
+                Output += HexDigits[static_cast<unsigned char>(CharValue) & 0x0F];
+            }
+            else
+                Output += CharValue;
+            break;
+        }
+    }
+    Output += '"';
+}
+
+// 每行一个 JSON 对象；列值一律为字符串，NULL 为 null
+inline auto AppendJsonRow(std::string& Output, const std::vector<std::string>& ColumnNames, const MySQLRow& RowData) -> void
+{
+    Output += '{';
+    for (std::size_t Index = 0; Index < ColumnNames.size() && Index < RowData.Size(); ++Index)
+    {
+        if (Index > 0)
+            Output += ',';
+        AppendJsonString(Output, ColumnNames[Index]);
+        Output += ':';
+        if (RowData.IsNull(Index))
+            Output += "null";
+        else
+            AppendJsonString(Output, RowData.Fields[Index]);
+    }
+    Output += '}';
+}
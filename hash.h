@@ -0,0 +1,111 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace FastHash
+{
+    inline constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+    inline constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+    inline constexpr uint64_t Prime3 = 0x165667B19E3779F9ULL;
+    inline constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+    inline constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+    [[nodiscard]] inline auto Read64(const char* DataPtr) noexcept -> uint64_t
+    {
+        uint64_t Value;
+        std::memcpy(&Value, DataPtr, sizeof(Value));
+        if constexpr (std::endian::native == std::endian::big)
+            Value = std::byteswap(Value);
+        return Value;
+    }
+
+    [[nodiscard]] inline auto Read32(const char* DataPtr) noexcept -> uint64_t
+    {
+        uint32_t Value;
+        std::memcpy(&Value, DataPtr, sizeof(Value));
+        if constexpr (std::endian::native == std::endian::big)
+            Value = std::byteswap(Value);
+        return Value;
+    }
+
+    [[nodiscard]] constexpr auto Round(uint64_t Accumulator, uint64_t Input) noexcept -> uint64_t
+    {
+        Accumulator += Input * Prime2;
+        Accumulator = std::rotl(Accumulator, 31);
+        return Accumulator * Prime1;
+    }
+
+    [[nodiscard]] constexpr auto MergeRound(uint64_t Accumulator, uint64_t Value) noexcept -> uint64_t
+    {
+        Accumulator ^= Round(0, Value);
+        return Accumulator * Prime1 + Prime4;
+    }
+
+    [[nodiscard]] constexpr auto Avalanche(uint64_t Hash) noexcept -> uint64_t
+    {
+        Hash ^= Hash >> 33;
+        Hash *= Prime2;
+        Hash ^= Hash >> 29;
+        Hash *= Prime3;
+        Hash ^= Hash >> 32;
+        return Hash;
+    }
+
+    // XXH64 算法，输出与参考实现一致，可用于持久化的摘要值
+    [[nodiscard]] inline auto Hash64(std::string_view Data, uint64_t Seed = 0) noexcept -> uint64_t
+    {
+        const char* Position = Data.data();
+        const char* const End = Position + Data.size();
+        uint64_t Hash;
+        if (Data.size() >= 32)
+        {
+            uint64_t Lane1 = Seed + Prime1 + Prime2;
+            uint64_t Lane2 = Seed + Prime2;
+            uint64_t Lane3 = Seed;
+            uint64_t Lane4 = Seed - Prime1;
+            const char* const Limit = End - 32;
+            do
+            {
+                Lane1 = Round(Lane1, Read64(Position));
+                Lane2 = Round(Lane2, Read64(Position + 8));
+                Lane3 = Round(Lane3, Read64(Position + 16));
+                Lane4 = Round(Lane4, Read64(Position + 24));
+                Position += 32;
+            } while (Position <= Limit);
+            Hash = std::rotl(Lane1, 1) + std::rotl(Lane2, 7) + std::rotl(Lane3, 12) + std::rotl(Lane4, 18);
+            Hash = MergeRound(Hash, Lane1);
+            Hash = MergeRound(Hash, Lane2);
+            Hash = MergeRound(Hash, Lane3);
+            Hash = MergeRound(Hash, Lane4);
+        }
+        else
+            Hash = Seed + Prime5;
+        Hash += static_cast<uint64_t>(Data.size());
+        while (Position + 8 <= End)
+        {
+            Hash ^= Round(0, Read64(Position));
+            Hash = std::rotl(Hash, 27) * Prime1 + Prime4;
+            Position += 8;
+        }
+        if (Position + 4 <= End)
+        {
+            Hash ^= Read32(Position) * Prime1;
+            Hash = std::rotl(Hash, 23) * Prime2 + Prime3;
+            Position += 4;
+        }
+        while (Position < End)
+        {
+            Hash ^= static_cast<uint64_t>(static_cast<unsigned char>(*Position)) * Prime5;
+            Hash = std::rotl(Hash, 11) * Prime1;
+            ++Position;
+        }
+        return Avalanche(Hash);
+    }
+
+    [[nodiscard]] constexpr auto Combine(uint64_t Seed, uint64_t Value) noexcept -> uint64_t
+    {
+        return Avalanche(Seed ^ (Value + Prime3 + (Seed << 6) + (Seed >> 2)));
+    }
+}
@@ -1,17 +1,59 @@
 #include "render.hpp"
 #include "def.h"
+#include "autocomplete.h"
 #include "database.h"
-#include <sstream>
+#include "execution.h"
+#include "formatter.hpp"
+#include "outputlog.h"
+#include "resultgrid.h"
+#include "sqllexer.h"
+#include "sqlscript.hpp"
+#include "watch.h"
 #include <algorithm>
 #include <expected>
+#include <limits>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <ranges>
 #include <eh.h>
 #include <chrono>
-#include <iomanip>
 
 inline MySQLWrapper MySQLConnection;
 inline bool IsMySQLConnected = false;
+// 监视线程把格式化好的差异文本通过此消息交给界面线程，LParam 为 new 出的 std::string*
+constexpr UINT WatchDeltaMessage = WM_APP + 1;
+inline std::unique_ptr<QueryWatcher> ActiveWatcher;
+// 执行线程的事件队列由空变为非空时发送此消息，界面线程随后取走全部事件
+constexpr UINT ExecutionEventMessage = WM_APP + 2;
+inline std::unique_ptr<ExecutionController> Executor;
+// 当前批次的日志文本，批次结束时一次写入输出框
+inline std::string PendingOutput;
+inline std::size_t BatchResultSets = 0;
+// 结果表格只在界面线程上访问
+inline ResultGridModel ResultGrid;
+inline uint64_t AppliedWidthVersion = 0;
+// 输出框的内容由 MessageLog 管理：追加先进入缓冲，由定时器每帧合并刷新一次
+inline OutputLog MessageLog;
+constexpr UINT_PTR OutputFlushTimerID = 1;
+constexpr UINT OutputFlushInterval = 16;
+inline bool IsOutputFlushScheduled = false;
+// 输入框的语法着色：修改与滚动只安排定时器，到时同步文本，并只为可见范围内重新分析过的行着色
+inline IncrementalSqlLexer InputLexer;
+constexpr UINT_PTR HighlightTimerID = 2;
+constexpr UINT HighlightInterval = 16;
+inline bool IsHighlightScheduled = false;
+// 自动补全：加载线程建好索引后通过此消息报告结果，LParam 为 new 出的 std::string*
+constexpr UINT SchemaLoadedMessage = WM_APP + 3;
+inline std::unique_ptr<AutocompleteEngine> Completion;
+// 当前显示的候选，为空表示列表未显示；CompletionStart 为被替换的标识符的起点
+inline std::vector<CompletionCandidate> CompletionItems;
+inline std::size_t CompletionStart = 0;
+// 输入标识符字符或 Ctrl+空格 后，在下一次着色同步文本时更新候选
+inline bool IsCompletionRequested = false;
+inline bool IsCompletionForced = false;
+// 已处理的按键随后由 TranslateMessage 产生的字符消息也要拦下
+inline bool IsCompletionCharSuppressed = false;
 
 struct ConnectionConfig
 {
@@ -24,76 +66,204 @@ struct ConnectionConfig
 
 [[nodiscard]] auto GetCurrentTimestamp() -> std::string
 {
-    const auto Now = std::chrono::system_clock::now();
-    const auto TimeT = std::chrono::system_clock::to_time_t(Now);
-    const auto Ms = std::chrono::duration_cast<std::chrono::milliseconds>(Now.time_since_epoch()) % 1000;
-    std::tm LocalTime{};
-    localtime_s(&LocalTime, &TimeT);
-    std::ostringstream Oss;
-    Oss << std::put_time(&LocalTime, "[%Y-%m-%d %H:%M:%S") << '.' << std::setfill('0') << std::setw(3) << Ms.count() << "]\r\n";
-    return Oss.str();
+    thread_local TimestampCache Cache;
+    std::string Timestamp;
+    Cache.Format(std::chrono::system_clock::now(), Timestamp);
+    Timestamp += "\r\n";
+    return Timestamp;
 }
 
-class TableFormatter
+auto FlushOutput() -> void
 {
-private:
-    std::ostringstream OutputStream;
-    std::vector<std::size_t> ColumnWidths;
-    auto CalculateColumnWidths(const MySQLResult& ResultData) -> void
-    {
-        ColumnWidths.clear();
-        ColumnWidths.reserve(ResultData.ColumnNames.size());
-        for (const auto& ColumnName : ResultData.ColumnNames)
-            ColumnWidths.push_back(ColumnName.length());
-        for (const auto& RowData : ResultData.Rows)
-        {
-            for (auto [Index, Width] : std::views::enumerate(ColumnWidths))
-            {
-                if (static_cast<std::size_t>(Index) < RowData.Fields.size())
-                    Width = max(Width, RowData.Fields[Index].length());
-            }
-        }
+    if (IsOutputFlushScheduled)
+    {
+        KillTimer(RenderState::WindowHandle, OutputFlushTimerID);
+        IsOutputFlushScheduled = false;
+    }
+    ApplyOutputLogUpdate(UIHandles::OutputEdit, MessageLog.Flush());
+}
+
+auto AppendOutput(std::string_view Text) -> void
+{
+    MessageLog.Append(Text);
+    if (IsOutputFlushScheduled)
+        return;
+    // 窗口尚未创建或定时器不可用时直接刷新
+    if (!RenderState::WindowHandle || SetTimer(RenderState::WindowHandle, OutputFlushTimerID, OutputFlushInterval, nullptr) == 0) [[unlikely]]
+    {
+        FlushOutput();
+        return;
+    }
+    IsOutputFlushScheduled = true;
+}
+
+auto ScheduleHighlight() -> void
+{
+    if (IsHighlightScheduled || !RenderState::WindowHandle)
+        return;
+    IsHighlightScheduled = SetTimer(RenderState::WindowHandle, HighlightTimerID, HighlightInterval, nullptr) != 0;
+}
+
+auto HideCompletion() -> void
+{
+    CompletionItems.clear();
+    HideCompletionPopup(UIHandles::CompletionPopup);
+}
+
+// 由 HighlightInput 在同步文本之后调用，InputLexer 的文本与控件一致
+auto UpdateCompletion() -> void
+{
+    const bool IsForced = std::exchange(IsCompletionForced, false);
+    IsCompletionRequested = false;
+    CHARRANGE Selection{};
+    SendMessageW(UIHandles::InputEdit, EM_EXGETSEL, 0, reinterpret_cast<LPARAM>(&Selection));
+    const std::u16string_view Text = InputLexer.GetText();
+    if (!Completion || Selection.cpMin != Selection.cpMax || Selection.cpMax < 0 || static_cast<std::size_t>(Selection.cpMax) > Text.size())
+    {
+        HideCompletion();
+        return;
     }
-    auto AppendSeparator() -> void
+    const auto Caret = static_cast<std::size_t>(Selection.cpMax);
+    // 字符串、注释与反引号内不补全
+    bool IsInLiteral = false;
+    if (Caret > 0)
     {
-        OutputStream << "+";
-        for (std::size_t Index = 0; Index < ColumnWidths.size(); ++Index)
+        InputLexer.ForEachSpan(Caret - 1, Caret, [&IsInLiteral](std::size_t, std::size_t, SqlTokenKind Kind)
         {
-            OutputStream << std::string(ColumnWidths[Index] + 2, '-');
-            if (Index < ColumnWidths.size() - 1)
-                OutputStream << "+";
-        }
-        OutputStream << "+\r\n";
-    }
-    auto AppendRow(const std::vector<std::string>& FieldsData) -> void
-    {
-        OutputStream << "|";
-        for (std::size_t Index = 0; Index < FieldsData.size() && Index < ColumnWidths.size(); ++Index)
-            OutputStream << std::format(" {:<{}} |", FieldsData[Index], ColumnWidths[Index]);
-        OutputStream << "\r\n";
-    }
-public:
-    [[nodiscard]] auto Format(const MySQLResult& ResultData) -> std::string
-    {
-        if (!ResultData.Success)
-            return std::format("错误: {}\r\n", ResultData.ErrorMessage);
-        if (ResultData.ColumnNames.empty())
-            return std::format("查询成功, 影响 {} 行\r\n", ResultData.AffectedRows);
-        CalculateColumnWidths(ResultData);
-        AppendSeparator();
-        AppendRow(ResultData.ColumnNames);
-        AppendSeparator();
-        for (const auto& RowData : ResultData.Rows)
-            AppendRow(RowData.Fields);
-        AppendSeparator();
-        OutputStream << std::format("共 {} 行\r\n", ResultData.Rows.size());
-        return OutputStream.str();
+            IsInLiteral |= Kind == SqlTokenKind::String || Kind == SqlTokenKind::Comment || Kind == SqlTokenKind::QuotedIdentifier;
+        });
     }
-};
+    const CompletionWord Word = FindCompletionWord(Text, Caret);
+    if (IsInLiteral || (Word.Prefix.empty() && Word.Qualifier.empty() && !IsForced))
+    {
+        HideCompletion();
+        return;
+    }
+    CompletionItems = Completion->Complete(Utf16ToUtf8(Word.Prefix), Utf16ToUtf8(Word.Qualifier));
+    if (CompletionItems.empty())
+    {
+        HideCompletion();
+        return;
+    }
+    CompletionStart = Word.Start;
+    ShowCompletionPopup(UIHandles::CompletionPopup, UIHandles::InputEdit, Word.Start, CompletionItems);
+}
+
+// 用选中的候选替换光标前的标识符
+auto AcceptCompletion() -> void
+{
+    const LRESULT Selected = SendMessageW(UIHandles::CompletionPopup, LB_GETCURSEL, 0, 0);
+    if (Selected < 0 || static_cast<std::size_t>(Selected) >= CompletionItems.size()) [[unlikely]]
+    {
+        HideCompletion();
+        return;
+    }
+    const CompletionCandidate Item = CompletionItems[static_cast<std::size_t>(Selected)];
+    HideCompletion();
+    CHARRANGE Selection{};
+    SendMessageW(UIHandles::InputEdit, EM_EXGETSEL, 0, reinterpret_cast<LPARAM>(&Selection));
+    if (Selection.cpMax < static_cast<LONG>(CompletionStart)) [[unlikely]]
+        return;
+    CHARRANGE Replaced{ static_cast<LONG>(CompletionStart), Selection.cpMax };
+    SendMessageW(UIHandles::InputEdit, EM_EXSETSEL, 0, reinterpret_cast<LPARAM>(&Replaced));
+    const std::wstring Inserted = Utf8ToWide(QuoteCompletionText(Item.Text, Item.Kind));
+    SendMessageW(UIHandles::InputEdit, EM_REPLACESEL, TRUE, reinterpret_cast<LPARAM>(Inserted.c_str()));
+    Completion->RecordUsage(Item.Text);
+}
 
-[[nodiscard]] auto FormatQueryResult(const MySQLResult& ResultData) -> std::string
+// 输入框的按键在控件处理之前经过这里，返回 true 表示拦下
+auto HandleCompletionKey(UINT Message, WPARAM Key) -> bool
 {
-    return TableFormatter{}.Format(ResultData);
+    if (Message == WM_CHAR)
+    {
+        if (std::exchange(IsCompletionCharSuppressed, false))
+            return true;
+        const auto CharValue = static_cast<wchar_t>(Key);
+        // 退格等控制字符由按下时处理
+        if (CharValue < L' ')
+            return false;
+        const bool IsIdentifierChar = (CharValue >= L'a' && CharValue <= L'z') || (CharValue >= L'A' && CharValue <= L'Z') || (CharValue >= L'0' && CharValue <= L'9') ||
+            CharValue == L'_' || CharValue == L'$' || CharValue == L'.' || CharValue >= 0x80;
+        if (IsIdentifierChar)
+            IsCompletionRequested = true;
+        else if (!CompletionItems.empty())
+            HideCompletion();
+        return false;
+    }
+    if (Message != WM_KEYDOWN)
+        return false;
+    if (Key == VK_SPACE && GetKeyState(VK_CONTROL) < 0)
+    {
+        IsCompletionRequested = true;
+        IsCompletionForced = true;
+        IsCompletionCharSuppressed = true;
+        ScheduleHighlight();
+        return true;
+    }
+    if (CompletionItems.empty())
+        return false;
+    const auto MoveSelection = [](int Delta)
+    {
+        const int Count = static_cast<int>(CompletionItems.size());
+        const int Current = static_cast<int>(SendMessageW(UIHandles::CompletionPopup, LB_GETCURSEL, 0, 0));
+        SendMessageW(UIHandles::CompletionPopup, LB_SETCURSEL, static_cast<WPARAM>((std::clamp)(Current + Delta, 0, Count - 1)), 0);
+    };
+    switch (Key)
+    {
+    case VK_UP: MoveSelection(-1); return true;
+    case VK_DOWN: MoveSelection(1); return true;
+    case VK_PRIOR: MoveSelection(-8); return true;
+    case VK_NEXT: MoveSelection(8); return true;
+    case VK_TAB:
+    case VK_RETURN:
+        IsCompletionCharSuppressed = true;
+        AcceptCompletion();
+        return true;
+    case VK_ESCAPE:
+        IsCompletionCharSuppressed = true;
+        HideCompletion();
+        return true;
+    case VK_BACK:
+        IsCompletionRequested = true;
+        return false;
+    case VK_LEFT:
+    case VK_RIGHT:
+    case VK_HOME:
+    case VK_END:
+        HideCompletion();
+        return false;
+    default:
+        return false;
+    }
+}
+
+// 连接成功后在独立连接上加载当前库的结构
+auto LoadCompletionSchema(const MySQLConfig& Config) -> void
+{
+    if (!Completion) [[unlikely]]
+        return;
+    const HWND WindowHandle = RenderState::WindowHandle;
+    Completion->LoadAsync(Config, [WindowHandle](const SchemaLoadResult& Result)
+    {
+        auto* ResultText = new std::string(Result.ErrorMessage.empty()
+            ? std::format("自动补全已加载 {} 张表、{} 列 ({:.1f} 毫秒)", Result.TableCount, Result.ColumnCount, std::chrono::duration<double, std::milli>(Result.Elapsed).count())
+            : std::format("自动补全加载库结构失败:\r\n{}", Result.ErrorMessage));
+        if (!PostMessageW(WindowHandle, SchemaLoadedMessage, 0, reinterpret_cast<LPARAM>(ResultText)))
+            delete ResultText;
+    });
+}
+
+auto HighlightInput() -> void
+{
+    KillTimer(RenderState::WindowHandle, HighlightTimerID);
+    IsHighlightScheduled = false;
+    if (!UIHandles::InputEdit || !IsWindow(UIHandles::InputEdit)) [[unlikely]]
+        return;
+    InputLexer.SetText(GetEditTextUtf16(UIHandles::InputEdit));
+    const auto [VisibleStart, VisibleEnd] = GetVisibleTextRange(UIHandles::InputEdit);
+    ApplySqlHighlight(UIHandles::InputEdit, InputLexer, InputLexer.TakeDirtyRange(VisibleStart, VisibleEnd));
+    if (IsCompletionRequested || !CompletionItems.empty())
+        UpdateCompletion();
 }
 
 auto UpdateStatusDisplay() -> void
@@ -109,133 +279,288 @@ auto UpdateStatusDisplay() -> void
     }
 }
 
-[[nodiscard]] auto SplitSQLStatements(std::string_view SqlText) -> std::vector<std::string>
+[[nodiscard]] auto GetGridCharWidth() -> int
+{
+    TEXTMETRICW Metrics{};
+    const HDC DeviceContext = GetDC(UIHandles::ResultList);
+    const HGDIOBJ PreviousFont = SelectObject(DeviceContext, reinterpret_cast<HGDIOBJ>(SendMessageW(UIHandles::ResultList, WM_GETFONT, 0, 0)));
+    GetTextMetricsW(DeviceContext, &Metrics);
+    SelectObject(DeviceContext, PreviousFont);
+    ReleaseDC(UIHandles::ResultList, DeviceContext);
+    return (std::max)(static_cast<int>(Metrics.tmAveCharWidth), 1);
+}
+
+// 按列表字体的平均字符宽度把模型的列宽（字符数）换算为像素
+[[nodiscard]] auto GetGridColumnPixels(std::size_t Column, int CharWidth) -> int
+{
+    const int MaxPixels = ScaleForDPI(480, RenderState::CurrentDPI);
+    return (std::min)(static_cast<int>(ResultGrid.GetColumnWidth(Column) + 2) * CharWidth, MaxPixels);
+}
+
+// 传入空指针时清空表格
+auto ShowResultGrid(std::shared_ptr<const MySQLResult> ResultData) -> void
+{
+    const HWND ListHandle = UIHandles::ResultList;
+    if (!ListHandle || !IsWindow(ListHandle)) [[unlikely]]
+        return;
+    ResultGrid.SetResult(std::move(ResultData));
+    SendMessageW(ListHandle, WM_SETREDRAW, FALSE, 0);
+    ListView_SetItemCountEx(ListHandle, 0, 0);
+    while (ListView_DeleteColumn(ListHandle, 0))
+    {
+    }
+    const int CharWidth = GetGridCharWidth();
+    for (std::size_t Column = 0; Column < ResultGrid.GetColumnCount(); ++Column)
+    {
+        std::wstring ColumnName = Utf8ToWide(ResultGrid.GetColumnName(Column));
+        LVCOLUMNW ColumnData{};
+        ColumnData.mask = LVCF_FMT | LVCF_TEXT | LVCF_WIDTH;
+        ColumnData.fmt = LVCFMT_LEFT;
+        ColumnData.cx = GetGridColumnPixels(Column, CharWidth);
+        ColumnData.pszText = ColumnName.data();
+        ListView_InsertColumn(ListHandle, static_cast<int>(Column), &ColumnData);
+    }
+    const std::size_t RowCount = (std::min)(ResultGrid.GetRowCount(), static_cast<std::size_t>((std::numeric_limits<int>::max)()));
+    ListView_SetItemCountEx(ListHandle, static_cast<int>(RowCount), LVSICF_NOSCROLL);
+    AppliedWidthVersion = ResultGrid.GetWidthVersion();
+    SendMessageW(ListHandle, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(ListHandle, nullptr, TRUE);
+}
+
+// 水平滚动位置以像素计，据此找出与客户区相交的列
+[[nodiscard]] auto GetVisibleGridColumns() -> std::pair<std::size_t, std::size_t>
+{
+    RECT ClientRect{};
+    GetClientRect(UIHandles::ResultList, &ClientRect);
+    const int ScrollX = GetScrollPos(UIHandles::ResultList, SB_HORZ);
+    std::size_t FirstColumn = ResultGrid.GetColumnCount();
+    std::size_t EndColumn = 0;
+    int Left = 0;
+    for (std::size_t Column = 0; Column < ResultGrid.GetColumnCount(); ++Column)
+    {
+        const int Width = ListView_GetColumnWidth(UIHandles::ResultList, static_cast<int>(Column));
+        if (Left + Width > ScrollX && Left < ScrollX + ClientRect.right)
+        {
+            FirstColumn = (std::min)(FirstColumn, Column);
+            EndColumn = Column + 1;
+        }
+        Left += Width;
+    }
+    return FirstColumn < EndColumn ? std::pair{ FirstColumn, EndColumn - FirstColumn } : std::pair{ std::size_t{ 0 }, ResultGrid.GetColumnCount() };
+}
+
+auto HandleResultGridNotify(const NMHDR* Header) -> LRESULT
 {
-    std::vector<std::string> Statements;
-    std::string CurrentStatement;
-    bool InSingleQuote = false;
-    bool InDoubleQuote = false;
-    bool InComment = false;
-    
-    for (std::size_t Index = 0; Index < SqlText.length(); ++Index)
-    {
-        const char CurrentChar = SqlText[Index];
-        const char NextChar = (Index + 1 < SqlText.length()) ? SqlText[Index + 1] : '\0';
-        if (!InSingleQuote && !InDoubleQuote)
+    switch (Header->code)
+    {
+    case LVN_GETDISPINFOW:
+    {
+        LVITEMW& Item = reinterpret_cast<NMLVDISPINFOW*>(const_cast<NMHDR*>(Header))->item;
+        if (!(Item.mask & LVIF_TEXT) || !Item.pszText || Item.cchTextMax <= 0)
+            return 0;
+        const std::string_view CellText = ResultGrid.GetCellText(static_cast<std::size_t>(Item.iItem), static_cast<std::size_t>(Item.iSubItem));
+        std::size_t Written = 0;
+        if (GetMaxUtf16Length(CellText.size()) < static_cast<std::size_t>(Item.cchTextMax)) [[likely]]
+            Written = Utf8ToUtf16(CellText, Item.pszText);
+        else
         {
-            if (CurrentChar == '-' && NextChar == '-')
-            {
-                while (Index < SqlText.length() && SqlText[Index] != '\n')
-                    ++Index;
-                continue;
-            }
-            if (CurrentChar == '#')
-            {
-                while (Index < SqlText.length() && SqlText[Index] != '\n')
-                    ++Index;
-                continue;
-            }
-            if (CurrentChar == '/' && NextChar == '*')
-            {
-                ++Index;
-                ++Index;
-                while (Index + 1 < SqlText.length())
-                {
-                    if (SqlText[Index] == '*' && SqlText[Index + 1] == '/')
-                    {
-                        ++Index;
-                        ++Index;
-                        break;
-                    }
-                    ++Index;
-                }
-                continue;
-            }
+            // 字节数超过控件的缓冲（如大量零宽字符）时先完整转换再截断显示
+            const std::wstring WideText = Utf8ToWide(CellText);
+            Written = (std::min)(WideText.size(), static_cast<std::size_t>(Item.cchTextMax - 1));
+            std::ranges::copy_n(WideText.begin(), static_cast<std::ptrdiff_t>(Written), Item.pszText);
         }
-        if (CurrentChar == '\'' && !InDoubleQuote)
+        Item.pszText[Written] = L'\0';
+        return 0;
+    }
+    case LVN_ODCACHEHINT:
+    {
+        const auto* Hint = reinterpret_cast<const NMLVCACHEHINT*>(Header);
+        const auto [FirstColumn, ColumnCount] = GetVisibleGridColumns();
+        ResultGrid.SetViewport({ .FirstRow = static_cast<std::size_t>(Hint->iFrom), .RowCount = static_cast<std::size_t>(Hint->iTo - Hint->iFrom + 1), .FirstColumn = FirstColumn, .ColumnCount = ColumnCount });
+        // 新进入视野的单元格比采样时更宽：只加宽，不缩小用户调整过的列
+        if (ResultGrid.GetWidthVersion() != AppliedWidthVersion)
         {
-            if (Index > 0 && SqlText[Index - 1] == '\\')
+            AppliedWidthVersion = ResultGrid.GetWidthVersion();
+            const int CharWidth = GetGridCharWidth();
+            for (std::size_t Column = FirstColumn; Column < FirstColumn + ColumnCount; ++Column)
             {
-                CurrentStatement += CurrentChar;
-                continue;
+                const int Pixels = GetGridColumnPixels(Column, CharWidth);
+                if (Pixels > ListView_GetColumnWidth(UIHandles::ResultList, static_cast<int>(Column)))
+                    ListView_SetColumnWidth(UIHandles::ResultList, static_cast<int>(Column), Pixels);
             }
-            InSingleQuote = !InSingleQuote;
-            CurrentStatement += CurrentChar;
-            continue;
         }
-        
-        if (CurrentChar == '"' && !InSingleQuote)
+        return 0;
+    }
+    case LVN_ODFINDITEMW:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+// 执行线程占用主连接期间不能连接、断开或提交新的批次
+[[nodiscard]] auto RejectWhileExecuting() -> bool
+{
+    if (!Executor || !Executor->IsBusy())
+        return false;
+    AppendOutput(GetCurrentTimestamp() + "语句仍在执行，请等待完成或按 Esc 取消。");
+    return true;
+}
+
+auto ShowExecutionProgress(const ExecutionEvent& Event) -> void
+{
+    if (!UIHandles::StatusText || !IsWindow(UIHandles::StatusText)) [[unlikely]]
+        return;
+    const std::string StatusText = Event.StatementCount > 1
+        ? std::format("MySQL 状态: 执行中 语句 {}/{}，已读取 {} 行 (Esc 取消)", Event.StatementIndex + 1, Event.StatementCount, Event.RowCount)
+        : std::format("MySQL 状态: 执行中，已读取 {} 行 (Esc 取消)", Event.RowCount);
+    SetWindowTextW(UIHandles::StatusText, Utf8ToWide(StatusText).c_str());
+}
+
+// 结果集在读取过程中先以列名和第一页显示，读完后换成完整结果；表格始终显示最近的一个结果集
+auto HandleExecutionEvents() -> void
+{
+    for (ExecutionEvent& Event : Executor->Drain())
+    {
+        switch (Event.Kind)
+        {
+        case ExecutionEventKind::ResultStarted:
+        case ExecutionEventKind::FirstPage:
+        {
+            auto Partial = std::make_shared<MySQLResult>();
+            Partial->Success = true;
+            Partial->ColumnNames = std::move(Event.ColumnNames);
+            for (auto& RowData : Event.FirstRows)
+                Partial->Rows.push_back(std::move(RowData));
+            ShowResultGrid(std::move(Partial));
+            ShowExecutionProgress(Event);
+            break;
+        }
+        case ExecutionEventKind::Progress:
+            ShowExecutionProgress(Event);
+            break;
+        case ExecutionEventKind::StatementFinished:
         {
-            if (Index > 0 && SqlText[Index - 1] == '\\')
+            const MySQLResult& ResultData = *Event.Result;
+            if (Event.StatementCount > 1)
+                PendingOutput += std::format("--- 语句 {} ---\r\n", Event.StatementIndex + 1);
+            if (ResultData.Success && !ResultData.ColumnNames.empty())
             {
-                CurrentStatement += CurrentChar;
-                continue;
+                PendingOutput += std::format("返回 {} 行 {} 列{} ({:.2f} ms)\r\n", ResultData.Rows.size(), ResultData.ColumnNames.size(), ResultData.IsTruncated ? "（已截断）" : "", std::chrono::duration<double, std::milli>(ResultData.ExecutionTime).count());
+                ShowResultGrid(std::move(Event.Result));
+                ++BatchResultSets;
             }
-            InDoubleQuote = !InDoubleQuote;
-            CurrentStatement += CurrentChar;
-            continue;
+            else
+                PendingOutput += FormatQueryResult(ResultData);
+            if (Event.StatementCount > 1 && Event.StatementIndex < Event.StatementCount - 1)
+                PendingOutput += "\r\n";
+            break;
         }
-        if (CurrentChar == ';' && !InSingleQuote && !InDoubleQuote)
+        case ExecutionEventKind::BatchFinished:
         {
-            CurrentStatement += CurrentChar;
-            auto TrimmedStatement = CurrentStatement;
-            TrimmedStatement.erase(0, TrimmedStatement.find_first_not_of(" \t\n\r"));
-            TrimmedStatement.erase(TrimmedStatement.find_last_not_of(" \t\n\r") + 1);
-            if (!TrimmedStatement.empty())
-                Statements.push_back(TrimmedStatement);
-            CurrentStatement.clear();
-            continue;
+            if (Event.IsCancelled)
+                PendingOutput += std::format("\r\n已取消，{} 条语句未执行。\r\n", Event.StatementCount - (std::min)(Event.StatementIndex, Event.StatementCount));
+            if (BatchResultSets > 1)
+                PendingOutput += std::format("\r\n共 {} 个结果集，表格中显示最后一个。\r\n", BatchResultSets);
+            AppendOutput(PendingOutput);
+            PendingOutput.clear();
+            UpdateStatusDisplay();
+            break;
+        }
         }
-        CurrentStatement += CurrentChar;
-    }
-    if (!CurrentStatement.empty())
-    {
-        auto TrimmedStatement = CurrentStatement;
-        TrimmedStatement.erase(0, TrimmedStatement.find_first_not_of(" \t\n\r"));
-        TrimmedStatement.erase(TrimmedStatement.find_last_not_of(" \t\n\r") + 1);
-        if (!TrimmedStatement.empty())
-            Statements.push_back(TrimmedStatement);
     }
-    return Statements;
+}
+
+auto CancelExecution() -> void
+{
+    if (Executor && Executor->Cancel() && UIHandles::StatusText)
+        SetWindowTextW(UIHandles::StatusText, L"MySQL 状态: 正在取消...");
 }
 
 auto ExecuteSQL() -> void
 {
+    if (RejectWhileExecuting())
+        return;
     const std::string InputSQL = GetEditText(UIHandles::InputEdit);
     if (!IsMySQLConnected) [[unlikely]]
     {
         const std::string OutputMessage = GetCurrentTimestamp() + "未连接到数据库，请先连接。";
-        AppendEditTextWithTimestamp(UIHandles::OutputEdit, OutputMessage);
+        AppendOutput(OutputMessage);
         return;
     }
     if (InputSQL.empty()) [[unlikely]]
     {
         const std::string OutputMessage = GetCurrentTimestamp() + "请输入 SQL 命令。";
-        AppendEditTextWithTimestamp(UIHandles::OutputEdit, OutputMessage);
+        AppendOutput(OutputMessage);
         return;
     }
-    const auto Statements = SplitSQLStatements(InputSQL);
+    auto Statements = SplitSQLStatements(InputSQL);
     if (Statements.empty()) [[unlikely]]
     {
         const std::string OutputMessage = GetCurrentTimestamp() + "未检测到有效的 SQL 语句。";
-        AppendEditTextWithTimestamp(UIHandles::OutputEdit, OutputMessage);
+        AppendOutput(OutputMessage);
         return;
     }
-    std::string OutputText = GetCurrentTimestamp();
+    // 语句在执行线程上运行，结果经 ExecutionEventMessage 分段送回；日志文本在批次结束时一次写入
+    PendingOutput = GetCurrentTimestamp();
     if (Statements.size() > 1)
-        OutputText += std::format("执行 {} 条 SQL 语句:\r\n\r\n", Statements.size());
-    for (std::size_t Index = 0; Index < Statements.size(); ++Index)
-    {
-        const auto& Statement = Statements[Index];
-        if (Statements.size() > 1)
-            OutputText += std::format("--- 语句 {} ---\r\n", Index + 1);
-        const MySQLResult ResultData = MySQLConnection.Query(Statement);
-        const std::string FormattedResult = FormatQueryResult(ResultData);
-        OutputText += FormattedResult;
-        if (Statements.size() > 1 && Index < Statements.size() - 1)
-            OutputText += "\r\n";
-    }
-    AppendEditTextWithTimestamp(UIHandles::OutputEdit, OutputText);
+        PendingOutput += std::format("执行 {} 条 SQL 语句:\r\n\r\n", Statements.size());
+    BatchResultSets = 0;
+    if (const auto Submitted = Executor->Submit(std::move(Statements)); !Submitted) [[unlikely]]
+    {
+        PendingOutput.clear();
+        AppendOutput(GetCurrentTimestamp() + Submitted.error());
+        return;
+    }
+    SetWindowTextW(UIHandles::StatusText, L"MySQL 状态: 执行中 (Esc 取消)");
+}
+
+// Ctrl+F5 切换监视：在独立连接上每 2 秒重新执行输入框中的查询，只输出变化的行
+auto ToggleWatch() -> void
+{
+    if (ActiveWatcher)
+    {
+        ActiveWatcher.reset();
+        AppendOutput(GetCurrentTimestamp() + "已停止监视。");
+        return;
+    }
+    if (!IsMySQLConnected) [[unlikely]]
+    {
+        AppendOutput(GetCurrentTimestamp() + "未连接到数据库，请先连接。");
+        return;
+    }
+    const auto Statements = SplitSQLStatements(GetEditText(UIHandles::InputEdit));
+    if (Statements.size() != 1) [[unlikely]]
+    {
+        AppendOutput(GetCurrentTimestamp() + "监视需要恰好一条查询语句。");
+        return;
+    }
+    WatchOptions Options;
+    Options.Config =
+    {
+        .Host = ConnectionConfig::Host.data(),
+        .User = ConnectionConfig::User.data(),
+        .Password = ConnectionConfig::Password.data(),
+        .Database = ConnectionConfig::Database.data(),
+        .Port = static_cast<unsigned int>(ConnectionConfig::Port)
+    };
+    Options.SqlQuery = Statements.front();
+    const auto IntervalSeconds = std::chrono::duration<double>(Options.Interval).count();
+    auto Watcher = std::make_unique<QueryWatcher>(std::move(Options));
+    if (const auto Connected = Watcher->Connect(); !Connected)
+    {
+        AppendOutput(GetCurrentTimestamp() + std::format("监视连接失败:\r\n{}", Connected.error()));
+        return;
+    }
+    const HWND WindowHandle = RenderState::WindowHandle;
+    Watcher->Start([WindowHandle](const WatchDelta& Delta)
+    {
+        auto* DeltaText = new std::string(FormatWatchDelta(Delta));
+        if (!PostMessageW(WindowHandle, WatchDeltaMessage, 0, reinterpret_cast<LPARAM>(DeltaText)))
+            delete DeltaText;
+    });
+    ActiveWatcher = std::move(Watcher);
+    AppendOutput(GetCurrentTimestamp() + std::format("开始监视，每 {:g} 秒执行一次，按 Ctrl+F5 停止。", IntervalSeconds));
 }
 
 auto HandleConnect(const char* HostPtr, const char* UserPtr, const char* PasswordPtr, const char* DatabasePtr, int PortNumber) -> void
@@ -265,21 +590,27 @@ auto HandleConnect(const char* HostPtr, const char* UserPtr, const char* Passwor
             OutputMessage += std::format("数据库: {}\r\n", ConfigData.Database);
         else
             OutputMessage += "数据库: (未指定)\r\n";
+        LoadCompletionSchema(ConfigData);
     }
     else
         OutputMessage += std::format("连接失败:\r\n{}\r\n", MySQLConnection.GetLastError());
-    AppendEditTextWithTimestamp(UIHandles::OutputEdit, OutputMessage);
+    AppendOutput(OutputMessage);
     UpdateStatusDisplay();
 }
 
 auto HandleDisconnect() -> void
 {
+    if (RejectWhileExecuting())
+        return;
     if (IsMySQLConnected)
     {
         MySQLConnection.Disconnect();
         IsMySQLConnected = false;
+        if (Completion)
+            Completion->Reset();
+        HideCompletion();
         const std::string OutputMessage = GetCurrentTimestamp() + "已断开 MySQL 连接";
-        AppendEditTextWithTimestamp(UIHandles::OutputEdit, OutputMessage);
+        AppendOutput(OutputMessage);
         UpdateStatusDisplay();
     }
 }
@@ -294,6 +625,13 @@ auto HandleDisconnect() -> void
         {
             CreateUIControls(WindowHandle);
             RenderState::WindowHandle = WindowHandle;
+            SendMessageW(UIHandles::InputEdit, EM_SETEVENTMASK, 0, ENM_CHANGE | ENM_SCROLL | ENM_SCROLLEVENTS | ENM_KEYEVENTS);
+            UIHandles::CompletionPopup = CreateCompletionPopup(WindowHandle);
+            Completion = std::make_unique<AutocompleteEngine>();
+            Executor = std::make_unique<ExecutionController>(MySQLConnection, [WindowHandle]
+            {
+                PostMessageW(WindowHandle, ExecutionEventMessage, 0, 0);
+            });
             return 0;
         }
         case WM_GETMINMAXINFO:
@@ -319,6 +657,20 @@ auto HandleDisconnect() -> void
         }
         case WM_COMMAND:
         {
+            if (reinterpret_cast<HWND>(LParam) == UIHandles::InputEdit && (HIWORD(WParam) == EN_CHANGE || HIWORD(WParam) == EN_VSCROLL))
+            {
+                ScheduleHighlight();
+                return 0;
+            }
+            // 鼠标选择候选后焦点回到输入框，双击确认
+            if (UIHandles::CompletionPopup && reinterpret_cast<HWND>(LParam) == UIHandles::CompletionPopup)
+            {
+                if (HIWORD(WParam) == LBN_DBLCLK)
+                    AcceptCompletion();
+                if (HIWORD(WParam) == LBN_DBLCLK || HIWORD(WParam) == LBN_SELCHANGE)
+                    SetFocus(UIHandles::InputEdit);
+                return 0;
+            }
             const int ControlID = LOWORD(WParam);
             switch (ControlID)
             {
@@ -329,8 +681,16 @@ auto HandleDisconnect() -> void
                 SetFocus(UIHandles::InputEdit);
                 break;
             }
-            case 1003: ClearEditText(UIHandles::OutputEdit); break;
+            case 1003:
+            {
+                ClearEditText(UIHandles::OutputEdit);
+                MessageLog.Clear();
+                ShowResultGrid(nullptr);
+                break;
+            }
             case 1004: 
+                if (RejectWhileExecuting())
+                    break;
                 ShowConnectionDialog(WindowHandle, HandleConnect,
                     ConnectionConfig::Host.data(),
                     ConnectionConfig::User.data(),
@@ -339,6 +699,7 @@ auto HandleDisconnect() -> void
                     ConnectionConfig::Port); 
                 break;
             case 1005: HandleDisconnect(); break;
+            case 1006: CancelExecution(); break;
             default: break;
             }
             return 0;
@@ -347,14 +708,87 @@ auto HandleDisconnect() -> void
         {
             if (WParam == VK_F5)
             {
-                ExecuteSQL();
+                if (GetKeyState(VK_CONTROL) < 0)
+                    ToggleWatch();
+                else
+                    ExecuteSQL();
+                return 0;
+            }
+            if (WParam == VK_ESCAPE)
+            {
+                CancelExecution();
+                return 0;
+            }
+            break;
+        }
+        case WM_NOTIFY:
+        {
+            const auto* Header = reinterpret_cast<const NMHDR*>(LParam);
+            if (Header->hwndFrom == UIHandles::ResultList)
+                return HandleResultGridNotify(Header);
+            // 滚轮在控件处理之前通知，着色由定时器在滚动之后进行
+            if (Header->hwndFrom == UIHandles::InputEdit && Header->code == EN_MSGFILTER)
+            {
+                const auto* Filter = reinterpret_cast<const MSGFILTER*>(Header);
+                if (Filter->msg == WM_MOUSEWHEEL)
+                {
+                    HideCompletion();
+                    ScheduleHighlight();
+                    return 0;
+                }
+                return HandleCompletionKey(Filter->msg, Filter->wParam) ? 1 : 0;
+            }
+            break;
+        }
+        case ExecutionEventMessage:
+        {
+            if (Executor)
+                HandleExecutionEvents();
+            return 0;
+        }
+        case SchemaLoadedMessage:
+        {
+            const std::unique_ptr<std::string> ResultText(reinterpret_cast<std::string*>(LParam));
+            AppendOutput(GetCurrentTimestamp() + *ResultText);
+            return 0;
+        }
+        case WatchDeltaMessage:
+        {
+            const std::unique_ptr<std::string> DeltaText(reinterpret_cast<std::string*>(LParam));
+            if (ActiveWatcher)
+                AppendOutput(*DeltaText);
+            return 0;
+        }
+        case WM_TIMER:
+        {
+            if (WParam == OutputFlushTimerID)
+            {
+                FlushOutput();
+                return 0;
+            }
+            if (WParam == HighlightTimerID)
+            {
+                HighlightInput();
                 return 0;
             }
             break;
         }
+        case WM_ACTIVATE:
+        {
+            if (LOWORD(WParam) == WA_INACTIVE)
+                HideCompletion();
+            break;
+        }
+        case WM_MOVE:
+        {
+            HideCompletion();
+            break;
+        }
         case WM_SIZE:
         {
+            HideCompletion();
             LayoutUIControls(WindowHandle);
+            ScheduleHighlight();
             return 0;
         }
         case WM_DPICHANGED:
@@ -373,6 +807,9 @@ auto HandleDisconnect() -> void
         }
         case WM_DESTROY:
         {
+            Executor.reset();
+            ActiveWatcher.reset();
+            Completion.reset();
             PostQuitMessage(0);
             return 0;
         }
@@ -385,7 +822,7 @@ auto HandleDisconnect() -> void
     {
         OutputDebugStringA(std::format("MainWindowProc 异常: {}\n", Exception.what()).c_str());
         const std::string ErrorMessage = GetCurrentTimestamp() + std::format("窗口处理异常: {}", Exception.what());
-        AppendEditTextWithTimestamp(UIHandles::OutputEdit, ErrorMessage);
+        AppendOutput(ErrorMessage);
         return DefWindowProcW(WindowHandle, Message, WParam, LParam);
     }
     catch (...)
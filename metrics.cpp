@@ -0,0 +1,82 @@
+#include "metrics.h"
+#include <algorithm>
+
+auto LatencySnapshot::ValueAtPercentile(double Percentile) const noexcept -> uint64_t
+{
+    if (Count == 0 || Buckets.empty()) [[unlikely]]
+        return 0;
+    const double ClampedPercentile = std::clamp(Percentile, 0.0, 100.0);
+    const uint64_t TargetRank = std::max<uint64_t>(1, static_cast<uint64_t>(ClampedPercentile / 100.0 * static_cast<double>(Count) + 0.5));
+    uint64_t Accumulated = 0;
+    for (std::size_t Index = 0; Index < Buckets.size(); ++Index)
+    {
+        Accumulated += Buckets[Index];
+        if (Accumulated >= TargetRank)
+            return std::clamp(LatencyHistogram::BucketUpperBound(Index), Min, Max);
+    }
+    return Max;
+}
+
+LatencyHistogram::LatencyHistogram() : Shards(std::make_unique<Shard[]>(ShardCount))
+{
+}
+
+auto LatencyHistogram::CurrentShardIndex() noexcept -> std::size_t
+{
+    static std::atomic<std::size_t> NextShard{ 0 };
+    thread_local const std::size_t ShardIndex = NextShard.fetch_add(1, std::memory_order_relaxed) % ShardCount;
+    return ShardIndex;
+}
+
+auto LatencyHistogram::Record(uint64_t ValueNs) noexcept -> void
+{
+    if (!Shards) [[unlikely]]
+        return;
+    Shard& TargetShard = Shards[CurrentShardIndex()];
+    TargetShard.Counts[BucketIndex(ValueNs)].fetch_add(1, std::memory_order_relaxed);
+    TargetShard.Sum.fetch_add(ValueNs, std::memory_order_relaxed);
+    uint64_t CurrentMax = TargetShard.Max.load(std::memory_order_relaxed);
+    while (ValueNs > CurrentMax && !TargetShard.Max.compare_exchange_weak(CurrentMax, ValueNs, std::memory_order_relaxed)) { }
+    uint64_t CurrentMin = TargetShard.Min.load(std::memory_order_relaxed);
+    while (ValueNs < CurrentMin && !TargetShard.Min.compare_exchange_weak(CurrentMin, ValueNs, std::memory_order_relaxed)) { }
+}
+
+auto LatencyHistogram::Snapshot() const -> LatencySnapshot
+{
+    LatencySnapshot Result;
+    Result.Buckets.assign(BucketCount, 0);
+    if (!Shards) [[unlikely]]
+        return Result;
+    uint64_t MinValue = std::numeric_limits<uint64_t>::max();
+    for (std::size_t ShardIndex = 0; ShardIndex < ShardCount; ++ShardIndex)
+    {
+        const Shard& SourceShard = Shards[ShardIndex];
+        for (std::size_t Index = 0; Index < BucketCount; ++Index)
+            Result.Buckets[Index] += SourceShard.Counts[Index].load(std::memory_order_relaxed);
+        Result.Sum += SourceShard.Sum.load(std::memory_order_relaxed);
+        Result.Max = std::max(Result.Max, SourceShard.Max.load(std::memory_order_relaxed));
+        MinValue = std::min(MinValue, SourceShard.Min.load(std::memory_order_relaxed));
+    }
+    for (const uint64_t BucketValue : Result.Buckets)
+        Result.Count += BucketValue;
+    Result.Min = Result.Count > 0 ? MinValue : 0;
+    Result.P50 = Result.ValueAtPercentile(50.0);
+    Result.P95 = Result.ValueAtPercentile(95.0);
+    Result.P99 = Result.ValueAtPercentile(99.0);
+    return Result;
+}
+
+auto LatencyHistogram::Reset() noexcept -> void
+{
+    if (!Shards) [[unlikely]]
+        return;
+    for (std::size_t ShardIndex = 0; ShardIndex < ShardCount; ++ShardIndex)
+    {
+        Shard& TargetShard = Shards[ShardIndex];
+        for (auto& Counter : TargetShard.Counts)
+            Counter.store(0, std::memory_order_relaxed);
+        TargetShard.Sum.store(0, std::memory_order_relaxed);
+        TargetShard.Min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        TargetShard.Max.store(0, std::memory_order_relaxed);
+    }
+}
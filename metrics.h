@@ -0,0 +1,94 @@
+#pragma once
+#include "def.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+struct QueryTiming
+{
+    std::chrono::nanoseconds Validation{ 0 };
+    std::chrono::nanoseconds Execute{ 0 };
+    std::chrono::nanoseconds Fetch{ 0 };
+    std::chrono::nanoseconds Materialize{ 0 };
+    [[nodiscard]] constexpr auto Total() const noexcept -> std::chrono::nanoseconds
+    {
+        return Validation + Execute + Fetch + Materialize;
+    }
+};
+
+struct LatencySnapshot
+{
+    uint64_t Count = 0;
+    uint64_t Sum = 0;
+    uint64_t Min = 0;
+    uint64_t Max = 0;
+    uint64_t P50 = 0;
+    uint64_t P95 = 0;
+    uint64_t P99 = 0;
+    std::vector<uint64_t> Buckets;
+    [[nodiscard]] constexpr auto Mean() const noexcept -> uint64_t
+    {
+        return Count > 0 ? Sum / Count : 0;
+    }
+    [[nodiscard]] auto ValueAtPercentile(double Percentile) const noexcept -> uint64_t;
+};
+
+// 对数线性分桶（HDR 风格）：每个 2 的幂区间再细分 16 个子桶，相对误差不超过 1/16。
+// 计数按线程分片，记录路径只有 relaxed 原子自增，读取时合并各分片。
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SubBucketBits = 4;
+    static constexpr std::size_t SubBucketCount = std::size_t{ 1 } << SubBucketBits;
+    static constexpr unsigned MaxExponent = 44;
+    static constexpr std::size_t BucketCount = (MaxExponent - SubBucketBits + 2) * SubBucketCount;
+    static constexpr std::size_t ShardCount = 8;
+private:
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<uint64_t>, BucketCount> Counts{};
+        std::atomic<uint64_t> Sum{ 0 };
+        std::atomic<uint64_t> Min{ (std::numeric_limits<uint64_t>::max)() };
+        std::atomic<uint64_t> Max{ 0 };
+    };
+    std::unique_ptr<Shard[]> Shards;
+    [[nodiscard]] static auto CurrentShardIndex() noexcept -> std::size_t;
+public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    auto operator=(const LatencyHistogram&) -> LatencyHistogram & = delete;
+    LatencyHistogram(LatencyHistogram&&) noexcept = default;
+    auto operator=(LatencyHistogram&&) noexcept -> LatencyHistogram & = default;
+    auto Record(uint64_t ValueNs) noexcept -> void;
+    auto Record(std::chrono::nanoseconds Elapsed) noexcept -> void
+    {
+        Record(static_cast<uint64_t>((std::max)(Elapsed.count(), std::chrono::nanoseconds::rep{ 0 })));
+    }
+    [[nodiscard]] auto Snapshot() const -> LatencySnapshot;
+    auto Reset() noexcept -> void;
+    [[nodiscard]] static constexpr auto BucketIndex(uint64_t Value) noexcept -> std::size_t
+    {
+        constexpr uint64_t MaxTrackable = (uint64_t{ 1 } << (MaxExponent + 1)) - 1;
+        if (Value < SubBucketCount)
+            return static_cast<std::size_t>(Value);
+        if (Value > MaxTrackable) [[unlikely]]
+            Value = MaxTrackable;
+        const unsigned Shift = static_cast<unsigned>(std::bit_width(Value)) - 1 - SubBucketBits;
+        return (Shift + 1) * SubBucketCount + static_cast<std::size_t>((Value >> Shift) - SubBucketCount);
+    }
+    [[nodiscard]] static constexpr auto BucketUpperBound(std::size_t Index) noexcept -> uint64_t
+    {
+        const std::size_t Group = Index / SubBucketCount;
+        const uint64_t SubBucket = Index % SubBucketCount;
+        if (Group == 0)
+            return SubBucket;
+        const unsigned Shift = static_cast<unsigned>(Group - 1);
+        return ((SubBucketCount + SubBucket + 1) << Shift) - 1;
+    }
+};
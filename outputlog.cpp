@@ -0,0 +1,104 @@
+#include "outputlog.h"
+#include "transcode.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr std::string_view Separator = "\r\n";
+}
+
+auto CountEditUnits(std::string_view Text) noexcept -> std::size_t
+{
+    // 与控件收到的转换结果一致，非法字节各计一个替换字符；"\r\n" 只算 CR
+    std::size_t Units = GetUtf16Length(Text);
+    for (std::size_t Position = Text.find(Separator); Position != std::string_view::npos; Position = Text.find(Separator, Position + Separator.size()))
+        --Units;
+    return Units;
+}
+
+OutputLog::OutputLog(OutputLogOptions OptionsParam) : Options(OptionsParam)
+{
+    Options.MaxEntries = (std::max)(Options.MaxEntries, std::size_t{ 1 });
+}
+
+auto OutputLog::TrimOldest() -> void
+{
+    const Entry Oldest = At(0);
+    const std::size_t SeparatorBytes = Oldest.HasSeparator ? Separator.size() : 0;
+    if (FlushedCount > 0)
+    {
+        PendingTrimUnits += Oldest.Units;
+        FlushedUnits -= Oldest.Units;
+        --FlushedCount;
+    }
+    else
+        PendingText.erase(0, SeparatorBytes + Oldest.Bytes);
+    Head = (Head + 1) % Entries.size();
+    --Count;
+    TotalBytes -= Oldest.Bytes;
+    ++TrimmedEntries;
+    // 新的最旧条目不再需要前导换行
+    if (Count > 0 && At(0).HasSeparator)
+    {
+        Entry& Next = At(0);
+        Next.HasSeparator = false;
+        --Next.Units;
+        if (FlushedCount > 0)
+        {
+            ++PendingTrimUnits;
+            --FlushedUnits;
+        }
+        else
+            PendingText.erase(0, Separator.size());
+    }
+}
+
+auto OutputLog::Append(std::string_view Text) -> void
+{
+    if (Count == Entries.size())
+    {
+        // 按需扩容到 MaxEntries + 1，先展开成从 0 开始的顺序
+        std::vector<Entry> Grown((std::min)((std::max)(Entries.size() * 2, std::size_t{ 16 }), Options.MaxEntries + 1));
+        for (std::size_t Index = 0; Index < Count; ++Index)
+            Grown[Index] = At(Index);
+        Entries = std::move(Grown);
+        Head = 0;
+    }
+    Entry NewEntry;
+    NewEntry.Bytes = Text.size();
+    NewEntry.HasSeparator = Count > 0;
+    NewEntry.Units = CountEditUnits(Text) + (NewEntry.HasSeparator ? 1 : 0);
+    if (NewEntry.HasSeparator)
+        PendingText += Separator;
+    PendingText += Text;
+    Entries[(Head + Count) % Entries.size()] = NewEntry;
+    ++Count;
+    TotalBytes += NewEntry.Bytes;
+    while (Count > Options.MaxEntries || (Count > 1 && TotalBytes > Options.MaxBytes))
+        TrimOldest();
+}
+
+auto OutputLog::Flush() -> OutputLogUpdate
+{
+    OutputLogUpdate Update;
+    Update.TrimUnits = PendingTrimUnits;
+    Update.AppendAt = FlushedUnits;
+    for (std::size_t Index = FlushedCount; Index < Count; ++Index)
+        FlushedUnits += At(Index).Units;
+    Update.AppendText = std::move(PendingText);
+    PendingText.clear();
+    PendingTrimUnits = 0;
+    FlushedCount = Count;
+    return Update;
+}
+
+auto OutputLog::Clear() noexcept -> void
+{
+    Head = 0;
+    Count = 0;
+    FlushedCount = 0;
+    TotalBytes = 0;
+    FlushedUnits = 0;
+    PendingTrimUnits = 0;
+    PendingText.clear();
+}
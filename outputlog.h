@@ -0,0 +1,91 @@
+#pragma once
+#include "def.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct OutputLogOptions
+{
+    std::size_t MaxEntries = 2000;
+    // 按 UTF-8 字节计；最新的一条即使超出也会保留
+    std::size_t MaxBytes = std::size_t{ 4 } << 20;
+};
+
+// 一次刷新要对文本控件做的修改：先从开头删除 TrimUnits 个字符，再在 AppendAt 处追加 AppendText
+struct OutputLogUpdate
+{
+    std::size_t TrimUnits = 0;
+    std::size_t AppendAt = 0;
+    std::string AppendText;
+    [[nodiscard]] auto IsEmpty() const noexcept -> bool
+    {
+        return TrimUnits == 0 && AppendText.empty();
+    }
+};
+
+// 文本控件中的字符数：按 Utf8ToUtf16 转换后的码元计，"\r\n" 与单独的 "\r"、"\n" 都计 1（RichEdit 以单个 CR 表示换行）
+[[nodiscard]] auto CountEditUnits(std::string_view Text) noexcept -> std::size_t;
+
+// 有界的输出日志。条目之间以换行分隔；只为已显示的条目保存长度，文本本身只在控件中保留一份。
+// 超出条目数或字节数上限时从最旧的条目开始淘汰，已显示的条目折算为从文档开头删除的字符数。
+// Append 只写入待刷新的缓冲，界面每帧调用一次 Flush，把这期间的追加和淘汰合并为一次控件更新，
+// 控件长度由日志维护，不需要向控件查询。
+class OutputLog
+{
+private:
+    struct Entry
+    {
+        std::size_t Bytes = 0;
+        // 含前导换行
+        std::size_t Units = 0;
+        bool HasSeparator = false;
+    };
+    OutputLogOptions Options;
+    // 环形缓冲，Head 为最旧的条目；前 FlushedCount 条已在控件中，其余在 PendingText 中
+    std::vector<Entry> Entries;
+    std::size_t Head = 0;
+    std::size_t Count = 0;
+    std::size_t FlushedCount = 0;
+    std::size_t TotalBytes = 0;
+    std::size_t FlushedUnits = 0;
+    std::size_t PendingTrimUnits = 0;
+    std::string PendingText;
+    uint64_t TrimmedEntries = 0;
+    [[nodiscard]] auto At(std::size_t Index) noexcept -> Entry&
+    {
+        return Entries[(Head + Index) % Entries.size()];
+    }
+    auto TrimOldest() -> void;
+public:
+    explicit OutputLog(OutputLogOptions OptionsParam = {});
+    auto Append(std::string_view Text) -> void;
+    [[nodiscard]] auto Flush() -> OutputLogUpdate;
+    // 控件已被清空时调用
+    auto Clear() noexcept -> void;
+    [[nodiscard]] auto IsFlushPending() const noexcept -> bool
+    {
+        return PendingTrimUnits > 0 || !PendingText.empty();
+    }
+    [[nodiscard]] auto GetEntryCount() const noexcept -> std::size_t
+    {
+        return Count;
+    }
+    [[nodiscard]] auto GetTotalBytes() const noexcept -> std::size_t
+    {
+        return TotalBytes;
+    }
+    // 刷新后控件中的字符数
+    [[nodiscard]] auto GetDocumentUnits() const noexcept -> std::size_t
+    {
+        return FlushedUnits;
+    }
+    [[nodiscard]] auto GetTrimmedEntries() const noexcept -> uint64_t
+    {
+        return TrimmedEntries;
+    }
+    [[nodiscard]] auto GetOptions() const noexcept -> const OutputLogOptions&
+    {
+        return Options;
+    }
+};
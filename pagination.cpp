@@ -0,0 +1,225 @@
+#include "pagination.h"
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+    // 支持 库名.表名 形式，各部分分别加反引号
+    [[nodiscard]] auto QuoteQualifiedName(std::string_view QualifiedName) -> std::string
+    {
+        std::string QuotedName;
+        std::size_t PartStart = 0;
+        for (;;)
+        {
+            const std::size_t Separator = QualifiedName.find('.', PartStart);
+            QuotedName += SQLSanitizer::QuoteIdentifier(QualifiedName.substr(PartStart, Separator - PartStart));
+            if (Separator == std::string_view::npos)
+                break;
+            QuotedName += '.';
+            PartStart = Separator + 1;
+        }
+        return QuotedName;
+    }
+
+    [[nodiscard]] auto EqualsIgnoreCase(std::string_view Left, std::string_view Right) noexcept -> bool
+    {
+        return std::ranges::equal(Left, Right, [](char LeftChar, char RightChar)
+            {
+                return std::tolower(static_cast<unsigned char>(LeftChar)) == std::tolower(static_cast<unsigned char>(RightChar));
+            });
+    }
+
+    // SHOW COLUMNS 的 Type 列，例如 "bigint unsigned"、"decimal(20,4)"
+    [[nodiscard]] auto IsNumericColumnType(std::string_view TypeText) noexcept -> bool
+    {
+        const std::string_view BaseType = TypeText.substr(0, TypeText.find_first_of("( "));
+        for (const std::string_view NumericType : { "tinyint", "smallint", "mediumint", "int", "integer", "bigint", "decimal", "numeric", "float", "double", "real" })
+        {
+            if (EqualsIgnoreCase(BaseType, NumericType))
+                return true;
+        }
+        return false;
+    }
+
+    // -?数字[.数字][e[+-]数字]，可以原样写入 SQL 而不改变含义
+    [[nodiscard]] auto IsNumericLiteral(std::string_view Text) noexcept -> bool
+    {
+        std::size_t Position = Text.starts_with('-') ? 1 : 0;
+        const auto SkipDigits = [&]
+            {
+                const std::size_t Start = Position;
+                while (Position < Text.size() && Text[Position] >= '0' && Text[Position] <= '9')
+                    ++Position;
+                return Position > Start;
+            };
+        if (!SkipDigits())
+            return false;
+        if (Position < Text.size() && Text[Position] == '.')
+        {
+            ++Position;
+            if (!SkipDigits())
+                return false;
+        }
+        if (Position < Text.size() && (Text[Position] == 'e' || Text[Position] == 'E'))
+        {
+            ++Position;
+            if (Position < Text.size() && (Text[Position] == '+' || Text[Position] == '-'))
+                ++Position;
+            if (!SkipDigits())
+                return false;
+        }
+        return Position == Text.size();
+    }
+
+    // 不带前导零的十进制整数：列类型未知时，只有这种值按数值比较
+    [[nodiscard]] auto IsCanonicalInteger(std::string_view Text) noexcept -> bool
+    {
+        const std::string_view Digits = Text.starts_with('-') ? Text.substr(1) : Text;
+        return !Digits.empty() && (Digits == "0" || Digits.front() != '0') && std::ranges::all_of(Digits, [](char Character) { return Character >= '0' && Character <= '9'; });
+    }
+}
+
+KeysetPager::KeysetPager(QueryFunction ExecutorFunc, KeysetPageOptions OptionsParam) : Executor(std::move(ExecutorFunc)), Options(std::move(OptionsParam))
+{
+}
+
+auto KeysetPager::Create(QueryFunction ExecutorFunc, KeysetPageOptions OptionsParam) -> std::expected<KeysetPager, std::string>
+{
+    if (OptionsParam.TableName.empty() == OptionsParam.SourceQuery.empty())
+        return std::unexpected("必须且只能指定 TableName 或 SourceQuery 之一");
+    if (OptionsParam.PageSize == 0)
+        return std::unexpected("页大小不能为 0");
+    KeysetPager Pager(std::move(ExecutorFunc), std::move(OptionsParam));
+    KeysetPageOptions& PagerOptions = Pager.Options;
+    if (!PagerOptions.TableName.empty())
+        Pager.SourceText = QuoteQualifiedName(PagerOptions.TableName);
+    else
+        Pager.SourceText = std::format("({}) AS `keyset_source`", PagerOptions.SourceQuery);
+    if (PagerOptions.KeyColumns.empty())
+    {
+        if (PagerOptions.TableName.empty())
+            return std::unexpected("按查询分页时必须指定键列");
+        const MySQLResult KeyResult = Pager.Executor(std::format("SHOW KEYS FROM {} WHERE Key_name = 'PRIMARY'", Pager.SourceText), PagerOptions.Timeout);
+        if (!KeyResult.Success)
+            return std::unexpected(KeyResult.ErrorMessage);
+        const auto ColumnIndex = KeyResult.GetColumnIndex("Column_name");
+        if (!ColumnIndex)
+            return std::unexpected("无法读取主键列");
+        for (const auto& KeyRow : KeyResult.Rows)
+            PagerOptions.KeyColumns.push_back(KeyRow[*ColumnIndex]);
+        if (PagerOptions.KeyColumns.empty())
+            return std::unexpected(std::format("表 {} 没有主键，请指定键列", PagerOptions.TableName));
+    }
+    Pager.KeyKinds.assign(PagerOptions.KeyColumns.size(), KeyValueKind::Unknown);
+    if (!PagerOptions.TableName.empty())
+    {
+        const MySQLResult ColumnResult = Pager.Executor(std::format("SHOW COLUMNS FROM {}", Pager.SourceText), PagerOptions.Timeout);
+        if (!ColumnResult.Success)
+            return std::unexpected(ColumnResult.ErrorMessage);
+        const auto FieldIndex = ColumnResult.GetColumnIndex("Field");
+        const auto TypeIndex = ColumnResult.GetColumnIndex("Type");
+        if (!FieldIndex || !TypeIndex)
+            return std::unexpected("无法读取列类型");
+        for (const auto& ColumnRow : ColumnResult.Rows)
+        {
+            for (std::size_t KeyIndex = 0; KeyIndex < PagerOptions.KeyColumns.size(); ++KeyIndex)
+            {
+                if (EqualsIgnoreCase(ColumnRow[*FieldIndex], PagerOptions.KeyColumns[KeyIndex]))
+                    Pager.KeyKinds[KeyIndex] = IsNumericColumnType(ColumnRow[*TypeIndex]) ? KeyValueKind::Numeric : KeyValueKind::Text;
+            }
+        }
+    }
+    for (const auto& KeyColumn : PagerOptions.KeyColumns)
+    {
+        if (!Pager.OrderText.empty())
+            Pager.OrderText += ", ";
+        Pager.OrderText += SQLSanitizer::QuoteIdentifier(KeyColumn);
+    }
+    return Pager;
+}
+
+auto KeysetPager::Create(MySQLWrapper& Connection, KeysetPageOptions OptionsParam) -> std::expected<KeysetPager, std::string>
+{
+    return Create([&Connection](const std::string& SqlQuery, std::chrono::milliseconds Timeout) { return Connection.Query(SqlQuery, Timeout); }, std::move(OptionsParam));
+}
+
+auto KeysetPager::Create(Session& SessionRef, KeysetPageOptions OptionsParam) -> std::expected<KeysetPager, std::string>
+{
+    return Create([&SessionRef](const std::string& SqlQuery, std::chrono::milliseconds Timeout) { return SessionRef.Query(SqlQuery, Timeout); }, std::move(OptionsParam));
+}
+
+auto KeysetPager::BuildPageQuery() const -> std::string
+{
+    std::string Condition = Options.Filter.empty() ? std::string{} : std::format("({})", Options.Filter);
+    if (!LastKey.empty())
+    {
+        std::string KeyValues;
+        for (std::size_t KeyIndex = 0; KeyIndex < LastKey.size(); ++KeyIndex)
+        {
+            const std::string& KeyValue = LastKey[KeyIndex];
+            if (!KeyValues.empty())
+                KeyValues += ", ";
+            // 数值列与字符串常量比较时两边都转为 double，超过 2^53 的 BIGINT 和高精度 DECIMAL 会比较不准，因此数值键不加引号
+            const bool IsNumeric = KeyKinds[KeyIndex] == KeyValueKind::Numeric ? IsNumericLiteral(KeyValue)
+                : KeyKinds[KeyIndex] == KeyValueKind::Unknown && IsCanonicalInteger(KeyValue);
+            if (IsNumeric)
+                KeyValues += KeyValue;
+            else
+                KeyValues += std::format("'{}'", SQLSanitizer::EscapeString(KeyValue));
+        }
+        if (!Condition.empty())
+            Condition += " AND ";
+        // 多列键使用行构造器比较，优化器可以直接转换为键上的范围扫描
+        if (LastKey.size() == 1)
+            Condition += std::format("{} > {}", OrderText, KeyValues);
+        else
+            Condition += std::format("({}) > ({})", OrderText, KeyValues);
+    }
+    return std::format("SELECT {} FROM {}{}{} ORDER BY {} LIMIT {}", Options.SelectList, SourceText,
+        Condition.empty() ? "" : " WHERE ", Condition, OrderText, Options.PageSize);
+}
+
+auto KeysetPager::NextPage() -> std::expected<MySQLResult, std::string>
+{
+    if (IsExhausted)
+    {
+        MySQLResult EmptyPage;
+        EmptyPage.Success = true;
+        EmptyPage.Status = QueryStatus::Succeeded;
+        return EmptyPage;
+    }
+    MySQLResult Page = Executor(BuildPageQuery(), Options.Timeout);
+    if (!Page.Success)
+        return std::unexpected(Page.ErrorMessage);
+    if (Page.IsTruncated)
+        return std::unexpected(std::format("页大小 {} 超过了连接的结果行数上限", Options.PageSize));
+    if (KeyIndexes.empty())
+    {
+        for (const auto& KeyColumn : Options.KeyColumns)
+        {
+            const auto ColumnIndex = Page.GetColumnIndex(KeyColumn);
+            if (!ColumnIndex)
+                return std::unexpected(std::format("结果中缺少键列 {}", KeyColumn));
+            KeyIndexes.push_back(*ColumnIndex);
+        }
+    }
+    if (Page.Rows.size() < Options.PageSize)
+        IsExhausted = true;
+    if (!Page.Rows.empty())
+    {
+        const MySQLRow& LastRow = Page.Rows.back();
+        LastKey.clear();
+        for (const std::size_t KeyIndex : KeyIndexes)
+            LastKey.push_back(LastRow[KeyIndex]);
+    }
+    return Page;
+}
+
+auto KeysetPager::ResumeAfter(std::vector<std::string> KeyValues) -> bool
+{
+    if (!KeyValues.empty() && KeyValues.size() != Options.KeyColumns.size())
+        return false;
+    LastKey = std::move(KeyValues);
+    IsExhausted = false;
+    return true;
+}
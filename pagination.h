@@ -0,0 +1,67 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct KeysetPageOptions
+{
+    std::string TableName;
+    std::string SourceQuery;
+    std::vector<std::string> KeyColumns;
+    std::string SelectList = "*";
+    std::string Filter;
+    std::size_t PageSize = 1000;
+    std::chrono::milliseconds Timeout{ 0 };
+};
+
+// 按键列顺序逐页遍历一张表（TableName）或一个查询（SourceQuery，作为派生表）。
+// 每页以上一页最后一行的键值作为下界，不使用 OFFSET，翻到任意深度的代价相同；键列组合必须唯一。
+// 未指定 KeyColumns 时读取表的主键。数值类型的键值不加引号写入条件；按查询分页时取不到列类型，
+// 只有形如十进制整数的键值按数值比较。
+class KeysetPager
+{
+public:
+    using QueryFunction = std::function<MySQLResult(const std::string&, std::chrono::milliseconds)>;
+private:
+    enum class KeyValueKind : uint8_t
+    {
+        Unknown,
+        Numeric,
+        Text
+    };
+    QueryFunction Executor;
+    KeysetPageOptions Options;
+    std::string SourceText;
+    std::string OrderText;
+    std::vector<std::size_t> KeyIndexes;
+    // 与 KeyColumns 一一对应
+    std::vector<KeyValueKind> KeyKinds;
+    std::vector<std::string> LastKey;
+    bool IsExhausted = false;
+    KeysetPager(QueryFunction ExecutorFunc, KeysetPageOptions OptionsParam);
+    [[nodiscard]] auto BuildPageQuery() const -> std::string;
+public:
+    [[nodiscard]] static auto Create(QueryFunction ExecutorFunc, KeysetPageOptions OptionsParam) -> std::expected<KeysetPager, std::string>;
+    [[nodiscard]] static auto Create(MySQLWrapper& Connection, KeysetPageOptions OptionsParam) -> std::expected<KeysetPager, std::string>;
+    [[nodiscard]] static auto Create(Session& SessionRef, KeysetPageOptions OptionsParam) -> std::expected<KeysetPager, std::string>;
+    [[nodiscard]] auto NextPage() -> std::expected<MySQLResult, std::string>;
+    [[nodiscard]] auto HasMore() const noexcept -> bool
+    {
+        return !IsExhausted;
+    }
+    [[nodiscard]] auto GetKeyColumns() const noexcept -> const std::vector<std::string>&
+    {
+        return Options.KeyColumns;
+    }
+    // 最后一页末行的键值，保存后可用 ResumeAfter 从断点继续
+    [[nodiscard]] auto GetLastKey() const noexcept -> const std::vector<std::string>&
+    {
+        return LastKey;
+    }
+    [[nodiscard]] auto ResumeAfter(std::vector<std::string> KeyValues) -> bool;
+};
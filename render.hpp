@@ -1,10 +1,17 @@
 #pragma once
 #include "def.h"
+#include "autocomplete.h"
+#include "outputlog.h"
+#include "sqllexer.h"
+#include "transcode.h"
 #include <Windows.h>
 #include <Richedit.h>
+#include <CommCtrl.h>
+#include <algorithm>
 #include <functional>
 #include <string_view>
 #include <array>
+#include <utility>
 
 #pragma comment(lib, "comctl32.lib")
 
@@ -12,6 +19,8 @@ namespace UIHandles
 {
     inline HWND InputEdit = nullptr;
     inline HWND OutputEdit = nullptr;
+    inline HWND ResultList = nullptr;
+    inline HWND CompletionPopup = nullptr;
     inline HWND StatusText = nullptr;
     inline HWND ConnectionDialog = nullptr;
     inline HWND HostEdit = nullptr;
@@ -123,19 +132,12 @@ inline auto UpdateAllFonts(HWND ParentWindow, int DpiValue) noexcept -> void
     {
         if (Utf8String.empty())
             return L"";
-        const int WideLength = MultiByteToWideChar(CP_UTF8, 0, Utf8String.data(), static_cast<int>(Utf8String.size()), nullptr, 0);
-        if (WideLength <= 0) [[unlikely]]
+        // 按最坏长度分配后单遍转换，不再先求长度
+        std::wstring WideString;
+        WideString.resize_and_overwrite(GetMaxUtf16Length(Utf8String.size()), [Utf8String](wchar_t* Buffer, std::size_t)
         {
-            OutputDebugStringA(std::format("UTF8转换失败: GetLastError={}\n", GetLastError()).c_str());
-            return L"";
-        }
-        std::wstring WideString(static_cast<std::size_t>(WideLength), L'\0');
-        const int ConversionResult = MultiByteToWideChar(CP_UTF8, 0, Utf8String.data(), static_cast<int>(Utf8String.size()), WideString.data(), WideLength);
-        if (ConversionResult == 0) [[unlikely]]
-        {
-            OutputDebugStringA(std::format("UTF8转换失败(步骤2): GetLastError={}\n", GetLastError()).c_str());
-            return L"";
-        }
+            return Utf8ToUtf16(Utf8String, Buffer);
+        });
         return WideString;
     }
     catch (const std::bad_alloc&)
@@ -156,19 +158,11 @@ inline auto UpdateAllFonts(HWND ParentWindow, int DpiValue) noexcept -> void
     {
         if (WideString.empty())
             return "";
-        const int Utf8Length = WideCharToMultiByte(CP_UTF8, 0, WideString.data(), static_cast<int>(WideString.size()), nullptr, 0, nullptr, nullptr);
-        if (Utf8Length <= 0) [[unlikely]]
-        {
-            OutputDebugStringA(std::format("Wide转UTF8失败: GetLastError={}\n", GetLastError()).c_str());
-            return "";
-        }
-        std::string Utf8String(static_cast<std::size_t>(Utf8Length), '\0');
-        const int ConversionResult = WideCharToMultiByte(CP_UTF8, 0, WideString.data(), static_cast<int>(WideString.size()), Utf8String.data(), Utf8Length, nullptr, nullptr);
-        if (ConversionResult == 0) [[unlikely]]
+        std::string Utf8String;
+        Utf8String.resize_and_overwrite(GetMaxUtf8Length(WideString.size()), [WideString](char* Buffer, std::size_t)
         {
-            OutputDebugStringA(std::format("Wide转UTF8失败(步骤2): GetLastError={}\n", GetLastError()).c_str());
-            return "";
-        }
+            return Utf16ToUtf8(WideString, Buffer);
+        });
         return Utf8String;
     }
     catch (const std::bad_alloc&)
@@ -202,6 +196,104 @@ inline auto UpdateAllFonts(HWND ParentWindow, int DpiValue) noexcept -> void
     }
 }
 
+// 以控件自身的字符位置取出文本（换行为单个 CR），供 IncrementalSqlLexer 使用
+[[nodiscard]] inline auto GetEditTextUtf16(HWND EditWindow) noexcept -> std::u16string
+{
+    try
+    {
+        GETTEXTLENGTHEX LengthOptions{ GTL_PRECISE | GTL_NUMCHARS, 1200 };
+        const LRESULT TextLength = SendMessageW(EditWindow, EM_GETTEXTLENGTHEX, reinterpret_cast<WPARAM>(&LengthOptions), 0);
+        if (TextLength <= 0)
+            return {};
+        std::u16string Text;
+        Text.resize_and_overwrite(static_cast<std::size_t>(TextLength) + 1, [EditWindow](char16_t* Buffer, std::size_t Size)
+        {
+            GETTEXTEX TextOptions{};
+            TextOptions.cb = static_cast<DWORD>(Size * sizeof(char16_t));
+            TextOptions.flags = GT_DEFAULT;
+            TextOptions.codepage = 1200;
+            const LRESULT Copied = SendMessageW(EditWindow, EM_GETTEXTEX, reinterpret_cast<WPARAM>(&TextOptions), reinterpret_cast<LPARAM>(Buffer));
+            return (std::clamp)(static_cast<std::size_t>((std::max)(Copied, LRESULT{ 0 })), std::size_t{ 0 }, Size - 1);
+        });
+        return Text;
+    }
+    catch (...)
+    {
+        OutputDebugStringA("GetEditTextUtf16: 异常\n");
+        return {};
+    }
+}
+
+[[nodiscard]] constexpr auto GetSqlTokenColor(SqlTokenKind Kind) noexcept -> COLORREF
+{
+    switch (Kind)
+    {
+    case SqlTokenKind::Keyword: return RGB(0, 0, 192);
+    case SqlTokenKind::Number: return RGB(9, 134, 88);
+    case SqlTokenKind::String: return RGB(163, 21, 21);
+    case SqlTokenKind::QuotedIdentifier: return RGB(128, 0, 128);
+    case SqlTokenKind::Comment: return RGB(0, 128, 0);
+    case SqlTokenKind::Delimiter: return RGB(128, 128, 128);
+    }
+    return RGB(0, 0, 0);
+}
+
+// 只为 Damage 内的文本重新着色：先恢复默认颜色，再设置区内记号的颜色。
+// 期间屏蔽控件通知、关闭重绘，结束后恢复选区与滚动位置
+inline auto ApplySqlHighlight(HWND EditWindow, const IncrementalSqlLexer& Lexer, const SqlLexDamage& Damage) noexcept -> void
+{
+    try
+    {
+        if (!EditWindow || !IsWindow(EditWindow) || Damage.IsEmpty() || Damage.End <= Damage.Start) [[unlikely]]
+            return;
+        const LRESULT EventMask = SendMessageW(EditWindow, EM_SETEVENTMASK, 0, ENM_NONE);
+        SendMessageW(EditWindow, WM_SETREDRAW, FALSE, 0);
+        CHARRANGE Selection{};
+        SendMessageW(EditWindow, EM_EXGETSEL, 0, reinterpret_cast<LPARAM>(&Selection));
+        POINT ScrollPosition{};
+        SendMessageW(EditWindow, EM_GETSCROLLPOS, 0, reinterpret_cast<LPARAM>(&ScrollPosition));
+        CHARFORMAT2W CharFormat{};
+        CharFormat.cbSize = sizeof(CHARFORMAT2W);
+        CharFormat.dwMask = CFM_COLOR;
+        const auto SetColor = [EditWindow, &CharFormat](std::size_t Start, std::size_t End, DWORD Effects, COLORREF Color)
+        {
+            CHARRANGE Range{ static_cast<LONG>(Start), static_cast<LONG>(End) };
+            SendMessageW(EditWindow, EM_EXSETSEL, 0, reinterpret_cast<LPARAM>(&Range));
+            CharFormat.dwEffects = Effects;
+            CharFormat.crTextColor = Color;
+            SendMessageW(EditWindow, EM_SETCHARFORMAT, SCF_SELECTION, reinterpret_cast<LPARAM>(&CharFormat));
+        };
+        SetColor(Damage.Start, Damage.End, CFE_AUTOCOLOR, 0);
+        Lexer.ForEachSpan(Damage.Start, Damage.End, [&SetColor](std::size_t Start, std::size_t Length, SqlTokenKind Kind)
+        {
+            SetColor(Start, Start + Length, 0, GetSqlTokenColor(Kind));
+        });
+        SendMessageW(EditWindow, EM_EXSETSEL, 0, reinterpret_cast<LPARAM>(&Selection));
+        SendMessageW(EditWindow, EM_SETSCROLLPOS, 0, reinterpret_cast<LPARAM>(&ScrollPosition));
+        SendMessageW(EditWindow, WM_SETREDRAW, TRUE, 0);
+        InvalidateRect(EditWindow, nullptr, FALSE);
+        SendMessageW(EditWindow, EM_SETEVENTMASK, 0, EventMask);
+    }
+    catch (...)
+    {
+        SendMessageW(EditWindow, WM_SETREDRAW, TRUE, 0);
+        OutputDebugStringA("ApplySqlHighlight: 异常\n");
+    }
+}
+
+// 输入框当前可见的字符范围
+[[nodiscard]] inline auto GetVisibleTextRange(HWND EditWindow) noexcept -> std::pair<std::size_t, std::size_t>
+{
+    const LRESULT FirstLine = SendMessageW(EditWindow, EM_GETFIRSTVISIBLELINE, 0, 0);
+    const LRESULT Start = SendMessageW(EditWindow, EM_LINEINDEX, static_cast<WPARAM>(FirstLine), 0);
+    RECT ClientRect{};
+    GetClientRect(EditWindow, &ClientRect);
+    POINTL BottomRight{ ClientRect.right, ClientRect.bottom };
+    const LRESULT End = SendMessageW(EditWindow, EM_CHARFROMPOS, 0, reinterpret_cast<LPARAM>(&BottomRight));
+    const std::size_t VisibleStart = static_cast<std::size_t>((std::max)(Start, LRESULT{ 0 }));
+    return { VisibleStart, (std::max)(VisibleStart, static_cast<std::size_t>((std::max)(End, LRESULT{ 0 })) + 1) };
+}
+
 inline auto ClearEditText(HWND EditWindow) noexcept -> void
 {
     try
@@ -249,45 +341,33 @@ inline auto SetEditText(HWND EditWindow, std::string_view TextContent) noexcept
     }
 }
 
-inline auto AppendEditText(HWND EditWindow, std::string_view TextContent) noexcept -> void
-{
-    try
-    {
-        if (!EditWindow || !IsWindow(EditWindow)) [[unlikely]]
-            return;
-        const std::wstring WideText = Utf8ToWide(TextContent);
-        const int CurrentLength = static_cast<int>(SendMessageW(EditWindow, WM_GETTEXTLENGTH, 0, 0));
-        SendMessageW(EditWindow, EM_SETSEL, CurrentLength, CurrentLength);
-        SendMessageW(EditWindow, EM_REPLACESEL, FALSE,reinterpret_cast<LPARAM>(WideText.c_str()));
-        SendMessageW(EditWindow, EM_SCROLLCARET, 0, 0);
-    }
-    catch (...)
-    {
-        OutputDebugStringA("AppendEditText: 异常\n");
-    }
-}
-
-inline auto AppendEditTextWithTimestamp(HWND EditWindow, std::string_view TextContent) noexcept -> void
+// 把 OutputLog 的一次刷新应用到输出框：删除开头被淘汰的文本并追加新条目，期间关闭重绘，位置由日志给出，不查询控件长度
+inline auto ApplyOutputLogUpdate(HWND EditWindow, const OutputLogUpdate& Update) noexcept -> void
 {
     try
     {
-        if (!EditWindow || !IsWindow(EditWindow)) [[unlikely]]
+        if (!EditWindow || !IsWindow(EditWindow) || Update.IsEmpty()) [[unlikely]]
             return;
-        const std::wstring WideText = Utf8ToWide(TextContent);
-        const int CurrentLength = static_cast<int>(SendMessageW(EditWindow, WM_GETTEXTLENGTH, 0, 0));
-        if (CurrentLength > 0)
+        SendMessageW(EditWindow, WM_SETREDRAW, FALSE, 0);
+        if (Update.TrimUnits > 0)
         {
-            SendMessageW(EditWindow, EM_SETSEL, CurrentLength, CurrentLength);
-            SendMessageW(EditWindow, EM_REPLACESEL, FALSE, reinterpret_cast<LPARAM>(L"\r\n"));
+            SendMessageW(EditWindow, EM_SETSEL, 0, static_cast<LPARAM>(Update.TrimUnits));
+            SendMessageW(EditWindow, EM_REPLACESEL, FALSE, reinterpret_cast<LPARAM>(L""));
         }
-        const int NewLength = static_cast<int>(SendMessageW(EditWindow, WM_GETTEXTLENGTH, 0, 0));
-        SendMessageW(EditWindow, EM_SETSEL, NewLength, NewLength);
-        SendMessageW(EditWindow, EM_REPLACESEL, FALSE,reinterpret_cast<LPARAM>(WideText.c_str()));
+        if (!Update.AppendText.empty())
+        {
+            const std::wstring WideText = Utf8ToWide(Update.AppendText);
+            SendMessageW(EditWindow, EM_SETSEL, static_cast<WPARAM>(Update.AppendAt), static_cast<LPARAM>(Update.AppendAt));
+            SendMessageW(EditWindow, EM_REPLACESEL, FALSE, reinterpret_cast<LPARAM>(WideText.c_str()));
+        }
+        SendMessageW(EditWindow, WM_SETREDRAW, TRUE, 0);
+        InvalidateRect(EditWindow, nullptr, TRUE);
         SendMessageW(EditWindow, EM_SCROLLCARET, 0, 0);
     }
     catch (...)
     {
-        OutputDebugStringA("AppendEditTextWithTimestamp: 异常\n");
+        SendMessageW(EditWindow, WM_SETREDRAW, TRUE, 0);
+        OutputDebugStringA("ApplyOutputLogUpdate: 异常\n");
     }
 }
 
@@ -317,6 +397,91 @@ inline auto AppendEditTextWithTimestamp(HWND EditWindow, std::string_view TextCo
     }
 }
 
+constexpr int ResultListID = 1010;
+
+// 虚拟（LVS_OWNERDATA）列表：控件只保存行数，单元格文本在绘制时通过 LVN_GETDISPINFO 向窗口过程索取
+[[nodiscard]] inline auto CreateResultListControl(HWND ParentWindow, int X, int Y, int Width, int Height) noexcept -> HWND
+{
+    try
+    {
+        const INITCOMMONCONTROLSEX CommonControls{ .dwSize = sizeof(INITCOMMONCONTROLSEX), .dwICC = ICC_LISTVIEW_CLASSES };
+        InitCommonControlsEx(&CommonControls);
+        HWND ListHandle = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, L"", WS_CHILD | WS_VISIBLE | WS_TABSTOP | LVS_REPORT | LVS_OWNERDATA | LVS_SHOWSELALWAYS, X, Y, Width, Height, ParentWindow, reinterpret_cast<HMENU>(static_cast<UINT_PTR>(ResultListID)), nullptr, nullptr);
+        if (ListHandle) [[likely]]
+            ListView_SetExtendedListViewStyle(ListHandle, LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES | LVS_EX_DOUBLEBUFFER);
+        return ListHandle;
+    }
+    catch (...)
+    {
+        OutputDebugStringA("CreateResultListControl: 异常\n");
+        return nullptr;
+    }
+}
+
+// 补全列表：不激活的弹出列表框，焦点始终留在输入框，按键由窗口过程经 EN_MSGFILTER 转交
+[[nodiscard]] inline auto CreateCompletionPopup(HWND OwnerWindow) noexcept -> HWND
+{
+    return CreateWindowExW(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, WC_LISTBOXW, L"", WS_POPUP | WS_BORDER | WS_VSCROLL | LBS_NOTIFY | LBS_NOINTEGRALHEIGHT, 0, 0, 0, 0, OwnerWindow, nullptr, nullptr, nullptr);
+}
+
+[[nodiscard]] constexpr auto GetCompletionKindLabel(CompletionKind Kind) noexcept -> std::wstring_view
+{
+    switch (Kind)
+    {
+    case CompletionKind::Table: return L"  (表)";
+    case CompletionKind::Column: return L"  (列)";
+    case CompletionKind::Keyword: break;
+    }
+    return L"";
+}
+
+// 在 AnchorPosition 处字符的下一行显示候选并选中第一项
+inline auto ShowCompletionPopup(HWND Popup, HWND EditWindow, std::size_t AnchorPosition, const std::vector<CompletionCandidate>& Candidates) noexcept -> void
+{
+    try
+    {
+        if (!Popup || !EditWindow || Candidates.empty()) [[unlikely]]
+            return;
+        constexpr std::size_t MaxVisibleItems = 8;
+        SendMessageW(Popup, WM_SETREDRAW, FALSE, 0);
+        SendMessageW(Popup, WM_SETFONT, reinterpret_cast<WPARAM>(RenderState::CurrentFont), FALSE);
+        SendMessageW(Popup, LB_RESETCONTENT, 0, 0);
+        for (const auto& Candidate : Candidates)
+        {
+            const std::wstring ItemText = Utf8ToWide(Candidate.Text) + std::wstring(GetCompletionKindLabel(Candidate.Kind));
+            SendMessageW(Popup, LB_ADDSTRING, 0, reinterpret_cast<LPARAM>(ItemText.c_str()));
+        }
+        SendMessageW(Popup, LB_SETCURSEL, 0, 0);
+        SendMessageW(Popup, WM_SETREDRAW, TRUE, 0);
+        POINTL CharPosition{};
+        SendMessageW(EditWindow, EM_POSFROMCHAR, reinterpret_cast<WPARAM>(&CharPosition), static_cast<LPARAM>(AnchorPosition));
+        const HDC DeviceContext = GetDC(EditWindow);
+        const HGDIOBJ PreviousFont = SelectObject(DeviceContext, RenderState::CurrentFont);
+        TEXTMETRICW Metrics{};
+        GetTextMetricsW(DeviceContext, &Metrics);
+        SelectObject(DeviceContext, PreviousFont);
+        ReleaseDC(EditWindow, DeviceContext);
+        POINT Origin{ CharPosition.x, CharPosition.y + Metrics.tmHeight + Metrics.tmExternalLeading };
+        ClientToScreen(EditWindow, &Origin);
+        const int ItemHeight = static_cast<int>(SendMessageW(Popup, LB_GETITEMHEIGHT, 0, 0));
+        const int VisibleItems = static_cast<int>((std::min)(Candidates.size(), MaxVisibleItems));
+        const int Width = ScaleForDPI(280, RenderState::CurrentDPI);
+        const int Height = ItemHeight * VisibleItems + GetSystemMetrics(SM_CYBORDER) * 2;
+        SetWindowPos(Popup, HWND_TOP, Origin.x, Origin.y, Width, Height, SWP_NOACTIVATE | SWP_SHOWWINDOW);
+        InvalidateRect(Popup, nullptr, TRUE);
+    }
+    catch (...)
+    {
+        OutputDebugStringA("ShowCompletionPopup: 异常\n");
+    }
+}
+
+inline auto HideCompletionPopup(HWND Popup) noexcept -> void
+{
+    if (Popup && IsWindowVisible(Popup))
+        ShowWindow(Popup, SW_HIDE);
+}
+
 inline auto CreateUIControls(HWND ParentWindow) -> void
 {
     try
@@ -346,7 +511,7 @@ inline auto CreateUIControls(HWND ParentWindow) -> void
         const int LabelHeight = ScaleForDPI(20, DpiValue);
         const int ButtonSpacing = ScaleForDPI(5, DpiValue);
         int CurrentY = MarginSize;
-        CreateWindowExW(WS_EX_TRANSPARENT, L"STATIC", L"SQL 命令 (按 F5 执行):", WS_CHILD | WS_VISIBLE, MarginSize, CurrentY, ClientWidth - MarginSize * 2, LabelHeight, ParentWindow, nullptr, nullptr, nullptr);
+        CreateWindowExW(WS_EX_TRANSPARENT, L"STATIC", L"SQL 命令 (按 F5 执行，Esc 取消，Ctrl+F5 监视，Ctrl+空格 补全):", WS_CHILD | WS_VISIBLE, MarginSize, CurrentY, ClientWidth - MarginSize * 2, LabelHeight, ParentWindow, nullptr, nullptr, nullptr);
         CurrentY += LabelHeight + ScaleForDPI(5, DpiValue);
         UIHandles::InputEdit = CreateRichEditControl(ParentWindow, MarginSize, CurrentY, ClientWidth - MarginSize * 2, InputHeight, ES_WANTRETURN, false);
         if (!UIHandles::InputEdit) [[unlikely]]
@@ -356,10 +521,11 @@ inline auto CreateUIControls(HWND ParentWindow) -> void
         }
         CurrentY += InputHeight + MarginSize;
         int ButtonX = MarginSize;
-        const std::array<std::pair<std::wstring_view, int>, 5> ButtonConfigs = 
+        const std::array<std::pair<std::wstring_view, int>, 6> ButtonConfigs = 
         { 
             {
                 {L"执行 (F5)", 1001},
+                {L"取消 (Esc)", 1006},
                 {L"清空输入", 1002},
                 {L"清空输出", 1003},
                 {L"连接", 1004},
@@ -376,13 +542,24 @@ inline auto CreateUIControls(HWND ParentWindow) -> void
         CurrentY += ScaleForDPI(8, DpiValue);
         CreateWindowExW(WS_EX_TRANSPARENT, L"STATIC", L"输出结果:", WS_CHILD | WS_VISIBLE, MarginSize, CurrentY, ClientWidth - MarginSize * 2, LabelHeight, ParentWindow, nullptr, nullptr, nullptr);
         CurrentY += LabelHeight + ScaleForDPI(5, DpiValue);
-        const int OutputHeight = ClientHeight - CurrentY - StatusHeight - MarginSize * 2;
+        const int OutputAreaHeight = ClientHeight - CurrentY - StatusHeight - MarginSize * 2;
+        const int GridHeight = OutputAreaHeight * 3 / 5;
+        UIHandles::ResultList = CreateResultListControl(ParentWindow, MarginSize, CurrentY, ClientWidth - MarginSize * 2, GridHeight);
+        if (!UIHandles::ResultList) [[unlikely]]
+        {
+            MessageBoxW(ParentWindow, L"创建结果表格失败", L"错误", MB_OK | MB_ICONERROR);
+            return;
+        }
+        CurrentY += GridHeight + ButtonSpacing;
+        const int OutputHeight = OutputAreaHeight - GridHeight - ButtonSpacing;
         UIHandles::OutputEdit = CreateRichEditControl(ParentWindow, MarginSize, CurrentY, ClientWidth - MarginSize * 2, OutputHeight, WS_VSCROLL | WS_HSCROLL | ES_AUTOHSCROLL, true);
         if (!UIHandles::OutputEdit) [[unlikely]]
         {
             MessageBoxW(ParentWindow, L"创建输出框失败", L"错误", MB_OK | MB_ICONERROR);
             return;
         }
+        // 长度由 OutputLog 限制，控件本身不再截断
+        SendMessageW(UIHandles::OutputEdit, EM_EXLIMITTEXT, 0, INT_MAX);
         CurrentY += OutputHeight + MarginSize;
         UIHandles::StatusText = CreateWindowExW(0, L"STATIC", L"MySQL 状态: 未连接", WS_CHILD | WS_VISIBLE | SS_SIMPLE, MarginSize, CurrentY, ClientWidth - MarginSize * 2, StatusHeight, ParentWindow, reinterpret_cast<HMENU>(9999), nullptr, nullptr);
         UpdateAllFonts(ParentWindow, DpiValue);
@@ -486,9 +663,15 @@ inline auto LayoutUIControls(HWND WindowHandle) noexcept -> void
             CurrentControl = GetWindow(CurrentControl, GW_HWNDNEXT);
         }
         CurrentY += LabelHeight + ScaleForDPI(5, DpiValue);
+        // 结果表格占输出区域的上五分之三，下方是消息日志
+        const int OutputAreaHeight = ClientHeight - CurrentY - StatusHeight - MarginSize * 2 - ScaleForDPI(5, DpiValue);
+        const int GridHeight = OutputAreaHeight * 3 / 5;
+        if (UIHandles::ResultList && IsWindow(UIHandles::ResultList) && GridHeight > 50)
+            SetWindowPos(UIHandles::ResultList, nullptr, MarginSize, CurrentY, ClientWidth - MarginSize * 2, GridHeight, SWP_NOZORDER);
+        CurrentY += GridHeight + ButtonSpacing;
         if (UIHandles::OutputEdit && IsWindow(UIHandles::OutputEdit))
         {
-            const int OutputHeight = ClientHeight - CurrentY - StatusHeight - MarginSize * 2 - ScaleForDPI(5, DpiValue);
+            const int OutputHeight = OutputAreaHeight - GridHeight - ButtonSpacing;
             if (OutputHeight > 50)
                 SetWindowPos(UIHandles::OutputEdit, nullptr, MarginSize, CurrentY, ClientWidth - MarginSize * 2, OutputHeight, SWP_NOZORDER);
         }
@@ -0,0 +1,109 @@
+#include "replay.h"
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+WorkloadReplayer::WorkloadReplayer(ReplayOptions OptionsParam) : Options(std::move(OptionsParam))
+{
+    Options.ConnectionCount = (std::max)(Options.ConnectionCount, std::size_t{ 1 });
+    if (Options.Speed == ReplaySpeed::Original || Options.SpeedFactor <= 0.0)
+        Options.SpeedFactor = 1.0;
+}
+
+auto WorkloadReplayer::Run(const WorkloadLog& Log) -> std::expected<ReplayReport, std::string>
+{
+    ReplayReport Report;
+    if (Log.Events.empty())
+        return Report;
+    // 每个采集会话一条通道，通道按首条语句的时间排列
+    std::unordered_map<uint64_t, std::size_t> SessionLanes;
+    std::vector<std::vector<const WorkloadEvent*>> Lanes;
+    for (const auto& Event : Log.Events)
+    {
+        const auto [Position, IsInserted] = SessionLanes.try_emplace(Event.SessionId, Lanes.size());
+        if (IsInserted)
+            Lanes.emplace_back();
+        Lanes[Position->second].push_back(&Event);
+    }
+    Report.SessionCount = Lanes.size();
+    Report.ConnectionCount = (std::min)(Options.ConnectionCount, Lanes.size());
+    Report.EventCount = Log.Events.size();
+
+    MySQLWrapper Connection;
+    Connection.SetSessionPoolSize(Report.ConnectionCount);
+    if (!Connection.Connect(Options.Config))
+        return std::unexpected(std::format("回放连接失败: {}", Connection.GetLastError()));
+
+    LatencyHistogram Latency;
+    LatencyHistogram CapturedLatency;
+    LatencyHistogram ScheduleLag;
+    std::atomic<uint64_t> SucceededCount{ 0 };
+    std::atomic<uint64_t> FailedCount{ 0 };
+    std::atomic<uint64_t> OutcomeMismatchCount{ 0 };
+    IsCancelled.store(false, std::memory_order_relaxed);
+    std::atomic<std::size_t> NextLane{ 0 };
+    const auto RecordError = [&](uint64_t SessionId, std::string_view ErrorMessage)
+        {
+            {
+                std::lock_guard<std::mutex> Lock(ErrorMutex);
+                if (Report.SampleErrors.size() < MaxSampleErrors)
+                    Report.SampleErrors.push_back(std::format("会话 {}: {}", SessionId, ErrorMessage));
+            }
+            if (Options.StopOnError)
+                Cancel();
+        };
+    const auto ReplayStart = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    {
+        std::vector<std::jthread> Workers;
+        Workers.reserve(Report.ConnectionCount);
+        for (std::size_t WorkerIndex = 0; WorkerIndex < Report.ConnectionCount; ++WorkerIndex)
+        {
+            Workers.emplace_back([&]
+            {
+                for (std::size_t LaneIndex = NextLane.fetch_add(1, std::memory_order_relaxed); LaneIndex < Lanes.size(); LaneIndex = NextLane.fetch_add(1, std::memory_order_relaxed))
+                {
+                    if (IsCancelled.load(std::memory_order_relaxed))
+                        break;
+                    const auto& Lane = Lanes[LaneIndex];
+                    // 会话独占一条池连接，库、会话变量、事务和临时表不会与其他会话交错；归还时不可清理的连接会被关闭
+                    auto SessionResult = Connection.OpenSession();
+                    if (!SessionResult) [[unlikely]]
+                    {
+                        FailedCount.fetch_add(Lane.size(), std::memory_order_relaxed);
+                        RecordError(Lane.front()->SessionId, SessionResult.error());
+                        continue;
+                    }
+                    Session& SessionRef = **SessionResult;
+                    for (const WorkloadEvent* Event : Lane)
+                    {
+                        if (IsCancelled.load(std::memory_order_relaxed))
+                            break;
+                        if (Options.Speed != ReplaySpeed::Maximum)
+                        {
+                            const auto Due = ReplayStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::nano>(static_cast<double>(Event->Offset.count()) / Options.SpeedFactor));
+                            std::this_thread::sleep_until(Due);
+                            ScheduleLag.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Due));
+                        }
+                        const MySQLResult ResultData = SessionRef.Execute(Event->SqlText);
+                        Latency.Record(ResultData.ExecutionTime);
+                        CapturedLatency.Record(Event->Latency);
+                        (ResultData.Success ? SucceededCount : FailedCount).fetch_add(1, std::memory_order_relaxed);
+                        if (ResultData.Success != Event->Success)
+                            OutcomeMismatchCount.fetch_add(1, std::memory_order_relaxed);
+                        if (!ResultData.Success)
+                            RecordError(Event->SessionId, ResultData.ErrorMessage);
+                    }
+                }
+            });
+        }
+    }
+    const auto ReplayEnd = std::chrono::steady_clock::now();
+    Report.Elapsed = ReplayEnd > ReplayStart ? std::chrono::duration_cast<std::chrono::nanoseconds>(ReplayEnd - ReplayStart) : std::chrono::nanoseconds{ 0 };
+    Report.SucceededCount = SucceededCount.load();
+    Report.FailedCount = FailedCount.load();
+    Report.OutcomeMismatchCount = OutcomeMismatchCount.load();
+    Report.Latency = Latency.Snapshot();
+    Report.CapturedLatency = CapturedLatency.Snapshot();
+    Report.ScheduleLag = ScheduleLag.Snapshot();
+    return Report;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include "metrics.h"
+#include "workload.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class ReplaySpeed
+{
+    Original,
+    Scaled,
+    Maximum
+};
+
+struct ReplayOptions
+{
+    MySQLConfig Config;
+    ReplaySpeed Speed = ReplaySpeed::Original;
+    double SpeedFactor = 1.0;
+    // 同时回放的会话数上限
+    std::size_t ConnectionCount = 8;
+    bool StopOnError = false;
+};
+
+struct ReplayReport
+{
+    uint64_t EventCount = 0;
+    uint64_t SucceededCount = 0;
+    uint64_t FailedCount = 0;
+    uint64_t OutcomeMismatchCount = 0;
+    std::size_t SessionCount = 0;
+    // 实际使用的工作线程数，即同时打开的回放连接数上限
+    std::size_t ConnectionCount = 0;
+    std::chrono::nanoseconds Elapsed{ 0 };
+    LatencySnapshot Latency;
+    LatencySnapshot CapturedLatency;
+    LatencySnapshot ScheduleLag;
+    std::vector<std::string> SampleErrors;
+    [[nodiscard]] auto Throughput() const noexcept -> double
+    {
+        const double Seconds = std::chrono::duration<double>(Elapsed).count();
+        return Seconds > 0.0 ? static_cast<double>(SucceededCount + FailedCount) / Seconds : 0.0;
+    }
+};
+
+// 采集到的每个会话在独占的池连接上按原始开始时间顺序执行，会话状态与语句顺序都与采集时一致；
+// ConnectionCount 只限制同时回放的会话数，会话多于该值时，空出的工作线程按首条语句的时间依次接手后面的会话。
+class WorkloadReplayer
+{
+private:
+    static constexpr std::size_t MaxSampleErrors = 10;
+    ReplayOptions Options;
+    std::atomic<bool> IsCancelled{ false };
+    std::mutex ErrorMutex;
+public:
+    explicit WorkloadReplayer(ReplayOptions OptionsParam);
+    [[nodiscard]] auto Run(const WorkloadLog& Log) -> std::expected<ReplayReport, std::string>;
+    auto Cancel() noexcept -> void
+    {
+        IsCancelled.store(true, std::memory_order_relaxed);
+    }
+};
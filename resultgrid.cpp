@@ -0,0 +1,248 @@
+#include "resultgrid.h"
+
+namespace
+{
+    constexpr char32_t ReplacementCharacter = 0xFFFD;
+    constexpr std::string_view ReplacementText = "\xEF\xBF\xBD";
+    constexpr std::string_view EllipsisText = "\xE2\x80\xA6";
+
+    // 解码 Position 处的一个码点并前移；非法或截断的序列只消耗一个字节，返回替换字符
+    [[nodiscard]] auto DecodeCodePoint(std::string_view Text, std::size_t& Position) noexcept -> char32_t
+    {
+        const auto Lead = static_cast<unsigned char>(Text[Position]);
+        if (Lead < 0x80) [[likely]]
+        {
+            ++Position;
+            return Lead;
+        }
+        std::size_t Length = 0;
+        char32_t CodePoint = 0;
+        char32_t Minimum = 0;
+        if ((Lead & 0xE0) == 0xC0)
+        {
+            Length = 2;
+            CodePoint = Lead & 0x1F;
+            Minimum = 0x80;
+        }
+        else if ((Lead & 0xF0) == 0xE0)
+        {
+            Length = 3;
+            CodePoint = Lead & 0x0F;
+            Minimum = 0x800;
+        }
+        else if ((Lead & 0xF8) == 0xF0)
+        {
+            Length = 4;
+            CodePoint = Lead & 0x07;
+            Minimum = 0x10000;
+        }
+        if (Length == 0 || Text.size() - Position < Length)
+        {
+            ++Position;
+            return ReplacementCharacter;
+        }
+        for (std::size_t Index = 1; Index < Length; ++Index)
+        {
+            const auto Continuation = static_cast<unsigned char>(Text[Position + Index]);
+            if ((Continuation & 0xC0) != 0x80)
+            {
+                ++Position;
+                return ReplacementCharacter;
+            }
+            CodePoint = (CodePoint << 6) | (Continuation & 0x3F);
+        }
+        // 过长编码、代理区和超出 Unicode 范围的码点都不合法
+        if (CodePoint < Minimum || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF) || CodePoint > 0x10FFFF)
+        {
+            ++Position;
+            return ReplacementCharacter;
+        }
+        Position += Length;
+        return CodePoint;
+    }
+
+    [[nodiscard]] constexpr auto GetCodePointWidth(char32_t CodePoint) noexcept -> std::size_t
+    {
+        if ((CodePoint >= 0x0300 && CodePoint <= 0x036F) || (CodePoint >= 0x200B && CodePoint <= 0x200F) || (CodePoint >= 0xFE00 && CodePoint <= 0xFE0F))
+            return 0;
+        const bool IsWide = (CodePoint >= 0x1100 && CodePoint <= 0x115F)
+            || (CodePoint >= 0x2E80 && CodePoint <= 0xA4CF && CodePoint != 0x303F)
+            || (CodePoint >= 0xAC00 && CodePoint <= 0xD7A3)
+            || (CodePoint >= 0xF900 && CodePoint <= 0xFAFF)
+            || (CodePoint >= 0xFE30 && CodePoint <= 0xFE4F)
+            || (CodePoint >= 0xFF00 && CodePoint <= 0xFF60)
+            || (CodePoint >= 0xFFE0 && CodePoint <= 0xFFE6)
+            || (CodePoint >= 0x1F300 && CodePoint <= 0x1F64F)
+            || (CodePoint >= 0x1F900 && CodePoint <= 0x1F9FF)
+            || (CodePoint >= 0x20000 && CodePoint <= 0x3FFFD);
+        return IsWide ? 2 : 1;
+    }
+}
+
+auto GetDisplayWidth(std::string_view Text) noexcept -> std::size_t
+{
+    std::size_t Width = 0;
+    std::size_t Position = 0;
+    while (Position < Text.size())
+        Width += GetCodePointWidth(DecodeCodePoint(Text, Position));
+    return Width;
+}
+
+auto FormatCellText(std::string_view Value, std::string& Output, std::size_t MaxWidth) -> std::size_t
+{
+    const bool IsPlainAscii = Value.size() <= MaxWidth && std::ranges::all_of(Value, [](char CharValue)
+    {
+        return CharValue >= 0x20 && CharValue < 0x7F;
+    });
+    if (IsPlainAscii) [[likely]]
+    {
+        Output.append(Value);
+        return Value.size();
+    }
+    // 宽度达到 MaxWidth - 1 时记下截断点，超出后回退到这里再补上省略号
+    std::size_t TruncateSize = std::string::npos;
+    std::size_t TruncateWidth = 0;
+    std::size_t Width = 0;
+    std::size_t Position = 0;
+    while (Position < Value.size())
+    {
+        const std::size_t Start = Position;
+        const char32_t CodePoint = DecodeCodePoint(Value, Position);
+        const std::size_t CodePointWidth = GetCodePointWidth(CodePoint);
+        if (TruncateSize == std::string::npos && Width + CodePointWidth + 1 > MaxWidth)
+        {
+            TruncateSize = Output.size();
+            TruncateWidth = Width;
+        }
+        if (Width + CodePointWidth > MaxWidth)
+        {
+            Output.resize(TruncateSize);
+            Output += EllipsisText;
+            return TruncateWidth + 1;
+        }
+        if (CodePoint < 0x20 || CodePoint == 0x7F)
+            Output += ' ';
+        else if (CodePoint == ReplacementCharacter && Position - Start == 1)
+            Output += ReplacementText;
+        else
+            Output.append(Value.substr(Start, Position - Start));
+        Width += CodePointWidth;
+    }
+    return Width;
+}
+
+auto ResultGridModel::SetResult(std::shared_ptr<const MySQLResult> ResultData) -> void
+{
+    if (!ResultData || !ResultData->Success || ResultData->ColumnNames.empty())
+    {
+        Reset();
+        return;
+    }
+    Result = std::move(ResultData);
+    Window = {};
+    CellText.clear();
+    ColumnWidths.assign(Result->ColumnNames.size(), 1);
+    for (std::size_t Column = 0; Column < ColumnWidths.size(); ++Column)
+        ColumnWidths[Column] = (std::clamp)(GetDisplayWidth(Result->ColumnNames[Column]), std::size_t{ 1 }, MaxCellWidth);
+    const std::size_t SampleRows = (std::min)(Result->Rows.size(), WidthSampleRows);
+    for (std::size_t Row = 0; Row < SampleRows; ++Row)
+    {
+        const MySQLRow& RowData = Result->Rows[Row];
+        for (std::size_t Column = 0; Column < ColumnWidths.size(); ++Column)
+            FormatCell(RowData, Column, Scratch);
+    }
+    ++WidthVersion;
+}
+
+auto ResultGridModel::Reset() noexcept -> void
+{
+    Result.reset();
+    ColumnWidths.clear();
+    Window = {};
+    CellText.clear();
+    ++WidthVersion;
+}
+
+auto ResultGridModel::GetColumnName(std::size_t Column) const -> std::string_view
+{
+    if (!Result || Column >= Result->ColumnNames.size())
+        return {};
+    return Result->ColumnNames[Column];
+}
+
+auto ResultGridModel::ClampViewport(GridViewport View) const noexcept -> GridViewport
+{
+    const std::size_t RowCount = GetRowCount();
+    const std::size_t ColumnCount = GetColumnCount();
+    View.FirstRow = (std::min)(View.FirstRow, RowCount);
+    View.RowCount = (std::min)(View.RowCount, RowCount - View.FirstRow);
+    View.FirstColumn = (std::min)(View.FirstColumn, ColumnCount);
+    View.ColumnCount = (std::min)(View.ColumnCount, ColumnCount - View.FirstColumn);
+    return View;
+}
+
+auto ResultGridModel::FormatCell(const MySQLRow& RowData, std::size_t Column, std::string& Output) -> void
+{
+    Output.clear();
+    const std::string_view Value = Column < RowData.Fields.size() ? std::string_view{ RowData.Fields[Column] } : std::string_view{};
+    const std::size_t Width = FormatCellText(Value, Output, MaxCellWidth);
+    if (Column < ColumnWidths.size() && Width > ColumnWidths[Column])
+    {
+        ColumnWidths[Column] = Width;
+        ++WidthVersion;
+    }
+}
+
+auto ResultGridModel::SetViewport(GridViewport View) -> void
+{
+    View = ClampViewport(View);
+    if (View.FirstRow == Window.FirstRow && View.RowCount == Window.RowCount && View.FirstColumn == Window.FirstColumn && View.ColumnCount == Window.ColumnCount)
+        return;
+    std::vector<std::string> NewText(View.RowCount * View.ColumnCount);
+    for (std::size_t RowOffset = 0; RowOffset < View.RowCount; ++RowOffset)
+    {
+        const std::size_t Row = View.FirstRow + RowOffset;
+        // 整行都能复用时不读取行，避免还原已落盘的块
+        const MySQLRow* RowData = nullptr;
+        for (std::size_t ColumnOffset = 0; ColumnOffset < View.ColumnCount; ++ColumnOffset)
+        {
+            const std::size_t Column = View.FirstColumn + ColumnOffset;
+            std::string& Cell = NewText[RowOffset * View.ColumnCount + ColumnOffset];
+            if (Window.Contains(Row, Column))
+            {
+                Cell = std::move(CellText[(Row - Window.FirstRow) * Window.ColumnCount + (Column - Window.FirstColumn)]);
+                continue;
+            }
+            if (!RowData)
+                RowData = &Result->Rows[Row];
+            FormatCell(*RowData, Column, Cell);
+        }
+    }
+    Window = View;
+    CellText = std::move(NewText);
+}
+
+auto ResultGridModel::GetCellText(std::size_t Row, std::size_t Column) -> std::string_view
+{
+    if (Row >= GetRowCount() || Column >= GetColumnCount()) [[unlikely]]
+        return {};
+    if (Window.Contains(Row, Column)) [[likely]]
+        return CellText[(Row - Window.FirstRow) * Window.ColumnCount + (Column - Window.FirstColumn)];
+    // 行在窗口内而列在窗口外（如半露出的列）时单独生成，不移动窗口，避免在相邻的列之间反复重建
+    if (Row >= Window.FirstRow && Row - Window.FirstRow < Window.RowCount)
+    {
+        FormatCell(Result->Rows[Row], Column, Scratch);
+        return Scratch;
+    }
+    GridViewport View;
+    View.FirstRow = Row / PageRows * PageRows;
+    View.RowCount = PageRows;
+    const bool IsColumnInWindow = Column >= Window.FirstColumn && Column - Window.FirstColumn < Window.ColumnCount;
+    View.FirstColumn = IsColumnInWindow ? Window.FirstColumn : Column;
+    View.ColumnCount = (std::max)(Window.ColumnCount, std::size_t{ 1 });
+    SetViewport(View);
+    if (Window.Contains(Row, Column)) [[likely]]
+        return CellText[(Row - Window.FirstRow) * Window.ColumnCount + (Column - Window.FirstColumn)];
+    FormatCell(Result->Rows[Row], Column, Scratch);
+    return Scratch;
+}
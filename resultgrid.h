@@ -0,0 +1,92 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 单元格区域：行与列都是 [First, First + Count)
+struct GridViewport
+{
+    std::size_t FirstRow = 0;
+    std::size_t RowCount = 0;
+    std::size_t FirstColumn = 0;
+    std::size_t ColumnCount = 0;
+    [[nodiscard]] auto Contains(std::size_t Row, std::size_t Column) const noexcept -> bool
+    {
+        return Row >= FirstRow && Row - FirstRow < RowCount && Column >= FirstColumn && Column - FirstColumn < ColumnCount;
+    }
+};
+
+// 按等宽字符计的显示宽度：东亚宽字符计 2，组合符号计 0；非法的 UTF-8 字节按一个替换字符计
+[[nodiscard]] auto GetDisplayWidth(std::string_view Text) noexcept -> std::size_t;
+
+// 单元格的显示文本：控制字符换为空格，非法字节换为 U+FFFD，超过 MaxWidth 的部分截断并以 "…" 结尾。返回显示宽度
+auto FormatCellText(std::string_view Value, std::string& Output, std::size_t MaxWidth) -> std::size_t;
+
+// 结果表格的视图模型，与界面无关。只为当前窗口（可见的行和列）内的单元格生成显示文本，
+// 窗口移动时重叠部分的文本直接复用；列宽由表头和前 WidthSampleRows 行估算，之后随访问到的单元格只增不减。
+// 行来自 RowStore，读取会更新其块缓存，只应在一个线程上使用。
+class ResultGridModel
+{
+public:
+    static constexpr std::size_t DefaultPageRows = 256;
+    static constexpr std::size_t WidthSampleRows = 200;
+    // 单元格最多显示的宽度，留出余量放进列表控件 260 字符的文本缓冲
+    static constexpr std::size_t MaxCellWidth = 240;
+private:
+    std::shared_ptr<const MySQLResult> Result;
+    std::vector<std::size_t> ColumnWidths;
+    uint64_t WidthVersion = 0;
+    GridViewport Window;
+    // 窗口内的单元格文本，按行优先存放
+    std::vector<std::string> CellText;
+    std::string Scratch;
+    std::size_t PageRows = DefaultPageRows;
+    [[nodiscard]] auto ClampViewport(GridViewport View) const noexcept -> GridViewport;
+    auto FormatCell(const MySQLRow& RowData, std::size_t Column, std::string& Output) -> void;
+public:
+    explicit ResultGridModel(std::size_t PageRowsParam = DefaultPageRows) noexcept : PageRows((std::max)(PageRowsParam, std::size_t{ 1 })) {}
+    // 只有带列的成功结果会被显示，其余结果等同于 Reset
+    auto SetResult(std::shared_ptr<const MySQLResult> ResultData) -> void;
+    auto Reset() noexcept -> void;
+    [[nodiscard]] auto HasResult() const noexcept -> bool
+    {
+        return Result != nullptr;
+    }
+    [[nodiscard]] auto GetResult() const noexcept -> const std::shared_ptr<const MySQLResult>&
+    {
+        return Result;
+    }
+    [[nodiscard]] auto GetRowCount() const noexcept -> std::size_t
+    {
+        return Result ? Result->Rows.size() : 0;
+    }
+    [[nodiscard]] auto GetColumnCount() const noexcept -> std::size_t
+    {
+        return Result ? Result->ColumnNames.size() : 0;
+    }
+    [[nodiscard]] auto GetColumnName(std::size_t Column) const -> std::string_view;
+    // 以显示字符计的列宽，至少为表头宽度，不超过 MaxCellWidth
+    [[nodiscard]] auto GetColumnWidth(std::size_t Column) const noexcept -> std::size_t
+    {
+        return Column < ColumnWidths.size() ? ColumnWidths[Column] : 0;
+    }
+    // 任一列变宽时递增，界面据此决定是否重新设置列宽
+    [[nodiscard]] auto GetWidthVersion() const noexcept -> uint64_t
+    {
+        return WidthVersion;
+    }
+    [[nodiscard]] auto GetViewport() const noexcept -> const GridViewport&
+    {
+        return Window;
+    }
+    // 超出结果范围的部分被截掉；与当前窗口重叠的单元格不会重新生成
+    auto SetViewport(GridViewport View) -> void;
+    // 窗口内的单元格直接返回缓存的文本；窗口外的行把窗口移到所在的页，列保持窗口宽度。
+    // 返回值在下一次 SetViewport、GetCellText 或 SetResult 之前有效
+    [[nodiscard]] auto GetCellText(std::size_t Row, std::size_t Column) -> std::string_view;
+};
@@ -0,0 +1,577 @@
+#include "router.h"
+#include "sqlscript.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+    [[nodiscard]] auto IsAnyKeyword(std::string_view Word, std::initializer_list<std::string_view> Keywords) noexcept -> bool
+    {
+        return std::ranges::any_of(Keywords, [Word](std::string_view Keyword) { return Word.size() == Keyword.size() && StartsWithKeyword(Word, Keyword); });
+    }
+
+    struct StatementTraits
+    {
+        // 锁定读、INTO、数据修改型 CTE、LAST_INSERT_ID 等连接级函数
+        bool NeedsPrimary = false;
+        // 用户变量与命名锁留在连接上，之后的语句都要发往同一连接
+        bool HoldsConnectionState = false;
+    };
+
+    [[nodiscard]] auto ScanStatement(std::string_view Text) noexcept -> StatementTraits
+    {
+        StatementTraits Traits;
+        char Quote = 0;
+        for (std::size_t Index = 0; Index < Text.size(); ++Index)
+        {
+            const char CharValue = Text[Index];
+            if (Quote != 0)
+            {
+                if (CharValue == '\\' && Quote != '`')
+                    ++Index;
+                else if (CharValue == Quote)
+                    Quote = 0;
+                continue;
+            }
+            if (CharValue == '\'' || CharValue == '"' || CharValue == '`')
+            {
+                Quote = CharValue;
+                continue;
+            }
+            if (CharValue == '@')
+            {
+                if (Index + 1 < Text.size() && Text[Index + 1] == '@')
+                {
+                    ++Index;
+                    continue;
+                }
+                Traits.HoldsConnectionState = true;
+                continue;
+            }
+            if (!IsWordChar(CharValue) || (Index > 0 && IsWordChar(Text[Index - 1])))
+                continue;
+            std::size_t WordEnd = Index;
+            while (WordEnd < Text.size() && IsWordChar(Text[WordEnd]))
+                ++WordEnd;
+            const std::string_view Word = Text.substr(Index, WordEnd - Index);
+            const std::string_view Rest = SkipSpaceAndComments(Text.substr(WordEnd));
+            const bool IsFunctionCall = Rest.starts_with('(');
+            // INSERT() / REPLACE() 同时是字符串函数
+            if (!IsFunctionCall && IsAnyKeyword(Word, { "UPDATE", "DELETE", "INSERT", "REPLACE", "INTO", "SHARE" }))
+                Traits.NeedsPrimary = true;
+            else if (IsFunctionCall && IsAnyKeyword(Word, { "GET_LOCK", "RELEASE_LOCK", "RELEASE_ALL_LOCKS", "IS_USED_LOCK", "IS_FREE_LOCK" }))
+                Traits.HoldsConnectionState = true;
+            else if (IsFunctionCall && IsAnyKeyword(Word, { "LAST_INSERT_ID", "FOUND_ROWS", "ROW_COUNT" }))
+                Traits.NeedsPrimary = true;
+            Index = WordEnd - 1;
+        }
+        return Traits;
+    }
+
+    [[nodiscard]] auto ClassifySingleStatement(std::string_view SqlQuery) noexcept -> StatementRoute
+    {
+        const std::string_view Text = SkipSpaceAndComments(SqlQuery);
+        if (StartsWithKeyword(Text, "USE"))
+            return StatementRoute::Session;
+        if (StartsWithKeyword(Text, "SET"))
+        {
+            const std::string_view Rest = SkipKeyword(Text, "SET");
+            if (StartsWithKeyword(Rest, "NAMES") || StartsWithKeyword(Rest, "CHARACTER") || StartsWithKeyword(Rest, "CHARSET"))
+                return StatementRoute::Session;
+            return StatementRoute::Write;
+        }
+        if (StartsWithKeyword(Text, "SELECT") || StartsWithKeyword(Text, "WITH") || StartsWithKeyword(Text, "TABLE") || StartsWithKeyword(Text, "VALUES") || Text.starts_with('('))
+        {
+            const StatementTraits Traits = ScanStatement(Text);
+            return Traits.NeedsPrimary || Traits.HoldsConnectionState ? StatementRoute::Write : StatementRoute::Read;
+        }
+        if (StartsWithKeyword(Text, "SHOW"))
+        {
+            // 复制、二进制日志与进程列表只在主库上有意义
+            std::string_view Rest = SkipKeyword(Text, "SHOW");
+            if (StartsWithKeyword(Rest, "FULL"))
+                Rest = SkipKeyword(Rest, "FULL");
+            for (const std::string_view Keyword : { "MASTER", "BINARY", "BINLOG", "REPLICA", "REPLICAS", "SLAVE", "PROCESSLIST" })
+            {
+                if (StartsWithKeyword(Rest, Keyword))
+                    return StatementRoute::Write;
+            }
+            return StatementRoute::Read;
+        }
+        if (StartsWithKeyword(Text, "DESCRIBE") || StartsWithKeyword(Text, "DESC") || StartsWithKeyword(Text, "EXPLAIN") || StartsWithKeyword(Text, "HELP"))
+            return StatementRoute::Read;
+        return StatementRoute::Write;
+    }
+
+    // SHOW WARNINGS / SHOW ERRORS / SHOW COUNT(*) WARNINGS 描述的是同一连接上的上一条语句
+    [[nodiscard]] auto IsDiagnosticsStatement(std::string_view SqlQuery) noexcept -> bool
+    {
+        const std::string_view Text = SkipSpaceAndComments(SqlQuery);
+        if (!StartsWithKeyword(Text, "SHOW"))
+            return false;
+        const std::string_view Rest = SkipKeyword(Text, "SHOW");
+        return StartsWithKeyword(Rest, "WARNINGS") || StartsWithKeyword(Rest, "ERRORS") || StartsWithKeyword(Rest, "COUNT");
+    }
+
+    [[nodiscard]] auto EndpointName(const MySQLConfig& Config) -> std::string
+    {
+        return std::format("{}:{}", Config.Host, Config.Port);
+    }
+
+    [[nodiscard]] auto FirstField(const MySQLResult& ResultData) -> std::optional<std::string>
+    {
+        if (!ResultData.Success || ResultData.Rows.empty() || ResultData.Rows[0].Fields.empty())
+            return std::nullopt;
+        return ResultData.Rows[0].GetValue<std::string>(0);
+    }
+}
+
+ReplicaMonitor::ReplicaMonitor(std::vector<ReplicaEndpoint> Replicas, std::chrono::milliseconds ProbeInterval) : Interval(ProbeInterval)
+{
+    Probes.reserve(Replicas.size());
+    for (auto& Endpoint : Replicas)
+    {
+        ReplicaProbe& Probe = Probes.emplace_back();
+        Probe.Health.Name = EndpointName(Endpoint.Config);
+        Probe.Health.Weight = Endpoint.Weight;
+        Probe.Endpoint = std::move(Endpoint);
+        Probe.Connection = std::make_unique<MySQLWrapper>();
+    }
+}
+
+ReplicaMonitor::~ReplicaMonitor()
+{
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        ProbeThread.request_stop();
+    }
+    WakeCondition.notify_all();
+    if (ProbeThread.joinable())
+        ProbeThread.join();
+}
+
+auto ReplicaMonitor::Start() -> void
+{
+    std::call_once(StartOnce, [this]
+        {
+            for (auto& Probe : Probes)
+            {
+                ReplicaHealth Health = ProbeReplica(Probe);
+                std::lock_guard<std::mutex> Lock(HealthMutex);
+                Probe.Health = std::move(Health);
+            }
+            if (!Probes.empty())
+                ProbeThread = std::jthread([this](std::stop_token StopToken) { ProbeLoop(StopToken); });
+        });
+}
+
+auto ReplicaMonitor::GetHealth() const -> std::vector<ReplicaHealth>
+{
+    std::lock_guard<std::mutex> Lock(HealthMutex);
+    std::vector<ReplicaHealth> HealthList;
+    HealthList.reserve(Probes.size());
+    for (const auto& Probe : Probes)
+        HealthList.push_back(Probe.Health);
+    return HealthList;
+}
+
+auto ReplicaMonitor::MarkUnreachable(std::size_t ReplicaIndex, std::string_view Reason) -> void
+{
+    std::lock_guard<std::mutex> Lock(HealthMutex);
+    if (ReplicaIndex >= Probes.size())
+        return;
+    Probes[ReplicaIndex].Health.IsReachable = false;
+    Probes[ReplicaIndex].Health.LastError = Reason;
+}
+
+auto ReplicaMonitor::ProbeLoop(std::stop_token StopToken) -> void
+{
+    std::unique_lock<std::mutex> Lock(WakeMutex);
+    while (!StopToken.stop_requested())
+    {
+        WakeCondition.wait_for(Lock, Interval);
+        if (StopToken.stop_requested())
+            break;
+        Lock.unlock();
+        for (auto& Probe : Probes)
+        {
+            ReplicaHealth Health = ProbeReplica(Probe);
+            std::lock_guard<std::mutex> HealthLock(HealthMutex);
+            Probe.Health = std::move(Health);
+        }
+        Lock.lock();
+    }
+}
+
+// 多源复制时每个通道一行，取最大延迟；任一通道的复制线程停止即视为不可用
+auto ReplicaMonitor::ProbeReplica(ReplicaProbe& Probe) -> ReplicaHealth
+{
+    ReplicaHealth Health;
+    Health.Name = EndpointName(Probe.Endpoint.Config);
+    Health.Weight = Probe.Endpoint.Weight;
+    MySQLWrapper& Connection = *Probe.Connection;
+    if (!Connection.IsConnectionActive() && !Connection.Connect(Probe.Endpoint.Config))
+    {
+        Health.LastError = Connection.GetLastError();
+        return Health;
+    }
+    MySQLResult Status = Connection.Query("SHOW REPLICA STATUS");
+    if (!Status.Success)
+        Status = Connection.Query("SHOW SLAVE STATUS");
+    if (!Status.Success)
+    {
+        Health.LastError = Status.ErrorMessage;
+        Health.IsReachable = Connection.Ping();
+        if (!Health.IsReachable)
+            Connection.Disconnect();
+        return Health;
+    }
+    Health.IsReachable = true;
+    if (Status.Rows.empty())
+    {
+        Health.LastError = "未配置复制";
+        return Health;
+    }
+    const auto ColumnOf = [&Status](std::string_view Name, std::string_view LegacyName)
+    {
+        const auto Index = Status.GetColumnIndex(Name);
+        return Index ? Index : Status.GetColumnIndex(LegacyName);
+    };
+    const auto LagIndex = ColumnOf("Seconds_Behind_Source", "Seconds_Behind_Master");
+    const auto SqlRunningIndex = ColumnOf("Replica_SQL_Running", "Slave_SQL_Running");
+    const auto IoRunningIndex = ColumnOf("Replica_IO_Running", "Slave_IO_Running");
+    if (!LagIndex || !SqlRunningIndex || !IoRunningIndex)
+    {
+        Health.LastError = "无法识别复制状态的列";
+        return Health;
+    }
+    std::chrono::milliseconds MaxLag{ 0 };
+    for (const MySQLRow& Row : Status.Rows)
+    {
+        const auto LagSeconds = Row.GetValue<long long>(*LagIndex);
+        if (!LagSeconds || Row.GetValue<std::string>(*SqlRunningIndex) != "Yes" || Row.GetValue<std::string>(*IoRunningIndex) != "Yes")
+        {
+            Health.LastError = "复制线程未运行";
+            return Health;
+        }
+        MaxLag = (std::max)(MaxLag, std::chrono::milliseconds(*LagSeconds * 1000));
+    }
+    Health.IsReplicating = true;
+    Health.Lag = MaxLag;
+    return Health;
+}
+
+QueryRouter::QueryRouter(RoutingConfig ConfigParam, std::shared_ptr<ReplicaMonitor> SharedMonitor) : Config(std::move(ConfigParam)), Monitor(std::move(SharedMonitor))
+{
+    if (!Monitor && !Config.Replicas.empty())
+        Monitor = std::make_shared<ReplicaMonitor>(Config.Replicas, Config.ProbeInterval);
+    // 共用的监视器可能按别的顺序或只探测部分从库，按端点名而不是下标对应
+    const std::vector<ReplicaHealth> Monitored = Monitor ? Monitor->GetHealth() : std::vector<ReplicaHealth>{};
+    Replicas.reserve(Config.Replicas.size());
+    for (const auto& Endpoint : Config.Replicas)
+    {
+        const auto Found = std::ranges::find(Monitored, EndpointName(Endpoint.Config), &ReplicaHealth::Name);
+        const auto HealthIndex = Found == Monitored.end() ? std::nullopt : std::optional<std::size_t>(static_cast<std::size_t>(Found - Monitored.begin()));
+        Replicas.push_back({ Endpoint, std::make_unique<MySQLWrapper>(), 0, {}, HealthIndex });
+    }
+}
+
+auto QueryRouter::Connect() -> std::expected<void, std::string>
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    if (Config.PrimaryFailover)
+    {
+        if (!Primary.ConnectFailover(Config.PrimaryFailover))
+            return std::unexpected(std::format("连接主库失败: {}", Primary.GetLastError()));
+    }
+    else if (!Primary.Connect(Config.Primary))
+        return std::unexpected(std::format("连接主库 {} 失败: {}", EndpointName(Config.Primary), Primary.GetLastError()));
+    for (auto& Replica : Replicas)
+        (void)ConnectReplica(Replica);
+    if (Monitor)
+        Monitor->Start();
+    return {};
+}
+
+auto QueryRouter::ConnectReplica(ReplicaRoute& Replica) -> bool
+{
+    Replica.NextConnectAttempt = std::chrono::steady_clock::now() + Config.ProbeInterval;
+    if (!Replica.Connection->Connect(Replica.Endpoint.Config))
+        return false;
+    for (const auto& Configure : Configurators)
+        Configure(*Replica.Connection);
+    for (const std::string* Statement : { &SchemaStatement, &CharsetStatement })
+    {
+        if (!Statement->empty() && !Replica.Connection->Execute(*Statement).Success)
+        {
+            Replica.Connection->Disconnect();
+            return false;
+        }
+    }
+    return true;
+}
+
+auto QueryRouter::ForEachConnection(const std::function<void(MySQLWrapper&)>& Configure) -> void
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    Configure(Primary);
+    for (auto& Replica : Replicas)
+        Configure(*Replica.Connection);
+    Configurators.push_back(Configure);
+}
+
+// 平滑加权轮询；有效权重随延迟下降，延迟 1 秒时减半
+auto QueryRouter::PickReplica() -> std::optional<std::size_t>
+{
+    if (!Monitor)
+        return std::nullopt;
+    const std::vector<ReplicaHealth> HealthList = Monitor->GetHealth();
+    const auto Now = std::chrono::steady_clock::now();
+    int64_t TotalWeight = 0;
+    std::optional<std::size_t> Chosen;
+    for (std::size_t Index = 0; Index < Replicas.size(); ++Index)
+    {
+        ReplicaRoute& Replica = Replicas[Index];
+        if (!Replica.HealthIndex || *Replica.HealthIndex >= HealthList.size())
+            continue;
+        const ReplicaHealth& Health = HealthList[*Replica.HealthIndex];
+        if (!Health.IsReachable || !Health.IsReplicating || !Health.Lag || *Health.Lag > Config.MaxReplicaLag || Replica.Endpoint.Weight == 0)
+            continue;
+        if (!Replica.Connection->IsConnectionActive() && (Now < Replica.NextConnectAttempt || !ConnectReplica(Replica)))
+            continue;
+        const int64_t EffectiveWeight = (std::max)(int64_t{ 1 }, static_cast<int64_t>(Replica.Endpoint.Weight) * 1'000'000 / (1000 + Health.Lag->count()));
+        Replica.CurrentWeight += EffectiveWeight;
+        TotalWeight += EffectiveWeight;
+        if (!Chosen || Replica.CurrentWeight > Replicas[*Chosen].CurrentWeight)
+            Chosen = Index;
+    }
+    if (Chosen)
+        Replicas[*Chosen].CurrentWeight -= TotalWeight;
+    return Chosen;
+}
+
+// 没有启用 GTID 时返回空串
+auto QueryRouter::RefreshWriteToken() -> std::string
+{
+    const auto GtidSet = FirstField(Primary.Query("SELECT @@GLOBAL.gtid_executed"));
+    if (!GtidSet)
+        return {};
+    HasUnsyncedWrite = false;
+    WriteToken = *GtidSet;
+    std::erase_if(WriteToken, [](char CharValue) { return CharValue == '\n' || CharValue == '\r'; });
+    return WriteToken;
+}
+
+auto QueryRouter::WaitForGtid(MySQLWrapper& Connection, const std::string& GtidSet) -> bool
+{
+    Counters.GtidWaits.fetch_add(1, std::memory_order_relaxed);
+    const double TimeoutSeconds = std::chrono::duration<double>(Config.GtidWaitTimeout).count();
+    const auto Reached = FirstField(Connection.Query(std::format("SELECT WAIT_FOR_EXECUTED_GTID_SET('{}', {:.3f})", SQLSanitizer::EscapeString(GtidSet), TimeoutSeconds)));
+    if (Reached == "0")
+        return true;
+    Counters.GtidWaitTimeouts.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+auto QueryRouter::TrackSessionState(std::string_view SqlQuery) -> void
+{
+    const std::string_view Text = SkipSpaceAndComments(SqlQuery);
+    if (StartsWithKeyword(Text, "BEGIN") || (StartsWithKeyword(Text, "START") && StartsWithKeyword(SkipKeyword(Text, "START"), "TRANSACTION")))
+        InTransaction = true;
+    else if (StartsWithKeyword(Text, "COMMIT") || (StartsWithKeyword(Text, "ROLLBACK") && !StartsWithKeyword(SkipKeyword(Text, "ROLLBACK"), "TO")))
+        InTransaction = false;
+    else if (StartsWithKeyword(Text, "LOCK"))
+        HasTableLocks = true;
+    else if (StartsWithKeyword(Text, "UNLOCK"))
+        HasTableLocks = false;
+    else if (StartsWithKeyword(Text, "SET"))
+    {
+        // SET [SESSION] autocommit = 0|1 / SET @@autocommit = ...
+        std::string_view Rest = SkipKeyword(Text, "SET");
+        if (StartsWithKeyword(Rest, "SESSION") || StartsWithKeyword(Rest, "LOCAL"))
+            Rest = SkipKeyword(Rest, StartsWithKeyword(Rest, "SESSION") ? "SESSION" : "LOCAL");
+        while (Rest.starts_with('@'))
+            Rest.remove_prefix(1);
+        if (Rest.starts_with("session.") || Rest.starts_with("SESSION."))
+            Rest.remove_prefix(8);
+        if (StartsWithKeyword(Rest, "AUTOCOMMIT"))
+        {
+            Rest = SkipKeyword(Rest, "AUTOCOMMIT");
+            if (Rest.starts_with(":="))
+                Rest.remove_prefix(2);
+            else if (Rest.starts_with('='))
+                Rest.remove_prefix(1);
+            Rest = SkipSpaceAndComments(Rest);
+            IsAutocommitOff = Rest.starts_with('0') || StartsWithKeyword(Rest, "OFF") || StartsWithKeyword(Rest, "FALSE");
+            if (!IsAutocommitOff)
+                InTransaction = false;
+            return;
+        }
+    }
+    else if (StartsWithKeyword(Text, "XA") || StartsWithKeyword(Text, "PREPARE") || StartsWithKeyword(Text, "HANDLER")
+        || (StartsWithKeyword(Text, "CREATE") && StartsWithKeyword(SkipKeyword(Text, "CREATE"), "TEMPORARY")))
+        IsPinned = true;
+    if (!IsPinned && ScanStatement(Text).HoldsConnectionState)
+        IsPinned = true;
+}
+
+auto QueryRouter::ExecuteOnPrimary(const std::string& SqlQuery, StatementRoute RouteKind, std::chrono::milliseconds Timeout) -> MySQLResult
+{
+    Counters.PrimaryStatements.fetch_add(1, std::memory_order_relaxed);
+    LastReplica.reset();
+    MySQLResult ResultData = Primary.Query(SqlQuery, Timeout);
+    if (RouteKind == StatementRoute::Write)
+    {
+        // 失败的写入也可能已经部分生效
+        HasWritten = true;
+        HasUnsyncedWrite = true;
+    }
+    if (!ResultData.Success || RouteKind == StatementRoute::Read)
+        return ResultData;
+    for (auto& Statement : SplitSQLStatements(SqlQuery))
+    {
+        TrackSessionState(Statement);
+        // 与其他语句一起发送的 USE / SET NAMES 无法单独在从库上重放
+        if (RouteKind != StatementRoute::Session && ClassifySingleStatement(Statement) == StatementRoute::Session)
+            IsPinned = true;
+        else if (RouteKind == StatementRoute::Session)
+            (StartsWithKeyword(SkipSpaceAndComments(Statement), "USE") ? SchemaStatement : CharsetStatement) = std::move(Statement);
+    }
+    if (RouteKind == StatementRoute::Session)
+    {
+        for (std::size_t Index = 0; Index < Replicas.size(); ++Index)
+        {
+            MySQLWrapper& Connection = *Replicas[Index].Connection;
+            if (Connection.IsConnectionActive() && !Connection.Execute(SqlQuery, Timeout).Success)
+            {
+                // 从库上没有对应的库等情况：断开，重连时再次重放，失败则一直不参与路由
+                Connection.Disconnect();
+                if (Monitor && Replicas[Index].HealthIndex)
+                    Monitor->MarkUnreachable(*Replicas[Index].HealthIndex, std::format("重放会话语句失败: {}", Connection.GetLastError()));
+            }
+        }
+    }
+    return ResultData;
+}
+
+auto QueryRouter::Route(const std::string& SqlQuery, std::string_view Token, std::chrono::milliseconds Timeout) -> MySQLResult
+{
+    if (IsDiagnosticsStatement(SqlQuery))
+    {
+        if (LastReplica && Replicas[*LastReplica].Connection->IsConnectionActive())
+            return Replicas[*LastReplica].Connection->Query(SqlQuery, Timeout);
+        return Primary.Query(SqlQuery, Timeout);
+    }
+    const StatementRoute RouteKind = ClassifyStatement(SqlQuery);
+    if (RouteKind != StatementRoute::Read || Replicas.empty() || InTransaction || IsAutocommitOff || HasTableLocks || IsPinned)
+        return ExecuteOnPrimary(SqlQuery, RouteKind, Timeout);
+    std::string GtidSet(Token);
+    if (GtidSet.empty() && Consistency == ReadConsistency::ReadYourWrites && HasWritten)
+    {
+        GtidSet = HasUnsyncedWrite ? RefreshWriteToken() : WriteToken;
+        // 未启用 GTID 时无法确认从库是否追上，本会话写入之后的读取全部走主库
+        if (GtidSet.empty())
+        {
+            Counters.FallbackReads.fetch_add(1, std::memory_order_relaxed);
+            return ExecuteOnPrimary(SqlQuery, RouteKind, Timeout);
+        }
+    }
+    const auto ReplicaIndex = PickReplica();
+    if (!ReplicaIndex || (!GtidSet.empty() && !WaitForGtid(*Replicas[*ReplicaIndex].Connection, GtidSet)))
+    {
+        Counters.FallbackReads.fetch_add(1, std::memory_order_relaxed);
+        return ExecuteOnPrimary(SqlQuery, RouteKind, Timeout);
+    }
+    MySQLWrapper& Connection = *Replicas[*ReplicaIndex].Connection;
+    MySQLResult ResultData = Connection.Query(SqlQuery, Timeout);
+    if (!ResultData.Success && ResultData.Status == QueryStatus::Failed && !Connection.Ping())
+    {
+        // 连接层面的失败才改由主库重试，语句本身的错误原样返回
+        Connection.Disconnect();
+        Monitor->MarkUnreachable(*Replicas[*ReplicaIndex].HealthIndex, ResultData.ErrorMessage);
+        Counters.FallbackReads.fetch_add(1, std::memory_order_relaxed);
+        return ExecuteOnPrimary(SqlQuery, RouteKind, Timeout);
+    }
+    Counters.ReplicaReads.fetch_add(1, std::memory_order_relaxed);
+    LastReplica = ReplicaIndex;
+    return ResultData;
+}
+
+auto QueryRouter::Query(const std::string& SqlQuery, std::chrono::milliseconds Timeout) -> MySQLResult
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    return Route(SqlQuery, {}, Timeout);
+}
+
+auto QueryRouter::QueryAfter(const std::string& SqlQuery, std::string_view GtidSet, std::chrono::milliseconds Timeout) -> MySQLResult
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    return Route(SqlQuery, GtidSet, Timeout);
+}
+
+auto QueryRouter::SetReadConsistency(ReadConsistency Mode) -> void
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    Consistency = Mode;
+}
+
+auto QueryRouter::GetConsistencyToken() -> std::expected<std::string, std::string>
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    if (!HasUnsyncedWrite)
+        return WriteToken;
+    std::string Token = RefreshWriteToken();
+    if (Token.empty())
+        return std::unexpected("无法读取主库的 gtid_executed，请确认已启用 GTID");
+    return Token;
+}
+
+auto QueryRouter::BeginTransaction() -> bool
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    LastReplica.reset();
+    if (!Primary.BeginTransaction())
+        return false;
+    InTransaction = true;
+    return true;
+}
+
+auto QueryRouter::CommitTransaction() -> bool
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    const bool IsCommitted = Primary.CommitTransaction();
+    InTransaction = false;
+    return IsCommitted;
+}
+
+auto QueryRouter::RollbackTransaction() -> bool
+{
+    std::lock_guard<std::mutex> Lock(RouterMutex);
+    const bool IsRolledBack = Primary.RollbackTransaction();
+    InTransaction = false;
+    return IsRolledBack;
+}
+
+auto QueryRouter::GetStatistics() const -> RoutingStatistics
+{
+    return { Counters.PrimaryStatements.load(std::memory_order_relaxed), Counters.ReplicaReads.load(std::memory_order_relaxed),
+        Counters.FallbackReads.load(std::memory_order_relaxed), Counters.GtidWaits.load(std::memory_order_relaxed),
+        Counters.GtidWaitTimeouts.load(std::memory_order_relaxed) };
+}
+
+auto QueryRouter::GetReplicaHealth() const -> std::vector<ReplicaHealth>
+{
+    return Monitor ? Monitor->GetHealth() : std::vector<ReplicaHealth>{};
+}
+
+// 多条语句一起发送时，只有全部为只读才交给从库
+auto QueryRouter::ClassifyStatement(std::string_view SqlQuery) -> StatementRoute
+{
+    const std::vector<std::string> Statements = SplitSQLStatements(SqlQuery);
+    if (Statements.size() == 1)
+        return ClassifySingleStatement(Statements.front());
+    if (Statements.empty())
+        return StatementRoute::Write;
+    const bool IsAllRead = std::ranges::all_of(Statements, [](const std::string& Statement) { return ClassifySingleStatement(Statement) == StatementRoute::Read; });
+    return IsAllRead ? StatementRoute::Read : StatementRoute::Write;
+}
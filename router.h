@@ -0,0 +1,173 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReplicaEndpoint
+{
+    MySQLConfig Config;
+    unsigned int Weight = 1;
+};
+
+struct RoutingConfig
+{
+    MySQLConfig Primary;
+    // 非空时主库在其中的候选端点间故障转移，忽略 Primary
+    std::shared_ptr<EndpointHealthMonitor> PrimaryFailover;
+    std::vector<ReplicaEndpoint> Replicas;
+    // 延迟超过该值（或复制线程未运行）的从库不再接收读请求
+    std::chrono::milliseconds MaxReplicaLag{ 5000 };
+    std::chrono::milliseconds ProbeInterval{ 1000 };
+    // 读己之写时在从库上等待 GTID 的上限，超时后改读主库
+    std::chrono::milliseconds GtidWaitTimeout{ 200 };
+};
+
+enum class StatementRoute : uint8_t
+{
+    Read,
+    Write,
+    Session
+};
+
+enum class ReadConsistency : uint8_t
+{
+    Eventual,
+    ReadYourWrites
+};
+
+struct ReplicaHealth
+{
+    std::string Name;
+    unsigned int Weight = 1;
+    bool IsReachable = false;
+    bool IsReplicating = false;
+    std::optional<std::chrono::milliseconds> Lag;
+    std::string LastError;
+};
+
+struct RoutingStatistics
+{
+    uint64_t PrimaryStatements = 0;
+    uint64_t ReplicaReads = 0;
+    uint64_t FallbackReads = 0;
+    uint64_t GtidWaits = 0;
+    uint64_t GtidWaitTimeouts = 0;
+};
+
+// 后台线程定期在独立连接上读取各从库的复制状态，多个路由器可以共用一个监视器
+class ReplicaMonitor
+{
+private:
+    struct ReplicaProbe
+    {
+        ReplicaEndpoint Endpoint;
+        std::unique_ptr<MySQLWrapper> Connection;
+        ReplicaHealth Health;
+    };
+    std::vector<ReplicaProbe> Probes;
+    std::chrono::milliseconds Interval;
+    mutable std::mutex HealthMutex;
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    std::once_flag StartOnce;
+    std::jthread ProbeThread;
+    auto ProbeLoop(std::stop_token StopToken) -> void;
+    [[nodiscard]] static auto ProbeReplica(ReplicaProbe& Probe) -> ReplicaHealth;
+public:
+    ReplicaMonitor(std::vector<ReplicaEndpoint> Replicas, std::chrono::milliseconds ProbeInterval);
+    ~ReplicaMonitor();
+    ReplicaMonitor(const ReplicaMonitor&) = delete;
+    auto operator=(const ReplicaMonitor&) -> ReplicaMonitor & = delete;
+    // 先同步探测一轮，再启动后台线程
+    auto Start() -> void;
+    [[nodiscard]] auto GetHealth() const -> std::vector<ReplicaHealth>;
+    // 路由连接出错时立即摘除，等待下一轮探测恢复
+    auto MarkUnreachable(std::size_t ReplicaIndex, std::string_view Reason) -> void;
+};
+
+// 读写分离：只读语句按权重和复制延迟分发到从库，写入、事务以及依赖会话状态的语句发往主库。
+// 与 MySQLWrapper 一样代表一个逻辑会话：事务期间、以及创建过临时表或用户变量之后，所有语句固定在主库上。
+// 读己之写：会话写入后读取主库的 gtid_executed 作为令牌，从库执行 WAIT_FOR_EXECUTED_GTID_SET 追上后再读。
+class QueryRouter
+{
+private:
+    struct ReplicaRoute
+    {
+        ReplicaEndpoint Endpoint;
+        std::unique_ptr<MySQLWrapper> Connection;
+        int64_t CurrentWeight = 0;
+        std::chrono::steady_clock::time_point NextConnectAttempt;
+        // 在监视器健康列表中的下标；监视器不探测该端点时为空，该从库不参与路由
+        std::optional<std::size_t> HealthIndex;
+    };
+    RoutingConfig Config;
+    std::shared_ptr<ReplicaMonitor> Monitor;
+    MySQLWrapper Primary;
+    std::vector<ReplicaRoute> Replicas;
+    std::mutex RouterMutex;
+    ReadConsistency Consistency = ReadConsistency::Eventual;
+    bool InTransaction = false;
+    bool IsAutocommitOff = false;
+    bool HasTableLocks = false;
+    bool IsPinned = false;
+    bool HasWritten = false;
+    bool HasUnsyncedWrite = false;
+    std::string WriteToken;
+    // 上一条语句所在的从库；SHOW WARNINGS 之类的诊断语句必须发往同一连接
+    std::optional<std::size_t> LastReplica;
+    // 最近一次广播的 USE 与字符集语句，从库重连后重放；更早的同类语句已被覆盖，不必保留
+    std::string SchemaStatement;
+    std::string CharsetStatement;
+    std::vector<std::function<void(MySQLWrapper&)>> Configurators;
+    struct RouterCounters
+    {
+        std::atomic<uint64_t> PrimaryStatements{ 0 };
+        std::atomic<uint64_t> ReplicaReads{ 0 };
+        std::atomic<uint64_t> FallbackReads{ 0 };
+        std::atomic<uint64_t> GtidWaits{ 0 };
+        std::atomic<uint64_t> GtidWaitTimeouts{ 0 };
+    } Counters;
+    [[nodiscard]] auto ConnectReplica(ReplicaRoute& Replica) -> bool;
+    [[nodiscard]] auto PickReplica() -> std::optional<std::size_t>;
+    [[nodiscard]] auto RefreshWriteToken() -> std::string;
+    [[nodiscard]] auto WaitForGtid(MySQLWrapper& Connection, const std::string& GtidSet) -> bool;
+    auto TrackSessionState(std::string_view SqlQuery) -> void;
+    [[nodiscard]] auto ExecuteOnPrimary(const std::string& SqlQuery, StatementRoute Route, std::chrono::milliseconds Timeout) -> MySQLResult;
+    [[nodiscard]] auto Route(const std::string& SqlQuery, std::string_view Token, std::chrono::milliseconds Timeout) -> MySQLResult;
+public:
+    // SharedMonitor 的健康信息按端点（主机:端口）对应到 Config.Replicas，顺序可以不同，权重以 Config.Replicas 为准
+    explicit QueryRouter(RoutingConfig ConfigParam, std::shared_ptr<ReplicaMonitor> SharedMonitor = nullptr);
+    QueryRouter(const QueryRouter&) = delete;
+    auto operator=(const QueryRouter&) -> QueryRouter & = delete;
+    // 主库必须连上；连不上的从库只记录，之后按探测结果重试
+    [[nodiscard]] auto Connect() -> std::expected<void, std::string>;
+    [[nodiscard]] auto Query(const std::string& SqlQuery, std::chrono::milliseconds Timeout = {}) -> MySQLResult;
+    // 保证读到 GtidSet（通常来自另一个会话的 GetConsistencyToken）之前的所有写入
+    [[nodiscard]] auto QueryAfter(const std::string& SqlQuery, std::string_view GtidSet, std::chrono::milliseconds Timeout = {}) -> MySQLResult;
+    auto SetReadConsistency(ReadConsistency Mode) -> void;
+    // 本会话已提交写入对应的 GTID 集合，可交给其他会话的 QueryAfter 使用
+    [[nodiscard]] auto GetConsistencyToken() -> std::expected<std::string, std::string>;
+    [[nodiscard]] auto BeginTransaction() -> bool;
+    [[nodiscard]] auto CommitTransaction() -> bool;
+    [[nodiscard]] auto RollbackTransaction() -> bool;
+    [[nodiscard]] auto GetPrimary() noexcept -> MySQLWrapper&
+    {
+        return Primary;
+    }
+    // 对主库和所有从库连接统一设置（结果上限、内存预算、负载采集等）
+    auto ForEachConnection(const std::function<void(MySQLWrapper&)>& Configure) -> void;
+    [[nodiscard]] auto GetStatistics() const -> RoutingStatistics;
+    [[nodiscard]] auto GetReplicaHealth() const -> std::vector<ReplicaHealth>;
+    [[nodiscard]] static auto ClassifyStatement(std::string_view SqlQuery) -> StatementRoute;
+};
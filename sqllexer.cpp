@@ -0,0 +1,318 @@
+#include "sqllexer.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    // 按字典序排列，供二分查找
+    constexpr std::array<std::string_view, 136> Keywords = {
+        "ADD", "ALL", "ALTER", "AND", "AS", "ASC", "AUTO_INCREMENT", "BEGIN", "BETWEEN", "BIGINT", "BINARY", "BLOB", "BY", "CALL", "CASCADE", "CASE",
+        "CHAR", "CHARSET", "CHECK", "COLLATE", "COLUMN", "COLUMNS", "COMMIT", "CONSTRAINT", "CREATE", "CROSS", "DATABASE", "DATABASES", "DATE",
+        "DATETIME", "DECIMAL", "DECLARE", "DEFAULT", "DELETE", "DELIMITER", "DESC", "DESCRIBE", "DISTINCT", "DO", "DOUBLE", "DROP", "DUPLICATE",
+        "ELSE", "ELSEIF", "END", "ENGINE", "ENUM", "EXISTS", "EXPLAIN", "FALSE", "FLOAT", "FOR", "FOREIGN", "FROM", "FULL", "FUNCTION", "GRANT",
+        "GROUP", "HAVING", "IF", "IGNORE", "IN", "INDEX", "INNER", "INSERT", "INT", "INTEGER", "INTERVAL", "INTO", "IS", "JOIN", "JSON", "KEY",
+        "KEYS", "KILL", "LEFT", "LIKE", "LIMIT", "LOCK", "LONGTEXT", "MEDIUMTEXT", "MODIFY", "NOT", "NULL", "OFFSET", "ON", "OR", "ORDER", "OUTER",
+        "PRIMARY", "PROCEDURE", "QUERY", "RECURSIVE", "REFERENCES", "RENAME", "REPLACE", "RETURN", "RETURNS", "REVOKE", "RIGHT", "ROLLBACK",
+        "SAVEPOINT", "SCHEMA", "SELECT", "SET", "SHOW", "SMALLINT", "START", "STATUS", "TABLE", "TABLES", "TEMPORARY", "TEXT", "THEN", "TIME",
+        "TIMESTAMP", "TINYINT", "TO", "TRANSACTION", "TRIGGER", "TRUE", "TRUNCATE", "UNION", "UNIQUE", "UNLOCK", "UNSIGNED", "UPDATE", "USE",
+        "USING", "VALUES", "VARCHAR", "VIEW", "WHEN", "WHERE", "WHILE", "WITH" };
+    static_assert(std::ranges::is_sorted(Keywords));
+    constexpr std::size_t MaxKeywordLength = 14;
+
+    [[nodiscard]] constexpr auto IsWordStart(char16_t CharValue) noexcept -> bool
+    {
+        return (CharValue >= u'a' && CharValue <= u'z') || (CharValue >= u'A' && CharValue <= u'Z') || CharValue == u'_' || CharValue == u'$' || CharValue >= 0x80;
+    }
+
+    [[nodiscard]] constexpr auto IsDigit(char16_t CharValue) noexcept -> bool
+    {
+        return CharValue >= u'0' && CharValue <= u'9';
+    }
+
+    [[nodiscard]] auto IsKeyword(std::u16string_view Word) noexcept -> bool
+    {
+        if (Word.size() > MaxKeywordLength)
+            return false;
+        std::array<char, MaxKeywordLength> Upper{};
+        for (std::size_t Index = 0; Index < Word.size(); ++Index)
+        {
+            const char16_t CharValue = Word[Index];
+            if (CharValue >= 0x80)
+                return false;
+            Upper[Index] = static_cast<char>(CharValue >= u'a' && CharValue <= u'z' ? CharValue - (u'a' - u'A') : CharValue);
+        }
+        return std::ranges::binary_search(Keywords, std::string_view{ Upper.data(), Word.size() });
+    }
+
+    // 与 SplitSQLStatements 相同：前一个字符是反斜杠的引号不起作用
+    [[nodiscard]] auto FindQuoteEnd(std::u16string_view Content, std::size_t From, char16_t Quote) noexcept -> std::size_t
+    {
+        for (std::size_t Index = From; Index < Content.size(); ++Index)
+        {
+            if (Content[Index] == Quote && !(Index > 0 && Content[Index - 1] == u'\\'))
+                return Index;
+        }
+        return std::u16string_view::npos;
+    }
+}
+
+auto GetSqlKeywords() noexcept -> std::span<const std::string_view>
+{
+    return Keywords;
+}
+
+auto IncrementalSqlLexer::FindLine(std::size_t Offset) const noexcept -> std::size_t
+{
+    const auto Found = std::ranges::upper_bound(Lines, Offset, {}, &Line::Start);
+    return static_cast<std::size_t>(Found - Lines.begin()) - 1;
+}
+
+auto IncrementalSqlLexer::GetLineEnd(std::size_t LineIndex) const noexcept -> std::size_t
+{
+    return LineIndex + 1 < Lines.size() ? Lines[LineIndex + 1].Start : Text.size();
+}
+
+auto IncrementalSqlLexer::LexLine(Line& Target, std::size_t End) const -> SqlLexState
+{
+    if (End > Target.Start && Text[End - 1] == u'\n')
+        --End;
+    if (End > Target.Start && Text[End - 1] == u'\r')
+        --End;
+    const std::u16string_view Content = std::u16string_view{ Text }.substr(Target.Start, End - Target.Start);
+    Target.Spans.clear();
+    const auto AddSpan = [&Target](std::size_t From, std::size_t To, SqlTokenKind Kind)
+    {
+        if (To > From)
+            Target.Spans.push_back({ static_cast<uint32_t>(From), static_cast<uint32_t>(To - From), Kind });
+    };
+    SqlLexState State = Target.EntryState;
+    std::size_t Position = 0;
+    // 从上一行延续的字符串或注释
+    if (State == SqlLexState::SingleQuote || State == SqlLexState::DoubleQuote)
+    {
+        const std::size_t Close = FindQuoteEnd(Content, 0, State == SqlLexState::SingleQuote ? u'\'' : u'"');
+        if (Close == std::u16string_view::npos)
+        {
+            AddSpan(0, Content.size(), SqlTokenKind::String);
+            return State;
+        }
+        AddSpan(0, Close + 1, SqlTokenKind::String);
+        Position = Close + 1;
+    }
+    else if (State == SqlLexState::BlockComment)
+    {
+        const std::size_t Close = Content.find(u"*/");
+        if (Close == std::u16string_view::npos)
+        {
+            AddSpan(0, Content.size(), SqlTokenKind::Comment);
+            return State;
+        }
+        AddSpan(0, Close + 2, SqlTokenKind::Comment);
+        Position = Close + 2;
+    }
+    while (Position < Content.size())
+    {
+        const char16_t Current = Content[Position];
+        const char16_t Next = Position + 1 < Content.size() ? Content[Position + 1] : u'\0';
+        if ((Current == u'-' && Next == u'-') || Current == u'#')
+        {
+            AddSpan(Position, Content.size(), SqlTokenKind::Comment);
+            return SqlLexState::Normal;
+        }
+        if (Current == u'/' && Next == u'*')
+        {
+            const std::size_t Close = Content.find(u"*/", Position + 2);
+            if (Close == std::u16string_view::npos)
+            {
+                AddSpan(Position, Content.size(), SqlTokenKind::Comment);
+                return SqlLexState::BlockComment;
+            }
+            AddSpan(Position, Close + 2, SqlTokenKind::Comment);
+            Position = Close + 2;
+            continue;
+        }
+        if ((Current == u'\'' || Current == u'"') && !(Position > 0 && Content[Position - 1] == u'\\'))
+        {
+            const std::size_t Close = FindQuoteEnd(Content, Position + 1, Current);
+            if (Close == std::u16string_view::npos)
+            {
+                AddSpan(Position, Content.size(), SqlTokenKind::String);
+                return Current == u'\'' ? SqlLexState::SingleQuote : SqlLexState::DoubleQuote;
+            }
+            AddSpan(Position, Close + 1, SqlTokenKind::String);
+            Position = Close + 1;
+            continue;
+        }
+        // 反引号不影响语句切分，未闭合时只到行尾
+        if (Current == u'`')
+        {
+            const std::size_t Close = Content.find(u'`', Position + 1);
+            const std::size_t SpanEnd = Close == std::u16string_view::npos ? Content.size() : Close + 1;
+            AddSpan(Position, SpanEnd, SqlTokenKind::QuotedIdentifier);
+            Position = SpanEnd;
+            continue;
+        }
+        if (IsDigit(Current) || IsWordStart(Current))
+        {
+            const std::size_t Start = Position;
+            while (Position < Content.size() && (IsWordStart(Content[Position]) || IsDigit(Content[Position]) || (IsDigit(Current) && Content[Position] == u'.')))
+                ++Position;
+            if (IsDigit(Current))
+                AddSpan(Start, Position, SqlTokenKind::Number);
+            else if (IsKeyword(Content.substr(Start, Position - Start)))
+                AddSpan(Start, Position, SqlTokenKind::Keyword);
+            continue;
+        }
+        if (Current == u';')
+            AddSpan(Position, Position + 1, SqlTokenKind::Delimiter);
+        ++Position;
+    }
+    return SqlLexState::Normal;
+}
+
+auto IncrementalSqlLexer::ApplyEdit(std::size_t Offset, std::size_t RemovedLength, std::u16string_view Inserted) -> SqlLexDamage
+{
+    Offset = (std::min)(Offset, Text.size());
+    RemovedLength = (std::min)(RemovedLength, Text.size() - Offset);
+    if (RemovedLength == 0 && Inserted.empty())
+        return {};
+    // 从修改点前一个字符所在的行开始：在 "\r" 与 "\n" 之间的修改会改变换行的切分
+    const std::size_t FirstLine = FindLine(Offset == 0 ? 0 : Offset - 1);
+    std::size_t LastLine = FindLine(Offset + RemovedLength);
+    const auto ShiftOld = [&](std::size_t OldOffset)
+    {
+        return OldOffset - RemovedLength + Inserted.size();
+    };
+    const auto GetOldLineEnd = [&](std::size_t LineIndex)
+    {
+        return LineIndex + 1 < Lines.size() ? ShiftOld(Lines[LineIndex + 1].Start) : Text.size();
+    };
+    Text.replace(Offset, RemovedLength, Inserted);
+    const std::size_t RegionStart = Lines[FirstLine].Start;
+    std::size_t RegionEnd = GetOldLineEnd(LastLine);
+    // 区域以新的 "\r" 结尾而下一行以 "\n" 开头时，两者合并为一个换行
+    while (RegionEnd > RegionStart && RegionEnd < Text.size() && Text[RegionEnd - 1] == u'\r' && Text[RegionEnd] == u'\n')
+        RegionEnd = GetOldLineEnd(++LastLine);
+    // 区域到达文档末尾时包括末尾换行之后的空行，由下面的切分重新生成
+    if (RegionEnd == Text.size())
+        LastLine = Lines.size() - 1;
+
+    std::vector<Line> NewLines;
+    SqlLexState State = Lines[FirstLine].EntryState;
+    std::size_t Position = RegionStart;
+    while (true)
+    {
+        Line NewLine;
+        NewLine.Start = Position;
+        NewLine.EntryState = State;
+        const std::size_t Break = Text.find_first_of(u"\r\n", Position);
+        if (Break == std::u16string::npos || Break >= RegionEnd)
+        {
+            // 没有换行的只能是文档的最后一行
+            State = LexLine(NewLine, RegionEnd);
+            NewLines.push_back(std::move(NewLine));
+            break;
+        }
+        const std::size_t LineEnd = Break + (Text[Break] == u'\r' && Break + 1 < Text.size() && Text[Break + 1] == u'\n' ? 2 : 1);
+        State = LexLine(NewLine, LineEnd);
+        NewLines.push_back(std::move(NewLine));
+        Position = LineEnd;
+        if (Position == RegionEnd && RegionEnd < Text.size())
+            break;
+    }
+
+    const std::size_t OldCount = LastLine - FirstLine + 1;
+    const std::size_t NewCount = NewLines.size();
+    const std::size_t CommonCount = (std::min)(OldCount, NewCount);
+    std::ranges::move(NewLines.begin(), NewLines.begin() + CommonCount, Lines.begin() + FirstLine);
+    if (NewCount > OldCount)
+        Lines.insert(Lines.begin() + FirstLine + CommonCount, std::make_move_iterator(NewLines.begin() + CommonCount), std::make_move_iterator(NewLines.end()));
+    else
+        Lines.erase(Lines.begin() + FirstLine + CommonCount, Lines.begin() + FirstLine + OldCount);
+    for (std::size_t Index = FirstLine + NewCount; Index < Lines.size(); ++Index)
+        Lines[Index].Start = ShiftOld(Lines[Index].Start);
+
+    // 行首状态变化时向后传播，直到与修改前的检查点一致
+    std::size_t NextLine = FirstLine + NewCount;
+    while (NextLine < Lines.size() && Lines[NextLine].EntryState != State)
+    {
+        Lines[NextLine].EntryState = State;
+        Lines[NextLine].IsDirty = true;
+        State = LexLine(Lines[NextLine], GetLineEnd(NextLine));
+        ++NextLine;
+    }
+    SqlLexDamage Damage;
+    Damage.Start = RegionStart;
+    Damage.End = GetLineEnd(NextLine - 1);
+    Damage.FirstLine = FirstLine;
+    Damage.LineCount = NextLine - FirstLine;
+    return Damage;
+}
+
+auto IncrementalSqlLexer::SetText(std::u16string_view NewText) -> SqlLexDamage
+{
+    const std::u16string_view OldText = Text;
+    // 先按块用 memcmp 跳过相同的部分，每次按键都要比较整个文档
+    constexpr std::size_t BlockSize = 256;
+    const std::size_t CommonLimit = (std::min)(OldText.size(), NewText.size());
+    std::size_t Prefix = 0;
+    while (CommonLimit - Prefix >= BlockSize && std::memcmp(OldText.data() + Prefix, NewText.data() + Prefix, BlockSize * sizeof(char16_t)) == 0)
+        Prefix += BlockSize;
+    while (Prefix < CommonLimit && OldText[Prefix] == NewText[Prefix])
+        ++Prefix;
+    if (Prefix == OldText.size() && Prefix == NewText.size())
+        return {};
+    const std::size_t SuffixLimit = CommonLimit - Prefix;
+    std::size_t Suffix = 0;
+    while (SuffixLimit - Suffix >= BlockSize && std::memcmp(OldText.data() + OldText.size() - Suffix - BlockSize, NewText.data() + NewText.size() - Suffix - BlockSize, BlockSize * sizeof(char16_t)) == 0)
+        Suffix += BlockSize;
+    while (Suffix < SuffixLimit && OldText[OldText.size() - 1 - Suffix] == NewText[NewText.size() - 1 - Suffix])
+        ++Suffix;
+    return ApplyEdit(Prefix, OldText.size() - Prefix - Suffix, NewText.substr(Prefix, NewText.size() - Prefix - Suffix));
+}
+
+auto IncrementalSqlLexer::Clear() -> void
+{
+    Text.clear();
+    Lines.assign(1, Line{});
+}
+
+auto IncrementalSqlLexer::TakeDirtyRange(std::size_t Start, std::size_t End) -> SqlLexDamage
+{
+    const std::size_t FirstInRange = FindLine(Start);
+    std::size_t FirstDirty = Lines.size();
+    std::size_t LastDirty = 0;
+    for (std::size_t LineIndex = FirstInRange; LineIndex < Lines.size() && (LineIndex == FirstInRange || Lines[LineIndex].Start < End); ++LineIndex)
+    {
+        if (!Lines[LineIndex].IsDirty)
+            continue;
+        Lines[LineIndex].IsDirty = false;
+        FirstDirty = (std::min)(FirstDirty, LineIndex);
+        LastDirty = LineIndex;
+    }
+    if (FirstDirty == Lines.size())
+        return {};
+    SqlLexDamage Damage;
+    Damage.Start = Lines[FirstDirty].Start;
+    Damage.End = GetLineEnd(LastDirty);
+    Damage.FirstLine = FirstDirty;
+    Damage.LineCount = LastDirty - FirstDirty + 1;
+    return Damage;
+}
+
+auto IncrementalSqlLexer::ForEachSpan(std::size_t Start, std::size_t End, const SpanCallback& Callback) const -> void
+{
+    for (std::size_t LineIndex = FindLine(Start); LineIndex < Lines.size() && Lines[LineIndex].Start < End; ++LineIndex)
+    {
+        const Line& Current = Lines[LineIndex];
+        for (const SqlTokenSpan& Span : Current.Spans)
+        {
+            const std::size_t SpanStart = Current.Start + Span.Start;
+            if (SpanStart >= End)
+                break;
+            if (SpanStart + Span.Length > Start)
+                Callback(SpanStart, Span.Length, Span.Kind);
+        }
+    }
+}
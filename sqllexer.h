@@ -0,0 +1,108 @@
+#pragma once
+#include "def.h"
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 只记录需要着色的记号；普通标识符、运算符与空白不产生区间
+enum class SqlTokenKind : uint8_t
+{
+    Keyword,
+    Number,
+    String,
+    // 反引号标识符
+    QuotedIdentifier,
+    Comment,
+    // 语句分隔符 ';'
+    Delimiter
+};
+
+// 行内区间，Start 相对所在行的开头，单位为 UTF-16 码元
+struct SqlTokenSpan
+{
+    uint32_t Start = 0;
+    uint32_t Length = 0;
+    SqlTokenKind Kind = SqlTokenKind::Keyword;
+    [[nodiscard]] auto operator==(const SqlTokenSpan&) const noexcept -> bool = default;
+};
+
+// 行首的词法状态：跨行的只有引号字符串和块注释
+enum class SqlLexState : uint8_t
+{
+    Normal,
+    SingleQuote,
+    DoubleQuote,
+    BlockComment
+};
+
+// 一次修改后着色发生变化的区域：[Start, End) 为文档偏移，覆盖第 FirstLine 行起的 LineCount 行
+struct SqlLexDamage
+{
+    std::size_t Start = 0;
+    std::size_t End = 0;
+    std::size_t FirstLine = 0;
+    std::size_t LineCount = 0;
+    [[nodiscard]] auto IsEmpty() const noexcept -> bool
+    {
+        return LineCount == 0;
+    }
+};
+
+// 着色所用的关键字，按字典序排列（大写）
+[[nodiscard]] auto GetSqlKeywords() noexcept -> std::span<const std::string_view>;
+
+// 增量 SQL 词法分析器，用于输入框的语法着色。文本以 UTF-16 保存，偏移与 RichEdit 的字符位置一致；
+// 每行保存行首状态作为检查点，修改后只重新分析被修改的行，并向后继续到某一行的行首状态与修改前一致为止。
+// 引号、转义与注释的规则与 SplitSQLStatements 相同，着色所见的语句边界就是执行时的边界（SplitSQLStatements 不识别 DELIMITER，这里也不识别）。
+// "\r\n"、单独的 "\r" 与 "\n" 都作为换行。
+class IncrementalSqlLexer
+{
+public:
+    using SpanCallback = std::function<void(std::size_t Start, std::size_t Length, SqlTokenKind Kind)>;
+private:
+    struct Line
+    {
+        std::size_t Start = 0;
+        SqlLexState EntryState = SqlLexState::Normal;
+        // 重新分析后尚未应用到控件
+        bool IsDirty = true;
+        std::vector<SqlTokenSpan> Spans;
+    };
+    std::u16string Text;
+    // 至少有一行；每个换行之后开始新的一行
+    std::vector<Line> Lines{ 1 };
+    [[nodiscard]] auto FindLine(std::size_t Offset) const noexcept -> std::size_t;
+    [[nodiscard]] auto GetLineEnd(std::size_t LineIndex) const noexcept -> std::size_t;
+    // 分析一行并返回下一行的行首状态
+    auto LexLine(Line& Target, std::size_t End) const -> SqlLexState;
+public:
+    // 与当前文本比较出修改的范围后按 ApplyEdit 处理
+    auto SetText(std::u16string_view NewText) -> SqlLexDamage;
+    // 把 [Offset, Offset + RemovedLength) 替换为 Inserted
+    auto ApplyEdit(std::size_t Offset, std::size_t RemovedLength, std::u16string_view Inserted) -> SqlLexDamage;
+    auto Clear() -> void;
+    // 取出与 [Start, End) 相交、尚未应用到控件的行，返回覆盖它们的区域并标记为已应用。
+    // 界面只为可见的部分着色，其余的行滚动到可见时再取
+    [[nodiscard]] auto TakeDirtyRange(std::size_t Start, std::size_t End) -> SqlLexDamage;
+    // 按顺序回调与 [Start, End) 相交的区间，偏移为文档偏移
+    auto ForEachSpan(std::size_t Start, std::size_t End, const SpanCallback& Callback) const -> void;
+    [[nodiscard]] auto GetText() const noexcept -> std::u16string_view
+    {
+        return Text;
+    }
+    [[nodiscard]] auto GetLineCount() const noexcept -> std::size_t
+    {
+        return Lines.size();
+    }
+    [[nodiscard]] auto GetLineState(std::size_t LineIndex) const noexcept -> SqlLexState
+    {
+        return LineIndex < Lines.size() ? Lines[LineIndex].EntryState : SqlLexState::Normal;
+    }
+    [[nodiscard]] auto GetLineSpans(std::size_t LineIndex) const noexcept -> const std::vector<SqlTokenSpan>&
+    {
+        return Lines[LineIndex].Spans;
+    }
+};
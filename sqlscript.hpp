@@ -0,0 +1,153 @@
+#pragma once
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <vector>
+
+[[nodiscard]] inline auto IsWordChar(char CharValue) noexcept -> bool
+{
+    return std::isalnum(static_cast<unsigned char>(CharValue)) || CharValue == '_' || CharValue == '$';
+}
+
+// Keyword 须为大写，Text 以它开头且其后不是标识符字符
+[[nodiscard]] inline auto StartsWithKeyword(std::string_view Text, std::string_view Keyword) noexcept -> bool
+{
+    if (Text.size() < Keyword.size() || (Text.size() > Keyword.size() && IsWordChar(Text[Keyword.size()])))
+        return false;
+    for (std::size_t Index = 0; Index < Keyword.size(); ++Index)
+    {
+        if (std::toupper(static_cast<unsigned char>(Text[Index])) != Keyword[Index])
+            return false;
+    }
+    return true;
+}
+
+// 跳过空白和注释（不含 /*+ 优化器提示），返回下一个有效字符的位置；注释未闭合时返回 npos
+[[nodiscard]] inline auto SkipSpaceAndComments(std::string_view SqlQuery, std::size_t Position) noexcept -> std::size_t
+{
+    while (Position < SqlQuery.size())
+    {
+        const std::string_view Rest = SqlQuery.substr(Position);
+        if (std::isspace(static_cast<unsigned char>(Rest.front())))
+            ++Position;
+        else if (Rest.starts_with("/*") && !Rest.starts_with("/*+"))
+        {
+            const std::size_t CommentEnd = Rest.find("*/", 2);
+            if (CommentEnd == std::string_view::npos)
+                return std::string_view::npos;
+            Position += CommentEnd + 2;
+        }
+        else if (Rest.starts_with("-- ") || Rest.starts_with('#'))
+        {
+            const std::size_t LineEnd = Rest.find('\n');
+            if (LineEnd == std::string_view::npos)
+                return SqlQuery.size();
+            Position += LineEnd + 1;
+        }
+        else
+            break;
+    }
+    return Position;
+}
+
+// 注释未闭合时返回空串
+[[nodiscard]] inline auto SkipSpaceAndComments(std::string_view Text) noexcept -> std::string_view
+{
+    const std::size_t Position = SkipSpaceAndComments(Text, 0);
+    return Position == std::string_view::npos ? std::string_view{} : Text.substr(Position);
+}
+
+// Text 以 Keyword 开头，返回其后的下一个有效字符起的部分
+[[nodiscard]] inline auto SkipKeyword(std::string_view Text, std::string_view Keyword) noexcept -> std::string_view
+{
+    return SkipSpaceAndComments(Text.substr(Keyword.size()));
+}
+
+[[nodiscard]] inline auto SplitSQLStatements(std::string_view SqlText) -> std::vector<std::string>
+{
+    std::vector<std::string> Statements;
+    std::string CurrentStatement;
+    bool InSingleQuote = false;
+    bool InDoubleQuote = false;
+    
+    for (std::size_t Index = 0; Index < SqlText.length(); ++Index)
+    {
+        const char CurrentChar = SqlText[Index];
+        const char NextChar = (Index + 1 < SqlText.length()) ? SqlText[Index + 1] : '\0';
+        if (!InSingleQuote && !InDoubleQuote)
+        {
+            if (CurrentChar == '-' && NextChar == '-')
+            {
+                while (Index < SqlText.length() && SqlText[Index] != '\n')
+                    ++Index;
+                continue;
+            }
+            if (CurrentChar == '#')
+            {
+                while (Index < SqlText.length() && SqlText[Index] != '\n')
+                    ++Index;
+                continue;
+            }
+            if (CurrentChar == '/' && NextChar == '*')
+            {
+                ++Index;
+                ++Index;
+                while (Index + 1 < SqlText.length())
+                {
+                    if (SqlText[Index] == '*' && SqlText[Index + 1] == '/')
+                    {
+                        // 停在 '/' 上，由外层循环跳过
+                        ++Index;
+                        break;
+                    }
+                    ++Index;
+                }
+                continue;
+            }
+        }
+        if (CurrentChar == '\'' && !InDoubleQuote)
+        {
+            if (Index > 0 && SqlText[Index - 1] == '\\')
+            {
+                CurrentStatement += CurrentChar;
+                continue;
+            }
+            InSingleQuote = !InSingleQuote;
+            CurrentStatement += CurrentChar;
+            continue;
+        }
+        
+        if (CurrentChar == '"' && !InSingleQuote)
+        {
+            if (Index > 0 && SqlText[Index - 1] == '\\')
+            {
+                CurrentStatement += CurrentChar;
+                continue;
+            }
+            InDoubleQuote = !InDoubleQuote;
+            CurrentStatement += CurrentChar;
+            continue;
+        }
+        if (CurrentChar == ';' && !InSingleQuote && !InDoubleQuote)
+        {
+            CurrentStatement += CurrentChar;
+            auto TrimmedStatement = CurrentStatement;
+            TrimmedStatement.erase(0, TrimmedStatement.find_first_not_of(" \t\n\r"));
+            TrimmedStatement.erase(TrimmedStatement.find_last_not_of(" \t\n\r") + 1);
+            if (!TrimmedStatement.empty())
+                Statements.push_back(TrimmedStatement);
+            CurrentStatement.clear();
+            continue;
+        }
+        CurrentStatement += CurrentChar;
+    }
+    if (!CurrentStatement.empty())
+    {
+        auto TrimmedStatement = CurrentStatement;
+        TrimmedStatement.erase(0, TrimmedStatement.find_first_not_of(" \t\n\r"));
+        TrimmedStatement.erase(TrimmedStatement.find_last_not_of(" \t\n\r") + 1);
+        if (!TrimmedStatement.empty())
+            Statements.push_back(TrimmedStatement);
+    }
+    return Statements;
+}
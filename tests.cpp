@@ -0,0 +1,543 @@
+#include "def.h"
+#include "database.h"
+#include "resultgrid.h"
+#include "sqllexer.h"
+#include "transcode.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <format>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    int FailureCount = 0;
+
+    auto Check(bool Condition, std::string_view Expression, int Line) -> void
+    {
+        if (Condition) [[likely]]
+            return;
+        ++FailureCount;
+        std::println(stderr, "tests.cpp:{}: 检查失败: {}", Line, Expression);
+    }
+
+    // Release 构建定义了 NDEBUG，不能用 assert
+#define CHECK(Expression) Check(static_cast<bool>(Expression), #Expression, __LINE__)
+#define CHECK_THROWS_OUT_OF_RANGE(Expression) \
+    do \
+    { \
+        bool IsThrown = false; \
+        try { (void)(Expression); } \
+        catch (const std::out_of_range&) { IsThrown = true; } \
+        Check(IsThrown, #Expression " 抛出 std::out_of_range", __LINE__); \
+    } while (false)
+
+    // 逐字节写出，避免编译器把非法序列当作源码中的字符串字面量处理
+    [[nodiscard]] auto Bytes(std::initializer_list<unsigned char> Values) -> std::string
+    {
+        return { Values.begin(), Values.end() };
+    }
+
+    [[nodiscard]] auto Replacements(std::size_t Count) -> std::u16string
+    {
+        return std::u16string(Count, u'\uFFFD');
+    }
+
+    // 两个方向的便捷接口、缓冲接口和 GetUtf16Length 应当一致
+    auto CheckUtf8ToUtf16(std::string_view Input, std::u16string_view Expected, int Line) -> void
+    {
+        Check(Utf8ToUtf16(Input) == Expected, "Utf8ToUtf16(Input) == Expected", Line);
+        Check(GetUtf16Length(Input) == Expected.size(), "GetUtf16Length(Input) == Expected.size()", Line);
+        std::vector<char16_t> Buffer(GetMaxUtf16Length(Input.size()) + 1);
+        const std::size_t Written = Utf8ToUtf16(Input, Buffer.data());
+        Check(std::u16string_view(Buffer.data(), Written) == Expected, "Utf8ToUtf16(Input, Buffer) == Expected", Line);
+    }
+
+    auto CheckUtf16ToUtf8(std::u16string_view Input, std::string_view Expected, int Line) -> void
+    {
+        Check(Utf16ToUtf8(Input) == Expected, "Utf16ToUtf8(Input) == Expected", Line);
+        std::vector<char> Buffer(GetMaxUtf8Length(Input.size()) + 1);
+        const std::size_t Written = Utf16ToUtf8(Input, Buffer.data());
+        Check(std::string_view(Buffer.data(), Written) == Expected, "Utf16ToUtf8(Input, Buffer) == Expected", Line);
+    }
+
+    auto TestTranscodeValid() -> void
+    {
+        CheckUtf8ToUtf16("", u"", __LINE__);
+        CheckUtf8ToUtf16("SELECT 1;", u"SELECT 1;", __LINE__);
+        // 超过 16 字节，经过 ASCII 批量转换的路径
+        CheckUtf8ToUtf16("SELECT * FROM orders WHERE id = 1;", u"SELECT * FROM orders WHERE id = 1;", __LINE__);
+        CheckUtf8ToUtf16("é中文", u"é中文", __LINE__);
+        CheckUtf8ToUtf16("a\U0001F600b", u"a\U0001F600b", __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xF4, 0x8F, 0xBF, 0xBF }), u"\U0010FFFF", __LINE__);
+    }
+
+    auto TestTranscodeOverlong() -> void
+    {
+        // '/' 的各种超长编码
+        CheckUtf8ToUtf16(Bytes({ 0xC0, 0xAF }), Replacements(2), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xE0, 0x80, 0xAF }), Replacements(3), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xF0, 0x80, 0x80, 0xAF }), Replacements(4), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xC1, 0xBF, 'x' }), Replacements(2) + u"x", __LINE__);
+        // 超出 U+10FFFF
+        CheckUtf8ToUtf16(Bytes({ 0xF4, 0x90, 0x80, 0x80 }), Replacements(4), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xF5, 0x80, 0x80, 0x80 }), Replacements(4), __LINE__);
+    }
+
+    auto TestTranscodeSurrogates() -> void
+    {
+        // UTF-8 中编码的代理项 U+D800、U+DFFF 不合法
+        CheckUtf8ToUtf16(Bytes({ 0xED, 0xA0, 0x80 }), Replacements(3), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xED, 0xBF, 0xBF }), Replacements(3), __LINE__);
+        // CESU-8 形式的代理对也不合法
+        CheckUtf8ToUtf16(Bytes({ 0xED, 0xA0, 0xBD, 0xED, 0xB8, 0x80 }), Replacements(6), __LINE__);
+        // 紧邻代理项区间的 U+D7FF 合法
+        CheckUtf8ToUtf16(Bytes({ 0xED, 0x9F, 0xBF }), u"\uD7FF", __LINE__);
+    }
+
+    auto TestTranscodeTruncated() -> void
+    {
+        CheckUtf8ToUtf16(Bytes({ 0xE4, 0xB8 }), Replacements(2), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xF0, 0x9F, 0x98 }), Replacements(3), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 'a', 0xE4, 0xB8, 'b' }), u"a" + Replacements(2) + u"b", __LINE__);
+        // 截断的序列后紧跟一个完整的字符，后者不受影响
+        CheckUtf8ToUtf16(Bytes({ 0xE4, 0xB8, 0xE4, 0xB8, 0xAD }), Replacements(2) + u"中", __LINE__);
+        // 孤立的后续字节
+        CheckUtf8ToUtf16(Bytes({ 0x80, 'a', 0xBF }), Replacements(1) + u"a" + Replacements(1), __LINE__);
+        CheckUtf8ToUtf16(Bytes({ 0xFF, 0xFE }), Replacements(2), __LINE__);
+    }
+
+    auto TestTranscodeUnpairedUtf16() -> void
+    {
+        const std::string Replacement = "\uFFFD";
+        CheckUtf16ToUtf8(u"", "", __LINE__);
+        CheckUtf16ToUtf8(u"中\U0001F600", "中\U0001F600", __LINE__);
+        CheckUtf16ToUtf8(std::u16string{ char16_t(0xD800) }, Replacement, __LINE__);
+        CheckUtf16ToUtf8(std::u16string{ char16_t(0xDC00) }, Replacement, __LINE__);
+        CheckUtf16ToUtf8(std::u16string{ u'a', char16_t(0xD83D), u'b' }, "a" + Replacement + "b", __LINE__);
+        // 低代理项在前、高代理项在后不构成代理对
+        CheckUtf16ToUtf8(std::u16string{ char16_t(0xDE00), char16_t(0xD83D) }, Replacement + Replacement, __LINE__);
+        // 两个高代理项：第一个未配对，第二个与随后的低代理项配对
+        CheckUtf16ToUtf8(std::u16string{ char16_t(0xD83D), char16_t(0xD83D), char16_t(0xDE00) }, Replacement + "\U0001F600", __LINE__);
+    }
+
+    auto TestTranscodeRoundTrip() -> void
+    {
+        std::string Text;
+        for (int Index = 0; Index < 64; ++Index)
+            Text += "INSERT INTO t VALUES ('中文', 'café', '\U0001F600');\n";
+        CHECK(Utf16ToUtf8(Utf8ToUtf16(Text)) == Text);
+        std::u16string Utf16Text;
+        for (char32_t CodePoint : { U'a', U'é', U'\u07FF', U'\u0800', U'\uD7FF', U'\uE000', U'\uFFFF', U'\U00010000', U'\U0010FFFF' })
+        {
+            if (CodePoint >= 0x10000)
+            {
+                Utf16Text.push_back(static_cast<char16_t>(0xD800 + ((CodePoint - 0x10000) >> 10)));
+                Utf16Text.push_back(static_cast<char16_t>(0xDC00 + ((CodePoint - 0x10000) & 0x3FF)));
+            }
+            else
+                Utf16Text.push_back(static_cast<char16_t>(CodePoint));
+        }
+        CHECK(Utf8ToUtf16(Utf16ToUtf8(Utf16Text)) == Utf16Text);
+        // 替换后的结果本身合法，再转换一次不再变化
+        const std::string Invalid = Bytes({ 'x', 0xC0, 0xAF, 0xED, 0xA0, 0x80, 0xE4, 0xB8 });
+        const std::string Repaired = Utf16ToUtf8(Utf8ToUtf16(Invalid));
+        CHECK(Utf16ToUtf8(Utf8ToUtf16(Repaired)) == Repaired);
+    }
+
+    [[nodiscard]] auto FormatCell(std::string_view Value, std::size_t MaxWidth, std::size_t& Width) -> std::string
+    {
+        std::string Output;
+        Width = FormatCellText(Value, Output, MaxWidth);
+        return Output;
+    }
+
+    auto TestCellText() -> void
+    {
+        CHECK(GetDisplayWidth("") == 0);
+        CHECK(GetDisplayWidth("abc") == 3);
+        CHECK(GetDisplayWidth("中文") == 4);
+        CHECK(GetDisplayWidth("e\u0301") == 1);
+        CHECK(GetDisplayWidth(Bytes({ 'a', 0xFF, 0xE4, 0xB8 })) == 4);
+        std::size_t Width = 0;
+        CHECK(FormatCell("abc", 10, Width) == "abc" && Width == 3);
+        CHECK(FormatCell("a\tb\r\nc", 10, Width) == "a b  c" && Width == 6);
+        CHECK(FormatCell(Bytes({ 'a', 0xFF, 'b' }), 10, Width) == "a\uFFFDb" && Width == 3);
+        // 截断后连同省略号不超过 MaxWidth
+        CHECK(FormatCell("abcdefghij", 5, Width) == "abcd\u2026" && Width == 5);
+        CHECK(FormatCell("abcde", 5, Width) == "abcde" && Width == 5);
+        // 宽字符不会被拆开，放不下时整个省去
+        CHECK(FormatCell("中文字符", 6, Width) == "中文\u2026" && Width == 5);
+        CHECK(FormatCell("中文字符", 8, Width) == "中文字符" && Width == 8);
+    }
+
+    [[nodiscard]] auto MakeResult(std::size_t RowCount) -> std::shared_ptr<MySQLResult>
+    {
+        auto ResultData = std::make_shared<MySQLResult>();
+        ResultData->Success = true;
+        ResultData->Status = QueryStatus::Succeeded;
+        ResultData->ColumnNames = { "id", "名称", "note" };
+        for (std::size_t Row = 0; Row < RowCount; ++Row)
+        {
+            MySQLRow RowData;
+            RowData.Fields = { std::to_string(Row), Row % 2 == 0 ? "中文" : "x", "n" };
+            ResultData->Rows.push_back(std::move(RowData));
+        }
+        return ResultData;
+    }
+
+    auto TestResultGridModel() -> void
+    {
+        ResultGridModel Model(100);
+        CHECK(!Model.HasResult());
+        CHECK(Model.GetCellText(0, 0).empty());
+        // 失败的结果与没有列的结果不显示
+        auto Failed = std::make_shared<MySQLResult>();
+        Model.SetResult(Failed);
+        CHECK(!Model.HasResult());
+        auto NoColumns = std::make_shared<MySQLResult>();
+        NoColumns->Success = true;
+        Model.SetResult(NoColumns);
+        CHECK(!Model.HasResult());
+
+        const std::size_t RowCount = ResultGridModel::WidthSampleRows + 150;
+        auto ResultData = MakeResult(RowCount);
+        Model.SetResult(ResultData);
+        CHECK(Model.HasResult());
+        CHECK(Model.GetRowCount() == RowCount);
+        CHECK(Model.GetColumnCount() == 3);
+        CHECK(Model.GetColumnName(1) == "名称");
+        CHECK(Model.GetColumnName(3).empty());
+        // 列宽取表头与采样行的最大值
+        CHECK(Model.GetColumnWidth(0) == 3);
+        CHECK(Model.GetColumnWidth(1) == 4);
+        CHECK(Model.GetColumnWidth(2) == 4);
+        CHECK(Model.GetColumnWidth(3) == 0);
+
+        // 超出结果范围的窗口被截掉
+        Model.SetViewport({ .FirstRow = RowCount - 2, .RowCount = 10, .FirstColumn = 1, .ColumnCount = 10 });
+        const GridViewport Clamped = Model.GetViewport();
+        CHECK(Clamped.FirstRow == RowCount - 2 && Clamped.RowCount == 2 && Clamped.FirstColumn == 1 && Clamped.ColumnCount == 2);
+        CHECK(Model.GetCellText(RowCount - 1, 1) == "x");
+        CHECK(Model.GetCellText(RowCount, 0).empty());
+        CHECK(Model.GetCellText(0, 3).empty());
+
+        // 窗口外的行把窗口移到所在的页，列保持窗口宽度
+        CHECK(Model.GetCellText(150, 0) == "150");
+        const GridViewport Paged = Model.GetViewport();
+        CHECK(Paged.FirstRow == 100 && Paged.RowCount == 100 && Paged.FirstColumn == 0 && Paged.ColumnCount == 2);
+        CHECK(Model.GetCellText(199, 1) == "x");
+        CHECK(Model.GetCellText(198, 1) == "中文");
+        // 行在窗口内而列在窗口外时不移动窗口
+        CHECK(Model.GetCellText(120, 2) == "n");
+        CHECK(Model.GetViewport().FirstRow == 100 && Model.GetViewport().FirstColumn == 0);
+
+        // 重叠部分复用，移动后的窗口内容与直接生成的一致
+        Model.SetViewport({ .FirstRow = 150, .RowCount = 100, .FirstColumn = 0, .ColumnCount = 3 });
+        for (std::size_t Row = 150; Row < 250; ++Row)
+        {
+            CHECK(Model.GetCellText(Row, 0) == std::to_string(Row));
+            CHECK(Model.GetCellText(Row, 1) == (Row % 2 == 0 ? "中文" : "x"));
+        }
+        CHECK(Model.GetViewport().FirstRow == 150);
+
+        // 采样范围之后更宽的单元格只让列宽增加
+        MySQLRow WideRow;
+        WideRow.Fields = { "0", std::string(ResultGridModel::MaxCellWidth * 2, 'w'), "n" };
+        ResultData = MakeResult(RowCount);
+        ResultData->Rows.push_back(std::move(WideRow));
+        Model.SetResult(ResultData);
+        const uint64_t Version = Model.GetWidthVersion();
+        CHECK(Model.GetColumnWidth(1) == 4);
+        CHECK(GetDisplayWidth(Model.GetCellText(RowCount, 1)) == ResultGridModel::MaxCellWidth);
+        CHECK(Model.GetColumnWidth(1) == ResultGridModel::MaxCellWidth);
+        CHECK(Model.GetWidthVersion() > Version);
+        CHECK(Model.GetCellText(0, 1) == "中文");
+        CHECK(Model.GetColumnWidth(1) == ResultGridModel::MaxCellWidth);
+
+        Model.Reset();
+        CHECK(!Model.HasResult() && Model.GetColumnCount() == 0 && Model.GetColumnWidth(0) == 0);
+    }
+
+    // 与同样内容的 std::vector 逐行比较：顺序下标、迭代、倒序下标（每步都换块，检验块缓存的替换）
+    auto CheckRows(const RowStore& Store, const std::vector<MySQLRow>& Expected, int Line) -> void
+    {
+        Check(Store.size() == Expected.size(), "Store.size() == Expected.size()", Line);
+        if (Store.size() != Expected.size())
+            return;
+        bool IsIndexEqual = true;
+        for (std::size_t Index = 0; Index < Expected.size(); ++Index)
+            IsIndexEqual = IsIndexEqual && Store[Index].Fields == Expected[Index].Fields;
+        Check(IsIndexEqual, "Store[Index] == Expected[Index]", Line);
+        bool IsIterationEqual = true;
+        std::size_t Position = 0;
+        for (const MySQLRow& RowData : Store)
+            IsIterationEqual = IsIterationEqual && Position < Expected.size() && RowData.Fields == Expected[Position++].Fields;
+        Check(IsIterationEqual && Position == Expected.size(), "迭代结果与 Expected 一致", Line);
+        bool IsReverseEqual = true;
+        for (std::size_t Index = Expected.size(); Index-- > 0;)
+            IsReverseEqual = IsReverseEqual && Store[Index].Fields == Expected[Index].Fields;
+        Check(IsReverseEqual, "倒序访问与 Expected 一致", Line);
+    }
+
+    // 每行约 600 字节：数千行即可写满一个 BlockBytes 的落盘块，末尾留下未写出的块
+    [[nodiscard]] auto MakeSpillRow(std::size_t Row) -> MySQLRow
+    {
+        MySQLRow RowData;
+        RowData.Fields = { std::to_string(Row), Row % 7 == 0 ? "NULL" : std::string(600, static_cast<char>('a' + Row % 26)), Row % 5 == 0 ? "" : "x" };
+        return RowData;
+    }
+
+    auto TestRowStoreSpill() -> void
+    {
+        static_assert(std::input_iterator<RowStore::const_iterator>);
+        RowStore Store;
+        Store.SetBudget(16 * 1024);
+        std::vector<MySQLRow> Expected;
+        bool IsBackEqual = true;
+        for (std::size_t Row = 0; Row < 3000; ++Row)
+        {
+            Store.push_back(MakeSpillRow(Row));
+            Expected.push_back(MakeSpillRow(Row));
+            // 读回未写出的块后继续追加，缓存的旧内容必须失效
+            IsBackEqual = IsBackEqual && Store.back().Fields == Expected.back().Fields;
+        }
+        CHECK(IsBackEqual);
+        CHECK(Store.IsSpilled());
+        CHECK(Store.GetSpilledRowCount() > 0 && Store.GetSpilledRowCount() < Store.size());
+        CHECK(Store[0].IsNull(1) && !Store[1].IsNull(1) && Store[2996].IsNull(1));
+        CheckRows(Store, Expected, __LINE__);
+        CHECK_THROWS_OUT_OF_RANGE(Store[Expected.size()]);
+
+        // 复制共享临时文件，之后各自追加的块互不覆盖
+        RowStore Copy = Store;
+        std::vector<MySQLRow> CopyExpected = Expected;
+        CheckRows(Copy, CopyExpected, __LINE__);
+        for (std::size_t Row = 3000; Row < 5000; ++Row)
+        {
+            Store.push_back(MakeSpillRow(Row));
+            Expected.push_back(MakeSpillRow(Row));
+            Copy.push_back(MakeSpillRow(Row + 100000));
+            CopyExpected.push_back(MakeSpillRow(Row + 100000));
+        }
+        CheckRows(Store, Expected, __LINE__);
+        CheckRows(Copy, CopyExpected, __LINE__);
+
+        RowStore Moved = std::move(Copy);
+        CHECK(Copy.empty() && Copy.GetResidentBytes() == 0);
+        CheckRows(Moved, CopyExpected, __LINE__);
+        RowStore Assigned;
+        Assigned = Moved;
+        CheckRows(Assigned, CopyExpected, __LINE__);
+        Assigned = std::move(Store);
+        CheckRows(Assigned, Expected, __LINE__);
+        CheckRows(Moved, CopyExpected, __LINE__);
+
+        const std::size_t ProcessBytes = RowStore::GetProcessResidentBytes();
+        const std::size_t ReleasedBytes = Assigned.GetResidentBytes();
+        Assigned.clear();
+        CHECK(Assigned.empty() && Assigned.GetResidentBytes() == 0 && !Assigned.IsSpilled());
+        CHECK(RowStore::GetProcessResidentBytes() == ProcessBytes - ReleasedBytes);
+    }
+
+    [[nodiscard]] auto CountExpected(const std::vector<MySQLRow>& Rows, std::size_t ColumnIndex) -> std::vector<std::pair<std::string, std::size_t>>
+    {
+        std::map<std::string, std::size_t> Counts;
+        for (const auto& RowData : Rows)
+            ++Counts[RowData.Fields[ColumnIndex]];
+        std::vector<std::pair<std::string, std::size_t>> SortedCounts(Counts.begin(), Counts.end());
+        std::ranges::stable_sort(SortedCounts, std::greater{}, &std::pair<std::string, std::size_t>::second);
+        return SortedCounts;
+    }
+
+    [[nodiscard]] auto FindExpected(const std::vector<MySQLRow>& Rows, std::size_t ColumnIndex, std::string_view Value) -> std::vector<std::size_t>
+    {
+        std::vector<std::size_t> Matches;
+        for (std::size_t Index = 0; Index < Rows.size(); ++Index)
+        {
+            if (ColumnIndex < Rows[Index].Size() && Rows[Index].Fields[ColumnIndex] == Value)
+                Matches.push_back(Index);
+        }
+        return Matches;
+    }
+
+    // 第 0 列各行不同，不选字典；第 1 列始终只有 5 种取值；第 2 列在采样范围内只有 10 种取值，之后每行都是新值，
+    // 在第一个编码块中途超出 MaxDictionaryEntries，退回普通存储
+    [[nodiscard]] auto MakeDictionaryRow(std::size_t Row) -> MySQLRow
+    {
+        static constexpr std::array<std::string_view, 5> States = { "new", "paid", "shipped", "NULL", "" };
+        MySQLRow RowData;
+        RowData.Fields = { std::format("order-{}", Row), std::string{ States[Row % States.size()] },
+            Row < RowStore::DictionarySampleRows ? std::format("tag-{}", Row % 10) : std::format("tag-{}", Row) };
+        return RowData;
+    }
+
+    auto CheckDictionaryQueries(const RowStore& Store, const std::vector<MySQLRow>& Expected, int Line) -> void
+    {
+        for (std::size_t ColumnIndex = 0; ColumnIndex < 3; ++ColumnIndex)
+            Check(Store.CountValues(ColumnIndex) == CountExpected(Expected, ColumnIndex), "CountValues 与逐行统计一致", Line);
+        const auto CheckFind = [&](std::size_t ColumnIndex, std::string_view Value)
+        {
+            Check(Store.FindRows(ColumnIndex, Value) == FindExpected(Expected, ColumnIndex, Value), std::format("FindRows({}, \"{}\")", ColumnIndex, Value), Line);
+        };
+        CheckFind(0, "order-5");
+        CheckFind(0, std::format("order-{}", Expected.size() - 1));
+        CheckFind(1, "NULL");
+        CheckFind(1, "");
+        CheckFind(1, "paid");
+        CheckFind(1, "missing");
+        // 采样范围内、已编码部分、退回普通存储之后各取一个值
+        CheckFind(2, "tag-3");
+        CheckFind(2, "tag-2000");
+        CheckFind(2, "tag-5300");
+        CheckFind(2, std::format("tag-{}", Expected.size() - 1));
+        CheckFind(2, "tag-missing");
+        CheckFind(3, "NULL");
+    }
+
+    auto TestRowStoreDictionary() -> void
+    {
+        RowStore Store;
+        std::vector<MySQLRow> Expected;
+        const std::size_t RowCount = RowStore::DictionarySampleRows + 3 * RowStore::EncodedBlockRows;
+        for (std::size_t Row = 0; Row < RowCount; ++Row)
+        {
+            Store.push_back(MakeDictionaryRow(Row));
+            Expected.push_back(MakeDictionaryRow(Row));
+            if (Row + 1 == RowStore::DictionarySampleRows + 100)
+            {
+                CHECK(!Store.IsDictionaryEncoded(0));
+                CHECK(Store.IsDictionaryEncoded(1));
+                CHECK(Store.IsDictionaryEncoded(2));
+            }
+        }
+        CHECK(!Store.IsSpilled());
+        CHECK(Store.IsDictionaryEncoded(1));
+        CHECK(!Store.IsDictionaryEncoded(2));
+        CHECK(!Store.IsDictionaryEncoded(3));
+        CheckRows(Store, Expected, __LINE__);
+        CheckDictionaryQueries(Store, Expected, __LINE__);
+        const RowStore Copy = Store;
+        CheckRows(Copy, Expected, __LINE__);
+        CheckDictionaryQueries(Copy, Expected, __LINE__);
+
+        // 编码块之后超出预算，剩余的行落盘：查询同时经过字典编码、普通存储和落盘的行
+        RowStore Mixed;
+        Mixed.SetBudget(256 * 1024);
+        for (const MySQLRow& RowData : Expected)
+            Mixed.push_back(RowData);
+        CHECK(Mixed.IsSpilled());
+        CHECK(Mixed.GetSpilledRowCount() < RowCount - RowStore::DictionarySampleRows);
+        CheckRows(Mixed, Expected, __LINE__);
+        CheckDictionaryQueries(Mixed, Expected, __LINE__);
+    }
+
+    // 增量分析的结果应与对最终文本从头分析完全一致：文本、行数、每行的行首状态和区间
+    auto CheckSameAsFresh(const IncrementalSqlLexer& Incremental, std::u16string_view Text, int Line) -> void
+    {
+        IncrementalSqlLexer Fresh;
+        (void)Fresh.SetText(Text);
+        Check(Incremental.GetText() == Text, "GetText() == Text", Line);
+        Check(Incremental.GetLineCount() == Fresh.GetLineCount(), "GetLineCount() 与重新分析一致", Line);
+        for (std::size_t LineIndex = 0; LineIndex < (std::min)(Incremental.GetLineCount(), Fresh.GetLineCount()); ++LineIndex)
+        {
+            Check(Incremental.GetLineState(LineIndex) == Fresh.GetLineState(LineIndex), std::format("第 {} 行的行首状态与重新分析一致", LineIndex), Line);
+            Check(Incremental.GetLineSpans(LineIndex) == Fresh.GetLineSpans(LineIndex), std::format("第 {} 行的区间与重新分析一致", LineIndex), Line);
+        }
+    }
+
+    auto TestSqlLexerEdits() -> void
+    {
+        std::u16string Text;
+        for (int Block = 0; Block < 8; ++Block)
+            Text += u"SELECT id, `name` FROM users WHERE note = 'a\\'b';\r\nUPDATE t SET v = \"x\" -- 行尾注释\n  WHERE id = 42;\r/* 单行 */ DELETE FROM t;\n";
+        IncrementalSqlLexer Lexer;
+        (void)Lexer.SetText(Text);
+        CheckSameAsFresh(Lexer, Text, __LINE__);
+
+        // 在第 Occurrence 次出现的 Anchor 处替换 RemovedLength 个码元，并与重新分析比较
+        const auto Edit = [&](std::u16string_view Anchor, std::size_t Occurrence, std::size_t RemovedLength, std::u16string_view Inserted, int Line)
+        {
+            std::size_t Offset = Text.find(Anchor);
+            for (std::size_t Index = 0; Index < Occurrence && Offset != std::u16string::npos; ++Index)
+                Offset = Text.find(Anchor, Offset + 1);
+            if (Offset == std::u16string::npos)
+            {
+                Check(false, "找到编辑位置", Line);
+                return;
+            }
+            Text.replace(Offset, RemovedLength, Inserted);
+            (void)Lexer.ApplyEdit(Offset, RemovedLength, Inserted);
+            CheckSameAsFresh(Lexer, Text, Line);
+        };
+
+        // 打开跨越多行的块注释，在后面闭合，再删去开头
+        Edit(u"UPDATE", 0, 0, u"/*", __LINE__);
+        Edit(u"DELETE", 5, 0, u"*/", __LINE__);
+        Edit(u"/*UPDATE", 0, 2, u"", __LINE__);
+        Edit(u"*/ DELETE", 1, 2, u"", __LINE__);
+        // 未闭合的引号一直延续到文末，闭合后后面的行恢复
+        Edit(u"FROM users", 1, 0, u"'", __LINE__);
+        Edit(u"WHERE id", 4, 0, u"'", __LINE__);
+        Edit(u"\"x\"", 2, 1, u"", __LINE__);
+        Edit(u"'FROM users", 0, 1, u"", __LINE__);
+        Edit(u"'WHERE id", 0, 1, u"", __LINE__);
+        Edit(u"x\"", 2, 0, u"\"", __LINE__);
+        // 反斜杠让引号失效，字符串延续到后面的行；跨行替换同时改变行数
+        Edit(u"'a", 3, 1, u"\\'", __LINE__);
+        Edit(u"\\'a", 0, 1, u"", __LINE__);
+        Edit(u"42;\r", 2, 40, u"1;\n\n/* 新增\r\n的行", __LINE__);
+        Edit(u"新增", 0, 0, u"*/ ", __LINE__);
+        // DELIMITER 不改变分隔符的识别，改写前后都应与重新分析一致
+        Edit(u"SELECT", 0, 0, u"DELIMITER //\r\nCREATE PROCEDURE p() BEGIN SELECT 1; END //\r\n", __LINE__);
+        Edit(u"//", 0, 2, u";;", __LINE__);
+        Edit(u"//", 0, 2, u";;", __LINE__);
+        Edit(u"DELIMITER ;;", 0, 12, u"DELIMITER ;", __LINE__);
+        // "\r" 与其后的 "\n" 合为一个换行，拆开后成为两行
+        Edit(u"\r/*", 0, 0, u"\n", __LINE__);
+        Edit(u"\n\r", 0, 1, u"", __LINE__);
+        Edit(u"\r\n", 1, 0, u"\r", __LINE__);
+        Edit(u"\r\r\n", 0, 1, u"", __LINE__);
+        Edit(u"UPDATE", 1, Text.size() - Text.find(u"UPDATE", Text.find(u"UPDATE") + 1), u"", __LINE__);
+
+        // SetText 自行比较出修改范围，结果同样应与重新分析一致
+        std::u16string Replaced = Text;
+        Replaced.insert(Replaced.find(u"CREATE"), u"/* 未闭合\r\n");
+        (void)Lexer.SetText(Replaced);
+        Text = Replaced;
+        CheckSameAsFresh(Lexer, Text, __LINE__);
+        Lexer.Clear();
+        Text.clear();
+        CheckSameAsFresh(Lexer, Text, __LINE__);
+    }
+}
+
+auto main() -> int
+{
+    TestTranscodeValid();
+    TestTranscodeOverlong();
+    TestTranscodeSurrogates();
+    TestTranscodeTruncated();
+    TestTranscodeUnpairedUtf16();
+    TestTranscodeRoundTrip();
+    TestCellText();
+    TestResultGridModel();
+    TestRowStoreSpill();
+    TestRowStoreDictionary();
+    TestSqlLexerEdits();
+    if (FailureCount != 0)
+    {
+        std::println(stderr, "{} 项检查失败", FailureCount);
+        return 1;
+    }
+    std::println("全部检查通过");
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include "transcode.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSCODE_SSE2 1
+#endif
+
+namespace
+{
+    constexpr char16_t ReplacementUnit = 0xFFFD;
+    constexpr uint64_t AsciiMask8 = 0x8080808080808080ULL;
+    constexpr uint64_t AsciiMask16 = 0xFF80FF80FF80FF80ULL;
+
+    // 从 Position 开始连续的 ASCII 字节直接展宽为码元，返回处理的字节数
+    template <typename UnitT>
+    auto WidenAscii(const char* Source, std::size_t Size, UnitT* Target) noexcept -> std::size_t
+    {
+        static_assert(sizeof(UnitT) == 2);
+        std::size_t Position = 0;
+#ifdef TRANSCODE_SSE2
+        const __m128i Zero = _mm_setzero_si128();
+        while (Size - Position >= 16)
+        {
+            const __m128i Block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + Position));
+            if (_mm_movemask_epi8(Block) != 0)
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(Target + Position), _mm_unpacklo_epi8(Block, Zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(Target + Position + 8), _mm_unpackhi_epi8(Block, Zero));
+            Position += 16;
+        }
+#endif
+        while (Size - Position >= 8)
+        {
+            uint64_t Word;
+            std::memcpy(&Word, Source + Position, sizeof(Word));
+            if (Word & AsciiMask8)
+                break;
+            for (std::size_t Index = 0; Index < 8; ++Index)
+                Target[Position + Index] = static_cast<UnitT>(static_cast<unsigned char>(Source[Position + Index]));
+            Position += 8;
+        }
+        return Position;
+    }
+
+    // 连续的 ASCII 码元收窄为字节，返回处理的码元数
+    template <typename UnitT>
+    auto NarrowAscii(const UnitT* Source, std::size_t Size, char* Target) noexcept -> std::size_t
+    {
+        static_assert(sizeof(UnitT) == 2);
+        std::size_t Position = 0;
+#ifdef TRANSCODE_SSE2
+        const __m128i Zero = _mm_setzero_si128();
+        const __m128i HighMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+        while (Size - Position >= 16)
+        {
+            const __m128i Low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + Position));
+            const __m128i High = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + Position + 8));
+            const __m128i NonAscii = _mm_and_si128(_mm_or_si128(Low, High), HighMask);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(NonAscii, Zero)) != 0xFFFF)
+                break;
+            // 码元都小于 0x80，无符号饱和收窄即为原值
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(Target + Position), _mm_packus_epi16(Low, High));
+            Position += 16;
+        }
+#endif
+        while (Size - Position >= 4)
+        {
+            uint64_t Word;
+            std::memcpy(&Word, Source + Position, sizeof(Word));
+            if (Word & AsciiMask16)
+                break;
+            for (std::size_t Index = 0; Index < 4; ++Index)
+                Target[Position + Index] = static_cast<char>(Source[Position + Index]);
+            Position += 4;
+        }
+        return Position;
+    }
+
+    // 校验 Source 处以非 ASCII 字节开头的序列，返回其长度；非法或截断时返回 0
+    [[nodiscard]] inline auto DecodeMultiByte(const char* Source, std::size_t Remaining, char32_t& CodePoint) noexcept -> std::size_t
+    {
+        const auto Lead = static_cast<unsigned char>(Source[0]);
+        std::size_t Length = 0;
+        char32_t Minimum = 0;
+        if ((Lead & 0xE0) == 0xC0)
+        {
+            Length = 2;
+            CodePoint = Lead & 0x1F;
+            Minimum = 0x80;
+        }
+        else if ((Lead & 0xF0) == 0xE0)
+        {
+            Length = 3;
+            CodePoint = Lead & 0x0F;
+            Minimum = 0x800;
+        }
+        else if ((Lead & 0xF8) == 0xF0)
+        {
+            Length = 4;
+            CodePoint = Lead & 0x07;
+            Minimum = 0x10000;
+        }
+        if (Length == 0 || Remaining < Length)
+            return 0;
+        for (std::size_t Index = 1; Index < Length; ++Index)
+        {
+            const auto Continuation = static_cast<unsigned char>(Source[Index]);
+            if ((Continuation & 0xC0) != 0x80)
+                return 0;
+            CodePoint = (CodePoint << 6) | (Continuation & 0x3F);
+        }
+        // 过长编码、代理区和超出 Unicode 范围的码点都不合法
+        if (CodePoint < Minimum || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF) || CodePoint > 0x10FFFF)
+            return 0;
+        return Length;
+    }
+
+    template <typename UnitT>
+    auto DecodeUtf8(std::string_view Input, UnitT* Output) noexcept -> std::size_t
+    {
+        const char* Source = Input.data();
+        const std::size_t Size = Input.size();
+        std::size_t Position = 0;
+        UnitT* Target = Output;
+        while (Position < Size)
+        {
+            const std::size_t AsciiBytes = WidenAscii(Source + Position, Size - Position, Target);
+            Position += AsciiBytes;
+            Target += AsciiBytes;
+            // 批量路径停下后逐个处理，直到遇到下一段可能为 ASCII 的位置
+            while (Position < Size)
+            {
+                const auto Lead = static_cast<unsigned char>(Source[Position]);
+                if (Lead < 0x80)
+                {
+                    *Target++ = static_cast<UnitT>(Lead);
+                    ++Position;
+                    if (Size - Position >= 8 && !(static_cast<unsigned char>(Source[Position]) & 0x80))
+                        break;
+                    continue;
+                }
+                char32_t CodePoint = 0;
+                const std::size_t Length = DecodeMultiByte(Source + Position, Size - Position, CodePoint);
+                if (Length == 0) [[unlikely]]
+                {
+                    *Target++ = static_cast<UnitT>(ReplacementUnit);
+                    ++Position;
+                    continue;
+                }
+                Position += Length;
+                if (CodePoint >= 0x10000)
+                {
+                    CodePoint -= 0x10000;
+                    *Target++ = static_cast<UnitT>(0xD800 + (CodePoint >> 10));
+                    *Target++ = static_cast<UnitT>(0xDC00 + (CodePoint & 0x3FF));
+                }
+                else
+                    *Target++ = static_cast<UnitT>(CodePoint);
+            }
+        }
+        return static_cast<std::size_t>(Target - Output);
+    }
+
+    template <typename UnitT>
+    auto EncodeUtf8(const UnitT* Source, std::size_t Size, char* Output) noexcept -> std::size_t
+    {
+        std::size_t Position = 0;
+        char* Target = Output;
+        while (Position < Size)
+        {
+            const std::size_t AsciiUnits = NarrowAscii(Source + Position, Size - Position, Target);
+            Position += AsciiUnits;
+            Target += AsciiUnits;
+            while (Position < Size)
+            {
+                char32_t CodePoint = static_cast<char16_t>(Source[Position]);
+                if (CodePoint < 0x80)
+                {
+                    *Target++ = static_cast<char>(CodePoint);
+                    ++Position;
+                    if (Size - Position >= 4 && static_cast<char16_t>(Source[Position]) < 0x80)
+                        break;
+                    continue;
+                }
+                ++Position;
+                if (CodePoint < 0x800)
+                {
+                    *Target++ = static_cast<char>(0xC0 | (CodePoint >> 6));
+                    *Target++ = static_cast<char>(0x80 | (CodePoint & 0x3F));
+                    continue;
+                }
+                if (CodePoint >= 0xD800 && CodePoint <= 0xDFFF)
+                {
+                    const char16_t Trail = Position < Size ? static_cast<char16_t>(Source[Position]) : char16_t{ 0 };
+                    if (CodePoint <= 0xDBFF && Trail >= 0xDC00 && Trail <= 0xDFFF) [[likely]]
+                    {
+                        ++Position;
+                        CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Trail - 0xDC00);
+                        *Target++ = static_cast<char>(0xF0 | (CodePoint >> 18));
+                        *Target++ = static_cast<char>(0x80 | ((CodePoint >> 12) & 0x3F));
+                        *Target++ = static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F));
+                        *Target++ = static_cast<char>(0x80 | (CodePoint & 0x3F));
+                        continue;
+                    }
+                    // 未配对的代理项
+                    CodePoint = ReplacementUnit;
+                }
+                *Target++ = static_cast<char>(0xE0 | (CodePoint >> 12));
+                *Target++ = static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F));
+                *Target++ = static_cast<char>(0x80 | (CodePoint & 0x3F));
+            }
+        }
+        return static_cast<std::size_t>(Target - Output);
+    }
+}
+
+auto GetUtf16Length(std::string_view Input) noexcept -> std::size_t
+{
+    const char* Source = Input.data();
+    const std::size_t Size = Input.size();
+    std::size_t Units = 0;
+    std::size_t Position = 0;
+    while (Position < Size)
+    {
+        if (Size - Position >= 8)
+        {
+            uint64_t Word;
+            std::memcpy(&Word, Source + Position, sizeof(Word));
+            if (!(Word & AsciiMask8))
+            {
+                Units += 8;
+                Position += 8;
+                continue;
+            }
+        }
+        if (!(static_cast<unsigned char>(Source[Position]) & 0x80))
+        {
+            ++Units;
+            ++Position;
+            continue;
+        }
+        char32_t CodePoint = 0;
+        const std::size_t Length = DecodeMultiByte(Source + Position, Size - Position, CodePoint);
+        Units += CodePoint >= 0x10000 && Length != 0 ? 2 : 1;
+        Position += (std::max)(Length, std::size_t{ 1 });
+    }
+    return Units;
+}
+
+auto Utf8ToUtf16(std::string_view Input, char16_t* Output) noexcept -> std::size_t
+{
+    return DecodeUtf8(Input, Output);
+}
+
+auto Utf16ToUtf8(std::u16string_view Input, char* Output) noexcept -> std::size_t
+{
+    return EncodeUtf8(Input.data(), Input.size(), Output);
+}
+
+auto Utf8ToUtf16(std::string_view Input) -> std::u16string
+{
+    std::u16string Output;
+    Output.resize_and_overwrite(GetMaxUtf16Length(Input.size()), [Input](char16_t* Buffer, std::size_t)
+    {
+        return DecodeUtf8(Input, Buffer);
+    });
+    return Output;
+}
+
+auto Utf16ToUtf8(std::u16string_view Input) -> std::string
+{
+    std::string Output;
+    Output.resize_and_overwrite(GetMaxUtf8Length(Input.size()), [Input](char* Buffer, std::size_t)
+    {
+        return EncodeUtf8(Input.data(), Input.size(), Buffer);
+    });
+    return Output;
+}
+
+#ifdef _WIN32
+auto Utf8ToUtf16(std::string_view Input, wchar_t* Output) noexcept -> std::size_t
+{
+    return DecodeUtf8(Input, Output);
+}
+
+auto Utf16ToUtf8(std::wstring_view Input, char* Output) noexcept -> std::size_t
+{
+    return EncodeUtf8(Input.data(), Input.size(), Output);
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+#include "def.h"
+#include <string>
+#include <string_view>
+
+// UTF-8 与 UTF-16 之间的单遍转换。输出缓冲按最坏情况预先分配，ASCII 段按 16 字节一组批量转换，
+// 多字节序列逐个校验：非法或截断的 UTF-8 每个字节、未配对的代理项各替换为一个 U+FFFD（与 MultiByteToWideChar 一致）。
+
+// 每个 UTF-8 字节最多产生一个 UTF-16 码元
+[[nodiscard]] constexpr auto GetMaxUtf16Length(std::size_t Utf8Bytes) noexcept -> std::size_t
+{
+    return Utf8Bytes;
+}
+
+// 每个 UTF-16 码元最多产生三个字节
+[[nodiscard]] constexpr auto GetMaxUtf8Length(std::size_t Utf16Units) noexcept -> std::size_t
+{
+    return Utf16Units * 3;
+}
+
+// 转换后的码元数，不写出结果
+[[nodiscard]] auto GetUtf16Length(std::string_view Input) noexcept -> std::size_t;
+
+// Output 至少能容纳 GetMaxUtf16Length(Input.size()) 个码元，返回写入的码元数
+auto Utf8ToUtf16(std::string_view Input, char16_t* Output) noexcept -> std::size_t;
+// Output 至少能容纳 GetMaxUtf8Length(Input.size()) 个字节，返回写入的字节数
+auto Utf16ToUtf8(std::u16string_view Input, char* Output) noexcept -> std::size_t;
+
+[[nodiscard]] auto Utf8ToUtf16(std::string_view Input) -> std::u16string;
+[[nodiscard]] auto Utf16ToUtf8(std::u16string_view Input) -> std::string;
+
+#ifdef _WIN32
+// Windows 上 wchar_t 即 UTF-16 码元，供 render.hpp 直接写入 std::wstring 与控件缓冲
+auto Utf8ToUtf16(std::string_view Input, wchar_t* Output) noexcept -> std::size_t;
+auto Utf16ToUtf8(std::wstring_view Input, char* Output) noexcept -> std::size_t;
+#endif
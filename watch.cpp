@@ -0,0 +1,286 @@
+#include "watch.h"
+#include "hash.h"
+#include <algorithm>
+#include <format>
+
+namespace
+{
+    // 逐字段链式哈希：上一字段的结果作为下一字段的种子，字段长度参与哈希，"ab"+"c" 与 "a"+"bc" 不会混淆
+    [[nodiscard]] auto HashFields(const MySQLRow& RowData, const std::vector<std::size_t>& Indexes) noexcept -> uint64_t
+    {
+        uint64_t Hash = FastHash::Prime5;
+        for (const std::size_t Index : Indexes)
+            Hash = FastHash::Hash64(Index < RowData.Fields.size() ? std::string_view{ RowData.Fields[Index] } : std::string_view{}, Hash);
+        return Hash;
+    }
+
+    [[nodiscard]] auto HashAllFields(const MySQLRow& RowData) noexcept -> uint64_t
+    {
+        uint64_t Hash = FastHash::Prime5;
+        for (const auto& Field : RowData.Fields)
+            Hash = FastHash::Hash64(Field, Hash);
+        return Hash;
+    }
+
+    [[nodiscard]] auto JoinFields(const MySQLRow& RowData, const std::vector<std::size_t>& Indexes) -> std::string
+    {
+        std::string Text;
+        for (const std::size_t Index : Indexes)
+        {
+            if (!Text.empty())
+                Text += '\t';
+            if (Index < RowData.Fields.size())
+                Text += RowData.Fields[Index];
+        }
+        return Text;
+    }
+
+    [[nodiscard]] auto JoinAllFields(const MySQLRow& RowData) -> std::string
+    {
+        std::string Text;
+        for (std::size_t Index = 0; Index < RowData.Fields.size(); ++Index)
+        {
+            if (Index > 0)
+                Text += '\t';
+            Text += RowData.Fields[Index];
+        }
+        return Text;
+    }
+}
+
+RowDeltaTracker::RowDeltaTracker(std::vector<std::string> KeyColumnNames) : KeyColumns(std::move(KeyColumnNames))
+{
+}
+
+auto RowDeltaTracker::Reset() noexcept -> void
+{
+    KeyIndexes.clear();
+    ColumnNames.clear();
+    Previous.clear();
+    PreviousRows.clear();
+    HasBaseline = false;
+}
+
+auto RowDeltaTracker::Apply(MySQLResult ResultData) -> std::expected<WatchDelta, std::string>
+{
+    if (!ResultData.Success) [[unlikely]]
+        return std::unexpected(ResultData.ErrorMessage.empty() ? std::string{ "查询失败" } : ResultData.ErrorMessage);
+    WatchDelta Delta;
+    if (!HasBaseline || ResultData.ColumnNames != ColumnNames)
+    {
+        std::vector<std::size_t> Indexes;
+        Indexes.reserve(KeyColumns.size());
+        for (const auto& KeyColumn : KeyColumns)
+        {
+            const auto Index = ResultData.GetColumnIndex(KeyColumn);
+            if (!Index) [[unlikely]]
+                return std::unexpected(std::format("结果中没有标识列 {}", KeyColumn));
+            Indexes.push_back(*Index);
+        }
+        KeyIndexes = std::move(Indexes);
+        ColumnNames = ResultData.ColumnNames;
+        Previous.clear();
+        PreviousRows.clear();
+        HasBaseline = true;
+        Delta.IsBaseline = true;
+    }
+    Delta.ColumnNames = ColumnNames;
+    Delta.RowCount = ResultData.Rows.size();
+    std::unordered_map<uint64_t, RowEntry> Current;
+    Current.reserve(ResultData.Rows.size());
+    // 每行的标识哈希按结果顺序保存，第二遍据此按原顺序输出新增和变化的行
+    std::vector<uint64_t> RowKeys;
+    RowKeys.reserve(ResultData.Rows.size());
+    std::size_t RowIndex = 0;
+    for (const MySQLRow& RowData : ResultData.Rows)
+    {
+        const uint64_t ContentHash = HashAllFields(RowData);
+        const uint64_t KeyHash = KeyIndexes.empty() ? ContentHash : HashFields(RowData, KeyIndexes);
+        auto [Position, IsInserted] = Current.try_emplace(KeyHash);
+        RowEntry& Entry = Position->second;
+        if (IsInserted)
+        {
+            Entry.ContentHash = ContentHash;
+            Entry.RowIndex = RowIndex;
+            // 整行作标识时不复制整行文本，删除时从上一轮的行中取出
+            if (!KeyIndexes.empty())
+                Entry.KeyText = JoinFields(RowData, KeyIndexes);
+        }
+        ++Entry.Count;
+        RowKeys.push_back(KeyHash);
+        ++RowIndex;
+    }
+    const bool IsKeyedByContent = KeyIndexes.empty();
+    if (Delta.IsBaseline)
+    {
+        Delta.Inserted.reserve(ResultData.Rows.size());
+        for (const MySQLRow& RowData : ResultData.Rows)
+            Delta.Inserted.push_back(RowData);
+        Previous = std::move(Current);
+        if (IsKeyedByContent)
+            PreviousRows = std::move(ResultData.Rows);
+        return Delta;
+    }
+    for (std::size_t Index = 0; Index < RowKeys.size(); ++Index)
+    {
+        const RowEntry& Entry = Current.find(RowKeys[Index])->second;
+        if (Entry.RowIndex != Index)
+            continue;
+        const MySQLRow& RowData = ResultData.Rows[Index];
+        const auto PreviousPosition = Previous.find(RowKeys[Index]);
+        if (PreviousPosition == Previous.end())
+        {
+            for (uint32_t Copy = 0; Copy < Entry.Count; ++Copy)
+                Delta.Inserted.push_back(RowData);
+            continue;
+        }
+        const RowEntry& PreviousEntry = PreviousPosition->second;
+        if (Entry.ContentHash != PreviousEntry.ContentHash)
+            Delta.Changed.push_back(RowData);
+        // 完全相同的重复行只比较出现次数
+        for (uint32_t Copy = PreviousEntry.Count; Copy < Entry.Count; ++Copy)
+            Delta.Inserted.push_back(RowData);
+        if (Entry.Count < PreviousEntry.Count)
+        {
+            // 整行作标识时内容与本轮的行相同
+            const std::string KeyText = IsKeyedByContent ? JoinAllFields(RowData) : Entry.KeyText;
+            for (uint32_t Copy = Entry.Count; Copy < PreviousEntry.Count; ++Copy)
+                Delta.Deleted.push_back(KeyText);
+        }
+    }
+    std::vector<std::pair<std::size_t, std::string>> Removed;
+    for (auto& [KeyHash, PreviousEntry] : Previous)
+    {
+        if (Current.contains(KeyHash))
+            continue;
+        const std::string KeyText = IsKeyedByContent ? JoinAllFields(PreviousRows[PreviousEntry.RowIndex]) : std::move(PreviousEntry.KeyText);
+        for (uint32_t Copy = 0; Copy < PreviousEntry.Count; ++Copy)
+            Removed.emplace_back(PreviousEntry.RowIndex, KeyText);
+    }
+    std::ranges::sort(Removed, {}, &std::pair<std::size_t, std::string>::first);
+    Delta.Deleted.reserve(Delta.Deleted.size() + Removed.size());
+    for (auto& [PreviousIndex, KeyText] : Removed)
+        Delta.Deleted.push_back(std::move(KeyText));
+    Previous = std::move(Current);
+    if (IsKeyedByContent)
+        PreviousRows = std::move(ResultData.Rows);
+    return Delta;
+}
+
+QueryWatcher::QueryWatcher(WatchOptions OptionsParam) : Options(std::move(OptionsParam)), Tracker(Options.KeyColumns)
+{
+    Options.Interval = (std::max)(Options.Interval, std::chrono::milliseconds{ 1 });
+}
+
+QueryWatcher::~QueryWatcher()
+{
+    Stop();
+}
+
+auto QueryWatcher::Connect() -> std::expected<void, std::string>
+{
+    return Connection.ConnectExpected(Options.Config);
+}
+
+auto QueryWatcher::RunOnce() -> WatchDelta
+{
+    const auto StartTime = std::chrono::steady_clock::now();
+    MySQLResult ResultData = Connection.Query(Options.SqlQuery);
+    const std::chrono::nanoseconds ExecutionTime = ResultData.ExecutionTime;
+    WatchDelta Delta;
+    if (auto Applied = Tracker.Apply(std::move(ResultData)))
+        Delta = std::move(*Applied);
+    else
+        Delta.ErrorMessage = std::move(Applied.error());
+    Delta.Iteration = ++Iteration;
+    Delta.Timestamp = std::chrono::system_clock::now();
+    Delta.ExecutionTime = ExecutionTime.count() > 0 ? ExecutionTime : std::chrono::steady_clock::now() - StartTime;
+    return Delta;
+}
+
+auto QueryWatcher::Start(DeltaCallback Callback) -> void
+{
+    Stop();
+    WatchThread = std::jthread([this, Callback = std::move(Callback)](std::stop_token StopToken) mutable { WatchLoop(StopToken, std::move(Callback)); });
+}
+
+auto QueryWatcher::Stop() -> void
+{
+    if (!WatchThread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        WatchThread.request_stop();
+    }
+    WakeCondition.notify_all();
+    // 正在执行的查询可能远长于间隔，取消后线程才能及时退出
+    Connection.Cancel();
+    WatchThread.join();
+}
+
+// 按固定节拍执行：下一轮的时间从上一轮的计划时间推算，执行耗时不会累积为漂移；超时的轮次不补执行
+auto QueryWatcher::WatchLoop(std::stop_token StopToken, DeltaCallback Callback) -> void
+{
+    auto NextRun = std::chrono::steady_clock::now();
+    while (!StopToken.stop_requested())
+    {
+        WatchDelta Delta = RunOnce();
+        if (StopToken.stop_requested())
+            break;
+        if (Delta.HasChanges() && Callback)
+            Callback(Delta);
+        const auto Now = std::chrono::steady_clock::now();
+        NextRun += Options.Interval;
+        if (NextRun < Now)
+            NextRun = Now;
+        std::unique_lock<std::mutex> Lock(WakeMutex);
+        WakeCondition.wait_until(Lock, NextRun, [&StopToken] { return StopToken.stop_requested(); });
+    }
+}
+
+auto FormatWatchDelta(const WatchDelta& Delta, std::string_view LineBreak) -> std::string
+{
+    thread_local TimestampCache Cache;
+    std::string Output;
+    Cache.Format(Delta.Timestamp, Output);
+    Output += ' ';
+    const double ElapsedMs = std::chrono::duration<double, std::milli>(Delta.ExecutionTime).count();
+    if (!Delta.ErrorMessage.empty())
+    {
+        Output += std::format("第 {} 轮执行失败 ({:.2f} ms): {}{}", Delta.Iteration, ElapsedMs, Delta.ErrorMessage, LineBreak);
+        return Output;
+    }
+    if (Delta.IsBaseline)
+        Output += std::format("第 {} 轮 基线 {} 行 ({:.2f} ms){}", Delta.Iteration, Delta.RowCount, ElapsedMs, LineBreak);
+    else
+        Output += std::format("第 {} 轮 {} 行: +{} ~{} -{} ({:.2f} ms){}", Delta.Iteration, Delta.RowCount, Delta.Inserted.size(), Delta.Changed.size(), Delta.Deleted.size(), ElapsedMs, LineBreak);
+    const auto AppendRow = [&](char Marker, const MySQLRow& RowData)
+    {
+        Output += Marker;
+        Output += ' ';
+        Output += JoinAllFields(RowData);
+        Output += LineBreak;
+    };
+    if (Delta.IsBaseline && !Delta.ColumnNames.empty())
+    {
+        Output += "  ";
+        for (std::size_t Index = 0; Index < Delta.ColumnNames.size(); ++Index)
+        {
+            if (Index > 0)
+                Output += '\t';
+            Output += Delta.ColumnNames[Index];
+        }
+        Output += LineBreak;
+    }
+    for (const auto& RowData : Delta.Inserted)
+        AppendRow('+', RowData);
+    for (const auto& RowData : Delta.Changed)
+        AppendRow('~', RowData);
+    for (const auto& KeyText : Delta.Deleted)
+    {
+        Output += "- ";
+        Output += KeyText;
+        Output += LineBreak;
+    }
+    return Output;
+}
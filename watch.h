@@ -0,0 +1,103 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct WatchOptions
+{
+    MySQLConfig Config;
+    std::string SqlQuery;
+    std::chrono::milliseconds Interval{ 2000 };
+    // 作为行标识的列；为空时以整行内容为标识，内容变化表现为一删一增
+    std::vector<std::string> KeyColumns;
+};
+
+struct WatchDelta
+{
+    uint64_t Iteration = 0;
+    std::chrono::system_clock::time_point Timestamp;
+    // 首次执行或列结构变化后的结果作为新的基线整体输出
+    bool IsBaseline = false;
+    std::vector<std::string> ColumnNames;
+    std::vector<MySQLRow> Inserted;
+    std::vector<MySQLRow> Changed;
+    // 已删除行的标识列取值（无标识列时为整行），以制表符分隔
+    std::vector<std::string> Deleted;
+    std::size_t RowCount = 0;
+    std::chrono::nanoseconds ExecutionTime{ 0 };
+    std::string ErrorMessage;
+    [[nodiscard]] auto HasChanges() const noexcept -> bool
+    {
+        return IsBaseline || !Inserted.empty() || !Changed.empty() || !Deleted.empty() || !ErrorMessage.empty();
+    }
+};
+
+// 两次结果之间的行级差异。有标识列时每行只保存标识的哈希、内容的哈希和标识列文本，不保留上一轮的完整结果；
+// 无标识列时标识就是内容哈希，上一轮的行留在接管过来的 RowStore 中（超出预算的部分编码或落盘），只用于输出被删除的行
+class RowDeltaTracker
+{
+private:
+    struct RowEntry
+    {
+        uint64_t ContentHash = 0;
+        uint32_t Count = 0;
+        // 首次出现的行号；无标识列时据此从 PreviousRows 取出被删除的行
+        std::size_t RowIndex = 0;
+        // 只在有标识列时保存
+        std::string KeyText;
+    };
+    std::vector<std::string> KeyColumns;
+    std::vector<std::size_t> KeyIndexes;
+    std::vector<std::string> ColumnNames;
+    std::unordered_map<uint64_t, RowEntry> Previous;
+    // 无标识列时为上一轮的结果行，否则为空
+    RowStore PreviousRows;
+    bool HasBaseline = false;
+public:
+    explicit RowDeltaTracker(std::vector<std::string> KeyColumnNames = {});
+    // 无标识列时接管 ResultData.Rows 作为下一轮比较删除行的依据，调用方不需要保留结果时应移入
+    [[nodiscard]] auto Apply(MySQLResult ResultData) -> std::expected<WatchDelta, std::string>;
+    auto Reset() noexcept -> void;
+};
+
+// 在独立连接上按固定间隔重复执行查询，只把相对上一轮的变化交给回调。
+// 执行时间超过间隔时下一轮立即开始，不会并发执行。
+class QueryWatcher
+{
+public:
+    using DeltaCallback = std::function<void(const WatchDelta&)>;
+private:
+    WatchOptions Options;
+    MySQLWrapper Connection;
+    RowDeltaTracker Tracker;
+    uint64_t Iteration = 0;
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    std::jthread WatchThread;
+    auto WatchLoop(std::stop_token StopToken, DeltaCallback Callback) -> void;
+public:
+    explicit QueryWatcher(WatchOptions OptionsParam);
+    ~QueryWatcher();
+    QueryWatcher(const QueryWatcher&) = delete;
+    auto operator=(const QueryWatcher&) -> QueryWatcher & = delete;
+    [[nodiscard]] auto Connect() -> std::expected<void, std::string>;
+    // 同步执行一轮并返回差异，供调用方自行调度
+    [[nodiscard]] auto RunOnce() -> WatchDelta;
+    // 后台线程按间隔执行，只有出现变化（或出错）时才调用回调；回调在后台线程上执行
+    auto Start(DeltaCallback Callback) -> void;
+    auto Stop() -> void;
+};
+
+// 文本形式的差异：+ 新增行，~ 变化行，- 删除行的标识
+[[nodiscard]] auto FormatWatchDelta(const WatchDelta& Delta, std::string_view LineBreak = "\r\n") -> std::string;
@@ -0,0 +1,149 @@
+#include "workload.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    auto AppendVarint(std::string& Output, uint64_t Value) -> void
+    {
+        while (Value >= 0x80)
+        {
+            Output += static_cast<char>((Value & 0x7F) | 0x80);
+            Value >>= 7;
+        }
+        Output += static_cast<char>(Value);
+    }
+
+    [[nodiscard]] auto ReadVarint(std::string_view& Input, uint64_t& Value) noexcept -> bool
+    {
+        Value = 0;
+        for (unsigned Shift = 0; Shift < 64 && !Input.empty(); Shift += 7)
+        {
+            const auto ByteValue = static_cast<unsigned char>(Input.front());
+            Input.remove_prefix(1);
+            Value |= static_cast<uint64_t>(ByteValue & 0x7F) << Shift;
+            if ((ByteValue & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    [[nodiscard]] auto ToNanoseconds(std::chrono::nanoseconds Duration) noexcept -> uint64_t
+    {
+        return Duration.count() > 0 ? static_cast<uint64_t>(Duration.count()) : 0;
+    }
+}
+
+WorkloadRecorder::~WorkloadRecorder()
+{
+    Stop();
+}
+
+auto WorkloadRecorder::Start(const std::string& FilePath) -> std::expected<void, std::string>
+{
+    std::lock_guard<std::mutex> Lock(RecorderMutex);
+    if (IsRecording.load(std::memory_order_relaxed))
+        return std::unexpected("负载采集已在进行中");
+    OutputFile.open(FilePath, std::ios::binary | std::ios::trunc);
+    if (!OutputFile)
+        return std::unexpected(std::format("无法创建负载日志: {}", FilePath));
+    StartTime = std::chrono::steady_clock::now();
+    const int64_t WallClockStart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    Buffer.assign(Magic);
+    for (unsigned Shift = 0; Shift < 64; Shift += 8)
+        Buffer += static_cast<char>(static_cast<uint64_t>(WallClockStart) >> Shift);
+    RecordedCount.store(0, std::memory_order_relaxed);
+    IsRecording.store(true, std::memory_order_release);
+    return {};
+}
+
+auto WorkloadRecorder::Stop() -> void
+{
+    std::lock_guard<std::mutex> Lock(RecorderMutex);
+    if (!IsRecording.exchange(false))
+        return;
+    FlushInternal();
+    OutputFile.close();
+}
+
+auto WorkloadRecorder::Flush() -> void
+{
+    std::lock_guard<std::mutex> Lock(RecorderMutex);
+    if (IsRecording.load(std::memory_order_relaxed))
+        FlushInternal();
+}
+
+auto WorkloadRecorder::FlushInternal() -> void
+{
+    if (Buffer.empty())
+        return;
+    OutputFile.write(Buffer.data(), static_cast<std::streamsize>(Buffer.size()));
+    OutputFile.flush();
+    Buffer.clear();
+}
+
+auto WorkloadRecorder::Record(uint64_t SessionId, std::chrono::steady_clock::time_point StatementStart, std::chrono::nanoseconds Latency, bool Success, uint64_t RowCount, std::string_view SqlText) -> void
+{
+    if (!IsRecording.load(std::memory_order_acquire))
+        return;
+    thread_local std::string Encoded;
+    Encoded.clear();
+    AppendVarint(Encoded, ToNanoseconds(StatementStart - StartTime));
+    AppendVarint(Encoded, SessionId);
+    AppendVarint(Encoded, ToNanoseconds(Latency));
+    Encoded += static_cast<char>(Success ? SuccessFlag : 0);
+    AppendVarint(Encoded, RowCount);
+    AppendVarint(Encoded, SqlText.size());
+    Encoded += SqlText;
+    std::lock_guard<std::mutex> Lock(RecorderMutex);
+    if (!IsRecording.load(std::memory_order_relaxed))
+        return;
+    Buffer += Encoded;
+    RecordedCount.fetch_add(1, std::memory_order_relaxed);
+    if (Buffer.size() >= FlushThreshold)
+        FlushInternal();
+}
+
+auto WorkloadRecorder::Load(const std::string& FilePath) -> std::expected<WorkloadLog, std::string>
+{
+    std::ifstream InputFile(FilePath, std::ios::binary);
+    if (!InputFile)
+        return std::unexpected(std::format("无法打开负载日志: {}", FilePath));
+    const std::string Content((std::istreambuf_iterator<char>(InputFile)), std::istreambuf_iterator<char>());
+    constexpr std::size_t HeaderSize = Magic.size() + sizeof(int64_t);
+    if (Content.size() < HeaderSize || !Content.starts_with(Magic))
+        return std::unexpected(std::format("不是有效的负载日志: {}", FilePath));
+    uint64_t WallClockStart = 0;
+    for (unsigned Index = 0; Index < sizeof(int64_t); ++Index)
+        WallClockStart |= static_cast<uint64_t>(static_cast<unsigned char>(Content[Magic.size() + Index])) << (Index * 8);
+    WorkloadLog Log;
+    Log.CaptureStart = std::chrono::system_clock::time_point{ std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{ static_cast<int64_t>(WallClockStart) }) };
+    std::string_view Remaining = std::string_view{ Content }.substr(HeaderSize);
+    while (!Remaining.empty())
+    {
+        uint64_t Offset = 0, SessionId = 0, Latency = 0, RowCount = 0, SqlLength = 0;
+        if (!ReadVarint(Remaining, Offset) || !ReadVarint(Remaining, SessionId) || !ReadVarint(Remaining, Latency) || Remaining.empty())
+        {
+            Log.IsTruncated = true;
+            break;
+        }
+        const auto Flags = static_cast<uint8_t>(Remaining.front());
+        Remaining.remove_prefix(1);
+        if (!ReadVarint(Remaining, RowCount) || !ReadVarint(Remaining, SqlLength) || SqlLength > Remaining.size())
+        {
+            Log.IsTruncated = true;
+            break;
+        }
+        WorkloadEvent& Event = Log.Events.emplace_back();
+        Event.Offset = std::chrono::nanoseconds{ static_cast<int64_t>(Offset) };
+        Event.SessionId = SessionId;
+        Event.Latency = std::chrono::nanoseconds{ static_cast<int64_t>(Latency) };
+        Event.Success = (Flags & SuccessFlag) != 0;
+        Event.RowCount = RowCount;
+        Event.SqlText = Remaining.substr(0, SqlLength);
+        Remaining.remove_prefix(SqlLength);
+    }
+    // 多个线程的记录按加锁顺序写入，回放前按开始时间重新排序
+    std::ranges::stable_sort(Log.Events, {}, &WorkloadEvent::Offset);
+    return Log;
+}
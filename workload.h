@@ -0,0 +1,64 @@
+#pragma once
+#include "def.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 负载日志格式（小端）：
+//   文件头: "MYWKLD01" | 采集开始的系统时间（纳秒，8 字节）
+//   记录:   varint 相对开始的偏移(ns) | varint 会话号 | varint 延迟(ns) | 1 字节标志 | varint 行数 | varint SQL 长度 | SQL
+struct WorkloadEvent
+{
+    std::chrono::nanoseconds Offset{ 0 };
+    uint64_t SessionId = 0;
+    std::chrono::nanoseconds Latency{ 0 };
+    bool Success = false;
+    uint64_t RowCount = 0;
+    std::string SqlText;
+};
+
+struct WorkloadLog
+{
+    std::chrono::system_clock::time_point CaptureStart;
+    std::vector<WorkloadEvent> Events;
+    bool IsTruncated = false;
+};
+
+class WorkloadRecorder
+{
+private:
+    static constexpr std::size_t FlushThreshold = 64 * 1024;
+    static constexpr uint8_t SuccessFlag = 0x01;
+    std::mutex RecorderMutex;
+    std::ofstream OutputFile;
+    std::string Buffer;
+    std::chrono::steady_clock::time_point StartTime;
+    std::atomic<bool> IsRecording{ false };
+    std::atomic<uint64_t> RecordedCount{ 0 };
+    auto FlushInternal() -> void;
+public:
+    static constexpr std::string_view Magic = "MYWKLD01";
+    WorkloadRecorder() = default;
+    ~WorkloadRecorder();
+    WorkloadRecorder(const WorkloadRecorder&) = delete;
+    auto operator=(const WorkloadRecorder&) -> WorkloadRecorder & = delete;
+    [[nodiscard]] auto Start(const std::string& FilePath) -> std::expected<void, std::string>;
+    auto Stop() -> void;
+    auto Flush() -> void;
+    [[nodiscard]] auto IsActive() const noexcept -> bool
+    {
+        return IsRecording.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] auto GetRecordedCount() const noexcept -> uint64_t
+    {
+        return RecordedCount.load(std::memory_order_relaxed);
+    }
+    auto Record(uint64_t SessionId, std::chrono::steady_clock::time_point StatementStart, std::chrono::nanoseconds Latency, bool Success, uint64_t RowCount, std::string_view SqlText) -> void;
+    [[nodiscard]] static auto Load(const std::string& FilePath) -> std::expected<WorkloadLog, std::string>;
+};
@@ -0,0 +1,335 @@
+#include "writebehind.h"
+#include <algorithm>
+#include <format>
+#include <unordered_map>
+
+namespace
+{
+    [[nodiscard]] auto MakeReadyCompletion(std::expected<void, std::string> Outcome) -> WriteCompletion
+    {
+        std::promise<std::expected<void, std::string>> Completion;
+        Completion.set_value(std::move(Outcome));
+        return Completion.get_future();
+    }
+}
+
+WriteBehindWriter::WriteBehindWriter(MySQLWrapper& ConnectionRef, WriteBehindOptions OptionsParam) : Connection(ConnectionRef), Options(std::move(OptionsParam))
+{
+    Options.MaxBatchWrites = (std::max)(Options.MaxBatchWrites, std::size_t{ 1 });
+    FlushThread = std::jthread([this](std::stop_token StopToken) { FlushLoop(StopToken); });
+}
+
+WriteBehindWriter::~WriteBehindWriter()
+{
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        FlushThread.request_stop();
+    }
+    WakeCondition.notify_all();
+    if (FlushThread.joinable())
+        FlushThread.join();
+}
+
+auto WriteBehindWriter::Insert(std::string_view TableName, const std::vector<std::string>& Columns, const std::vector<std::optional<std::string>>& Values) -> WriteCompletion
+{
+    if (Columns.empty() || Columns.size() != Values.size()) [[unlikely]]
+        return MakeReadyCompletion(std::unexpected(std::format("列数 {} 与值数 {} 不匹配", Columns.size(), Values.size())));
+    auto Write = std::make_unique<PendingWrite>();
+    Write->Kind = WriteKind::Row;
+    Write->Target = std::format("INSERT INTO {} (", SQLSanitizer::QuoteIdentifier(TableName));
+    for (std::size_t Index = 0; Index < Columns.size(); ++Index)
+    {
+        if (Index > 0)
+            Write->Target += ", ";
+        Write->Target += SQLSanitizer::QuoteIdentifier(Columns[Index]);
+    }
+    Write->Target += ") VALUES ";
+    Write->Values += '(';
+    for (std::size_t Index = 0; Index < Values.size(); ++Index)
+    {
+        if (Index > 0)
+            Write->Values += ", ";
+        if (Values[Index])
+            Write->Values += std::format("'{}'", SQLSanitizer::EscapeString(*Values[Index]));
+        else
+            Write->Values += "NULL";
+    }
+    Write->Values += ')';
+    return Enqueue(std::move(Write));
+}
+
+auto WriteBehindWriter::Execute(std::string SqlStatement) -> WriteCompletion
+{
+    auto Write = std::make_unique<PendingWrite>();
+    Write->Kind = WriteKind::Statement;
+    Write->Target = std::move(SqlStatement);
+    return Enqueue(std::move(Write));
+}
+
+auto WriteBehindWriter::Flush() -> void
+{
+    auto Barrier = std::make_unique<PendingWrite>();
+    Barrier->Kind = WriteKind::Barrier;
+    Enqueue(std::move(Barrier)).wait();
+}
+
+// 入队路径只有一次 CAS；只在队列由空变为非空、积压达到批量上限或请求落盘时才加锁唤醒后台线程
+auto WriteBehindWriter::Enqueue(std::unique_ptr<PendingWrite> Write) -> WriteCompletion
+{
+    const bool IsBarrier = Write->Kind == WriteKind::Barrier;
+    const std::size_t QueuedCount = PendingCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!IsBarrier)
+    {
+        if (QueuedCount > Options.MaxPendingWrites) [[unlikely]]
+        {
+            PendingCount.fetch_sub(1, std::memory_order_relaxed);
+            Counters.Rejected.fetch_add(1, std::memory_order_relaxed);
+            return MakeReadyCompletion(std::unexpected(std::format("写入队列已满（{} 条）", Options.MaxPendingWrites)));
+        }
+        Counters.Submitted.fetch_add(1, std::memory_order_relaxed);
+    }
+    WriteCompletion Completion = Write->Completion.get_future();
+    Write->SubmitTime = std::chrono::steady_clock::now();
+    // 发布之后节点随时可能被后台线程取走并释放，不能再访问
+    PendingWrite* Node = Write.release();
+    PendingWrite* PreviousHead = QueueHead.load(std::memory_order_relaxed);
+    do
+        Node->Next = PreviousHead;
+    while (!QueueHead.compare_exchange_weak(PreviousHead, Node, std::memory_order_release, std::memory_order_relaxed));
+    if (IsBarrier)
+        IsFlushRequested.store(true, std::memory_order_relaxed);
+    if (IsBarrier || PreviousHead == nullptr || QueuedCount % Options.MaxBatchWrites == 0)
+        Wake();
+    return Completion;
+}
+
+// 在锁内通知，避免后台线程检查队列之后、进入等待之前错过唤醒
+auto WriteBehindWriter::Wake() -> void
+{
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+    }
+    WakeCondition.notify_one();
+}
+
+auto WriteBehindWriter::TakeQueued() -> void
+{
+    PendingWrite* Node = QueueHead.exchange(nullptr, std::memory_order_acquire);
+    PendingWrite* Reversed = nullptr;
+    while (Node)
+    {
+        PendingWrite* Next = Node->Next;
+        Node->Next = Reversed;
+        Reversed = Node;
+        Node = Next;
+    }
+    while (Reversed)
+    {
+        std::unique_ptr<PendingWrite> Write(Reversed);
+        Reversed = Reversed->Next;
+        Write->Next = nullptr;
+        BacklogBytes += Write->Kind == WriteKind::Row ? Write->Values.size() + 2 : Write->Target.size();
+        if (Write->Kind == WriteKind::Barrier)
+            ++BacklogBarriers;
+        Backlog.push_back(std::move(Write));
+    }
+}
+
+auto WriteBehindWriter::IsBatchReady(std::chrono::steady_clock::time_point Now) const -> bool
+{
+    return !Backlog.empty() && (Backlog.size() >= Options.MaxBatchWrites || BacklogBytes >= Options.MaxBatchBytes || BacklogBarriers > 0
+        || Now >= Backlog.front()->SubmitTime + Options.MaxDelay);
+}
+
+auto WriteBehindWriter::FlushLoop(std::stop_token StopToken) -> void
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> Lock(WakeMutex);
+            if (Backlog.empty())
+                WakeCondition.wait(Lock, [&] { return StopToken.stop_requested() || QueueHead.load(std::memory_order_acquire) != nullptr; });
+            else if (!IsBatchReady(std::chrono::steady_clock::now()))
+            {
+                WakeCondition.wait_until(Lock, Backlog.front()->SubmitTime + Options.MaxDelay, [&]
+                    {
+                        return StopToken.stop_requested() || IsFlushRequested.load(std::memory_order_relaxed) || PendingCount.load(std::memory_order_relaxed) >= Options.MaxBatchWrites;
+                    });
+            }
+        }
+        IsFlushRequested.store(false, std::memory_order_relaxed);
+        TakeQueued();
+        const bool IsStopping = StopToken.stop_requested();
+        if (Backlog.empty())
+        {
+            if (IsStopping)
+                return;
+            continue;
+        }
+        // 停止时把剩余写入全部提交完再退出
+        while (IsStopping ? !Backlog.empty() : IsBatchReady(std::chrono::steady_clock::now()))
+            CommitNextBatch();
+    }
+}
+
+auto WriteBehindWriter::CommitNextBatch() -> void
+{
+    std::vector<std::unique_ptr<PendingWrite>> Batch;
+    std::size_t BatchBytes = 0;
+    while (!Backlog.empty() && Batch.size() < Options.MaxBatchWrites)
+    {
+        PendingWrite& Front = *Backlog.front();
+        const std::size_t WriteBytes = Front.Kind == WriteKind::Row ? Front.Values.size() + 2 : Front.Target.size();
+        if (!Batch.empty() && BatchBytes + WriteBytes > Options.MaxBatchBytes)
+            break;
+        BatchBytes += WriteBytes;
+        BacklogBytes -= WriteBytes;
+        const bool IsBarrier = Front.Kind == WriteKind::Barrier;
+        Batch.push_back(std::move(Backlog.front()));
+        Backlog.pop_front();
+        // 屏障之前的写入单独成批，Flush 不必等待之后到达的写入
+        if (IsBarrier)
+        {
+            --BacklogBarriers;
+            break;
+        }
+    }
+    const std::vector<std::string> Statements = BuildStatements(Batch);
+    std::string FailureMessage;
+    bool IsCommitted = Statements.empty();
+    bool IsOutcomeUnknown = false;
+    const auto CommitStart = std::chrono::steady_clock::now();
+    if (!IsCommitted)
+    {
+        // 在自己打开的会话上执行，失败后才能取得提交结果是否未知
+        auto SessionResult = Connection.OpenSession();
+        if (!SessionResult) [[unlikely]]
+            FailureMessage = SessionResult.error();
+        else
+        {
+            // 死锁和连接中断由 ExecuteTransaction 整体重放，回调每次进入时重新执行全部语句
+            IsCommitted = (*SessionResult)->ExecuteTransaction([&](Session& SessionRef)
+                {
+                    FailureMessage.clear();
+                    for (const auto& Statement : Statements)
+                    {
+                        const MySQLResult ResultData = SessionRef.Execute(Statement);
+                        if (!ResultData.Success)
+                        {
+                            FailureMessage = ResultData.ErrorMessage;
+                            return false;
+                        }
+                    }
+                    return true;
+                });
+            if (!IsCommitted)
+            {
+                IsOutcomeUnknown = (*SessionResult)->IsTransactionOutcomeUnknown();
+                if (FailureMessage.empty() || IsOutcomeUnknown)
+                    FailureMessage = (*SessionResult)->GetLastError();
+            }
+        }
+    }
+    if (!Statements.empty())
+    {
+        Counters.Transactions.fetch_add(1, std::memory_order_relaxed);
+        Counters.Statements.fetch_add(Statements.size(), std::memory_order_relaxed);
+    }
+    if (IsCommitted)
+    {
+        CommitLatency.Record(std::chrono::steady_clock::now() - CommitStart);
+        for (auto& Write : Batch)
+            Complete(*Write, {});
+        return;
+    }
+    const std::size_t WriteCount = std::ranges::count_if(Batch, [](const auto& Write) { return Write->Kind != WriteKind::Barrier; });
+    // 提交结果未知时整批可能已经生效，逐条重新执行会重复写入
+    if (WriteCount > 1 && !IsOutcomeUnknown)
+    {
+        ExecuteIsolated(Batch);
+        return;
+    }
+    for (auto& Write : Batch)
+        Complete(*Write, Write->Kind == WriteKind::Barrier ? std::expected<void, std::string>{} : std::unexpected(FailureMessage.empty() ? std::string{ "提交事务失败" } : FailureMessage));
+}
+
+// 同一目标的行在第一次出现的位置合并为多行 INSERT，超过字节上限时另起一条；语句写入前后的分组互不合并
+auto WriteBehindWriter::BuildStatements(const std::vector<std::unique_ptr<PendingWrite>>& Batch) const -> std::vector<std::string>
+{
+    std::vector<std::string> Statements;
+    std::unordered_map<std::string_view, std::size_t> OpenStatements;
+    for (const auto& Write : Batch)
+    {
+        if (Write->Kind == WriteKind::Barrier)
+            continue;
+        if (Write->Kind == WriteKind::Statement)
+        {
+            Statements.push_back(Write->Target);
+            OpenStatements.clear();
+            continue;
+        }
+        const auto OpenEntry = OpenStatements.find(Write->Target);
+        if (OpenEntry != OpenStatements.end() && Statements[OpenEntry->second].size() + Write->Values.size() + 2 <= Options.MaxBatchBytes)
+        {
+            Statements[OpenEntry->second] += ", ";
+            Statements[OpenEntry->second] += Write->Values;
+            continue;
+        }
+        OpenStatements[Write->Target] = Statements.size();
+        Statements.push_back(Write->Target + Write->Values);
+    }
+    return Statements;
+}
+
+// 整批失败时无法得知是哪条写入出错，逐条以自动提交方式重新执行，只让出错的写入失败
+auto WriteBehindWriter::ExecuteIsolated(std::vector<std::unique_ptr<PendingWrite>>& Batch) -> void
+{
+    Counters.IsolatedBatches.fetch_add(1, std::memory_order_relaxed);
+    auto SessionResult = Connection.OpenSession();
+    for (auto& Write : Batch)
+    {
+        if (Write->Kind == WriteKind::Barrier)
+        {
+            Complete(*Write, {});
+            continue;
+        }
+        if (!SessionResult)
+        {
+            Complete(*Write, std::unexpected(SessionResult.error()));
+            continue;
+        }
+        const auto StatementStart = std::chrono::steady_clock::now();
+        const MySQLResult ResultData = (*SessionResult)->Execute(Write->Kind == WriteKind::Row ? Write->Target + Write->Values : Write->Target);
+        Counters.Statements.fetch_add(1, std::memory_order_relaxed);
+        if (ResultData.Success)
+        {
+            CommitLatency.Record(std::chrono::steady_clock::now() - StatementStart);
+            Complete(*Write, {});
+        }
+        else
+            Complete(*Write, std::unexpected(ResultData.ErrorMessage));
+    }
+}
+
+auto WriteBehindWriter::Complete(PendingWrite& Write, std::expected<void, std::string> Outcome) -> void
+{
+    if (Write.Kind != WriteKind::Barrier)
+        (Outcome ? Counters.Committed : Counters.Failed).fetch_add(1, std::memory_order_relaxed);
+    Write.Completion.set_value(std::move(Outcome));
+    PendingCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+auto WriteBehindWriter::GetStatistics() const -> WriteBehindStatistics
+{
+    return
+    {
+        Counters.Submitted.load(),
+        Counters.Committed.load(),
+        Counters.Failed.load(),
+        Counters.Rejected.load(),
+        Counters.Transactions.load(),
+        Counters.Statements.load(),
+        Counters.IsolatedBatches.load(),
+        CommitLatency.Snapshot()
+    };
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "def.h"
+#include "database.h"
+#include "metrics.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct WriteBehindOptions
+{
+    // 一个事务最多合并的写入数和 SQL 字节数；字节上限应低于服务端 max_allowed_packet
+    std::size_t MaxBatchWrites = 1000;
+    std::size_t MaxBatchBytes = 1024 * 1024;
+    // 最早一条写入在队列中等待的上限
+    std::chrono::milliseconds MaxDelay{ 10 };
+    // 排队写入达到上限后，新写入直接失败而不是无限堆积
+    std::size_t MaxPendingWrites = 100'000;
+};
+
+struct WriteBehindStatistics
+{
+    uint64_t Submitted = 0;
+    uint64_t Committed = 0;
+    uint64_t Failed = 0;
+    uint64_t Rejected = 0;
+    uint64_t Transactions = 0;
+    uint64_t Statements = 0;
+    // 整批提交失败后逐条重新执行的批次数
+    uint64_t IsolatedBatches = 0;
+    LatencySnapshot CommitLatency;
+};
+
+using WriteCompletion = std::future<std::expected<void, std::string>>;
+
+// 多个线程提交的小写入先进入无锁队列，由后台线程合并后在一个事务中提交：同一表、同一列集合的行拼成多行 INSERT，
+// 批内写入数、SQL 字节数或最早写入的等待时间达到上限时落盘。每次写入返回的 future 在所在事务提交后就绪。
+// 同一批中不同表的行按表分组发送，相对顺序可能改变；Execute 提交的语句是分组边界，前后顺序保持不变。
+// 整批失败时逐条重新执行，只有出错的写入得到错误，其余写入照常提交。
+class WriteBehindWriter
+{
+private:
+    enum class WriteKind : uint8_t
+    {
+        Row,
+        Statement,
+        Barrier
+    };
+    struct PendingWrite
+    {
+        WriteKind Kind = WriteKind::Row;
+        // 行写入为 "INSERT INTO `表` (`列`, ...) VALUES "，语句写入为完整 SQL
+        std::string Target;
+        // 行写入的值元组 "(...)"
+        std::string Values;
+        std::promise<std::expected<void, std::string>> Completion;
+        std::chrono::steady_clock::time_point SubmitTime;
+        PendingWrite* Next = nullptr;
+    };
+    MySQLWrapper& Connection;
+    WriteBehindOptions Options;
+    // 生产者用 CAS 压入链表头，后台线程一次取走整条链表再反转为提交顺序
+    std::atomic<PendingWrite*> QueueHead{ nullptr };
+    std::atomic<std::size_t> PendingCount{ 0 };
+    std::atomic<bool> IsFlushRequested{ false };
+    // 以下三项只由后台线程访问
+    std::deque<std::unique_ptr<PendingWrite>> Backlog;
+    std::size_t BacklogBytes = 0;
+    std::size_t BacklogBarriers = 0;
+    struct WriterCounters
+    {
+        std::atomic<uint64_t> Submitted{ 0 };
+        std::atomic<uint64_t> Committed{ 0 };
+        std::atomic<uint64_t> Failed{ 0 };
+        std::atomic<uint64_t> Rejected{ 0 };
+        std::atomic<uint64_t> Transactions{ 0 };
+        std::atomic<uint64_t> Statements{ 0 };
+        std::atomic<uint64_t> IsolatedBatches{ 0 };
+    } Counters;
+    LatencyHistogram CommitLatency;
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    std::jthread FlushThread;
+    [[nodiscard]] auto Enqueue(std::unique_ptr<PendingWrite> Write) -> WriteCompletion;
+    auto Wake() -> void;
+    auto FlushLoop(std::stop_token StopToken) -> void;
+    auto TakeQueued() -> void;
+    [[nodiscard]] auto IsBatchReady(std::chrono::steady_clock::time_point Now) const -> bool;
+    auto CommitNextBatch() -> void;
+    [[nodiscard]] auto BuildStatements(const std::vector<std::unique_ptr<PendingWrite>>& Batch) const -> std::vector<std::string>;
+    auto ExecuteIsolated(std::vector<std::unique_ptr<PendingWrite>>& Batch) -> void;
+    auto Complete(PendingWrite& Write, std::expected<void, std::string> Outcome) -> void;
+public:
+    explicit WriteBehindWriter(MySQLWrapper& ConnectionRef, WriteBehindOptions OptionsParam = {});
+    // 提交所有排队的写入后才返回
+    ~WriteBehindWriter();
+    WriteBehindWriter(const WriteBehindWriter&) = delete;
+    auto operator=(const WriteBehindWriter&) -> WriteBehindWriter & = delete;
+    // Values 中的空值写为 NULL，其余按字符串字面量转义
+    [[nodiscard]] auto Insert(std::string_view TableName, const std::vector<std::string>& Columns, const std::vector<std::optional<std::string>>& Values) -> WriteCompletion;
+    [[nodiscard]] auto Execute(std::string SqlStatement) -> WriteCompletion;
+    // 立即落盘，等待此前提交的所有写入完成
+    auto Flush() -> void;
+    [[nodiscard]] auto GetStatistics() const -> WriteBehindStatistics;
+};